@@ -3,5 +3,8 @@ REM this is used instead of CMake, MakeGNU, Ninja, etc. Build tools are used to
 REM  %comspec% /k “C:\Program Files (x86)\Microsoft Visual Studio\2019\Community\VC\Auxiliary\Build\vcvars64.bat”
 mkdir ..\build
 pushd ..\build
-cl -Zi ..\code\win32_midnight_madness.cpp user32.lib gdi32.lib
+cl -DMIDNIGHT_MADNESS_INTERNAL=1 -DMIDNIGHT_MADNESS_SLOW=1 -Zi ..\code\win32_midnight_madness.cpp user32.lib gdi32.lib advapi32.lib psapi.lib winmm.lib
+REM The asset file is generated, so it is rebuilt along with the code
+cl -DMIDNIGHT_MADNESS_INTERNAL=1 -DMIDNIGHT_MADNESS_SLOW=1 -Zi ..\code\test_asset_builder.cpp
+test_asset_builder.exe midnight_madness.mma
 popd
\ No newline at end of file
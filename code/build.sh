@@ -0,0 +1,10 @@
+#!/bin/bash
+# Linux counterpart of build.bat. Builds the headless platform layer with optimisations on, since it exists to benchmark the game layer.
+mkdir -p ../build
+pushd ../build > /dev/null
+g++ -std=c++14 -O2 -g -DMIDNIGHT_MADNESS_INTERNAL=1 -DMIDNIGHT_MADNESS_SLOW=1 ../code/linux_midnight_madness.cpp -o linux_midnight_madness -lm -pthread
+# The asset file is generated, so it is rebuilt along with the code
+g++ -std=c++14 -O2 -g -DMIDNIGHT_MADNESS_INTERNAL=1 -DMIDNIGHT_MADNESS_SLOW=1 ../code/test_asset_builder.cpp -o test_asset_builder -lm && ./test_asset_builder midnight_madness.mma
+# The benchmarks time release code: no asserts and no profiler
+g++ -std=c++14 -O2 -g -DMIDNIGHT_MADNESS_INTERNAL=0 -DMIDNIGHT_MADNESS_SLOW=0 -DMIDNIGHT_MADNESS_PROFILE=0 ../code/midnight_madness_benchmark.cpp -o midnight_madness_benchmark -lm
+popd > /dev/null
@@ -0,0 +1,3661 @@
+/*
+
+    Headless Linux platform layer.
+
+    - There is no window and no audio device. The platform owns a game_offscreen_buffer and a
+      game_sound_output_buffer in plain memory and just calls GameUpdateAndRender N times.
+    - Every frame is timed with both the monotonic clock (nanoseconds) and __rdtsc (cycles), so we
+      can measure the game layer on the Linux build/bench boxes without Windows in the loop.
+    - Everything is deterministic: same arguments in, same frames out. The keyboard is a fixed script of
+      key presses (LinuxSynthesizeInput), so the game's input handling runs too.
+
+    Usage: linux_midnight_madness [-frames N] [-warmup N] [-width W] [-height H] [-rate HZ] [-fps N]
+                                  [-simd auto|scalar|sse2|avx2] [-verify] [-largepages] [-audiobench [-hours N] [-tone HZ]]
+                                  [-renderbench] [-presentbench] [-present WxH] [-threads N]
+                                  [-audiothread [-wav FILE] [-spikems N] [-spikeevery N] [-period N] [-latencyframes N]]
+                                  [-profile] [-trace FILE] [-pace] [-record NAME | -playback NAME]
+                                  [-capture NAME [-captureformat ppm|raw]] [-assets FILE]
+                                  [-format bgrx8888|rgba8888|rgb565|indexed8] [-buffers N] [-resizeevery N] [-pipeline N]
+                                  [-inject N] [-overlay] [-batch N] [-blend srgb|linear]
+
+    -verify renders the gradient, and draws rectangles, bitmaps and textured quads, with every SIMD path the CPU
+    supports and checks they are byte for byte the same as the scalar path, and that a frame drawn in tiles on the
+    work queue is the same as one drawn on one thread, and that presenting (scaling the frame to a window size, see
+    midnight_madness_present.h) matches scalar too, then exits (non-zero on a mismatch). Rendering is checked in both
+    blend spaces, along with the sRGB tables giving every byte back and linear blends against a float reference.
+
+    -audiobench times the oscillator bank against the old one-sinf-per-sample loop (samples/second), times the mixer
+    with hundreds of resampled, panned voices, then plays a tone for -hours of simulated time (default 4) and checks
+    the oscillator has not drifted, then exits.
+
+    -renderbench times the renderer at 1920x1080 with every SIMD path: opaque and blended full screen rectangles
+    (pixels/second), and 64x64 sprites drawn as bitmaps and as rotated bilinear quads (sprites/second and per frame).
+    Then it draws a busy frame in tiles on work queues of 1, 2, 4, 8 and 16 threads, for how the fill rate scales, and
+    last the gradient, a blended full screen fill and the busy frame at 1080p and 4K in every pixel format. The blended
+    rectangle and the bitmaps are timed blending in linear too, next to plain sRGB.
+
+    -presentbench times presenting a 1280x720 frame into 1080p, 1440p, 4K and a couple of other window sizes with every
+    SIMD path, next to plainly copying that many pixels. -present WxH presents every frame into a WxH buffer, the way
+    the Windows build presents into its window, and reports what that cost.
+
+    -format is the pixel format of the frame the game draws into (default bgrx8888, what Windows gets). Capturing and
+    presenting only take bgrx8888.
+
+    -buffers N is how many backbuffers the swap chain has, 2 to 4 (default: as many as -pipeline needs, see
+    midnight_madness_swap_chain.h). -resizeevery N resizes them every N frames, between -width x -height and three
+    quarters of that, the way dragging the window's edge would, for what a resize costs when it never goes to the OS.
+    Not with -capture.
+
+    -pipeline N lets a render thread build frames up to N ahead (0 to 2, default 0) of the one this thread presents,
+    see midnight_madness_frame_pipeline.h. The run reports frames per second of wall time and how long each frame
+    took from its input being sampled to it being presented, which is what the depth trades against each other.
+
+    -inject N has an input thread tap a key N times a second (on its own clock, at random around that, not the frame's),
+    stamping every press and release when it injects it, the way a window gets key messages. The run reports how long
+    each event took to be presented, and where the time went, see midnight_madness_input_latency.h. The key is one the
+    game doesn't use, so a run that records or plays back still ends up in the same state.
+
+    -overlay draws the performance overlay (see midnight_madness_overlay.h) over every frame before it is presented or
+    captured: what rendering it took, latencies, the profiler's busiest blocks, and what the overlay took itself the
+    frame before. The run reports what drawing it cost next to what the frame cost.
+
+    -batch N runs N instances of the game at once, each on its own thread with its own game memory, frame and sound
+    buffer, all playing the same script for -warmup + -frames frames as fast as they can, with no presenting, pacing or
+    profiler. Each renders on its own thread (the instances are what keep the cores busy) and loads its assets as it
+    asks for them, so its frames depend on nothing but its input. Every instance prints a checksum of all its frames
+    and one of all its sound, and as the sessions are the same, so must they be: an instance that differs means state
+    is shared between them somewhere (non-zero exit). The result is frames per second over every instance, next to
+    what one instance managed on its own.
+
+    -blend linear blends translucent pixels in linear light rather than on the sRGB bytes (default srgb), see
+    midnight_madness_render.cpp.
+
+    -threads N is how many threads render the frames, this one included (default: one per core, see
+    midnight_madness_work_queue.h).
+
+    -assets FILE is the packed asset file to memory map (default midnight_madness.mma next to the executable, which
+    build.sh writes with test_asset_builder). The game asks for its assets at startup and draws stand-ins until the
+    loader thread has paged them in; the run prints how long mapping the file and the first frame took, which should
+    not depend on how many assets the file has (see test_asset_builder -filler), and how many loads finished.
+
+    -largepages backs game memory with huge pages (MAP_HUGETLB, or transparent huge pages if none are reserved).
+
+    -pace runs the frames in real time, one every 1/fps seconds, through the frame pacer: sleep for most of the wait,
+    spin the rest, and report the histogram of frame times, missed frames and how much CPU that took. -spikems N makes
+    every -spikeevery'th frame (default 60th) take N ms longer.
+
+    -audiothread paces the frames too, and sends the sound through the audio ring to an audio thread that plays it
+    into a null sink at the sample rate, or into a WAV file with -wav, to see when the ring underruns. The null sink plays
+    -period samples at a time (default 240) and the game writes -latencyframes frames of sound (default 1) ahead, plus
+    the safety margin the audio thread measures.
+
+    -profile prints what the TIMED_BLOCKs measured over the last frames, -trace writes them out as Chrome trace JSON.
+
+    -record NAME snapshots the game memory into NAME.state (a memory mapped file) at the end of the warm-up, and writes
+    every measured frame's input to NAME.input. -playback NAME copies the snapshot back into game memory at the same
+    point and feeds the recorded input to the game instead of the script, going back to the snapshot whenever it runs
+    out, so two builds can be timed over exactly the same session. Both print a checksum of the game memory at
+    the end: the same -frames recorded and played back gives the same checksum (without -audiothread,
+    whose sound per frame depends on timing).
+
+    -capture NAME renders every frame straight into a pool of capture frames that a writer thread saves as NAME.ppm
+    (a stream of PPM images, or NAME.raw, raw BGRX pixels, with -captureformat raw) along with the sound as NAME.wav,
+    see midnight_madness_capture.h. Frames the writer had no room for are counted as dropped.
+
+*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <x86intrin.h>
+
+#include "midnight_madness.cpp"
+#include "midnight_madness_audio_ring.h"
+#include "midnight_madness_frame_pacer.h"
+#include "midnight_madness_capture.h"
+#include "midnight_madness_work_queue.h"
+#include "midnight_madness_present.h"
+#include "midnight_madness_swap_chain.h"
+#include "midnight_madness_input_latency.h"
+#include "midnight_madness_frame_pipeline.h"
+#include "midnight_madness_overlay.h"
+
+struct linux_offscreen_buffer
+{
+    void *Memory;
+    int Width;
+    int Height;
+    int Pitch;
+    pixel_format Format;
+};
+
+struct linux_sound_output
+{
+    int SamplesPerSecond;
+    int BytesPerSample;
+    int SecondaryBufferSize;
+};
+
+struct linux_benchmark_settings
+{
+    int FrameCount;
+    int WarmupFrameCount;
+    int Width;
+    int Height;
+    int SamplesPerSecond;
+    int GameUpdateHz;
+    int ToneHz;
+    simd_level SIMDLevel;
+    bool32 Verify;
+    bool32 LargePages;
+    bool32 AudioBenchmark;
+    bool32 RenderBenchmark;
+    bool32 PresentBenchmark;
+    int PresentWidth;
+    int PresentHeight;
+    int DriftHours;
+    bool32 AudioThread;
+    char *WavPath;
+    int SpikeMilliseconds;
+    int SpikeEvery;
+    int PeriodSamples;
+    int LatencyFrames;
+    int ThreadCount;
+    bool32 Profile;
+    char *TracePath;
+    bool32 Pace;
+    char *RecordName;
+    char *PlaybackName;
+    char *CaptureName;
+    capture_format CaptureFormat;
+    char *AssetPath;
+    pixel_format PixelFormat;
+    int BufferCount;
+    int ResizeEvery;
+    int PipelineDepth;
+    int InjectTapsPerSecond;
+    bool32 Overlay;
+    int BatchCount;
+    blend_space BlendSpace;
+};
+
+//Looped record and playback, like the Windows 'L' key. The game memory is copied into a memory mapped file when
+//recording starts, and copied back every time playback (re)starts; in between, the input file is all there is.
+#define LINUX_REPLAY_MAGIC 0x4C504552 //NOTE(Robin) "REPL"
+
+struct linux_replay_header
+{
+    uint32 Magic;
+    uint32 InputSize;
+    //NOTE(Robin) The game memory holds pointers into itself, so a snapshot only works at the same base address
+    uint64 GameMemoryBase;
+    uint64 GameMemorySize;
+};
+
+struct linux_replay
+{
+    void *GameMemoryBlock;
+    uint64 GameMemorySize;
+
+    void *Snapshot;
+    FILE *RecordingHandle;
+    FILE *PlaybackHandle;
+
+    uint32 FrameCount;
+    uint32 LoopCount;
+    uint64 FirstLoopChecksum;
+
+    //NOTE(Robin) Drained before game memory is snapshotted or restored, so no asset load is halfway through either way
+    platform_work_queue *LoadQueue;
+};
+
+//The stand-in for a sound card: plays one period every period's worth of real time, out of a device buffer two periods
+//deep that it tops up from the ring. Its play cursor moves a period at a time, like a real device's write cursor.
+struct linux_audio_thread
+{
+    audio_ring *Ring;
+    audio_device_clock *Clock;
+    int SamplesPerSecond;
+    int PeriodSamples;
+    int16 *Silence;
+    FILE *Wav;
+    uint32 WavDataBytes;
+    uint32 BlocksPlayed;
+    bool32 volatile Running;
+};
+
+//Writes out the capture frames the game thread publishes, and hands them back to the pool
+struct linux_capture_thread
+{
+    capture_queue *Queue;
+    int SamplesPerSecond;
+    sem_t FramesPublished;
+    int FrameFile;
+    int WavFile;
+    uint32 WavDataBytes;
+    uint32 FramesWritten;
+    int64 WriteNanoseconds;
+    bool32 WriteFailed;
+    bool32 volatile Running;
+};
+
+//Renders the frames the main thread submits, see midnight_madness_frame_pipeline.h. Without -pipeline the main thread
+//renders them itself, through the same LinuxRenderFrame.
+struct linux_render_thread
+{
+    frame_pipeline *Pipeline;
+    linux_benchmark_settings *Settings;
+    game_memory *GameMemory;
+    swap_chain *SwapChain;
+    capture_queue *CaptureQueue;
+    audio_ring *AudioRing;
+    audio_scheduler *AudioScheduler;
+    audio_device_clock *AudioClock;
+    linux_replay *Replay;
+    int16 *Samples;
+    int SamplesPerFrame;
+    int SamplesPerSecond;
+    sem_t FramesSubmitted;
+    sem_t FramesRendered;
+    bool32 volatile Running;
+};
+
+//A frame_pipeline_slot's PlatformFlags
+enum linux_frame_flags
+{
+    LinuxFrame_RestoreSnapshot = 0x1, //NOTE(Robin) Playback ran out, game memory goes back to the snapshot first
+    LinuxFrame_FirstLoopEnded = 0x2, //NOTE(Robin) And it was the first loop, checksum the memory before it goes
+};
+
+//Injects key presses and releases from a thread of its own, through a ring that the main thread drains every time it
+//samples the input, like the audio ring but for events: each count only goes up, and is only written by one thread
+#define LINUX_INJECTED_EVENT_COUNT 256 //NOTE(Robin) A power of two
+
+struct linux_input_injector
+{
+    int TapsPerSecond;
+    uint32 ButtonIndex;
+    uint32 RandomState;
+    input_event_stamp Events[LINUX_INJECTED_EVENT_COUNT];
+    uint32 volatile WriteCount;
+    uint32 volatile ReadCount;
+    uint32 DroppedCount; //NOTE(Robin) Only the input thread writes this one, read once it has stopped
+    bool32 volatile Running;
+};
+
+//The render queue's worker threads. The thread that starts the queue is its owner, thread 0.
+struct linux_worker
+{
+    struct linux_work_queue *WorkQueue;
+    uint32 ThreadIndex;
+    pthread_t Thread;
+};
+
+struct linux_work_queue
+{
+    platform_work_queue *Queue;
+    sem_t Wake;
+    uint32 ThreadCount; //NOTE(Robin) The owner and the workers that started
+    bool32 volatile Running;
+    linux_worker Workers[WORK_QUEUE_MAX_THREADS];
+};
+
+//One game of a -batch run, and what it came out with
+#define LINUX_BATCH_MAX_INSTANCES 64
+
+struct linux_batch_instance
+{
+    linux_benchmark_settings *Settings;
+    game_memory GameMemory;
+    linux_offscreen_buffer Buffer;
+    int16 *Samples;
+    int SamplesPerFrame;
+
+    uint64 FrameChecksum;
+    uint64 SoundChecksum;
+    int64 Nanoseconds;
+};
+
+struct linux_frame_timing
+{
+    int64 Nanoseconds;
+    int64 Cycles;
+};
+
+internal int64 LinuxGetNanoseconds(void)
+{
+    //CLOCK_MONOTONIC never jumps backwards, unlike the wall clock, so it is safe to subtract
+    timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return((int64)Now.tv_sec*1000000000LL + (int64)Now.tv_nsec);
+}
+
+//Plain anonymous pages straight from the OS, the Linux version of VirtualAlloc(MEM_RESERVE|MEM_COMMIT).
+//MAP_POPULATE faults them in right away so the first frame doesn't pay for it.
+internal void *LinuxAllocateMemory(uint64 Size)
+{
+    void *Result = mmap(0, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    return(Result);
+}
+
+//The Linux version of Win32AllocateGameMemory: one block, at BaseAddress if it is free, with every page faulted in up front.
+//MAP_POPULATE makes the kernel fault the whole range in before mmap returns. Explicit huge pages only exist if the
+//admin reserved some (vm.nr_hugepages), so when that fails we ask for transparent huge pages and touch the pages ourselves.
+internal void *LinuxAllocateGameMemory(void *BaseAddress, uint64 Size, bool32 LargePages, bool32 *UsedLargePages)
+{
+    void *Result = MAP_FAILED;
+    *UsedLargePages = false;
+
+    int Flags = MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE;
+#if defined(MAP_FIXED_NOREPLACE)
+    if(BaseAddress)
+    {
+        //Like MAP_FIXED, but fails instead of silently unmapping whatever was already there
+        Flags |= MAP_FIXED_NOREPLACE;
+    }
+#endif
+
+    if(LargePages)
+    {
+        uint64 HugePageSize = Megabytes(2);
+        uint64 HugeSize = (Size + HugePageSize - 1) & ~(HugePageSize - 1);
+        Result = mmap(BaseAddress, HugeSize, PROT_READ|PROT_WRITE, Flags|MAP_HUGETLB, -1, 0);
+        *UsedLargePages = (Result != MAP_FAILED);
+
+        if(Result == MAP_FAILED)
+        {
+            Result = mmap(BaseAddress, Size, PROT_READ|PROT_WRITE, Flags & ~MAP_POPULATE, -1, 0);
+            if(Result != MAP_FAILED)
+            {
+                *UsedLargePages = (madvise(Result, Size, MADV_HUGEPAGE) == 0);
+                volatile uint8 *Page = (volatile uint8 *)Result;
+                for(uint64 Offset = 0; Offset < Size; Offset += Kilobytes(4))
+                {
+                    Page[Offset] = 0;
+                }
+            }
+        }
+    }
+    else
+    {
+        Result = mmap(BaseAddress, Size, PROT_READ|PROT_WRITE, Flags, -1, 0);
+    }
+
+    if((Result == MAP_FAILED) && BaseAddress)
+    {
+        //Someone else already lives at the base address, let the kernel pick
+        Result = LinuxAllocateGameMemory(0, Size, LargePages, UsedLargePages);
+    }
+
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    return(Result);
+}
+
+//Read only and copy on write, at BaseAddress if it is free. Mapping reads nothing, a page is read the first time it is touched.
+internal void *LinuxMapFile(char *FileName, void *BaseAddress, uint64 *Size)
+{
+    void *Result = 0;
+    *Size = 0;
+
+    int File = open(FileName, O_RDONLY);
+    struct stat FileStat;
+    if((File >= 0) && (fstat(File, &FileStat) == 0) && (FileStat.st_size > 0))
+    {
+        int Flags = MAP_PRIVATE;
+#if defined(MAP_FIXED_NOREPLACE)
+        if(BaseAddress)
+        {
+            Flags |= MAP_FIXED_NOREPLACE;
+        }
+#endif
+        void *Memory = mmap(BaseAddress, FileStat.st_size, PROT_READ, Flags, File, 0);
+        if((Memory == MAP_FAILED) && BaseAddress)
+        {
+            Memory = mmap(0, FileStat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+        }
+        if(Memory != MAP_FAILED)
+        {
+            Result = Memory;
+            *Size = (uint64)FileStat.st_size;
+        }
+    }
+
+    //The mapping keeps the file alive on its own
+    if(File >= 0)
+    {
+        close(File);
+    }
+
+    return(Result);
+}
+
+//Minor (no disk involved) plus major page faults for the whole process so far
+internal uint64 LinuxGetPageFaultCount(void)
+{
+    rusage Usage;
+    getrusage(RUSAGE_SELF, &Usage);
+    return((uint64)Usage.ru_minflt + (uint64)Usage.ru_majflt);
+}
+
+//User plus system time for the whole process so far
+internal float64 LinuxGetCPUSeconds(void)
+{
+    rusage Usage;
+    getrusage(RUSAGE_SELF, &Usage);
+    float64 Result = (Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec) + (Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec) / 1.0e6;
+    return(Result);
+}
+
+internal void LinuxResizeOffscreenBuffer(linux_offscreen_buffer *Buffer, int Width, int Height, pixel_format Format)
+{
+    if(Buffer->Memory)
+    {
+        munmap(Buffer->Memory, (uint64)Buffer->Pitch*Buffer->Height);
+    }
+
+    Buffer->Width = Width;
+    Buffer->Height = Height;
+    Buffer->Format = Format;
+    Buffer->Pitch = Width*GetBytesPerPixel(Format);
+    Buffer->Memory = LinuxAllocateMemory((uint64)Buffer->Pitch*Buffer->Height);
+}
+
+//The platform's half of the work queue: the worker threads and the semaphore they sleep on
+internal PLATFORM_ADD_ENTRY(LinuxAddEntry)
+{
+    AddWorkQueueEntry(Queue, Callback, Data);
+    sem_post((sem_t *)Queue->WakeSemaphore);
+}
+
+internal PLATFORM_COMPLETE_ALL_WORK(LinuxCompleteAllWork)
+{
+    uint32 ThreadIndex = GetWorkQueueThreadIndex(Queue);
+    while(!IsWorkQueueDone(Queue))
+    {
+        if(!DoNextWorkQueueEntry(Queue, ThreadIndex))
+        {
+            //The last entries are running on other threads. If one of them is waiting for this core, let it have it.
+            sched_yield();
+        }
+    }
+}
+
+internal void *LinuxWorkQueueThreadProc(void *Parameter)
+{
+    linux_worker *Worker = (linux_worker *)Parameter;
+    linux_work_queue *WorkQueue = Worker->WorkQueue;
+    platform_work_queue *Queue = WorkQueue->Queue;
+
+    RegisterWorkQueueThread(Queue, Worker->ThreadIndex);
+    DebugNameThread("Worker");
+
+    while(WorkQueue->Running)
+    {
+        if(!DoNextWorkQueueEntry(Queue, Worker->ThreadIndex))
+        {
+            sem_wait(&WorkQueue->Wake);
+        }
+    }
+
+    return(0);
+}
+
+//The calling thread becomes the queue's owner, and ThreadCount - 1 workers are started
+internal bool32 LinuxStartWorkQueue(linux_work_queue *WorkQueue, uint32 ThreadCount)
+{
+    *WorkQueue = {};
+    WorkQueue->Queue = (platform_work_queue *)LinuxAllocateMemory(sizeof(platform_work_queue));
+    if(!WorkQueue->Queue)
+    {
+        return(false);
+    }
+
+    sem_init(&WorkQueue->Wake, 0, 0);
+    InitializeWorkQueue(WorkQueue->Queue, ThreadCount, &WorkQueue->Wake);
+    RegisterWorkQueueThread(WorkQueue->Queue, 0);
+
+    //Only the workers that started count, the queue goes on with fewer (the owner runs entries too) if one didn't
+    WorkQueue->Running = true;
+    WorkQueue->ThreadCount = 1;
+    for(uint32 ThreadIndex = 1; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        linux_worker *Worker = WorkQueue->Workers + ThreadIndex;
+        Worker->WorkQueue = WorkQueue;
+        Worker->ThreadIndex = ThreadIndex;
+        int Error = pthread_create(&Worker->Thread, 0, LinuxWorkQueueThreadProc, Worker);
+        if(Error != 0)
+        {
+            fprintf(stderr, "Could only start %u of the work queue's %u threads: %s\n", ThreadIndex, ThreadCount, strerror(Error));
+            WorkQueue->Queue->ThreadCount = ThreadIndex;
+            break;
+        }
+        WorkQueue->ThreadCount = ThreadIndex + 1;
+    }
+
+    return(true);
+}
+
+internal void LinuxStopWorkQueue(linux_work_queue *WorkQueue)
+{
+    WorkQueue->Running = false;
+    for(uint32 ThreadIndex = 1; ThreadIndex < WorkQueue->ThreadCount; ++ThreadIndex)
+    {
+        sem_post(&WorkQueue->Wake);
+    }
+    for(uint32 ThreadIndex = 1; ThreadIndex < WorkQueue->ThreadCount; ++ThreadIndex)
+    {
+        pthread_join(WorkQueue->Workers[ThreadIndex].Thread, 0);
+    }
+
+    sem_destroy(&WorkQueue->Wake);
+    munmap(WorkQueue->Queue, sizeof(platform_work_queue));
+    WorkQueue->Queue = 0;
+}
+
+internal int LinuxCompareTimings(const void *A, const void *B)
+{
+    int64 NanosecondsA = ((linux_frame_timing *)A)->Nanoseconds;
+    int64 NanosecondsB = ((linux_frame_timing *)B)->Nanoseconds;
+    return((NanosecondsA > NanosecondsB) - (NanosecondsA < NanosecondsB));
+}
+
+internal int LinuxCompareInt64(const void *A, const void *B)
+{
+    int64 ValueA = *(int64 *)A;
+    int64 ValueB = *(int64 *)B;
+    return((ValueA > ValueB) - (ValueA < ValueB));
+}
+
+global_variable const char *SIMDLevelNames[SIMDLevel_Count] = {"auto", "scalar", "sse2", "avx2"};
+global_variable const char *PixelFormatNames[PixelFormat_Count] = {"bgrx8888", "rgba8888", "rgb565", "indexed8"};
+global_variable const char *BlendSpaceNames[BlendSpace_Count] = {"srgb", "linear"};
+
+//NOTE(Robin) Only drawn on with -overlay, but initialized either way: building the atlas takes next to nothing
+global_variable debug_overlay GlobalOverlay;
+
+internal bool32 LinuxParseArguments(int ArgCount, char **Args, linux_benchmark_settings *Settings)
+{
+    bool32 Result = true;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        char *Value = (ArgIndex + 1 < ArgCount) ? Args[ArgIndex + 1] : 0;
+        int *Target = 0;
+
+        if(strcmp(Arg, "-frames") == 0) {Target = &Settings->FrameCount;}
+        else if(strcmp(Arg, "-warmup") == 0) {Target = &Settings->WarmupFrameCount;}
+        else if(strcmp(Arg, "-width") == 0) {Target = &Settings->Width;}
+        else if(strcmp(Arg, "-height") == 0) {Target = &Settings->Height;}
+        else if(strcmp(Arg, "-rate") == 0) {Target = &Settings->SamplesPerSecond;}
+        else if(strcmp(Arg, "-fps") == 0) {Target = &Settings->GameUpdateHz;}
+        else if(strcmp(Arg, "-tone") == 0) {Target = &Settings->ToneHz;}
+        else if(strcmp(Arg, "-hours") == 0) {Target = &Settings->DriftHours;}
+        else if(strcmp(Arg, "-spikems") == 0) {Target = &Settings->SpikeMilliseconds;}
+        else if(strcmp(Arg, "-spikeevery") == 0) {Target = &Settings->SpikeEvery;}
+        else if(strcmp(Arg, "-period") == 0) {Target = &Settings->PeriodSamples;}
+        else if(strcmp(Arg, "-latencyframes") == 0) {Target = &Settings->LatencyFrames;}
+        else if(strcmp(Arg, "-threads") == 0) {Target = &Settings->ThreadCount;}
+        else if(strcmp(Arg, "-buffers") == 0) {Target = &Settings->BufferCount;}
+        else if(strcmp(Arg, "-resizeevery") == 0) {Target = &Settings->ResizeEvery;}
+        else if(strcmp(Arg, "-pipeline") == 0) {Target = &Settings->PipelineDepth;}
+        else if(strcmp(Arg, "-inject") == 0) {Target = &Settings->InjectTapsPerSecond;}
+        else if(strcmp(Arg, "-batch") == 0) {Target = &Settings->BatchCount;}
+
+        if(strcmp(Arg, "-verify") == 0)
+        {
+            Settings->Verify = true;
+        }
+        else if(strcmp(Arg, "-largepages") == 0)
+        {
+            Settings->LargePages = true;
+        }
+        else if(strcmp(Arg, "-audiobench") == 0)
+        {
+            Settings->AudioBenchmark = true;
+        }
+        else if(strcmp(Arg, "-renderbench") == 0)
+        {
+            Settings->RenderBenchmark = true;
+        }
+        else if(strcmp(Arg, "-presentbench") == 0)
+        {
+            Settings->PresentBenchmark = true;
+        }
+        else if((strcmp(Arg, "-present") == 0) && Value)
+        {
+            if((sscanf(Value, "%dx%d", &Settings->PresentWidth, &Settings->PresentHeight) != 2) ||
+               (Settings->PresentWidth <= 0) || (Settings->PresentHeight <= 0) ||
+               (Settings->PresentWidth > PRESENT_MAX_WIDTH))
+            {
+                fprintf(stderr, "-present wants WxH, at most %d wide: %s\n", PRESENT_MAX_WIDTH, Value);
+                Result = false;
+            }
+            ++ArgIndex;
+        }
+        else if(strcmp(Arg, "-audiothread") == 0)
+        {
+            Settings->AudioThread = true;
+            Settings->Pace = true;
+        }
+        else if(strcmp(Arg, "-pace") == 0)
+        {
+            Settings->Pace = true;
+        }
+        else if((strcmp(Arg, "-wav") == 0) && Value)
+        {
+            Settings->WavPath = Value;
+            ++ArgIndex;
+        }
+        else if(strcmp(Arg, "-profile") == 0)
+        {
+            Settings->Profile = true;
+        }
+        else if(strcmp(Arg, "-overlay") == 0)
+        {
+            Settings->Overlay = true;
+        }
+        else if((strcmp(Arg, "-trace") == 0) && Value)
+        {
+            Settings->TracePath = Value;
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-record") == 0) && Value)
+        {
+            Settings->RecordName = Value;
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-playback") == 0) && Value)
+        {
+            Settings->PlaybackName = Value;
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-assets") == 0) && Value)
+        {
+            Settings->AssetPath = Value;
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-capture") == 0) && Value)
+        {
+            Settings->CaptureName = Value;
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-captureformat") == 0) && Value)
+        {
+            if(strcmp(Value, "ppm") == 0)
+            {
+                Settings->CaptureFormat = CaptureFormat_PPM;
+            }
+            else if(strcmp(Value, "raw") == 0)
+            {
+                Settings->CaptureFormat = CaptureFormat_Raw;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown capture format: %s\n", Value);
+                Result = false;
+            }
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-format") == 0) && Value)
+        {
+            int FormatIndex = 0;
+            while((FormatIndex < PixelFormat_Count) && (strcmp(Value, PixelFormatNames[FormatIndex]) != 0))
+            {
+                ++FormatIndex;
+            }
+
+            if(FormatIndex < PixelFormat_Count)
+            {
+                Settings->PixelFormat = (pixel_format)FormatIndex;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown pixel format: %s\n", Value);
+                Result = false;
+            }
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-simd") == 0) && Value)
+        {
+            int LevelIndex = 0;
+            while((LevelIndex < SIMDLevel_Count) && (strcmp(Value, SIMDLevelNames[LevelIndex]) != 0))
+            {
+                ++LevelIndex;
+            }
+
+            if(LevelIndex < SIMDLevel_Count)
+            {
+                Settings->SIMDLevel = (simd_level)LevelIndex;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown SIMD level: %s\n", Value);
+                Result = false;
+            }
+            ++ArgIndex;
+        }
+        else if((strcmp(Arg, "-blend") == 0) && Value)
+        {
+            int SpaceIndex = 0;
+            while((SpaceIndex < BlendSpace_Count) && (strcmp(Value, BlendSpaceNames[SpaceIndex]) != 0))
+            {
+                ++SpaceIndex;
+            }
+
+            if(SpaceIndex < BlendSpace_Count)
+            {
+                Settings->BlendSpace = (blend_space)SpaceIndex;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown blend space: %s\n", Value);
+                Result = false;
+            }
+            ++ArgIndex;
+        }
+        else if(Target && Value)
+        {
+            *Target = atoi(Value);
+            ++ArgIndex;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", Arg);
+            Result = false;
+        }
+    }
+
+    //Unless asked for more, as few backbuffers as the pipeline needs
+    if(Settings->BufferCount == 0)
+    {
+        Settings->BufferCount = Settings->PipelineDepth + 2;
+    }
+
+    if((Settings->FrameCount <= 0) || (Settings->Width <= 0) || (Settings->Height <= 0) ||
+       (Settings->SamplesPerSecond <= 0) || (Settings->GameUpdateHz <= 0) || (Settings->ToneHz <= 0) ||
+       (Settings->SpikeEvery <= 0) || (Settings->PeriodSamples <= 0) || (Settings->LatencyFrames <= 0))
+    {
+        fprintf(stderr, "Frames, resolution, sample rate, frame rate, tone, spike interval, period and latency must all be positive\n");
+        Result = false;
+    }
+    else if(Settings->PeriodSamples > Settings->SamplesPerSecond)
+    {
+        //The silence the audio thread plays on an underrun comes out of the one second sample buffer
+        fprintf(stderr, "The audio period can be at most one second\n");
+        Result = false;
+    }
+    else if(Settings->RecordName && Settings->PlaybackName)
+    {
+        fprintf(stderr, "Record or play back, not both\n");
+        Result = false;
+    }
+    else if((Settings->ThreadCount < 1) || (Settings->ThreadCount > WORK_QUEUE_MAX_THREADS))
+    {
+        fprintf(stderr, "Threads must be between 1 and %d\n", WORK_QUEUE_MAX_THREADS);
+        Result = false;
+    }
+    else if((Settings->PipelineDepth < 0) || (Settings->PipelineDepth > FRAME_PIPELINE_MAX_DEPTH))
+    {
+        fprintf(stderr, "The pipeline depth must be between 0 and %d\n", FRAME_PIPELINE_MAX_DEPTH);
+        Result = false;
+    }
+    else if((Settings->BufferCount < 2) || (Settings->BufferCount > SWAP_CHAIN_MAX_BUFFERS) || (Settings->ResizeEvery < 0))
+    {
+        fprintf(stderr, "Buffers must be between 2 and %d, and the resize interval can't be negative\n", SWAP_CHAIN_MAX_BUFFERS);
+        Result = false;
+    }
+    else if(Settings->BufferCount < Settings->PipelineDepth + 2)
+    {
+        //One for every frame in flight, and the one on screen
+        fprintf(stderr, "A pipeline %d deep needs at least %d buffers\n", Settings->PipelineDepth, Settings->PipelineDepth + 2);
+        Result = false;
+    }
+    else if((Settings->InjectTapsPerSecond < 0) || (Settings->InjectTapsPerSecond > 1000))
+    {
+        fprintf(stderr, "Injected taps per second must be between 0 and 1000\n");
+        Result = false;
+    }
+    else if((Settings->BatchCount < 0) || (Settings->BatchCount > LINUX_BATCH_MAX_INSTANCES))
+    {
+        fprintf(stderr, "A batch can be at most %d instances\n", LINUX_BATCH_MAX_INSTANCES);
+        Result = false;
+    }
+    else if(Settings->CaptureName && Settings->ResizeEvery)
+    {
+        //The capture frames are all one size
+        fprintf(stderr, "Capturing needs the frames to stay the same size\n");
+        Result = false;
+    }
+    else if((Settings->PixelFormat != PixelFormat_BGRX8888) && (Settings->CaptureName || Settings->PresentWidth))
+    {
+        //Both of them read the frame as 32 bit pixels
+        fprintf(stderr, "Capturing and presenting need the bgrx8888 pixel format\n");
+        Result = false;
+    }
+    else if(Settings->PresentWidth && (Settings->Width < 2))
+    {
+        //Bilinear filtering needs a pixel on either side, PresentScaled won't take anything narrower
+        fprintf(stderr, "Presenting needs frames at least 2 pixels wide\n");
+        Result = false;
+    }
+
+    return(Result);
+}
+
+//Every 16 and 8 bit pixel has to come back unchanged from being widened to 0xAARRGGBB and narrowed again, or pixels
+//the SIMD paths load and mask off would change
+internal bool32 LinuxVerifyPixelFormats(void)
+{
+    bool32 Result = true;
+    for(uint32 Value = 0; Value < 65536; ++Value)
+    {
+        uint16 Pixel565 = (uint16)Value;
+        uint8 Pixel8 = (uint8)Value;
+        if((pixel_format_rgb565::Pack(pixel_format_rgb565::Unpack(Pixel565)) != Pixel565) ||
+           (pixel_format_indexed8::Pack(pixel_format_indexed8::Unpack(Pixel8)) != Pixel8))
+        {
+            fprintf(stderr, "Pixel 0x%04x changes when widened and narrowed again\n", Value);
+            Result = false;
+        }
+    }
+    return(Result);
+}
+
+//Renders the same gradient with the scalar path and the path being checked, over awkward widths, pitches and offsets.
+//Both buffers start out filled with a canary byte so we also catch writes past the end of a row into the pitch padding.
+internal bool32 LinuxVerifyGradientLevel(simd_level Level, pixel_format Format)
+{
+    int Widths[] = {1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 100, 1280};
+    int PitchPaddings[] = {0, 4, 12, 64};
+    int Offsets[] = {0, 1, 250, -3, -1000, 1000003};
+    int Height = 5;
+
+    int MaxPitch = (1280 + 64/4)*4;
+    uint8 *Expected = (uint8 *)LinuxAllocateMemory(MaxPitch*Height);
+    uint8 *Actual = (uint8 *)LinuxAllocateMemory(MaxPitch*Height);
+
+    bool32 Result = true;
+    for(int WidthIndex = 0; WidthIndex < ArrayCount(Widths); ++WidthIndex)
+    {
+        for(int PaddingIndex = 0; PaddingIndex < ArrayCount(PitchPaddings); ++PaddingIndex)
+        {
+            for(int OffsetIndex = 0; OffsetIndex < ArrayCount(Offsets); ++OffsetIndex)
+            {
+                game_offscreen_buffer Buffer = {};
+                Buffer.Format = Format;
+                Buffer.Width = Widths[WidthIndex];
+                Buffer.Height = Height;
+                Buffer.Pitch = Buffer.Width*GetBytesPerPixel(Buffer.Format) + PitchPaddings[PaddingIndex];
+                int XOffset = Offsets[OffsetIndex];
+                int YOffset = -Offsets[OffsetIndex]/2;
+                int Size = Buffer.Pitch*Buffer.Height;
+
+                memset(Expected, 0xCD, Size);
+                memset(Actual, 0xCD, Size);
+
+                Buffer.Memory = Expected;
+                GameSelectSIMDLevel(SIMDLevel_Scalar);
+                RenderWeirdGradient(&Buffer, XOffset, YOffset);
+
+                Buffer.Memory = Actual;
+                GameSelectSIMDLevel(Level);
+                RenderWeirdGradient(&Buffer, XOffset, YOffset);
+
+                if(memcmp(Expected, Actual, Size) != 0)
+                {
+                    fprintf(stderr, "%s %s gradient differs from scalar: width %d, pitch %d, offset %d\n",
+                            SIMDLevelNames[Level], PixelFormatNames[Format], Buffer.Width, Buffer.Pitch, XOffset);
+                    Result = false;
+                }
+            }
+        }
+    }
+
+    munmap(Expected, MaxPitch*Height);
+    munmap(Actual, MaxPitch*Height);
+
+    return(Result);
+}
+
+//Copies the gradient out of tiled backgrounds of one period and of several, and checks it is the gradient computed
+//at the same offsets, the whole buffer and through a clip rectangle, over rows that wrap around the tile several times
+//and offsets either side of zero. Canary bytes as for the gradient.
+internal bool32 LinuxVerifyTiledBackground(pixel_format Format)
+{
+    int TileSizes[][2] = {{256, 256}, {768, 512}};
+    int Widths[] = {1, 3, 17, 100, 257, 1280};
+    int PitchPaddings[] = {0, 12};
+    int Offsets[] = {0, 1, 250, -3, -1000, 1000003};
+    int Height = 300;
+
+    int MaxPitch = 1280*4 + 12;
+    uint8 *Expected = (uint8 *)LinuxAllocateMemory(MaxPitch*Height);
+    uint8 *Actual = (uint8 *)LinuxAllocateMemory(MaxPitch*Height);
+
+    memory_index TileMemorySize = Megabytes(4);
+    void *TileMemory = LinuxAllocateMemory(TileMemorySize);
+
+    bool32 Result = true;
+    for(int TileIndex = 0; TileIndex < ArrayCount(TileSizes); ++TileIndex)
+    {
+        memory_arena TileArena;
+        InitializeArena(&TileArena, TileMemorySize, TileMemory);
+        tiled_background Background;
+        InitializeTiledBackground(&Background, &TileArena, TileSizes[TileIndex][0], TileSizes[TileIndex][1]);
+        DrawGradientBackground(&Background, Format);
+
+        for(int WidthIndex = 0; WidthIndex < ArrayCount(Widths); ++WidthIndex)
+        {
+            for(int PaddingIndex = 0; PaddingIndex < ArrayCount(PitchPaddings); ++PaddingIndex)
+            {
+                for(int OffsetIndex = 0; OffsetIndex < ArrayCount(Offsets); ++OffsetIndex)
+                {
+                    for(int Clipped = 0; Clipped < 2; ++Clipped)
+                    {
+                        game_offscreen_buffer Buffer = {};
+                        Buffer.Format = Format;
+                        Buffer.Width = Widths[WidthIndex];
+                        Buffer.Height = Height;
+                        Buffer.Pitch = Buffer.Width*GetBytesPerPixel(Format) + PitchPaddings[PaddingIndex];
+                        int XOffset = Offsets[OffsetIndex];
+                        int YOffset = -Offsets[OffsetIndex]/2;
+                        int Size = Buffer.Pitch*Buffer.Height;
+
+                        rectangle2i ClipRect = RectangleFromBuffer(&Buffer);
+                        if(Clipped)
+                        {
+                            ClipRect.MinX = Buffer.Width/3;
+                            ClipRect.MinY = 7;
+                            ClipRect.MaxX = Buffer.Width - Buffer.Width/5;
+                            ClipRect.MaxY = Buffer.Height - 11;
+                        }
+
+                        memset(Expected, 0xCD, Size);
+                        memset(Actual, 0xCD, Size);
+
+                        //The gradient has no clipping of its own, so it is drawn into a buffer that is just the clip
+                        //rectangle, the way RenderGroupToOutput does
+                        game_offscreen_buffer ClipBuffer = Buffer;
+                        ClipBuffer.Memory = Expected + ClipRect.MinX*GetBytesPerPixel(Format) + ClipRect.MinY*Buffer.Pitch;
+                        ClipBuffer.Width = ClipRect.MaxX - ClipRect.MinX;
+                        ClipBuffer.Height = ClipRect.MaxY - ClipRect.MinY;
+                        RenderWeirdGradient(&ClipBuffer, XOffset + ClipRect.MinX, YOffset + ClipRect.MinY);
+
+                        Buffer.Memory = Actual;
+                        DrawTiledBackground(&Buffer, &Background, XOffset, YOffset, ClipRect);
+
+                        if(memcmp(Expected, Actual, Size) != 0)
+                        {
+                            fprintf(stderr, "%s gradient copied from a %dx%d tile differs: width %d, pitch %d, offset %d%s\n",
+                                    PixelFormatNames[Format], Background.Width, Background.Height, Buffer.Width, Buffer.Pitch,
+                                    XOffset, Clipped ? ", clipped" : "");
+                            Result = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    munmap(Expected, MaxPitch*Height);
+    munmap(Actual, MaxPitch*Height);
+    munmap(TileMemory, TileMemorySize);
+
+    return(Result);
+}
+
+//Draws the same rectangles, bitmaps and quads with the scalar path and the path being checked, into buffers with
+//awkward sizes and pitches, with everything partly or wholly clipped somewhere. Canary bytes as for the gradient.
+internal bool32 LinuxVerifyRenderLevel(simd_level Level, pixel_format Format, loaded_bitmap *Sprite)
+{
+    int Widths[] = {1, 5, 8, 13, 33, 100};
+    int PitchPaddings[] = {0, 4, 12};
+    int Height = 37;
+
+    int MaxPitch = (100 + 12/4)*4;
+    uint8 *Expected = (uint8 *)LinuxAllocateMemory(MaxPitch*Height);
+    uint8 *Actual = (uint8 *)LinuxAllocateMemory(MaxPitch*Height);
+
+    bool32 Result = true;
+    for(int WidthIndex = 0; WidthIndex < ArrayCount(Widths); ++WidthIndex)
+    {
+        for(int PaddingIndex = 0; PaddingIndex < ArrayCount(PitchPaddings); ++PaddingIndex)
+        {
+            game_offscreen_buffer Buffer = {};
+            Buffer.Format = Format;
+            Buffer.Width = Widths[WidthIndex];
+            Buffer.Height = Height;
+            Buffer.Pitch = Buffer.Width*GetBytesPerPixel(Format) + PitchPaddings[PaddingIndex];
+            int Size = Buffer.Pitch*Buffer.Height;
+
+            memset(Expected, 0xCD, Size);
+            memset(Actual, 0xCD, Size);
+
+            //Every other buffer is drawn through a clip rectangle a little inside it
+            rectangle2i ClipRect = RectangleFromBuffer(&Buffer);
+            if(PaddingIndex & 1)
+            {
+                ClipRect.MinX += 1;
+                ClipRect.MinY += 2;
+                ClipRect.MaxX -= 1;
+                ClipRect.MaxY -= 5;
+            }
+
+            for(int Pass = 0; Pass < 2; ++Pass)
+            {
+                Buffer.Memory = Pass ? Actual : Expected;
+                GameSelectSIMDLevel(Pass ? Level : SIMDLevel_Scalar);
+
+                //Opaque background, so the canary only survives in the padding
+                DrawRectangle(&Buffer, V2(-10.0f, -10.0f), V2(1000.0f, 1000.0f), V4(0.2f, 0.4f, 0.6f, 1.0f), ClipRect);
+                for(int Step = 0; Step < 24; ++Step)
+                {
+                    float32 X = -40.0f + 7.3f*Step;
+                    float32 Y = -30.0f + 3.1f*Step;
+                    float32 Alpha = (float32)(Step % 5) / 4.0f;
+                    DrawRectangle(&Buffer, V2(X, Y), V2(X + 11.7f + Step, Y + 9.2f), V4(0.7f*Alpha, 0.1f*Alpha, 0.9f*Alpha, Alpha), ClipRect);
+                    DrawBitmap(&Buffer, Sprite, V2(X*0.5f, Y*0.7f), ClipRect);
+
+                    float32 Angle = 0.37f*Step;
+                    v2 XAxis = (12.0f + 3.0f*Step)*V2(cosf(Angle), sinf(Angle));
+                    DrawTexturedQuad(&Buffer, V2(X + 0.3f, Y + 0.6f), XAxis, 0.8f*Perp(XAxis),
+                                     V4(0.9f, 0.8f, 0.7f, 0.9f), Sprite, ClipRect);
+                }
+            }
+
+            if(memcmp(Expected, Actual, Size) != 0)
+            {
+                fprintf(stderr, "%s %s rendering differs from scalar: width %d, pitch %d\n",
+                        SIMDLevelNames[Level], PixelFormatNames[Format], Buffer.Width, Buffer.Pitch);
+                Result = false;
+            }
+        }
+    }
+
+    munmap(Expected, MaxPitch*Height);
+    munmap(Actual, MaxPitch*Height);
+
+    return(Result);
+}
+
+//Every byte through SRGBToLinear15 and back is itself again, and a linear blend of one translucent pixel over
+//another comes out within a byte of the same blend done in floats
+internal bool32 LinuxVerifyLinearBlending(void)
+{
+    GameSelectBlendSpace(BlendSpace_Linear);
+    GameSelectSIMDLevel(SIMDLevel_Scalar);
+
+    bool32 Result = true;
+    for(uint32 Byte = 0; Byte < 256; ++Byte)
+    {
+        uint32 Pixel = Byte*0x01010101;
+        uint16 Linear[4];
+        LinearFromDest(Pixel, Linear);
+        if(SRGBFromLinear(Linear) != Pixel)
+        {
+            fprintf(stderr, "byte %u does not survive going to linear and back\n", Byte);
+            Result = false;
+        }
+    }
+
+    int MaxError = 0;
+    for(uint32 DestByte = 0; DestByte < 256; DestByte += 15)
+    {
+        for(uint32 ColorByte = 0; ColorByte < 256; ColorByte += 17)
+        {
+            for(uint32 Alpha = 1; Alpha < 256; Alpha += 10)
+            {
+                uint32 Dest = 0xFF000000 | DestByte*0x010101;
+                uint32 Premultiplied = Div255(ColorByte*Alpha);
+                uint32 Source = (Alpha << 24) | Premultiplied*0x010101;
+                DrawSpanLinear<pixel_format_bgrx8888>(&Dest, &Source, 0, 1);
+
+                float32 Coverage = Alpha / 255.0f;
+                float32 Color = ((float32)Premultiplied / Coverage) / 255.0f;
+                Color = (Color > 1.0f) ? 1.0f : Color;
+                float32 Linear = SRGBToLinear(Color)*Coverage + SRGBToLinear(DestByte / 255.0f)*(1.0f - Coverage);
+                int Expected = (int)(LinearToSRGB(Linear)*255.0f + 0.5f);
+                int Error = abs((int)(Dest & 0xFF) - Expected);
+                MaxError = (Error > MaxError) ? Error : MaxError;
+            }
+        }
+    }
+    if(MaxError > 1)
+    {
+        fprintf(stderr, "linear blending is %d away from the float reference\n", MaxError);
+        Result = false;
+    }
+
+    //A big enough rectangle goes through a table instead of DrawSpanLinear, which has to write the same bytes
+    uint32 TablePixels[96*64];
+    uint32 SpanPixels[96*64];
+    for(int Index = 0; Index < ArrayCount(TablePixels); ++Index)
+    {
+        TablePixels[Index] = SpanPixels[Index] = (uint32)Index*2654435761u;
+    }
+    game_offscreen_buffer Buffer = {};
+    Buffer.Format = PixelFormat_BGRX8888;
+    Buffer.Width = 96;
+    Buffer.Height = 64;
+    Buffer.Pitch = Buffer.Width*4;
+    Buffer.Memory = TablePixels;
+    v4 Color = V4(0.3f*0.6f, 0.1f*0.6f, 0.5f*0.6f, 0.6f);
+    DrawRectangle(&Buffer, V2(0.0f, 0.0f), V2(96.0f, 64.0f), Color, RectangleFromBuffer(&Buffer));
+    for(int Y = 0; Y < Buffer.Height; ++Y)
+    {
+        DrawSpanLinear<pixel_format_bgrx8888>(SpanPixels + Y*Buffer.Width, 0, PackColor(Color), Buffer.Width);
+    }
+    if(memcmp(TablePixels, SpanPixels, sizeof(TablePixels)) != 0)
+    {
+        fprintf(stderr, "a linear rectangle's table differs from blending it pixel by pixel\n");
+        Result = false;
+    }
+
+    //An untinted quad lined up with the pixels samples every texel exactly, so it has to blend like the bitmap itself
+    uint32 TexturePixels[16*16];
+    for(int Index = 0; Index < ArrayCount(TexturePixels); ++Index)
+    {
+        uint32 Alpha = ((uint32)Index*37) & 0xFF;
+        uint32 Color = (uint32)Index*2246822519u;
+        TexturePixels[Index] = (Alpha << 24) | (Div255(((Color >> 16) & 0xFF)*Alpha) << 16) |
+                               (Div255(((Color >> 8) & 0xFF)*Alpha) << 8) | Div255((Color & 0xFF)*Alpha);
+    }
+    loaded_bitmap Texture = {16, 16, 16*4, TexturePixels};
+    for(int Index = 0; Index < ArrayCount(TablePixels); ++Index)
+    {
+        TablePixels[Index] = SpanPixels[Index] = (uint32)Index*2654435761u;
+    }
+    Buffer.Memory = TablePixels;
+    DrawTexturedQuad(&Buffer, V2(40.0f, 24.0f), V2(16.0f, 0.0f), V2(0.0f, 16.0f), V4(1.0f, 1.0f, 1.0f, 1.0f), &Texture,
+                     RectangleFromBuffer(&Buffer));
+    Buffer.Memory = SpanPixels;
+    DrawBitmap(&Buffer, &Texture, V2(40.0f, 24.0f), RectangleFromBuffer(&Buffer));
+    if(memcmp(TablePixels, SpanPixels, sizeof(TablePixels)) != 0)
+    {
+        fprintf(stderr, "a linear textured quad differs from blending its texture as a bitmap\n");
+        Result = false;
+    }
+
+    GameSelectBlendSpace(BlendSpace_SRGB);
+    return(Result);
+}
+
+//Deterministic positions, so every SIMD level and thread count draws exactly the same things
+internal float32 LinuxRandomUnilateral(uint32 *Series)
+{
+    *Series = *Series*1664525 + 1013904223;
+    float32 Result = (float32)(*Series >> 8) / 16777216.0f;
+    return(Result);
+}
+
+global_variable uint8 GlobalTestTiles[48*32];
+
+//A frame like the game's but busier: the gradient, translucent panels, and sprites as bitmaps and as rotated quads,
+//some of them hanging off the edges
+internal void LinuxPushTestScene(render_group *Group, loaded_bitmap *Sprite, int Width, int Height, int SpriteCount, uint32 Seed)
+{
+    uint32 Series = Seed;
+    PushGradient(Group, (int)Seed, -(int)Seed/2);
+
+    //A grid of walls with holes in it, bigger than the smallest buffers and hanging off their top left
+    for(int TileIndex = 0; TileIndex < ArrayCount(GlobalTestTiles); ++TileIndex)
+    {
+        GlobalTestTiles[TileIndex] = (uint8)((LinuxRandomUnilateral(&Series) < 0.4f) ? 0 : 1 + TileIndex % (WORLD_TILE_VALUE_COUNT - 1));
+    }
+    PushTileGrid(Group, GlobalTestTiles, 48, 32, 27, -13, -21, WorldTileColors);
+    for(int PanelIndex = 0; PanelIndex < 3; ++PanelIndex)
+    {
+        float32 Alpha = 0.25f*(PanelIndex + 1);
+        v2 Min = V2(LinuxRandomUnilateral(&Series)*Width - 100.0f, LinuxRandomUnilateral(&Series)*Height - 100.0f);
+        PushRectangle(Group, Min, Min + V2(0.6f*Width, 0.3f*Height), V4(0.3f*Alpha, 0.0f, 0.6f*Alpha, Alpha));
+    }
+    for(int SpriteIndex = 0; SpriteIndex < SpriteCount; ++SpriteIndex)
+    {
+        v2 Position = V2(LinuxRandomUnilateral(&Series)*(Width + 64) - 64.0f, LinuxRandomUnilateral(&Series)*(Height + 64) - 64.0f);
+        if(SpriteIndex % 4)
+        {
+            PushBitmap(Group, Sprite, Position);
+        }
+        else
+        {
+            float32 Angle = 2.0f*Pi32*LinuxRandomUnilateral(&Series);
+            v2 XAxis = (48.0f + 64.0f*LinuxRandomUnilateral(&Series))*V2(cosf(Angle), sinf(Angle));
+            PushTexturedQuad(Group, Position, XAxis, Perp(XAxis), V4(0.9f, 0.9f, 0.9f, 0.9f), Sprite);
+        }
+    }
+}
+
+//Sets tiles all over the world, near the origin, either side of chunk edges and out at the ends of int32, and checks
+//they read back, that their neighbours (none of them at 7 in their chunk) are still empty, that reading made no chunks, and that there are only as many chunks as were set. Then culls
+//from cameras all over and checks that the chunks pushed are exactly the populated ones the screen overlaps.
+internal bool32 LinuxVerifyWorld(void)
+{
+    memory_index ArenaSize = Megabytes(4);
+    memory_arena Arena;
+    InitializeArena(&Arena, ArenaSize, LinuxAllocateMemory(ArenaSize));
+    world *World = PushStruct(&Arena, world);
+    InitializeWorld(World);
+    memory_index UsedBeforeChunks = Arena.Used;
+
+    int32 Coordinates[] = {0, 1, -1, 15, 16, -16, -17, 1000003, -1000003, 0x7FFFFFFF, (int32)0x80000000};
+    bool32 Result = true;
+    for(int Pass = 0; Pass < 2; ++Pass)
+    {
+        for(int IndexY = 0; IndexY < ArrayCount(Coordinates); ++IndexY)
+        {
+            for(int IndexX = 0; IndexX < ArrayCount(Coordinates); ++IndexX)
+            {
+                int32 TileX = Coordinates[IndexX];
+                int32 TileY = Coordinates[IndexY];
+                uint8 Value = (uint8)(1 + (IndexX + IndexY) % (WORLD_TILE_VALUE_COUNT - 1));
+                if(Pass == 0)
+                {
+                    SetTileValue(World, &Arena, TileX, TileY, Value);
+                }
+                else if((GetTileValue(World, TileX, TileY) != Value) ||
+                        (GetTileValue(World, (TileX & ~WORLD_CHUNK_MASK) | 7, TileY) != 0))
+                {
+                    fprintf(stderr, "World tile %d, %d doesn't read back\n", TileX, TileY);
+                    Result = false;
+                }
+            }
+        }
+    }
+
+    //0, 1 and 15 share a chunk, and so do -1 and -16, so 8 chunks a row. Chunks are a multiple of the arena's
+    //alignment, so apart from lining up the first one they take exactly their size.
+    uint32 ExpectedChunkCount = 8*8;
+    memory_index ChunkBytes = Arena.Used - UsedBeforeChunks;
+    if((World->ChunkCount != ExpectedChunkCount) || (ChunkBytes < ExpectedChunkCount*sizeof(world_chunk)) ||
+       (ChunkBytes >= ExpectedChunkCount*sizeof(world_chunk) + 16))
+    {
+        fprintf(stderr, "World has %u chunks in %llu bytes, expected %u\n", World->ChunkCount,
+                (unsigned long long)ChunkBytes, ExpectedChunkCount);
+        Result = false;
+    }
+
+    GenerateTestWorld(World, &Arena);
+    render_group *Group = AllocateRenderGroup(&Arena, Kilobytes(64));
+    int32 ChunkSide = WORLD_CHUNK_DIM*WORLD_TILE_SIDE_IN_PIXELS;
+    int32 CameraXs[] = {0, -1, -ChunkSide, 12345, -3000, ChunkSide*100000 - 7, 0x7FFFFFFF - 4000, (int32)0x80000000};
+    int32 CameraYs[] = {0, -1, 511, -1700, ChunkSide*50000 + 300, (int32)0x80000000};
+    for(int CameraIndexY = 0; CameraIndexY < ArrayCount(CameraYs); ++CameraIndexY)
+    {
+        for(int CameraIndexX = 0; CameraIndexX < ArrayCount(CameraXs); ++CameraIndexX)
+        {
+            int32 CameraX = CameraXs[CameraIndexX];
+            int32 CameraY = CameraYs[CameraIndexY];
+            int32 Width = 1920;
+            int32 Height = 1080;
+
+            //Every chunk there is, against the screen, the slow way
+            uint32 ExpectedCount = 0;
+            for(uint32 HashIndex = 0; HashIndex < WORLD_CHUNK_HASH_COUNT; ++HashIndex)
+            {
+                for(world_chunk *Chunk = World->ChunkHash[HashIndex]; Chunk; Chunk = Chunk->NextInHash)
+                {
+                    int64 MinX = (int64)Chunk->ChunkX*ChunkSide - CameraX;
+                    int64 MinY = (int64)Chunk->ChunkY*ChunkSide - CameraY;
+                    if((MinX < Width) && (MinX + ChunkSide > 0) && (MinY < Height) && (MinY + ChunkSide > 0))
+                    {
+                        ++ExpectedCount;
+                    }
+                }
+            }
+
+            Group->PushBufferSize = 0;
+            uint32 Count = PushVisibleChunks(Group, World, CameraX, CameraY, Width, Height);
+            bool32 AllOnScreen = true;
+            for(memory_index BaseAddress = 0; BaseAddress < Group->PushBufferSize;)
+            {
+                render_entry_tile_grid *Grid = (render_entry_tile_grid *)(Group->PushBufferBase + BaseAddress + sizeof(render_entry_header));
+                AllOnScreen = AllOnScreen && (Grid->MinX < Width) && (Grid->MinX + ChunkSide > 0) &&
+                              (Grid->MinY < Height) && (Grid->MinY + ChunkSide > 0);
+                BaseAddress += sizeof(render_entry_header) + sizeof(render_entry_tile_grid);
+            }
+
+            if((Count != ExpectedCount) || !AllOnScreen)
+            {
+                fprintf(stderr, "World camera at %d, %d pushed %u chunks, %u are on screen\n", CameraX, CameraY, Count, ExpectedCount);
+                Result = false;
+            }
+        }
+    }
+
+    munmap(Arena.Base, ArenaSize);
+
+    return(Result);
+}
+
+//Draws the test scene in one go on this thread, then tiled on the work queue, and checks they are byte for byte the same
+internal bool32 LinuxVerifyTiledRendering(linux_work_queue *WorkQueue, pixel_format Format, loaded_bitmap *Sprite)
+{
+    int Widths[] = {257, 1280, 1920};
+    int Heights[] = {65, 720, 1080};
+    int PitchPadding = 12;
+
+    int MaxPitch = 1920*4 + PitchPadding;
+    int MaxSize = MaxPitch*1080;
+    uint8 *Expected = (uint8 *)LinuxAllocateMemory(MaxSize);
+    uint8 *Actual = (uint8 *)LinuxAllocateMemory(MaxSize);
+
+    uint64 GroupMemorySize = Megabytes(1);
+    memory_arena GroupArena;
+    InitializeArena(&GroupArena, GroupMemorySize, LinuxAllocateMemory(GroupMemorySize));
+    render_group *Group = AllocateRenderGroup(&GroupArena, Kilobytes(256));
+
+    platform_api Platform = {LinuxAddEntry, LinuxCompleteAllWork};
+
+    bool32 Result = true;
+    for(int SizeIndex = 0; SizeIndex < ArrayCount(Widths); ++SizeIndex)
+    {
+        game_offscreen_buffer Buffer = {};
+        Buffer.Format = Format;
+        Buffer.Width = Widths[SizeIndex];
+        Buffer.Height = Heights[SizeIndex];
+        Buffer.Pitch = Buffer.Width*GetBytesPerPixel(Format) + PitchPadding;
+        int Size = Buffer.Pitch*Buffer.Height;
+
+        memset(Expected, 0xCD, Size);
+        memset(Actual, 0xCD, Size);
+
+        Group->PushBufferSize = 0;
+        LinuxPushTestScene(Group, Sprite, Buffer.Width, Buffer.Height, 200, 77 + SizeIndex);
+
+        Buffer.Memory = Expected;
+        RenderGroupToOutput(Group, &Buffer, RectangleFromBuffer(&Buffer));
+
+        Buffer.Memory = Actual;
+        TiledRenderGroupToOutput(WorkQueue->Queue, &Platform, Group, &Buffer);
+
+        if(memcmp(Expected, Actual, Size) != 0)
+        {
+            fprintf(stderr, "Tiled %s rendering on %u threads differs: %dx%d\n", PixelFormatNames[Format], WorkQueue->ThreadCount,
+                    Buffer.Width, Buffer.Height);
+            Result = false;
+        }
+    }
+
+    munmap(Expected, MaxSize);
+    munmap(Actual, MaxSize);
+    munmap(GroupArena.Base, GroupMemorySize);
+
+    return(Result);
+}
+
+//Any picture will do for scaling, as long as neighbouring pixels differ in every channel
+internal void LinuxFillNoise(game_offscreen_buffer *Buffer, uint32 Seed)
+{
+    uint32 Series = Seed;
+    for(int Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32 *Pixel = (uint32 *)((uint8 *)Buffer->Memory + (memory_index)Y*Buffer->Pitch);
+        for(int X = 0; X < Buffer->Width; ++X)
+        {
+            Series = Series*1664525 + 1013904223;
+            *Pixel++ = Series ^ (Series >> 13);
+        }
+    }
+}
+
+//Presents the same frame with scalar and the path being checked into window sizes that hit the integer path, the
+//bilinear path up and down, bars on either side and row tails of every length, into buffers with pitch padding
+internal bool32 LinuxVerifyPresentLevel(simd_level Level)
+{
+    int DestSizes[][2] = {{1280, 720}, {2560, 1440}, {3840, 2160}, {1920, 1080}, {1000, 1000}, {3440, 1440},
+                          {641, 481}, {333, 187}, {7, 5}, {1283, 722}};
+    int PitchPadding = 12;
+
+    game_offscreen_buffer Source = {};
+    Source.Width = 1280;
+    Source.Height = 720;
+    Source.Pitch = Source.Width*4 + PitchPadding;
+    Source.Memory = LinuxAllocateMemory((memory_index)Source.Pitch*Source.Height);
+    LinuxFillNoise(&Source, 1234);
+
+    memory_index MaxSize = (memory_index)(3840*4 + PitchPadding)*2160;
+    uint8 *Expected = (uint8 *)LinuxAllocateMemory(MaxSize);
+    uint8 *Actual = (uint8 *)LinuxAllocateMemory(MaxSize);
+    present_scaler *Scaler = (present_scaler *)LinuxAllocateMemory(sizeof(present_scaler));
+
+    bool32 Result = true;
+    for(int SizeIndex = 0; SizeIndex < ArrayCount(DestSizes); ++SizeIndex)
+    {
+        game_offscreen_buffer Dest = {};
+        Dest.Width = DestSizes[SizeIndex][0];
+        Dest.Height = DestSizes[SizeIndex][1];
+        Dest.Pitch = Dest.Width*4 + PitchPadding;
+        memory_index Size = (memory_index)Dest.Pitch*Dest.Height;
+
+        for(int Pass = 0; Pass < 2; ++Pass)
+        {
+            Dest.Memory = Pass ? Actual : Expected;
+            memset(Dest.Memory, 0xCD, Size);
+            GameSelectSIMDLevel(Pass ? Level : SIMDLevel_Scalar);
+            PresentScaled(Scaler, &Source, &Dest);
+        }
+
+        //Scalar must not have touched the padding either
+        bool32 PaddingIntact = true;
+        for(int Y = 0; Y < Dest.Height; ++Y)
+        {
+            uint8 *Padding = Expected + (memory_index)Y*Dest.Pitch + Dest.Width*4;
+            for(int Byte = 0; Byte < PitchPadding; ++Byte)
+            {
+                PaddingIntact = PaddingIntact && (Padding[Byte] == 0xCD);
+            }
+        }
+
+        if(!PaddingIntact || (memcmp(Expected, Actual, Size) != 0))
+        {
+            present_layout Layout = ComputePresentLayout(Source.Width, Source.Height, Dest.Width, Dest.Height);
+            fprintf(stderr, "%s presenting differs from scalar: %dx%d (%s)\n", SIMDLevelNames[Level], Dest.Width, Dest.Height,
+                    Layout.IntegerScale ? "integer" : "bilinear");
+            Result = false;
+        }
+    }
+
+    munmap(Source.Memory, (memory_index)Source.Pitch*Source.Height);
+    munmap(Expected, MaxSize);
+    munmap(Actual, MaxSize);
+    munmap(Scaler, sizeof(present_scaler));
+
+    return(Result);
+}
+
+//The GameOutputSound loop from before the oscillator bank, kept here as the baseline to beat
+internal void LinuxReferenceSineLoop(float32 *tSine, int SamplesPerSecond, int ToneHz, int SampleCount, int16 *Samples)
+{
+    int16 ToneVolume = 3000;
+    int WavePeriod = SamplesPerSecond/ToneHz;
+
+    int16 *SampleOut = Samples;
+    for(int i = 0; i < SampleCount; ++i)
+    {
+        float32 SineValue = sinf(*tSine);
+        int16 SampleValue = (int16)(SineValue * ToneVolume);
+        *SampleOut++ = SampleValue;
+        *SampleOut++ = SampleValue;
+
+        *tSine += 2.0f * Pi32 * 1.0f / (float32)WavePeriod;
+    }
+}
+
+//Mixes BlockCount blocks of VoiceCount looping sounds at assorted pitches and pans, the same set every time for a given
+//seed, and returns the seconds it took. The int16 output of the last block is left in Samples.
+internal float64 LinuxRunMixerBenchmark(loaded_sound *Sounds, int SoundCount, int VoiceCount, int BlockSize, int BlockCount,
+                                        memory_arena *Arena, int16 *Samples)
+{
+    temporary_memory BenchMemory = BeginTemporaryMemory(Arena);
+
+    audio_state AudioState = {};
+    InitializeAudioState(&AudioState, Arena);
+    float32 *Channel0 = PushArray(Arena, BlockSize, float32);
+    float32 *Channel1 = PushArray(Arena, BlockSize, float32);
+
+    uint32 Random = 12345;
+    for(int VoiceIndex = 0; VoiceIndex < VoiceCount; ++VoiceIndex)
+    {
+        playing_sound *PlayingSound = PlaySound(&AudioState, Sounds + (VoiceIndex % SoundCount), true);
+        Random = XorShift32(Random);
+        float32 Pitch = 0.5f + 1.5f*(float32)(Random & 0xFFFF) / 65535.0f;
+        Random = XorShift32(Random);
+        float32 Pan = -1.0f + 2.0f*(float32)(Random & 0xFFFF) / 65535.0f;
+        ChangePitch(PlayingSound, Pitch);
+        ChangeVolume(PlayingSound, 4.0f / VoiceCount, Pan);
+    }
+
+    int64 StartNanoseconds = LinuxGetNanoseconds();
+    for(int BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+    {
+        memset(Channel0, 0, BlockSize*sizeof(float32));
+        memset(Channel1, 0, BlockSize*sizeof(float32));
+        MixPlayingSounds(&AudioState, BlockSize, Channel0, Channel1);
+        ConvertChannelsToInt16(BlockSize, Channel0, Channel1, Samples);
+    }
+    float64 Result = (float64)(LinuxGetNanoseconds() - StartNanoseconds) / 1.0e9;
+
+    EndTemporaryMemory(BenchMemory);
+    return(Result);
+}
+
+internal int LinuxRunAudioBenchmark(linux_benchmark_settings *Settings)
+{
+    int SamplesPerSecond = Settings->SamplesPerSecond;
+    int BlockSize = SamplesPerSecond / Settings->GameUpdateHz;
+    int BlockCount = 2000;
+    float64 SampleCount = (float64)BlockSize*(float64)BlockCount;
+
+    int16 *Samples = (int16 *)LinuxAllocateMemory(BlockSize*2*sizeof(int16));
+    float32 *Mix = (float32 *)LinuxAllocateMemory(BlockSize*sizeof(float32));
+    oscillator_bank *Bank = (oscillator_bank *)LinuxAllocateMemory(sizeof(oscillator_bank));
+
+    printf("Audio: %d Hz, %d samples per block, %d blocks\n", SamplesPerSecond, BlockSize, BlockCount);
+
+    float32 tSine = 0.0f;
+    int64 StartNanoseconds = LinuxGetNanoseconds();
+    for(int BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+    {
+        LinuxReferenceSineLoop(&tSine, SamplesPerSecond, Settings->ToneHz, BlockSize, Samples);
+    }
+    float64 Seconds = (float64)(LinuxGetNanoseconds() - StartNanoseconds) / 1.0e9;
+    printf("  sinf loop            1 voice : %8.1f Msamples/s\n", SampleCount / Seconds / 1.0e6);
+
+    simd_level Supported = GameSelectSIMDLevel(SIMDLevel_Auto);
+    int VoiceCounts[] = {1, 16, 64};
+    for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+    {
+        GameSelectSIMDLevel((simd_level)Level);
+        for(int CountIndex = 0; CountIndex < ArrayCount(VoiceCounts); ++CountIndex)
+        {
+            int VoiceCount = VoiceCounts[CountIndex];
+            Bank->VoiceCount = 0;
+            for(int VoiceIndex = 0; VoiceIndex < VoiceCount; ++VoiceIndex)
+            {
+                AddOscillator(Bank, Waveform_Sine, (float32)(Settings->ToneHz + 7*VoiceIndex), 3000.0f / VoiceCount, SamplesPerSecond);
+            }
+
+            StartNanoseconds = LinuxGetNanoseconds();
+            for(int BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+            {
+                memset(Mix, 0, BlockSize*sizeof(float32));
+                RenderOscillatorBank(Bank, BlockSize, Mix);
+            }
+            Seconds = (float64)(LinuxGetNanoseconds() - StartNanoseconds) / 1.0e9;
+            printf("  oscillators %-6s %2d voices: %8.1f Msamples/s  (%.1f Mvoice-samples/s, %.1f us per block)\n",
+                   SIMDLevelNames[Level], VoiceCount, SampleCount / Seconds / 1.0e6,
+                   SampleCount*VoiceCount / Seconds / 1.0e6, Seconds*1.0e6 / BlockCount);
+        }
+
+        //Accuracy of the sine against the real thing, over every part of the cycle
+        Bank->VoiceCount = 0;
+        oscillator *Probe = AddOscillator(Bank, Waveform_Sine, 1.0f, 1.0f, SamplesPerSecond);
+        Probe->PhaseIncrement = 0x00010003;
+        float64 MaxError = 0.0;
+        uint32 Phase = 0;
+        for(int BlockIndex = 0; BlockIndex < 128; ++BlockIndex)
+        {
+            memset(Mix, 0, BlockSize*sizeof(float32));
+            RenderOscillatorBank(Bank, BlockSize, Mix);
+            for(int SampleIndex = 0; SampleIndex < BlockSize; ++SampleIndex)
+            {
+                float64 Error = fabs(Mix[SampleIndex] - sin(2.0*3.14159265358979323846*(float64)Phase / 4294967296.0));
+                MaxError = (Error > MaxError) ? Error : MaxError;
+                Phase += Probe->PhaseIncrement;
+            }
+        }
+        printf("  oscillators %-6s sine max error %.2e (one int16 step is %.2e)\n", SIMDLevelNames[Level], MaxError, 1.0 / 32767.0);
+    }
+
+    //Mixer: a few seconds-long test sounds, mono and stereo, played by hundreds of voices at once
+    uint64 MixerMemorySize = Megabytes(16);
+    memory_arena MixerArena;
+    InitializeArena(&MixerArena, MixerMemorySize, LinuxAllocateMemory(MixerMemorySize));
+
+    loaded_sound TestSounds[4];
+    for(int SoundIndex = 0; SoundIndex < ArrayCount(TestSounds); ++SoundIndex)
+    {
+        loaded_sound *Sound = TestSounds + SoundIndex;
+        Sound->SampleCount = SamplesPerSecond + 1000*SoundIndex;
+        Sound->ChannelCount = 1 + (SoundIndex & 1);
+        Sound->Samples = PushArray(&MixerArena, (Sound->SampleCount + 1)*Sound->ChannelCount, int16);
+        for(int SampleIndex = 0; SampleIndex < Sound->SampleCount*Sound->ChannelCount; ++SampleIndex)
+        {
+            Sound->Samples[SampleIndex] = (int16)(8000.0f*sinf(0.01f*(SoundIndex + 1)*SampleIndex));
+        }
+        Sound->Samples[Sound->SampleCount*Sound->ChannelCount] = 0;
+        if(Sound->ChannelCount == 2)
+        {
+            Sound->Samples[Sound->SampleCount*Sound->ChannelCount + 1] = 0;
+        }
+    }
+
+    int16 *ScalarSamples = PushArray(&MixerArena, BlockSize*2, int16);
+    int MixerVoiceCounts[] = {100, 300, 1000};
+    int MixerBlockCount = 300;
+    bool32 MixerMatches = true;
+    for(int CountIndex = 0; CountIndex < ArrayCount(MixerVoiceCounts); ++CountIndex)
+    {
+        int VoiceCount = MixerVoiceCounts[CountIndex];
+        GameSelectSIMDLevel(SIMDLevel_Scalar);
+        LinuxRunMixerBenchmark(TestSounds, ArrayCount(TestSounds), VoiceCount, BlockSize, 4, &MixerArena, ScalarSamples);
+
+        for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+        {
+            GameSelectSIMDLevel((simd_level)Level);
+            Seconds = LinuxRunMixerBenchmark(TestSounds, ArrayCount(TestSounds), VoiceCount, BlockSize, MixerBlockCount, &MixerArena, Samples);
+            LinuxRunMixerBenchmark(TestSounds, ArrayCount(TestSounds), VoiceCount, BlockSize, 4, &MixerArena, Samples);
+
+            int MaxDifference = 0;
+            for(int SampleIndex = 0; SampleIndex < BlockSize*2; ++SampleIndex)
+            {
+                int Difference = abs(Samples[SampleIndex] - ScalarSamples[SampleIndex]);
+                MaxDifference = (Difference > MaxDifference) ? Difference : MaxDifference;
+            }
+            MixerMatches = MixerMatches && (MaxDifference <= 1);
+
+            printf("  mixer %-6s %4d voices: %.3f ms per %d sample block  (%.1f Mvoice-samples/s, max difference from scalar %d)\n",
+                   SIMDLevelNames[Level], VoiceCount, Seconds*1.0e3 / MixerBlockCount, BlockSize,
+                   (float64)VoiceCount*BlockSize*MixerBlockCount / Seconds / 1.0e6, MaxDifference);
+        }
+    }
+
+    /*
+        Drift: play one tone for hours of simulated time through the real render path, then check that
+        - the phase is exactly N*PhaseIncrement (nothing lost to rounding along the way),
+        - the tone is still within a fraction of a millihertz of the requested frequency,
+        - the samples coming out at the end still match a sine at the exact phase.
+        The old float32 accumulator is stepped for the same time to show what it did.
+    */
+    GameSelectSIMDLevel(SIMDLevel_Auto);
+    uint64 DriftSampleCount = (uint64)Settings->DriftHours*3600*SamplesPerSecond;
+    Bank->VoiceCount = 0;
+    oscillator *Tone = AddOscillator(Bank, Waveform_Sine, (float32)Settings->ToneHz, 1.0f, SamplesPerSecond);
+
+    StartNanoseconds = LinuxGetNanoseconds();
+    uint64 Rendered = 0;
+    while(Rendered < DriftSampleCount)
+    {
+        int Count = ((DriftSampleCount - Rendered) < (uint64)BlockSize) ? (int)(DriftSampleCount - Rendered) : BlockSize;
+        memset(Mix, 0, Count*sizeof(float32));
+        RenderOscillatorBank(Bank, Count, Mix);
+        Rendered += Count;
+    }
+    Seconds = (float64)(LinuxGetNanoseconds() - StartNanoseconds) / 1.0e9;
+
+    uint32 ExpectedPhase = (uint32)((uint64)Tone->PhaseIncrement*DriftSampleCount);
+    float64 ActualHz = (float64)Tone->PhaseIncrement*SamplesPerSecond / 4294967296.0;
+    float64 FrequencyError = fabs(ActualHz - (float64)Settings->ToneHz);
+
+    bool32 PhaseIsExact = (Tone->Phase == ExpectedPhase);
+    uint32 Phase = Tone->Phase;
+    memset(Mix, 0, BlockSize*sizeof(float32));
+    RenderOscillatorBank(Bank, BlockSize, Mix);
+    float64 MaxError = 0.0;
+    for(int SampleIndex = 0; SampleIndex < BlockSize; ++SampleIndex)
+    {
+        float64 Error = fabs(Mix[SampleIndex] - sin(2.0*3.14159265358979323846*(float64)Phase / 4294967296.0));
+        MaxError = (Error > MaxError) ? Error : MaxError;
+        Phase += Tone->PhaseIncrement;
+    }
+
+    //The old accumulator: measure how far it actually moves over the last second of the run
+    float32 OldSine = 0.0f;
+    float32 OldSineStep = 2.0f * Pi32 * 1.0f / (float32)(SamplesPerSecond/Settings->ToneHz);
+    float32 OldSineSecondAgo = 0.0f;
+    for(uint64 SampleIndex = 0; SampleIndex < DriftSampleCount; ++SampleIndex)
+    {
+        if(SampleIndex == DriftSampleCount - SamplesPerSecond)
+        {
+            OldSineSecondAgo = OldSine;
+        }
+        OldSine += OldSineStep;
+    }
+    float64 OldHz = (float64)(OldSine - OldSineSecondAgo) / (2.0*3.14159265358979323846);
+
+    bool32 Passed = MixerMatches && PhaseIsExact && (FrequencyError < 0.001) && (MaxError < 1.0e-4);
+    printf("Drift after %d hours (%llu samples, rendered in %.2f s):\n", Settings->DriftHours, (unsigned long long)DriftSampleCount, Seconds);
+    printf("  phase accumulator: %s, plays %.6f Hz (error %.2e Hz), max sample error at the end %.2e\n",
+           PhaseIsExact ? "exact" : "WRONG", ActualHz, FrequencyError, MaxError);
+    printf("  old float32 tSine: plays %.3f Hz in the last second (asked for %d Hz)\n", OldHz, Settings->ToneHz);
+    printf("  %s\n", Passed ? "no drift" : "DRIFT DETECTED");
+
+    return(Passed ? 0 : 1);
+}
+
+enum full_screen_test
+{
+    FullScreenTest_Gradient,
+    FullScreenTest_TiledBackground,
+    FullScreenTest_BlendedFill,
+    FullScreenTest_Scene,
+};
+
+//Milliseconds per full screen of one of the tests, run for about Seconds
+internal float64 LinuxTimeFullScreenTest(full_screen_test Test, game_offscreen_buffer *Buffer, render_group *Group,
+                                         tiled_background *Background, float64 Seconds)
+{
+    int Count = 0;
+    int64 StartNanoseconds = LinuxGetNanoseconds();
+    int64 EndNanoseconds = StartNanoseconds;
+    while((EndNanoseconds - StartNanoseconds) < (int64)(Seconds*1.0e9))
+    {
+        switch(Test)
+        {
+            case FullScreenTest_Gradient:
+            {
+                RenderWeirdGradient(Buffer, Count, -Count/2);
+            } break;
+
+            case FullScreenTest_TiledBackground:
+            {
+                DrawTiledBackground(Buffer, Background, Count, -Count/2, RectangleFromBuffer(Buffer));
+            } break;
+
+            case FullScreenTest_BlendedFill:
+            {
+                DrawRectangle(Buffer, V2(0.0f, 0.0f), V2((float32)Buffer->Width, (float32)Buffer->Height),
+                              V4(0.1f, 0.2f, 0.3f, 0.5f), RectangleFromBuffer(Buffer));
+            } break;
+
+            case FullScreenTest_Scene:
+            {
+                RenderGroupToOutput(Group, Buffer, RectangleFromBuffer(Buffer));
+            } break;
+        }
+        ++Count;
+        EndNanoseconds = LinuxGetNanoseconds();
+    }
+
+    float64 Result = (float64)(EndNanoseconds - StartNanoseconds) / 1.0e6 / Count;
+    return(Result);
+}
+
+//Throughput of the renderer at 1080p: full screen fills in pixels per second, then 64x64 sprites drawn as bitmaps
+//and as rotated bilinear quads, in sprites per second and how many of them fit in a 60Hz frame
+internal int LinuxRunRenderBenchmark(linux_benchmark_settings *Settings)
+{
+    game_offscreen_buffer Buffer = {};
+    Buffer.Width = 1920;
+    Buffer.Height = 1080;
+    Buffer.Pitch = Buffer.Width*4;
+    Buffer.Memory = LinuxAllocateMemory((memory_index)Buffer.Pitch*Buffer.Height);
+
+    uint64 SpriteMemorySize = Megabytes(1);
+    memory_arena SpriteArena;
+    InitializeArena(&SpriteArena, SpriteMemorySize, LinuxAllocateMemory(SpriteMemorySize));
+    loaded_bitmap Sprite = MakeTestSprite(&SpriteArena, 64, 64);
+
+    float64 PixelCount = (float64)Buffer.Width*Buffer.Height;
+    float64 TestSeconds = 0.25;
+    float64 FrameSeconds = 1.0 / 60.0;
+    printf("Render: %dx%d, 64x64 sprites\n", Buffer.Width, Buffer.Height);
+
+    simd_level Supported = GameSelectSIMDLevel(SIMDLevel_Auto);
+    for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+    {
+        GameSelectSIMDLevel((simd_level)Level);
+
+        //Fills: run each for about TestSeconds, checking the clock once per full screen. The last one blends in linear.
+        const char *FillNames[] = {"opaque ", "blended", "linear "};
+        for(int Fill = 0; Fill < ArrayCount(FillNames); ++Fill)
+        {
+            GameSelectBlendSpace((Fill == 2) ? BlendSpace_Linear : BlendSpace_SRGB);
+            v4 Color = Fill ? V4(0.1f, 0.2f, 0.3f, 0.5f) : V4(0.2f, 0.4f, 0.6f, 1.0f);
+            int FillCount = 0;
+            int64 StartNanoseconds = LinuxGetNanoseconds();
+            int64 EndNanoseconds = StartNanoseconds;
+            while((EndNanoseconds - StartNanoseconds) < (int64)(TestSeconds*1.0e9))
+            {
+                DrawRectangle(&Buffer, V2(0.0f, 0.0f), V2((float32)Buffer.Width, (float32)Buffer.Height), Color, RectangleFromBuffer(&Buffer));
+                ++FillCount;
+                EndNanoseconds = LinuxGetNanoseconds();
+            }
+            float64 Seconds = (float64)(EndNanoseconds - StartNanoseconds) / 1.0e9;
+            printf("  %-6s %s rectangle: %8.1f Mpixels/s  (%.3f ms per full screen)\n", SIMDLevelNames[Level],
+                   FillNames[Fill], PixelCount*FillCount / Seconds / 1.0e6, Seconds*1.0e3 / FillCount);
+        }
+
+        //Sprites, a batch of 256 between clock checks: bitmaps then rotated quads, each blended in sRGB and in linear
+        const char *SpriteNames[] = {"bitmap          ", "bitmap, linear  ", "rotated quad    ", "quad, linear    "};
+        for(int Mode = 0; Mode < ArrayCount(SpriteNames); ++Mode)
+        {
+            GameSelectBlendSpace((Mode & 1) ? BlendSpace_Linear : BlendSpace_SRGB);
+            bool32 Quads = (Mode >= 2);
+            uint32 Series = 1234;
+            int SpriteCount = 0;
+            int64 StartNanoseconds = LinuxGetNanoseconds();
+            int64 EndNanoseconds = StartNanoseconds;
+            while((EndNanoseconds - StartNanoseconds) < (int64)(TestSeconds*1.0e9))
+            {
+                for(int BatchIndex = 0; BatchIndex < 256; ++BatchIndex)
+                {
+                    v2 Position = V2(LinuxRandomUnilateral(&Series)*(Buffer.Width - 64), LinuxRandomUnilateral(&Series)*(Buffer.Height - 64));
+                    if(Quads)
+                    {
+                        float32 Angle = 2.0f*Pi32*LinuxRandomUnilateral(&Series);
+                        v2 XAxis = 64.0f*V2(cosf(Angle), sinf(Angle));
+                        DrawTexturedQuad(&Buffer, Position, XAxis, Perp(XAxis), V4(1.0f, 1.0f, 1.0f, 1.0f), &Sprite,
+                                         RectangleFromBuffer(&Buffer));
+                    }
+                    else
+                    {
+                        DrawBitmap(&Buffer, &Sprite, Position, RectangleFromBuffer(&Buffer));
+                    }
+                }
+                SpriteCount += 256;
+                EndNanoseconds = LinuxGetNanoseconds();
+            }
+            float64 Seconds = (float64)(EndNanoseconds - StartNanoseconds) / 1.0e9;
+            float64 SpritesPerSecond = SpriteCount / Seconds;
+            printf("  %-6s %s: %8.0f sprites/s  (%.0f per 60Hz frame, %.1f Mpixels/s)\n", SIMDLevelNames[Level],
+                   SpriteNames[Mode], SpritesPerSecond, SpritesPerSecond*FrameSeconds,
+                   SpritesPerSecond*64.0*64.0 / 1.0e6);
+        }
+    }
+
+
+    //Whole frames, tiled on the work queue: the same busy scene at every thread count, against one thread
+    render_group *Group = AllocateRenderGroup(&SpriteArena, Kilobytes(256));
+    LinuxPushTestScene(Group, &Sprite, Buffer.Width, Buffer.Height, 256, 1234);
+    platform_api Platform = {LinuxAddEntry, LinuxCompleteAllWork};
+
+    simd_level Level = GameSelectSIMDLevel(SIMDLevel_Auto);
+    printf("Tiled frames: gradient, 3 panels, 256 sprites  |  %s  |  %ld cores online\n", SIMDLevelNames[Level],
+           sysconf(_SC_NPROCESSORS_ONLN));
+
+    uint32 ThreadCounts[] = {1, 2, 4, 8, 16};
+    float64 OneThreadMilliseconds = 0.0;
+    for(int CountIndex = 0; CountIndex < ArrayCount(ThreadCounts); ++CountIndex)
+    {
+        linux_work_queue WorkQueue;
+        if(!LinuxStartWorkQueue(&WorkQueue, ThreadCounts[CountIndex]))
+        {
+            fprintf(stderr, "Could not start a work queue\n");
+            return(1);
+        }
+
+        int FrameCount = 0;
+        int64 StartNanoseconds = LinuxGetNanoseconds();
+        int64 EndNanoseconds = StartNanoseconds;
+        while((EndNanoseconds - StartNanoseconds) < (int64)(2.0*TestSeconds*1.0e9))
+        {
+            TiledRenderGroupToOutput(WorkQueue.Queue, &Platform, Group, &Buffer);
+            ++FrameCount;
+            EndNanoseconds = LinuxGetNanoseconds();
+        }
+        float64 Milliseconds = (float64)(EndNanoseconds - StartNanoseconds) / 1.0e6 / FrameCount;
+        OneThreadMilliseconds = (CountIndex == 0) ? Milliseconds : OneThreadMilliseconds;
+
+        uint32 EntriesRun = 0;
+        uint32 EntriesStolen = 0;
+        for(uint32 ThreadIndex = 0; ThreadIndex < WorkQueue.ThreadCount; ++ThreadIndex)
+        {
+            EntriesRun += WorkQueue.Queue->Deques[ThreadIndex].EntriesRun;
+            EntriesStolen += WorkQueue.Queue->Deques[ThreadIndex].EntriesStolen;
+        }
+
+        printf("  %2u threads: %7.3f ms per frame  |  %8.1f Mpixels/s  |  %5.2fx one thread  |  %4.1f%% of tiles stolen\n",
+               WorkQueue.ThreadCount, Milliseconds, PixelCount / Milliseconds / 1.0e3, OneThreadMilliseconds / Milliseconds,
+               EntriesRun ? 100.0*EntriesStolen / EntriesRun : 0.0);
+
+        LinuxStopWorkQueue(&WorkQueue);
+    }
+
+    //Every pixel format at 1080p and 4K, on this thread: how much less there is to write (and read back, for the
+    //blended fill and the scene) in the narrow formats, and what that is worth
+    printf("Pixel formats: %s, one thread\n", SIMDLevelNames[Level]);
+    int FormatWidths[] = {1920, 3840};
+    int FormatHeights[] = {1080, 2160};
+    memory_index FormatMemorySize = (memory_index)3840*2160*4;
+    void *FormatMemory = LinuxAllocateMemory(FormatMemorySize);
+    tiled_background Background;
+    InitializeTiledBackground(&Background, &SpriteArena, 256, 256);
+    for(int SizeIndex = 0; SizeIndex < ArrayCount(FormatWidths); ++SizeIndex)
+    {
+        Group->PushBufferSize = 0;
+        LinuxPushTestScene(Group, &Sprite, FormatWidths[SizeIndex], FormatHeights[SizeIndex], 256, 1234);
+
+        float64 FullSizeMegabytes = 0.0;
+        for(int Format = 0; Format < PixelFormat_Count; ++Format)
+        {
+            game_offscreen_buffer FormatBuffer = {};
+            FormatBuffer.Memory = FormatMemory;
+            FormatBuffer.Width = FormatWidths[SizeIndex];
+            FormatBuffer.Height = FormatHeights[SizeIndex];
+            FormatBuffer.Format = (pixel_format)Format;
+            FormatBuffer.Pitch = FormatBuffer.Width*GetBytesPerPixel(FormatBuffer.Format);
+
+            float64 Megabytes = (float64)FormatBuffer.Pitch*FormatBuffer.Height / (1024.0*1024.0);
+            FullSizeMegabytes = (Format == PixelFormat_BGRX8888) ? Megabytes : FullSizeMegabytes;
+            float64 GradientMilliseconds = LinuxTimeFullScreenTest(FullScreenTest_Gradient, &FormatBuffer, Group, &Background, TestSeconds);
+            DrawGradientBackground(&Background, FormatBuffer.Format);
+            float64 BackgroundMilliseconds = LinuxTimeFullScreenTest(FullScreenTest_TiledBackground, &FormatBuffer, Group, &Background,
+                                                                     TestSeconds);
+            float64 BlendMilliseconds = LinuxTimeFullScreenTest(FullScreenTest_BlendedFill, &FormatBuffer, Group, &Background, TestSeconds);
+            float64 SceneMilliseconds = LinuxTimeFullScreenTest(FullScreenTest_Scene, &FormatBuffer, Group, &Background, TestSeconds);
+            printf("  %4dx%-4d %-8s: %5.1f MB (%3.0f%%)  |  gradient %6.3f ms, %5.1f GB/s  |  copied from its tile %6.3f ms, %5.1f GB/s  |  "
+                   "blended fill %6.3f ms  |  scene %6.3f ms\n",
+                   FormatBuffer.Width, FormatBuffer.Height, PixelFormatNames[Format], Megabytes, 100.0*Megabytes / FullSizeMegabytes,
+                   GradientMilliseconds, Megabytes / 1024.0 / (GradientMilliseconds / 1.0e3),
+                   BackgroundMilliseconds, Megabytes / 1024.0 / (BackgroundMilliseconds / 1.0e3), BlendMilliseconds, SceneMilliseconds);
+        }
+    }
+    munmap(FormatMemory, FormatMemorySize);
+
+    return(0);
+}
+
+internal int LinuxRunPresentBenchmark(linux_benchmark_settings *Settings)
+{
+    game_offscreen_buffer Source = {};
+    Source.Width = 1280;
+    Source.Height = 720;
+    Source.Pitch = Source.Width*4;
+    Source.Memory = LinuxAllocateMemory((memory_index)Source.Pitch*Source.Height);
+    LinuxFillNoise(&Source, 1234);
+
+    game_offscreen_buffer Dest = {};
+    memory_index MaxSize = (memory_index)3840*4*2160;
+    Dest.Memory = LinuxAllocateMemory(MaxSize);
+    void *CopySource = LinuxAllocateMemory(MaxSize);
+    present_scaler *Scaler = (present_scaler *)LinuxAllocateMemory(sizeof(present_scaler));
+
+    float64 TestSeconds = 0.25;
+    printf("Present: %dx%d into a window, median of the presents in %.2f s\n", Source.Width, Source.Height, TestSeconds);
+
+    int DestSizes[][2] = {{1920, 1080}, {2560, 1440}, {3840, 2160}, {3440, 1440}, {1920, 1200}};
+    simd_level Supported = GameSelectSIMDLevel(SIMDLevel_Auto);
+    for(int SizeIndex = 0; SizeIndex < ArrayCount(DestSizes); ++SizeIndex)
+    {
+        Dest.Width = DestSizes[SizeIndex][0];
+        Dest.Height = DestSizes[SizeIndex][1];
+        Dest.Pitch = Dest.Width*4;
+        float64 DestPixels = (float64)Dest.Width*Dest.Height;
+
+        present_layout Layout = ComputePresentLayout(Source.Width, Source.Height, Dest.Width, Dest.Height);
+        char PathName[32];
+        if(Layout.IntegerScale)
+        {
+            snprintf(PathName, sizeof(PathName), "integer %dx", Layout.IntegerScale);
+        }
+        else
+        {
+            snprintf(PathName, sizeof(PathName), "bilinear");
+        }
+        printf("  %dx%d (picture %dx%d, %s):\n", Dest.Width, Dest.Height, Layout.Width, Layout.Height, PathName);
+
+        //Level Scalar - 1 is the reference: a memcpy of the whole window, the least a present can cost
+        for(int Level = SIMDLevel_Scalar - 1; Level <= Supported; ++Level)
+        {
+            if(Level >= SIMDLevel_Scalar)
+            {
+                GameSelectSIMDLevel((simd_level)Level);
+            }
+
+            int64 Samples[4096];
+            int SampleCount = 0;
+            int64 StartNanoseconds = LinuxGetNanoseconds();
+            while(((LinuxGetNanoseconds() - StartNanoseconds) < (int64)(TestSeconds*1.0e9)) && (SampleCount < ArrayCount(Samples)))
+            {
+                int64 PresentStart = LinuxGetNanoseconds();
+                if(Level >= SIMDLevel_Scalar)
+                {
+                    PresentScaled(Scaler, &Source, &Dest);
+                }
+                else
+                {
+                    memcpy(Dest.Memory, CopySource, (memory_index)Dest.Pitch*Dest.Height);
+                }
+                Samples[SampleCount++] = LinuxGetNanoseconds() - PresentStart;
+            }
+
+            qsort(Samples, SampleCount, sizeof(int64), LinuxCompareInt64);
+            float64 Milliseconds = (float64)Samples[SampleCount/2] / 1.0e6;
+            printf("    %-6s %7.3f ms  |  %8.1f Mpixels/s  |  p99 %.3f ms\n",
+                   (Level >= SIMDLevel_Scalar) ? SIMDLevelNames[Level] : "copy", Milliseconds,
+                   DestPixels / Milliseconds / 1.0e3, (float64)Samples[((SampleCount - 1)*99)/100] / 1.0e6);
+        }
+    }
+
+    return(0);
+}
+
+internal void LinuxWriteWavHeader(FILE *Wav, int SamplesPerSecond, uint32 DataBytes)
+{
+    wav_header Header = MakeWavHeader(SamplesPerSecond, DataBytes);
+    fseek(Wav, 0, SEEK_SET);
+    fwrite(&Header, sizeof(Header), 1, Wav);
+}
+
+//write() can write less than it was asked to, keep going until it is all out
+internal bool32 LinuxWriteAll(int File, void *Memory, memory_index Size)
+{
+    uint8 *At = (uint8 *)Memory;
+    while(Size > 0)
+    {
+        ssize_t Written = write(File, At, Size);
+        if(Written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return(false);
+        }
+        At += Written;
+        Size -= Written;
+    }
+    return(true);
+}
+
+internal void *LinuxCaptureThreadProc(void *Parameter)
+{
+    linux_capture_thread *Thread = (linux_capture_thread *)Parameter;
+    capture_queue *Queue = Thread->Queue;
+
+    DebugNameThread("Capture");
+
+    //Writing is background work: on a machine with cores to spare it changes nothing, on a busy one it should mostly
+    //get the time the game and audio threads leave
+    sched_param Priority = {};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &Priority);
+
+    for(;;)
+    {
+        while(sem_wait(&Thread->FramesPublished) != 0)
+        {
+            //Interrupted by a signal, go back to waiting
+        }
+
+        capture_frame *Frame;
+        while((Frame = BeginCaptureRead(Queue)) != 0)
+        {
+            TIMED_BLOCK("LinuxCaptureWrite");
+
+            int64 Start = LinuxGetNanoseconds();
+
+            char Header[64];
+            int HeaderSize;
+            memory_index PixelSize;
+            uint8 *Pixels = PrepareCaptureFrame(Queue, Frame, Header, sizeof(Header), &HeaderSize, &PixelSize);
+            memory_index SampleSize = (memory_index)Frame->SampleCount*2*sizeof(int16);
+            if(!LinuxWriteAll(Thread->FrameFile, Header, HeaderSize) ||
+               !LinuxWriteAll(Thread->FrameFile, Pixels, PixelSize) ||
+               !LinuxWriteAll(Thread->WavFile, Frame->Samples, SampleSize))
+            {
+                Thread->WriteFailed = true;
+            }
+            Thread->WavDataBytes += (uint32)SampleSize;
+            ++Thread->FramesWritten;
+
+            EndCaptureRead(Queue);
+            Thread->WriteNanoseconds += LinuxGetNanoseconds() - Start;
+        }
+
+        //The game thread publishes everything before it stops us, so once we have drained the queue we are done
+        if(!Thread->Running)
+        {
+            break;
+        }
+    }
+
+    wav_header WavHeader = MakeWavHeader(Thread->SamplesPerSecond, Thread->WavDataBytes);
+    if(pwrite(Thread->WavFile, &WavHeader, sizeof(WavHeader), 0) != sizeof(WavHeader))
+    {
+        Thread->WriteFailed = true;
+    }
+
+    return(0);
+}
+
+internal int64 LinuxSleepUntil(int64 Deadline)
+{
+    timespec Until;
+    Until.tv_sec = Deadline / 1000000000LL;
+    Until.tv_nsec = Deadline % 1000000000LL;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Until, 0) != 0)
+    {
+        //Interrupted by a signal, go back to sleep
+    }
+    return(Deadline);
+}
+
+internal void *LinuxAudioThreadProc(void *Parameter)
+{
+    linux_audio_thread *Thread = (linux_audio_thread *)Parameter;
+    audio_ring *Ring = Thread->Ring;
+    audio_device_clock *Clock = Thread->Clock;
+    uint32 PeriodSamples = Thread->PeriodSamples;
+
+    uint32 PlayedSampleIndex = 0;
+    uint32 WrittenSampleIndex = 0;
+    uint32 RingSamplesConsumed = 0;
+    uint32 ServiceInterval = 0;
+
+    DebugNameThread("Audio");
+
+    //Sleep to absolute deadlines so the playback rate doesn't drift with how long each period takes
+    int64 PeriodNanoseconds = ((int64)PeriodSamples*1000000000LL) / Thread->SamplesPerSecond;
+    int64 NextDeadline = LinuxGetNanoseconds();
+    int64 LastWake = NextDeadline;
+    while(Thread->Running)
+    {
+        //The game only gets its sound to the device when we wake up, so how long that takes, waking up late included,
+        //is part of its safety margin. The worst case fades so one hiccup doesn't add latency forever.
+        int64 Wake = LinuxGetNanoseconds();
+        uint32 Interval = (uint32)(((Wake - LastWake)*Thread->SamplesPerSecond) / 1000000000LL);
+        ServiceInterval = (Interval > ServiceInterval) ? Interval : ServiceInterval - (ServiceInterval - Interval)/64;
+        LastWake = Wake;
+
+        {
+            TIMED_BLOCK("LinuxAudioPeriod", PeriodSamples);
+
+            //Top the device buffer up to two periods with whatever the game has sent
+            int SampleCount;
+            int16 *Block;
+            while((WrittenSampleIndex - PlayedSampleIndex < 2*PeriodSamples) && (Block = BeginAudioRingRead(Ring, &SampleCount)) != 0)
+            {
+                if(Thread->Wav)
+                {
+                    fwrite(Block, SampleCount*2*sizeof(int16), 1, Thread->Wav);
+                    Thread->WavDataBytes += SampleCount*2*sizeof(int16);
+                }
+                EndAudioRingRead(Ring);
+                ++Thread->BlocksPlayed;
+
+                WrittenSampleIndex += SampleCount;
+                RingSamplesConsumed += SampleCount;
+            }
+
+            uint32 Queued = WrittenSampleIndex - PlayedSampleIndex;
+            if(Queued < PeriodSamples)
+            {
+                //The device needs a whole period right now and doesn't have it: play silence for the rest
+                CountAudioRingUnderrun(Ring);
+                uint32 SilenceCount = PeriodSamples - Queued;
+                if(Thread->Wav)
+                {
+                    fwrite(Thread->Silence, SilenceCount*2*sizeof(int16), 1, Thread->Wav);
+                    Thread->WavDataBytes += SilenceCount*2*sizeof(int16);
+                }
+                WrittenSampleIndex += SilenceCount;
+            }
+            PlayedSampleIndex += PeriodSamples;
+
+            //The period now playing is committed, and the cursor moves a period at a time
+            AtomicStoreRelease(&Clock->PlayedSampleIndex, PlayedSampleIndex);
+            AtomicStoreRelease(&Clock->WrittenSampleIndex, WrittenSampleIndex);
+            AtomicStoreRelease(&Clock->RingSamplesConsumed, RingSamplesConsumed);
+            AtomicStoreRelease(&Clock->WriteLeadSamples, PeriodSamples);
+            AtomicStoreRelease(&Clock->GranularitySamples, PeriodSamples);
+            AtomicStoreRelease(&Clock->ServiceIntervalSamples, ServiceInterval);
+        }
+
+        NextDeadline = LinuxSleepUntil(NextDeadline + PeriodNanoseconds);
+    }
+
+    return(0);
+}
+
+//Sleeps most of the way to the next frame's deadline and spins the rest, see midnight_madness_frame_pacer.h
+internal void LinuxWaitForNextFrame(frame_pacer *Pacer)
+{
+    TIMED_FUNCTION();
+
+    int64 Now = LinuxGetNanoseconds();
+    int64 WakeTime = FramePacerWakeTime(Pacer);
+    if(Now < WakeTime)
+    {
+        LinuxSleepUntil(WakeTime);
+        Now = LinuxGetNanoseconds();
+        FramePacerSlept(Pacer, WakeTime, Now);
+    }
+
+    int64 SpinStart = Now;
+    while(Now < Pacer->NextDeadline)
+    {
+        _mm_pause();
+        Now = LinuxGetNanoseconds();
+    }
+    Pacer->SpinTicks += Now - SpinStart;
+
+    AdvanceFramePacer(Pacer, Now);
+}
+
+internal void LinuxProcessKeyboardButton(game_button_state *NewState, bool32 IsDown)
+{
+    if(NewState->EndedDown != IsDown)
+    {
+        NewState->EndedDown = IsDown;
+        ++NewState->HalfTransitionCount;
+    }
+}
+
+//Stands in for a player: every half second the script moves on to the next step, holding one direction on the even
+//steps and nothing on the odd ones, with the tone going up and down on a different beat so the two overlap
+internal void LinuxSynthesizeInput(int FrameIndex, game_controller_input *Keyboard)
+{
+    int Step = (FrameIndex / 30) % 8;
+    LinuxProcessKeyboardButton(&Keyboard->MoveRight, Step == 0);
+    LinuxProcessKeyboardButton(&Keyboard->MoveDown, Step == 2);
+    LinuxProcessKeyboardButton(&Keyboard->MoveLeft, Step == 4);
+    LinuxProcessKeyboardButton(&Keyboard->MoveUp, Step == 6);
+
+    int ToneStep = (FrameIndex / 45) % 4;
+    LinuxProcessKeyboardButton(&Keyboard->ActionUp, ToneStep == 1);
+    LinuxProcessKeyboardButton(&Keyboard->ActionDown, ToneStep == 3);
+
+    //A tap every two seconds, to ring the bell
+    LinuxProcessKeyboardButton(&Keyboard->ActionLeft, (FrameIndex % 120) == 60);
+}
+
+//Every press and release is half a tap apart on average, anywhere from half to one and a half times that, so they land
+//all over the frame instead of in step with it
+internal void *LinuxInputInjectorProc(void *Parameter)
+{
+    linux_input_injector *Injector = (linux_input_injector *)Parameter;
+
+    DebugNameThread("Input");
+
+    int64 HalfTapNanoseconds = 500000000LL / Injector->TapsPerSecond;
+    int64 NextEvent = LinuxGetNanoseconds();
+    bool32 IsDown = false;
+    while(Injector->Running)
+    {
+        //xorshift32, the same taps every run (and never 0)
+        uint32 Random = Injector->RandomState;
+        Random ^= Random << 13;
+        Random ^= Random >> 17;
+        Random ^= Random << 5;
+        Injector->RandomState = Random;
+
+        NextEvent += HalfTapNanoseconds/2 + (int64)(Random % (uint32)HalfTapNanoseconds);
+        LinuxSleepUntil(NextEvent);
+        IsDown = !IsDown;
+
+        uint32 WriteCount = Injector->WriteCount;
+        if((WriteCount - AtomicLoadAcquire(&Injector->ReadCount)) < LINUX_INJECTED_EVENT_COUNT)
+        {
+            input_event_stamp *Event = Injector->Events + (WriteCount & (LINUX_INJECTED_EVENT_COUNT - 1));
+            Event->ArrivalTicks = LinuxGetNanoseconds();
+            Event->ButtonIndex = Injector->ButtonIndex;
+            Event->IsDown = IsDown;
+            AtomicStoreRelease(&Injector->WriteCount, WriteCount + 1);
+        }
+        else
+        {
+            ++Injector->DroppedCount;
+        }
+    }
+
+    return(0);
+}
+
+//Main thread. Everything injected since the last frame goes into this one's input, and its events.
+internal void LinuxDrainInjectedInput(linux_input_injector *Injector, game_controller_input *Keyboard, input_event_batch *InputEvents)
+{
+    uint32 WriteCount = AtomicLoadAcquire(&Injector->WriteCount);
+    for(uint32 ReadCount = Injector->ReadCount; ReadCount != WriteCount; ++ReadCount)
+    {
+        input_event_stamp *Event = Injector->Events + (ReadCount & (LINUX_INJECTED_EVENT_COUNT - 1));
+        LinuxProcessKeyboardButton(Keyboard->Buttons + Event->ButtonIndex, Event->IsDown);
+        AddInputEvent(InputEvents, Event->ArrivalTicks, Event->ButtonIndex, Event->IsDown);
+    }
+    AtomicStoreRelease(&Injector->ReadCount, WriteCount);
+}
+
+//FNV-1a a word at a time, only to tell whether two runs ended up in the same state
+internal uint64 LinuxChecksumMemory(void *Memory, uint64 Size)
+{
+    uint64 Result = 14695981039346656037ULL;
+    uint64 *Word = (uint64 *)Memory;
+    for(uint64 WordIndex = 0; WordIndex < Size/sizeof(uint64); ++WordIndex)
+    {
+        Result = (Result ^ Word[WordIndex]) * 1099511628211ULL;
+    }
+    //A byte at a time for whatever doesn't make a whole word, a frame of sound often doesn't
+    uint8 *Byte = (uint8 *)Memory;
+    for(uint64 ByteIndex = Size & ~(uint64)(sizeof(uint64) - 1); ByteIndex < Size; ++ByteIndex)
+    {
+        Result = (Result ^ Byte[ByteIndex]) * 1099511628211ULL;
+    }
+    return(Result);
+}
+
+//A running checksum over many blocks, in order
+inline uint64 LinuxAccumulateChecksum(uint64 Checksum, void *Memory, uint64 Size)
+{
+    uint64 Result = (Checksum ^ LinuxChecksumMemory(Memory, Size)) * 1099511628211ULL;
+    return(Result);
+}
+
+internal void LinuxGetReplayFileName(char *Name, const char *Extension, char *Dest, int DestSize)
+{
+    snprintf(Dest, DestSize, "%s.%s", Name, Extension);
+}
+
+//A load job that finished after the snapshot was taken, or after it was copied back, would write into the wrong state
+internal void LinuxFinishAssetLoads(linux_replay *Replay)
+{
+    if(Replay->LoadQueue)
+    {
+        LinuxCompleteAllWork(Replay->LoadQueue);
+    }
+}
+
+internal bool32 LinuxBeginRecordingInput(linux_replay *Replay, char *Name)
+{
+    bool32 Result = false;
+
+    char StateFileName[4096];
+    char InputFileName[4096];
+    LinuxGetReplayFileName(Name, "state", StateFileName, sizeof(StateFileName));
+    LinuxGetReplayFileName(Name, "input", InputFileName, sizeof(InputFileName));
+
+    //The snapshot is a shared mapping of the state file, so copying the game memory into it is the write: the kernel
+    //flushes the pages to disk in its own time instead of us waiting on a 192 MB write()
+    int StateFile = open(StateFileName, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if((StateFile >= 0) && (ftruncate(StateFile, Replay->GameMemorySize) == 0))
+    {
+        void *Snapshot = mmap(0, Replay->GameMemorySize, PROT_READ|PROT_WRITE, MAP_SHARED, StateFile, 0);
+        Replay->RecordingHandle = fopen(InputFileName, "wb");
+        if((Snapshot != MAP_FAILED) && Replay->RecordingHandle)
+        {
+            Replay->Snapshot = Snapshot;
+            LinuxFinishAssetLoads(Replay);
+            memcpy(Replay->Snapshot, Replay->GameMemoryBlock, Replay->GameMemorySize);
+
+            linux_replay_header Header = {};
+            Header.Magic = LINUX_REPLAY_MAGIC;
+            Header.InputSize = sizeof(game_input);
+            Header.GameMemoryBase = (uint64)Replay->GameMemoryBlock;
+            Header.GameMemorySize = Replay->GameMemorySize;
+            fwrite(&Header, sizeof(Header), 1, Replay->RecordingHandle);
+
+            Result = true;
+        }
+    }
+    if(StateFile >= 0)
+    {
+        close(StateFile);
+    }
+
+    if(!Result)
+    {
+        fprintf(stderr, "Could not record to %s and %s\n", StateFileName, InputFileName);
+    }
+    return(Result);
+}
+
+internal void LinuxRecordInput(linux_replay *Replay, game_input *NewInput)
+{
+    fwrite(NewInput, sizeof(*NewInput), 1, Replay->RecordingHandle);
+    ++Replay->FrameCount;
+}
+
+internal void LinuxEndRecordingInput(linux_replay *Replay)
+{
+    fclose(Replay->RecordingHandle);
+    Replay->RecordingHandle = 0;
+    munmap(Replay->Snapshot, Replay->GameMemorySize);
+    Replay->Snapshot = 0;
+}
+
+internal bool32 LinuxBeginInputPlayback(linux_replay *Replay, char *Name)
+{
+    bool32 Result = false;
+
+    char StateFileName[4096];
+    char InputFileName[4096];
+    LinuxGetReplayFileName(Name, "state", StateFileName, sizeof(StateFileName));
+    LinuxGetReplayFileName(Name, "input", InputFileName, sizeof(InputFileName));
+
+    linux_replay_header Header = {};
+    Replay->PlaybackHandle = fopen(InputFileName, "rb");
+    if(!Replay->PlaybackHandle || (fread(&Header, sizeof(Header), 1, Replay->PlaybackHandle) != 1) ||
+       (Header.Magic != LINUX_REPLAY_MAGIC) || (Header.InputSize != sizeof(game_input)))
+    {
+        fprintf(stderr, "%s is not a recording this build can play\n", InputFileName);
+    }
+    else if((Header.GameMemoryBase != (uint64)Replay->GameMemoryBlock) || (Header.GameMemorySize != Replay->GameMemorySize))
+    {
+        fprintf(stderr, "%s was recorded with game memory at 0x%llx (%llu MB), this run has it at %p (%llu MB)\n",
+                InputFileName, (unsigned long long)Header.GameMemoryBase, (unsigned long long)(Header.GameMemorySize / Megabytes(1)),
+                Replay->GameMemoryBlock, (unsigned long long)(Replay->GameMemorySize / Megabytes(1)));
+    }
+    else
+    {
+        //A private read-only mapping: playback copies out of it every loop and never writes it
+        int StateFile = open(StateFileName, O_RDONLY);
+        struct stat StateStat;
+        if((StateFile >= 0) && (fstat(StateFile, &StateStat) == 0) && ((uint64)StateStat.st_size == Replay->GameMemorySize))
+        {
+            void *Snapshot = mmap(0, Replay->GameMemorySize, PROT_READ, MAP_PRIVATE, StateFile, 0);
+            if(Snapshot != MAP_FAILED)
+            {
+                Replay->Snapshot = Snapshot;
+                LinuxFinishAssetLoads(Replay);
+                memcpy(Replay->GameMemoryBlock, Replay->Snapshot, Replay->GameMemorySize);
+                Result = true;
+            }
+        }
+        if(StateFile >= 0)
+        {
+            close(StateFile);
+        }
+
+        if(!Result)
+        {
+            fprintf(stderr, "Could not map %s\n", StateFileName);
+        }
+    }
+
+    return(Result);
+}
+
+//Overwrites NewInput with the next recorded frame. At the end of the recording the input goes back to the first frame,
+//and it returns true: the game memory has to go back to the snapshot (LinuxRestoreSnapshot) before that frame is
+//rendered, so the session loops for as many frames as we run.
+internal bool32 LinuxPlaybackInput(linux_replay *Replay, game_input *NewInput)
+{
+    bool32 Result = false;
+    if(fread(NewInput, sizeof(*NewInput), 1, Replay->PlaybackHandle) != 1)
+    {
+        Result = true;
+        ++Replay->LoopCount;
+        Replay->FrameCount = 0;
+
+        fseek(Replay->PlaybackHandle, sizeof(linux_replay_header), SEEK_SET);
+        if(fread(NewInput, sizeof(*NewInput), 1, Replay->PlaybackHandle) != 1)
+        {
+            //An empty recording, play it as no keys down
+            *NewInput = {};
+        }
+    }
+    ++Replay->FrameCount;
+    return(Result);
+}
+
+//On whichever thread runs the game, after the last frame of the loop and before the first one of the next
+internal void LinuxRestoreSnapshot(linux_replay *Replay, bool32 FirstLoopEnded)
+{
+    if(FirstLoopEnded)
+    {
+        Replay->FirstLoopChecksum = LinuxChecksumMemory(Replay->GameMemoryBlock, Replay->GameMemorySize);
+    }
+
+    LinuxFinishAssetLoads(Replay);
+    memcpy(Replay->GameMemoryBlock, Replay->Snapshot, Replay->GameMemorySize);
+}
+
+//Runs the game for one submitted frame: into the swap chain's next buffer (or a capture frame), and its sound
+internal void LinuxRenderFrame(linux_render_thread *Thread, frame_pipeline_slot *Slot)
+{
+    linux_benchmark_settings *Settings = Thread->Settings;
+
+    if(Slot->PlatformFlags & LinuxFrame_RestoreSnapshot)
+    {
+        LinuxRestoreSnapshot(Thread->Replay, Slot->PlatformFlags & LinuxFrame_FirstLoopEnded);
+    }
+
+    if(Settings->Pace && (Settings->SpikeMilliseconds > 0) && (Slot->FrameIndex % Settings->SpikeEvery) == (uint32)(Settings->SpikeEvery - 1))
+    {
+        //An artificial long frame
+        LinuxSleepUntil(LinuxGetNanoseconds() + (int64)Settings->SpikeMilliseconds*1000000LL);
+    }
+
+    //When capturing, the game renders right into a capture frame, and only uses the backbuffer when there is none free
+    capture_frame *CaptureFrame = 0;
+    if(Settings->CaptureName)
+    {
+        CaptureFrame = BeginCaptureFrame(Thread->CaptureQueue, Slot->FrameIndex);
+    }
+
+    game_offscreen_buffer Buffer = GetDrawBuffer(Thread->SwapChain);
+    if(CaptureFrame)
+    {
+        Buffer.Memory = CaptureFrame->Pixels;
+    }
+    Slot->Buffer = Buffer;
+    Slot->CaptureFrame = CaptureFrame;
+
+    game_sound_output_buffer SoundBuffer = {};
+    SoundBuffer.SamplesPerSecond = Thread->SamplesPerSecond;
+    SoundBuffer.SampleCount = Thread->SamplesPerFrame;
+    SoundBuffer.Samples = Thread->Samples;
+
+    uint64 StartPageFaults = LinuxGetPageFaultCount();
+    int64 StartNanoseconds = LinuxGetNanoseconds();
+    int64 StartCycleCount = __rdtsc();
+
+    GameUpdateAndRender(Thread->GameMemory, &Slot->Input, &Buffer);
+    if(Settings->AudioThread)
+    {
+        //Write just enough sound to last until next frame's gets to the device. It goes straight into free blocks
+        //of the ring; if there are none it is dropped (and counted as an overrun) so the game never waits.
+        audio_ring *AudioRing = Thread->AudioRing;
+        int SamplesNeeded = ComputeAudioSamplesNeeded(Thread->AudioScheduler, Thread->AudioClock, Slot->ExpectedFrameSeconds);
+        int SamplesProduced = 0;
+        while(SamplesProduced < SamplesNeeded)
+        {
+            SoundBuffer.SampleCount = SamplesNeeded - SamplesProduced;
+            if(SoundBuffer.SampleCount > AudioRing->SamplesPerBlock)
+            {
+                SoundBuffer.SampleCount = AudioRing->SamplesPerBlock;
+            }
+            SoundBuffer.Samples = BeginAudioRingWrite(AudioRing);
+            if(!SoundBuffer.Samples)
+            {
+                break;
+            }
+            GameGetSoundSamples(Thread->GameMemory, &SoundBuffer);
+            if(CaptureFrame)
+            {
+                //The block belongs to the audio thread as soon as it is published, so capture keeps its own copy
+                memcpy(CaptureFrame->Samples + 2*CaptureFrame->SampleCount, SoundBuffer.Samples, SoundBuffer.SampleCount*2*sizeof(int16));
+                CaptureFrame->SampleCount += SoundBuffer.SampleCount;
+            }
+            EndAudioRingWrite(AudioRing, SoundBuffer.SampleCount);
+            SamplesProduced += SoundBuffer.SampleCount;
+        }
+        RecordAudioSamplesProduced(Thread->AudioScheduler, Thread->AudioClock, SamplesProduced);
+    }
+    else
+    {
+        if(CaptureFrame)
+        {
+            SoundBuffer.Samples = CaptureFrame->Samples;
+            CaptureFrame->SampleCount = SoundBuffer.SampleCount;
+        }
+        GameGetSoundSamples(Thread->GameMemory, &SoundBuffer);
+    }
+
+    Slot->RenderCycles = __rdtsc() - StartCycleCount;
+    Slot->RenderStartTicks = StartNanoseconds;
+    Slot->RenderEndTicks = LinuxGetNanoseconds();
+    Slot->PageFaults = LinuxGetPageFaultCount() - StartPageFaults;
+
+    SwapBackbuffers(Thread->SwapChain);
+}
+
+internal void *LinuxRenderThreadProc(void *Parameter)
+{
+    linux_render_thread *Thread = (linux_render_thread *)Parameter;
+
+    DebugNameThread("Render");
+
+    for(;;)
+    {
+        while(sem_wait(&Thread->FramesSubmitted) != 0)
+        {
+            //Interrupted by a signal, go back to waiting
+        }
+
+        frame_pipeline_slot *Slot;
+        while((Slot = BeginFrameRender(Thread->Pipeline)) != 0)
+        {
+            LinuxRenderFrame(Thread, Slot);
+            EndFrameRender(Thread->Pipeline);
+            sem_post(&Thread->FramesRendered);
+        }
+
+        //The main thread has presented everything it submitted before it stops us
+        if(!Thread->Running)
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+
+//Next to the executable, wherever we are run from
+internal char *LinuxGetDefaultAssetPath(char *Dest, int DestSize)
+{
+    ssize_t ExeLength = readlink("/proc/self/exe", Dest, DestSize - 1);
+    ExeLength = (ExeLength < 0) ? 0 : ExeLength;
+    Dest[ExeLength] = 0;
+    char *LastSlash = strrchr(Dest, '/');
+    char *Directory = LastSlash ? LastSlash + 1 : Dest;
+    snprintf(Directory, DestSize - (Directory - Dest), "midnight_madness.mma");
+    return(Dest);
+}
+
+//The script's frames one after the other, as fast as they go, folding every frame and every frame's sound into the
+//instance's checksums
+internal void *LinuxBatchInstanceProc(void *Parameter)
+{
+    linux_batch_instance *Instance = (linux_batch_instance *)Parameter;
+    linux_benchmark_settings *Settings = Instance->Settings;
+
+    game_offscreen_buffer Buffer = {Instance->Buffer.Memory, Instance->Buffer.Width, Instance->Buffer.Height,
+                                    Instance->Buffer.Pitch, Instance->Buffer.Format};
+    uint64 FrameSize = (uint64)Buffer.Pitch*Buffer.Height;
+
+    game_sound_output_buffer SoundBuffer = {};
+    SoundBuffer.SamplesPerSecond = Settings->SamplesPerSecond;
+    SoundBuffer.SampleCount = Instance->SamplesPerFrame;
+    SoundBuffer.Samples = Instance->Samples;
+    uint64 SoundSize = (uint64)Instance->SamplesPerFrame*2*sizeof(int16);
+
+    game_input Input[2] = {};
+    game_input *NewInput = &Input[0];
+    game_input *OldInput = &Input[1];
+
+    uint64 FrameChecksum = 14695981039346656037ULL;
+    uint64 SoundChecksum = 14695981039346656037ULL;
+    int64 Start = LinuxGetNanoseconds();
+    int FrameCount = Settings->WarmupFrameCount + Settings->FrameCount;
+    for(int FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        game_controller_input *OldKeyboard = GetController(OldInput, 0);
+        game_controller_input *NewKeyboard = GetController(NewInput, 0);
+        *NewKeyboard = {};
+        NewKeyboard->IsConnected = true;
+        for(int ButtonIndex = 0; ButtonIndex < ArrayCount(NewKeyboard->Buttons); ++ButtonIndex)
+        {
+            NewKeyboard->Buttons[ButtonIndex].EndedDown = OldKeyboard->Buttons[ButtonIndex].EndedDown;
+        }
+        LinuxSynthesizeInput(FrameIndex, NewKeyboard);
+
+        GameUpdateAndRender(&Instance->GameMemory, NewInput, &Buffer);
+        GameGetSoundSamples(&Instance->GameMemory, &SoundBuffer);
+
+        FrameChecksum = LinuxAccumulateChecksum(FrameChecksum, Buffer.Memory, FrameSize);
+        SoundChecksum = LinuxAccumulateChecksum(SoundChecksum, SoundBuffer.Samples, SoundSize);
+
+        game_input *Temp = NewInput;
+        NewInput = OldInput;
+        OldInput = Temp;
+    }
+    Instance->Nanoseconds = LinuxGetNanoseconds() - Start;
+    Instance->FrameChecksum = FrameChecksum;
+    Instance->SoundChecksum = SoundChecksum;
+
+    return(0);
+}
+
+//Runs the instances from First up to Last all at once, and returns how long until the last one was done
+//Returns -1 if a thread could not be started, once the ones that were have finished
+internal int64 LinuxRunBatchInstances(linux_batch_instance *Instances, int First, int Last)
+{
+    pthread_t Threads[LINUX_BATCH_MAX_INSTANCES];
+    int64 Start = LinuxGetNanoseconds();
+    int StartedEnd = First;
+    for(; StartedEnd < Last; ++StartedEnd)
+    {
+        int Error = pthread_create(&Threads[StartedEnd], 0, LinuxBatchInstanceProc, Instances + StartedEnd);
+        if(Error)
+        {
+            fprintf(stderr, "Could not start a thread for instance %d of the batch: %s\n", StartedEnd, strerror(Error));
+            break;
+        }
+    }
+    for(int InstanceIndex = First; InstanceIndex < StartedEnd; ++InstanceIndex)
+    {
+        pthread_join(Threads[InstanceIndex], 0);
+    }
+    int64 Result = (StartedEnd == Last) ? (LinuxGetNanoseconds() - Start) : -1;
+    return(Result);
+}
+
+/*
+    -batch: N games in one process. The game keeps everything it knows in the game memory it is handed, and the
+    platform gives every instance its own, so they can only meet in what the process shares: the SIMD level and blend
+    space (with its tables), picked once before they start and only read after, the asset file, mapped read only, and
+    the profiler, which is left off.
+
+    One more instance than asked for runs on its own first, with the same script: that is the single instance
+    throughput the batch is compared with, and the checksums every instance of the batch has to match.
+*/
+internal int LinuxRunBatch(linux_benchmark_settings *Settings)
+{
+    int InstanceCount = Settings->BatchCount + 1;
+    simd_level SIMDLevel = GameSelectSIMDLevel(Settings->SIMDLevel);
+    GameSelectBlendSpace(Settings->BlendSpace);
+
+    char DefaultAssetPath[4096];
+    char *AssetPath = Settings->AssetPath ? Settings->AssetPath : LinuxGetDefaultAssetPath(DefaultAssetPath, sizeof(DefaultAssetPath));
+    uint64 AssetFileSize = 0;
+    void *AssetFileMemory = LinuxMapFile(AssetPath, 0, &AssetFileSize);
+    if(!AssetFileMemory)
+    {
+        fprintf(stderr, "Could not map %s, running without assets\n", AssetPath);
+    }
+
+    linux_batch_instance *Instances = (linux_batch_instance *)LinuxAllocateMemory(InstanceCount*sizeof(linux_batch_instance));
+    if(!Instances)
+    {
+        fprintf(stderr, "Could not allocate the batch\n");
+        return 1;
+    }
+
+    int SamplesPerFrame = Settings->SamplesPerSecond / Settings->GameUpdateHz;
+    for(int InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+    {
+        linux_batch_instance *Instance = Instances + InstanceIndex;
+        Instance->Settings = Settings;
+        Instance->SamplesPerFrame = SamplesPerFrame;
+
+        //The same sizes as the game gets on its own. No fixed address, there are no replays here.
+        game_memory *GameMemory = &Instance->GameMemory;
+        GameMemory->PermanentStorageSize = Megabytes(64);
+        GameMemory->TransientStorageSize = Megabytes(128);
+        uint64 SamplesSize = (uint64)SamplesPerFrame*2*sizeof(int16);
+        bool32 UsedLargePages;
+        GameMemory->PermanentStorage = LinuxAllocateGameMemory(0, GameMemory->PermanentStorageSize + GameMemory->TransientStorageSize + SamplesSize,
+                                                               Settings->LargePages, &UsedLargePages);
+        GameMemory->TransientStorage = (uint8 *)GameMemory->PermanentStorage + GameMemory->PermanentStorageSize;
+        Instance->Samples = (int16 *)((uint8 *)GameMemory->TransientStorage + GameMemory->TransientStorageSize);
+        GameMemory->AssetFileMemory = AssetFileMemory;
+        GameMemory->AssetFileSize = AssetFileSize;
+        GameMemory->PlatformAPI.AddEntry = LinuxAddEntry;
+        GameMemory->PlatformAPI.CompleteAllWork = LinuxCompleteAllWork;
+
+        LinuxResizeOffscreenBuffer(&Instance->Buffer, Settings->Width, Settings->Height, Settings->PixelFormat);
+        if(!GameMemory->PermanentStorage || !Instance->Buffer.Memory)
+        {
+            fprintf(stderr, "Could not allocate memory for instance %d of the batch\n", InstanceIndex);
+            return 1;
+        }
+    }
+
+    int FrameCount = Settings->WarmupFrameCount + Settings->FrameCount;
+    int64 SingleNanoseconds = LinuxRunBatchInstances(Instances, 0, 1);
+    int64 BatchNanoseconds = (SingleNanoseconds >= 0) ? LinuxRunBatchInstances(Instances, 1, InstanceCount) : -1;
+    if(BatchNanoseconds < 0)
+    {
+        return 1;
+    }
+
+    float64 SingleFramesPerSecond = FrameCount / (SingleNanoseconds / 1.0e9);
+    float64 BatchFramesPerSecond = (float64)Settings->BatchCount*FrameCount / (BatchNanoseconds / 1.0e9);
+    long ProcessorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("Batch:      %d instances x %d frames  |  %dx%d %s  |  %d Hz audio, %d samples per frame  |  %s  |  %ld cores\n",
+           Settings->BatchCount, FrameCount, Settings->Width, Settings->Height, PixelFormatNames[Settings->PixelFormat],
+           Settings->SamplesPerSecond, SamplesPerFrame, SIMDLevelNames[SIMDLevel], ProcessorCount);
+    printf("Throughput: %.1f frames/s over all instances in %.3f s  |  one instance alone %.1f frames/s  |  %.2fx\n",
+           BatchFramesPerSecond, BatchNanoseconds / 1.0e9, SingleFramesPerSecond, BatchFramesPerSecond / SingleFramesPerSecond);
+
+    linux_batch_instance *Reference = Instances;
+    int MismatchCount = 0;
+    for(int InstanceIndex = 1; InstanceIndex < InstanceCount; ++InstanceIndex)
+    {
+        linux_batch_instance *Instance = Instances + InstanceIndex;
+        bool32 Matches = ((Instance->FrameChecksum == Reference->FrameChecksum) && (Instance->SoundChecksum == Reference->SoundChecksum));
+        MismatchCount += Matches ? 0 : 1;
+        printf("  instance %2d: frames %016llx  |  sound %016llx  |  %.1f frames/s%s\n", InstanceIndex - 1,
+               (unsigned long long)Instance->FrameChecksum, (unsigned long long)Instance->SoundChecksum,
+               FrameCount / (Instance->Nanoseconds / 1.0e9), Matches ? "" : "  MISMATCH");
+    }
+    printf("Checksums:  frames %016llx  |  sound %016llx  |  %s\n", (unsigned long long)Reference->FrameChecksum,
+           (unsigned long long)Reference->SoundChecksum, MismatchCount ? "instances DIFFER from running alone" : "every instance matches running alone");
+
+    return(MismatchCount ? 1 : 0);
+}
+
+int main(int ArgCount, char **Args)
+{
+    linux_benchmark_settings Settings = {};
+    Settings.FrameCount = 600;
+    Settings.WarmupFrameCount = 10;
+    Settings.Width = 1280;
+    Settings.Height = 720;
+    Settings.SamplesPerSecond = 48000;
+    Settings.GameUpdateHz = 60;
+    Settings.ToneHz = 256;
+    Settings.DriftHours = 4;
+    Settings.SpikeEvery = 60;
+    Settings.PeriodSamples = 240;
+    Settings.LatencyFrames = 1;
+    Settings.BufferCount = 0;
+
+    //One thread per core we can run on, this one included
+    long ProcessorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    Settings.ThreadCount = (ProcessorCount < 1) ? 1 : ((ProcessorCount > WORK_QUEUE_MAX_THREADS) ? WORK_QUEUE_MAX_THREADS : (int)ProcessorCount);
+
+    if(!LinuxParseArguments(ArgCount, Args, &Settings))
+    {
+        fprintf(stderr, "Usage: %s [-frames N] [-warmup N] [-width W] [-height H] [-rate HZ] [-fps N] "
+                "[-simd auto|scalar|sse2|avx2] [-verify] [-largepages] [-audiobench [-hours N] [-tone HZ]] [-renderbench] [-presentbench] "
+                "[-present WxH] [-threads N] "
+                "[-audiothread [-wav FILE] [-spikems N] [-spikeevery N] [-period N] [-latencyframes N]] [-profile] [-trace FILE] [-pace] "
+                "[-record NAME | -playback NAME] [-capture NAME [-captureformat ppm|raw]] [-assets FILE] "
+                "[-format bgrx8888|rgba8888|rgb565|indexed8] [-buffers N] [-resizeevery N] [-pipeline N] [-inject N] [-overlay] [-batch N] [-blend srgb|linear]\n", Args[0]);
+        return 1;
+    }
+
+    if(Settings.Verify)
+    {
+        bool32 AllMatch = true;
+        simd_level Supported = GameSelectSIMDLevel(SIMDLevel_Auto);
+        bool32 RoundTrip = LinuxVerifyPixelFormats();
+        printf("formats  widened and narrowed again: %s\n", RoundTrip ? "unchanged" : "MISMATCH");
+        AllMatch = AllMatch && RoundTrip;
+
+        for(int Level = SIMDLevel_SSE2; Level <= Supported; ++Level)
+        {
+            for(int Format = 0; Format < PixelFormat_Count; ++Format)
+            {
+                bool32 Match = LinuxVerifyGradientLevel((simd_level)Level, (pixel_format)Format);
+                printf("%-6s gradient %-8s: %s\n", SIMDLevelNames[Level], PixelFormatNames[Format], Match ? "matches scalar" : "MISMATCH");
+                AllMatch = AllMatch && Match;
+            }
+        }
+
+        bool32 WorldMatches = LinuxVerifyWorld();
+        printf("world    chunks and culling: %s\n", WorldMatches ? "match" : "MISMATCH");
+        AllMatch = AllMatch && WorldMatches;
+
+        GameSelectSIMDLevel(SIMDLevel_Auto);
+        for(int Format = 0; Format < PixelFormat_Count; ++Format)
+        {
+            bool32 Match = LinuxVerifyTiledBackground((pixel_format)Format);
+            printf("tiled  background %-8s: %s\n", PixelFormatNames[Format], Match ? "matches the gradient" : "MISMATCH");
+            AllMatch = AllMatch && Match;
+        }
+
+        uint64 SpriteMemorySize = Megabytes(1);
+        memory_arena SpriteArena;
+        InitializeArena(&SpriteArena, SpriteMemorySize, LinuxAllocateMemory(SpriteMemorySize));
+        loaded_bitmap Sprite = MakeTestSprite(&SpriteArena, 16, 12);
+        bool32 LinearMatches = LinuxVerifyLinearBlending();
+        printf("linear   tables and blending: %s\n", LinearMatches ? "match the float reference" : "MISMATCH");
+        AllMatch = AllMatch && LinearMatches;
+
+        for(int Space = 0; Space < BlendSpace_Count; ++Space)
+        {
+            GameSelectBlendSpace((blend_space)Space);
+            for(int Level = SIMDLevel_SSE2; Level <= Supported; ++Level)
+            {
+                for(int Format = 0; Format < PixelFormat_Count; ++Format)
+                {
+                    bool32 Match = LinuxVerifyRenderLevel((simd_level)Level, (pixel_format)Format, &Sprite);
+                    printf("%-6s rendering %-8s %-6s: %s\n", SIMDLevelNames[Level], PixelFormatNames[Format], BlendSpaceNames[Space],
+                           Match ? "matches scalar" : "MISMATCH");
+                    AllMatch = AllMatch && Match;
+                }
+            }
+        }
+        GameSelectBlendSpace(BlendSpace_SRGB);
+
+        for(int Level = SIMDLevel_SSE2; Level <= Supported; ++Level)
+        {
+            bool32 Match = LinuxVerifyPresentLevel((simd_level)Level);
+            printf("%-6s presenting: %s\n", SIMDLevelNames[Level], Match ? "matches scalar" : "MISMATCH");
+            AllMatch = AllMatch && Match;
+        }
+
+        //Four threads whatever the machine has, so the tiles really are spread out and stolen
+        GameSelectSIMDLevel(SIMDLevel_Auto);
+        linux_work_queue WorkQueue;
+        if(LinuxStartWorkQueue(&WorkQueue, 4))
+        {
+            for(int Format = 0; Format < PixelFormat_Count; ++Format)
+            {
+                bool32 Match = LinuxVerifyTiledRendering(&WorkQueue, (pixel_format)Format, &Sprite);
+                printf("tiled  rendering %-8s on %u threads: %s\n", PixelFormatNames[Format], WorkQueue.ThreadCount,
+                       Match ? "matches one thread" : "MISMATCH");
+                AllMatch = AllMatch && Match;
+            }
+            LinuxStopWorkQueue(&WorkQueue);
+        }
+        return(AllMatch ? 0 : 1);
+    }
+
+    if(Settings.AudioBenchmark)
+    {
+        return(LinuxRunAudioBenchmark(&Settings));
+    }
+
+    if(Settings.RenderBenchmark)
+    {
+        return(LinuxRunRenderBenchmark(&Settings));
+    }
+
+    if(Settings.PresentBenchmark)
+    {
+        return(LinuxRunPresentBenchmark(&Settings));
+    }
+
+    if(Settings.BatchCount)
+    {
+        return(LinuxRunBatch(&Settings));
+    }
+
+    simd_level SIMDLevel = GameSelectSIMDLevel(Settings.SIMDLevel);
+    if((Settings.SIMDLevel != SIMDLevel_Auto) && (SIMDLevel != Settings.SIMDLevel))
+    {
+        fprintf(stderr, "This CPU can't run %s, falling back to %s\n", SIMDLevelNames[Settings.SIMDLevel], SIMDLevelNames[SIMDLevel]);
+    }
+    GameSelectBlendSpace(Settings.BlendSpace);
+
+    //One allocation for every backbuffer at the largest size, made here once: resizing never goes back to the OS.
+    //MAP_POPULATE has faulted it all in too, so a resize to a bigger size doesn't page fault either.
+    int SwapChainMaxWidth = (Settings.Width > SWAP_CHAIN_MAX_WIDTH) ? Settings.Width : SWAP_CHAIN_MAX_WIDTH;
+    int SwapChainMaxHeight = (Settings.Height > SWAP_CHAIN_MAX_HEIGHT) ? Settings.Height : SWAP_CHAIN_MAX_HEIGHT;
+    memory_index SwapChainSize = SwapChainMemorySize(SwapChainMaxWidth, SwapChainMaxHeight, Settings.BufferCount);
+    void *SwapChainMemory = LinuxAllocateMemory(SwapChainSize);
+    swap_chain SwapChain;
+    InitializeSwapChain(&SwapChain, SwapChainMemory, SwapChainMaxWidth, SwapChainMaxHeight, Settings.BufferCount);
+    if(SwapChainMemory)
+    {
+        ResizeSwapChain(&SwapChain, Settings.Width, Settings.Height, Settings.PixelFormat);
+    }
+
+    //Stands in for the window: what the frame gets scaled into, if we are presenting
+    linux_offscreen_buffer PresentBuffer = {};
+    present_scaler *PresentScaler = 0;
+    if(Settings.PresentWidth)
+    {
+        LinuxResizeOffscreenBuffer(&PresentBuffer, Settings.PresentWidth, Settings.PresentHeight, PixelFormat_BGRX8888);
+        PresentScaler = (present_scaler *)LinuxAllocateMemory(sizeof(present_scaler));
+        if(!PresentBuffer.Memory || !PresentScaler)
+        {
+            fprintf(stderr, "Could not allocate the present buffer\n");
+            return 1;
+        }
+    }
+    int64 PresentNanoseconds = 0;
+    int64 MaxPresentNanoseconds = 0;
+    int FailedPresentCount = 0;
+    int64 OverlayNanoseconds = 0;
+    int64 MaxOverlayNanoseconds = 0;
+    int64 LastOverlayNanoseconds = 0;
+    int64 LastLatencyNanoseconds = 0;
+
+    linux_sound_output SoundOutput = {};
+    SoundOutput.SamplesPerSecond = Settings.SamplesPerSecond;
+    SoundOutput.BytesPerSample = sizeof(int16)*2;
+    SoundOutput.SecondaryBufferSize = SoundOutput.SamplesPerSecond*SoundOutput.BytesPerSample;
+
+#if MIDNIGHT_MADNESS_INTERNAL
+    void *BaseAddress = (void *)Terabytes(2);
+#else
+    void *BaseAddress = 0;
+#endif
+
+    game_memory GameMemory = {};
+    GameMemory.PermanentStorageSize = Megabytes(64);
+    GameMemory.TransientStorageSize = Megabytes(128);
+
+    //Ring blocks hold up to a frame of sound, 8 of them. How much the game actually writes each frame is up to the
+    //audio scheduler.
+    int SamplesPerFrame = SoundOutput.SamplesPerSecond / Settings.GameUpdateHz;
+    uint32 AudioRingBlockCount = 8;
+    memory_index AudioRingSize = AudioRingMemorySize(AudioRingBlockCount, SamplesPerFrame);
+
+    //Capture frames hold a whole frame of pixels and as much sound as the scheduler ever writes in one frame
+    uint32 CaptureFrameCount = 8;
+    int CaptureMaxSampleCount = AudioRingBlockCount*SamplesPerFrame;
+    memory_index CaptureSize = 0;
+    if(Settings.CaptureName)
+    {
+        CaptureSize = CAPTURE_CACHE_LINE + CaptureMemorySize(CaptureFrameCount, Settings.Width, Settings.Height, CaptureMaxSampleCount);
+    }
+
+    //Same layout as on Windows: permanent storage, transient storage, one second of sound samples, the audio ring,
+    //the profiler's tables, then the capture frames if we are capturing
+    uint64 TotalSize = GameMemory.PermanentStorageSize + GameMemory.TransientStorageSize + SoundOutput.SecondaryBufferSize +
+                       AudioRingSize + DebugStorageSize() + CaptureSize;
+    bool32 UsedLargePages;
+    GameMemory.PermanentStorage = LinuxAllocateGameMemory(BaseAddress, TotalSize, Settings.LargePages, &UsedLargePages);
+    GameMemory.TransientStorage = ((uint8 *)GameMemory.PermanentStorage + GameMemory.PermanentStorageSize);
+    int16 *Samples = (int16 *)((uint8 *)GameMemory.TransientStorage + GameMemory.TransientStorageSize);
+    void *AudioRingMemory = (uint8 *)Samples + SoundOutput.SecondaryBufferSize;
+    void *DebugStorage = (uint8 *)AudioRingMemory + AudioRingSize;
+    void *CaptureMemory = (void *)CaptureAlign((memory_index)DebugStorage + DebugStorageSize());
+
+    linux_frame_timing *Timings = (linux_frame_timing *)LinuxAllocateMemory(Settings.FrameCount*sizeof(linux_frame_timing));
+    int64 *Latencies = (int64 *)LinuxAllocateMemory(Settings.FrameCount*sizeof(int64));
+    if(!SwapChainMemory || !GameMemory.PermanentStorage || !Timings || !Latencies)
+    {
+        fprintf(stderr, "Could not allocate benchmark memory\n");
+        return 1;
+    }
+
+    DebugInitialize(DebugStorage);
+    DebugNameThread("Main");
+
+    //The game renders a tile at a time on every thread of the queue, this one included
+    linux_work_queue RenderQueue;
+    if(!LinuxStartWorkQueue(&RenderQueue, Settings.ThreadCount))
+    {
+        fprintf(stderr, "Could not start the render queue\n");
+        return 1;
+    }
+    GameMemory.RenderQueue = RenderQueue.Queue;
+    GameMemory.PlatformAPI.AddEntry = LinuxAddEntry;
+    GameMemory.PlatformAPI.CompleteAllWork = LinuxCompleteAllWork;
+
+    //Asset loads are mostly waiting on the disk, one loader thread is plenty and leaves the cores to the renderer
+    linux_work_queue LoadQueue;
+    if(!LinuxStartWorkQueue(&LoadQueue, 2))
+    {
+        fprintf(stderr, "Could not start the asset load queue\n");
+        return 1;
+    }
+    GameMemory.LowPriorityQueue = LoadQueue.Queue;
+
+    char DefaultAssetPath[4096];
+    char *AssetPath = Settings.AssetPath ? Settings.AssetPath : LinuxGetDefaultAssetPath(DefaultAssetPath, sizeof(DefaultAssetPath));
+
+#if MIDNIGHT_MADNESS_INTERNAL
+    //Game memory points into the mapping, so it gets a fixed address too, for replays
+    void *AssetBaseAddress = (void *)Terabytes(3);
+#else
+    void *AssetBaseAddress = 0;
+#endif
+    int64 MapStart = LinuxGetNanoseconds();
+    GameMemory.AssetFileMemory = LinuxMapFile(AssetPath, AssetBaseAddress, &GameMemory.AssetFileSize);
+    int64 MapNanoseconds = LinuxGetNanoseconds() - MapStart;
+    if(!GameMemory.AssetFileMemory)
+    {
+        fprintf(stderr, "Could not map %s, running without assets\n", AssetPath);
+    }
+
+    audio_ring AudioRing;
+    InitializeAudioRing(&AudioRing, AudioRingBlockCount, SamplesPerFrame, AudioRingMemory);
+
+    audio_scheduler AudioScheduler;
+    InitializeAudioScheduler(&AudioScheduler, SoundOutput.SamplesPerSecond, AudioRingBlockCount*SamplesPerFrame, (float32)Settings.LatencyFrames);
+
+    //Before the audio thread runs, all we know is that the device will take a period at a time
+    audio_device_clock AudioClock = {};
+    AudioClock.WriteLeadSamples = Settings.PeriodSamples;
+    AudioClock.GranularitySamples = Settings.PeriodSamples;
+
+    linux_audio_thread AudioThread = {};
+    pthread_t AudioThreadHandle;
+    if(Settings.AudioThread)
+    {
+        AudioThread.Ring = &AudioRing;
+        AudioThread.Clock = &AudioClock;
+        AudioThread.SamplesPerSecond = SoundOutput.SamplesPerSecond;
+        AudioThread.PeriodSamples = Settings.PeriodSamples;
+        //The one second sample buffer isn't used when the ring is, and it is all zeros: perfect silence
+        AudioThread.Silence = Samples;
+        AudioThread.Running = true;
+        if(Settings.WavPath)
+        {
+            AudioThread.Wav = fopen(Settings.WavPath, "wb");
+            if(!AudioThread.Wav)
+            {
+                fprintf(stderr, "Could not open %s\n", Settings.WavPath);
+                return 1;
+            }
+            LinuxWriteWavHeader(AudioThread.Wav, SoundOutput.SamplesPerSecond, 0);
+        }
+    }
+
+    capture_queue CaptureQueue;
+    linux_capture_thread CaptureThread = {};
+    pthread_t CaptureThreadHandle;
+    char CaptureFrameFileName[4096];
+    char CaptureWavFileName[4096];
+    if(Settings.CaptureName)
+    {
+        InitializeCaptureQueue(&CaptureQueue, CaptureFrameCount, Settings.Width, Settings.Height, CaptureMaxSampleCount,
+                               Settings.CaptureFormat, CaptureMemory);
+
+        snprintf(CaptureFrameFileName, sizeof(CaptureFrameFileName), "%s.%s", Settings.CaptureName,
+                 (Settings.CaptureFormat == CaptureFormat_PPM) ? "ppm" : "raw");
+        snprintf(CaptureWavFileName, sizeof(CaptureWavFileName), "%s.wav", Settings.CaptureName);
+        CaptureThread.Queue = &CaptureQueue;
+        CaptureThread.SamplesPerSecond = SoundOutput.SamplesPerSecond;
+        CaptureThread.FrameFile = open(CaptureFrameFileName, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        CaptureThread.WavFile = open(CaptureWavFileName, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        if((CaptureThread.FrameFile < 0) || (CaptureThread.WavFile < 0))
+        {
+            fprintf(stderr, "Could not open %s and %s\n", CaptureFrameFileName, CaptureWavFileName);
+            return 1;
+        }
+
+        //The WAV header gets its sizes when the capture stops, until then the samples go in after an empty one
+        wav_header WavHeader = MakeWavHeader(SoundOutput.SamplesPerSecond, 0);
+        LinuxWriteAll(CaptureThread.WavFile, &WavHeader, sizeof(WavHeader));
+
+        sem_init(&CaptureThread.FramesPublished, 0, 0);
+        CaptureThread.Running = true;
+        int Error = pthread_create(&CaptureThreadHandle, 0, LinuxCaptureThreadProc, &CaptureThread);
+        if(Error != 0)
+        {
+            //Without a writer the run goes on uncaptured, nothing publishes frames and nothing is joined at the end
+            fprintf(stderr, "Could not start the capture thread, not capturing: %s\n", strerror(Error));
+            CaptureThread.Running = false;
+            close(CaptureThread.FrameFile);
+            close(CaptureThread.WavFile);
+            unlink(CaptureFrameFileName);
+            unlink(CaptureWavFileName);
+            sem_destroy(&CaptureThread.FramesPublished);
+            Settings.CaptureName = 0;
+        }
+    }
+
+    //Record and playback only cover the game's own memory, not the platform's sound buffer, ring or profiler tables
+    linux_replay Replay = {};
+    Replay.GameMemoryBlock = GameMemory.PermanentStorage;
+    Replay.GameMemorySize = GameMemory.PermanentStorageSize + GameMemory.TransientStorageSize;
+    Replay.LoadQueue = LoadQueue.Queue;
+
+    game_input Input[2] = {};
+    game_input *NewInput = &Input[0];
+    game_input *OldInput = &Input[1];
+
+    frame_pacer Pacer;
+    InitializeFramePacer(&Pacer, 1000000000LL, Settings.GameUpdateHz, LinuxGetNanoseconds());
+    int64 MeasuredStart = 0;
+    float64 MeasuredCPUStart = 0.0;
+
+    uint64 MeasuredPageFaults = 0;
+    uint64 MaxPageFaultsPerFrame = 0;
+    float64 MeasuredPixelCount = 0.0;
+    int64 LastFrameEnd = LinuxGetNanoseconds();
+    int64 FirstFrameNanoseconds = 0;
+
+    frame_pipeline Pipeline;
+    InitializeFramePipeline(&Pipeline, Settings.PipelineDepth);
+    InitializeOverlay(&GlobalOverlay);
+
+    linux_render_thread RenderThread = {};
+    RenderThread.Pipeline = &Pipeline;
+    RenderThread.Settings = &Settings;
+    RenderThread.GameMemory = &GameMemory;
+    RenderThread.SwapChain = &SwapChain;
+    RenderThread.CaptureQueue = &CaptureQueue;
+    RenderThread.AudioRing = &AudioRing;
+    RenderThread.AudioScheduler = &AudioScheduler;
+    RenderThread.AudioClock = &AudioClock;
+    RenderThread.Replay = &Replay;
+    RenderThread.Samples = Samples;
+    RenderThread.SamplesPerFrame = SamplesPerFrame;
+    RenderThread.SamplesPerSecond = SoundOutput.SamplesPerSecond;
+    pthread_t RenderThreadHandle;
+    if(Settings.PipelineDepth)
+    {
+        sem_init(&RenderThread.FramesSubmitted, 0, 0);
+        sem_init(&RenderThread.FramesRendered, 0, 0);
+        RenderThread.Running = true;
+        int Error = pthread_create(&RenderThreadHandle, 0, LinuxRenderThreadProc, &RenderThread);
+        if(Error != 0)
+        {
+            //Without the thread, the frames are rendered here one at a time, and nothing is joined at the end
+            fprintf(stderr, "Could not start the render thread, rendering without a pipeline: %s\n", strerror(Error));
+            RenderThread.Running = false;
+            sem_destroy(&RenderThread.FramesSubmitted);
+            sem_destroy(&RenderThread.FramesRendered);
+            Settings.PipelineDepth = 0;
+            Pipeline.Depth = 0;
+        }
+    }
+
+    //The injected key is one the game ignores, so the game ends up in the same state with or without it
+    linux_input_injector Injector = {};
+    pthread_t InjectorHandle;
+    input_latency_stats InputLatency;
+    InitializeInputLatencyStats(&InputLatency, 1000000000LL);
+    if(Settings.InjectTapsPerSecond)
+    {
+        game_controller_input *Keyboard = GetController(NewInput, 0);
+        Injector.TapsPerSecond = Settings.InjectTapsPerSecond;
+        Injector.ButtonIndex = (uint32)(&Keyboard->RightShoulder - Keyboard->Buttons);
+        Injector.RandomState = 0x9E3779B9;
+        Injector.Running = true;
+        int Error = pthread_create(&InjectorHandle, 0, LinuxInputInjectorProc, &Injector);
+        if(Error != 0)
+        {
+            //The run goes on without injected input, so there is nothing to drain, join or report
+            fprintf(stderr, "Could not start the input injector thread, not injecting: %s\n", strerror(Error));
+            Injector.Running = false;
+            Settings.InjectTapsPerSecond = 0;
+        }
+    }
+
+    //Frames are submitted in order and presented in order, the render thread up to -pipeline frames ahead
+    int TotalFrameCount = Settings.WarmupFrameCount + Settings.FrameCount;
+    int SubmitIndex = 0;
+    while(Pipeline.PresentedCount < (uint32)TotalFrameCount)
+    {
+        //The end of the warm-up (which can snapshot game memory or restore it) and a resize of the backbuffers both
+        //wait for every frame in flight to be out, so nothing is rendering while they happen
+        bool32 WarmupEnds = (SubmitIndex == Settings.WarmupFrameCount);
+        bool32 Resizes = (Settings.ResizeEvery && SubmitIndex && ((SubmitIndex % Settings.ResizeEvery) == 0));
+        bool32 CanSubmit = ((SubmitIndex < TotalFrameCount) && (!(WarmupEnds || Resizes) || FramePipelineIsEmpty(&Pipeline)));
+        if(CanSubmit)
+        {
+            int FrameIndex = SubmitIndex++;
+
+            if(WarmupEnds)
+            {
+                if(Settings.RecordName && !LinuxBeginRecordingInput(&Replay, Settings.RecordName))
+                {
+                    return 1;
+                }
+                if(Settings.PlaybackName && !LinuxBeginInputPlayback(&Replay, Settings.PlaybackName))
+                {
+                    return 1;
+                }
+
+                ResetFramePacerStats(&Pacer);
+                ResetFramePipelineStats(&Pipeline);
+                ResetInputLatencyStats(&InputLatency);
+                MeasuredStart = LinuxGetNanoseconds();
+                MeasuredCPUStart = LinuxGetCPUSeconds();
+            }
+
+            //Stands in for the window being resized: back and forth between the size asked for and three quarters of it
+            if(Resizes)
+            {
+                bool32 Smaller = (SwapChain.Width == Settings.Width);
+                ResizeSwapChain(&SwapChain, Smaller ? (3*Settings.Width + 3)/4 : Settings.Width,
+                                Smaller ? (3*Settings.Height + 3)/4 : Settings.Height, Settings.PixelFormat);
+            }
+
+            //The frame's latency counts from here
+            int64 InputNanoseconds = LinuxGetNanoseconds();
+
+            //Buttons stay where they were last frame until something moves them
+            game_controller_input *OldKeyboard = GetController(OldInput, 0);
+            game_controller_input *NewKeyboard = GetController(NewInput, 0);
+            *NewKeyboard = {};
+            NewKeyboard->IsConnected = true;
+            for(int ButtonIndex = 0; ButtonIndex < ArrayCount(NewKeyboard->Buttons); ++ButtonIndex)
+            {
+                NewKeyboard->Buttons[ButtonIndex].EndedDown = OldKeyboard->Buttons[ButtonIndex].EndedDown;
+            }
+            LinuxSynthesizeInput(FrameIndex, NewKeyboard);
+            input_event_batch InputEvents = {};
+            if(Settings.InjectTapsPerSecond)
+            {
+                LinuxDrainInjectedInput(&Injector, NewKeyboard, &InputEvents);
+            }
+
+            uint32 PlatformFlags = 0;
+            if(Replay.RecordingHandle)
+            {
+                LinuxRecordInput(&Replay, NewInput);
+            }
+            if(Replay.PlaybackHandle && LinuxPlaybackInput(&Replay, NewInput))
+            {
+                PlatformFlags |= LinuxFrame_RestoreSnapshot | ((Replay.LoopCount == 1) ? LinuxFrame_FirstLoopEnded : 0);
+            }
+
+            frame_pipeline_slot *Slot = BeginFrameSubmit(&Pipeline);
+            Slot->Input = *NewInput;
+            Slot->FrameIndex = FrameIndex;
+            Slot->PlatformFlags = PlatformFlags;
+            Slot->InputTicks = InputNanoseconds;
+            Slot->ExpectedFrameSeconds = FramePacerTargetSeconds(&Pacer);
+            Slot->InputEvents = InputEvents;
+            EndFrameSubmit(&Pipeline);
+
+            if(Settings.PipelineDepth)
+            {
+                sem_post(&RenderThread.FramesSubmitted);
+            }
+            else
+            {
+                LinuxRenderFrame(&RenderThread, BeginFrameRender(&Pipeline));
+                EndFrameRender(&Pipeline);
+            }
+
+            game_input *Temp = NewInput;
+            NewInput = OldInput;
+            OldInput = Temp;
+        }
+
+        //The oldest frame goes out once there are more in flight than the pipeline is deep, and all of them do before
+        //the warm-up ends, a resize, or the end of the run
+        if(FramePipelineMustPresent(&Pipeline) || (!CanSubmit && !FramePipelineIsEmpty(&Pipeline)))
+        {
+            frame_pipeline_slot *Slot;
+            while((Slot = BeginFramePresent(&Pipeline)) == 0)
+            {
+                //Only with a render thread, without one every frame is rendered by the time it is submitted
+                sem_wait(&RenderThread.FramesRendered);
+            }
+            int FrameIndex = (int)Slot->FrameIndex;
+            game_offscreen_buffer *Buffer = &Slot->Buffer;
+            capture_frame *CaptureFrame = Slot->CaptureFrame;
+            int64 RenderNanoseconds = Slot->RenderEndTicks - Slot->RenderStartTicks;
+
+            //Drawn before presenting and capturing, so it is in whatever goes out
+            if(Settings.Overlay)
+            {
+                int64 OverlayStart = LinuxGetNanoseconds();
+                BeginOverlayText(&GlobalOverlay);
+                OverlayPrint(&GlobalOverlay, "Frame %d  %dx%d %s  %s  %d threads", FrameIndex, Buffer->Width, Buffer->Height,
+                             PixelFormatNames[Buffer->Format], SIMDLevelNames[SIMDLevel], Settings.ThreadCount);
+                OverlayPrint(&GlobalOverlay, "Render %.3f ms  %.2f Mcycles", RenderNanoseconds / 1.0e6,
+                             (float64)Slot->RenderCycles / 1.0e6);
+                OverlayPrint(&GlobalOverlay, "Input to present %.3f ms (last frame)  pipeline depth %d",
+                             LastLatencyNanoseconds / 1.0e6, Settings.PipelineDepth);
+                if(Settings.AudioThread)
+                {
+                    OverlayPrint(&GlobalOverlay, "Audio latency %.1f ms  max %.1f ms  underruns %u",
+                                 AudioScheduler.LastLatencySeconds*1000.0f, AudioScheduler.MaxLatencySeconds*1000.0f,
+                                 AudioRing.UnderrunCount);
+                }
+                OverlayPrint(&GlobalOverlay, "Overlay %.1f us (last frame)", LastOverlayNanoseconds / 1.0e3);
+                OverlayPrintProfile(&GlobalOverlay, 8);
+                DrawOverlay(&GlobalOverlay, Buffer);
+
+                LastOverlayNanoseconds = LinuxGetNanoseconds() - OverlayStart;
+                if(FrameIndex >= Settings.WarmupFrameCount)
+                {
+                    OverlayNanoseconds += LastOverlayNanoseconds;
+                    MaxOverlayNanoseconds = (LastOverlayNanoseconds > MaxOverlayNanoseconds) ? LastOverlayNanoseconds : MaxOverlayNanoseconds;
+                }
+            }
+
+            //Timed on its own, it is the platform's cost and not the game's
+            if(PresentScaler)
+            {
+                game_offscreen_buffer PresentTarget = {};
+                PresentTarget.Memory = PresentBuffer.Memory;
+                PresentTarget.Width = PresentBuffer.Width;
+                PresentTarget.Height = PresentBuffer.Height;
+                PresentTarget.Pitch = PresentBuffer.Pitch;
+                PresentTarget.Format = PixelFormat_BGRX8888;
+                int64 PresentStart = LinuxGetNanoseconds();
+                bool32 Presented = PresentScaled(PresentScaler, Buffer, &PresentTarget);
+                int64 Nanoseconds = LinuxGetNanoseconds() - PresentStart;
+                if(!Presented)
+                {
+                    ++FailedPresentCount;
+                }
+                else if(FrameIndex >= Settings.WarmupFrameCount)
+                {
+                    PresentNanoseconds += Nanoseconds;
+                    MaxPresentNanoseconds = (Nanoseconds > MaxPresentNanoseconds) ? Nanoseconds : MaxPresentNanoseconds;
+                }
+            }
+            if(FrameIndex == 0)
+            {
+                //The game initializes itself in its first frame, this is its part of the startup time
+                FirstFrameNanoseconds = RenderNanoseconds;
+            }
+
+            if(Settings.AudioThread && (FrameIndex == 0))
+            {
+                //Start playing once the first frame's sound is in the ring, so the device doesn't begin with an underrun
+                pthread_create(&AudioThreadHandle, 0, LinuxAudioThreadProc, &AudioThread);
+            }
+
+            if(Settings.Pace)
+            {
+                LinuxWaitForNextFrame(&Pacer);
+            }
+
+            //The frame is out, the writer can have it
+            if(CaptureFrame)
+            {
+                EndCaptureFrame(&CaptureQueue);
+                sem_post(&CaptureThread.FramesPublished);
+            }
+
+            //Warm-up frames fault in the pages and fill the caches, they are not part of the result
+            if(FrameIndex >= Settings.WarmupFrameCount)
+            {
+                linux_frame_timing *Timing = Timings + (FrameIndex - Settings.WarmupFrameCount);
+                Timing->Nanoseconds = RenderNanoseconds;
+                Timing->Cycles = Slot->RenderCycles;
+                MeasuredPixelCount += (float64)Buffer->Width*(float64)Buffer->Height;
+
+                MeasuredPageFaults += Slot->PageFaults;
+                if(Slot->PageFaults > MaxPageFaultsPerFrame)
+                {
+                    MaxPageFaultsPerFrame = Slot->PageFaults;
+                }
+            }
+
+            int64 FrameEnd = LinuxGetNanoseconds();
+            RecordInputLatencies(&InputLatency, &Slot->InputEvents, Slot->InputTicks, Slot->RenderEndTicks, FrameEnd);
+            int64 LatencyNanoseconds = EndFramePresent(&Pipeline, Slot, FrameEnd);
+            LastLatencyNanoseconds = LatencyNanoseconds;
+            if(FrameIndex >= Settings.WarmupFrameCount)
+            {
+                Latencies[FrameIndex - Settings.WarmupFrameCount] = LatencyNanoseconds;
+            }
+            DebugEndFrame((float32)(FrameEnd - LastFrameEnd) / 1.0e9f);
+            LastFrameEnd = FrameEnd;
+        }
+    }
+
+    if(Settings.PipelineDepth)
+    {
+        RenderThread.Running = false;
+        sem_post(&RenderThread.FramesSubmitted);
+        pthread_join(RenderThreadHandle, 0);
+        sem_destroy(&RenderThread.FramesSubmitted);
+        sem_destroy(&RenderThread.FramesRendered);
+    }
+
+    if(Settings.InjectTapsPerSecond)
+    {
+        Injector.Running = false;
+        pthread_join(InjectorHandle, 0);
+    }
+
+    float64 MeasuredSeconds = (LinuxGetNanoseconds() - MeasuredStart) / 1.0e9;
+    float64 MeasuredCPUSeconds = LinuxGetCPUSeconds() - MeasuredCPUStart;
+
+    if(Settings.CaptureName)
+    {
+        CaptureThread.Running = false;
+        sem_post(&CaptureThread.FramesPublished);
+        pthread_join(CaptureThreadHandle, 0);
+        close(CaptureThread.FrameFile);
+        close(CaptureThread.WavFile);
+        sem_destroy(&CaptureThread.FramesPublished);
+    }
+
+    if(Settings.AudioThread)
+    {
+        AudioThread.Running = false;
+        pthread_join(AudioThreadHandle, 0);
+        if(AudioThread.Wav)
+        {
+            LinuxWriteWavHeader(AudioThread.Wav, SoundOutput.SamplesPerSecond, AudioThread.WavDataBytes);
+            fclose(AudioThread.Wav);
+        }
+    }
+
+    LinuxStopWorkQueue(&RenderQueue);
+
+    //Whatever hasn't loaded by now never will be used, it is only counted
+    uint32 LoadsQueued = AtomicLoadAcquire(&LoadQueue.Queue->CompletionGoal);
+    uint32 LoadsDone = AtomicLoadAcquire(&LoadQueue.Queue->CompletionCount);
+    LinuxStopWorkQueue(&LoadQueue);
+
+    int64 TotalNanoseconds = 0;
+    int64 TotalCycles = 0;
+    for(int FrameIndex = 0; FrameIndex < Settings.FrameCount; ++FrameIndex)
+    {
+        TotalNanoseconds += Timings[FrameIndex].Nanoseconds;
+        TotalCycles += Timings[FrameIndex].Cycles;
+    }
+
+    qsort(Timings, Settings.FrameCount, sizeof(linux_frame_timing), LinuxCompareTimings);
+    linux_frame_timing *Min = Timings;
+    linux_frame_timing *Median = Timings + Settings.FrameCount/2;
+    linux_frame_timing *P99 = Timings + ((Settings.FrameCount - 1)*99)/100;
+
+    float64 TotalSeconds = (float64)TotalNanoseconds / 1.0e9;
+    float64 PixelCount = MeasuredPixelCount;
+    float64 SampleCount = (float64)SamplesPerFrame*(float64)Settings.FrameCount;
+
+    printf("Frames: %d (+%d warm-up)  |  %dx%d %s  |  %d Hz audio, %d samples per frame  |  %s, %s blending  |  %d threads\n",
+           Settings.FrameCount, Settings.WarmupFrameCount, Settings.Width, Settings.Height, PixelFormatNames[Settings.PixelFormat],
+           SoundOutput.SamplesPerSecond, SamplesPerFrame, SIMDLevelNames[SIMDLevel], BlendSpaceNames[Settings.BlendSpace],
+           Settings.ThreadCount);
+    printf("Per frame:  %.0f ns  |  %.0f cycles  (mean)\n",
+           (float64)TotalNanoseconds / Settings.FrameCount, (float64)TotalCycles / Settings.FrameCount);
+    printf("Frame time: min %.3f ms  |  median %.3f ms  |  p99 %.3f ms\n",
+           Min->Nanoseconds / 1.0e6, Median->Nanoseconds / 1.0e6, P99->Nanoseconds / 1.0e6);
+    printf("Throughput: %.1f Mpixels/s  |  %.0f samples/s\n",
+           PixelCount / TotalSeconds / 1.0e6, SampleCount / TotalSeconds);
+
+    //What the pipeline depth trades: frames out per second of wall time against input to present latency
+    qsort(Latencies, Settings.FrameCount, sizeof(int64), LinuxCompareInt64);
+    printf("Pipeline:   depth %d (%s)  |  %.1f frames/s  |  input to present: mean %.3f ms, median %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           Settings.PipelineDepth, Settings.PipelineDepth ? "render thread" : "one thread", Settings.FrameCount / MeasuredSeconds,
+           (float64)Pipeline.LatencyTicksSum / Pipeline.LatencyCount / 1.0e6, Latencies[Settings.FrameCount/2] / 1.0e6,
+           Latencies[((Settings.FrameCount - 1)*99)/100] / 1.0e6, Pipeline.MaxLatencyTicks / 1.0e6);
+    if(Settings.InjectTapsPerSecond)
+    {
+        //Every injected press and release over the measured frames, from when it was injected to when it was presented
+        printf("Input:      %u events at %d taps/s (%u dropped, %u untimed)  |  event to present: mean %.3f ms, p50 %.2f ms, p90 %.2f ms, "
+               "p99 %.2f ms, max %.3f ms  |  queued %.3f ms, rendering %.3f ms, presenting %.3f ms (mean)\n",
+               InputLatency.EventCount, Settings.InjectTapsPerSecond, Injector.DroppedCount, InputLatency.DroppedCount,
+               InputLatencyMean(&InputLatency, InputLatency.Sum)*1000.0f, InputLatencyPercentile(&InputLatency, 50.0f)*1000.0f,
+               InputLatencyPercentile(&InputLatency, 90.0f)*1000.0f, InputLatencyPercentile(&InputLatency, 99.0f)*1000.0f,
+               InputLatency.MaxSeconds*1000.0f, InputLatencyMean(&InputLatency, InputLatency.QueuedSum)*1000.0f,
+               InputLatencyMean(&InputLatency, InputLatency.RenderingSum)*1000.0f,
+               InputLatencyMean(&InputLatency, InputLatency.PresentingSum)*1000.0f);
+    }
+    printf("Memory:     %llu MB at %p%s  |  page faults %llu over measured frames (max %llu in one frame)\n",
+           (unsigned long long)(TotalSize / Megabytes(1)), GameMemory.PermanentStorage, UsedLargePages ? " (large pages)" : "",
+           (unsigned long long)MeasuredPageFaults, (unsigned long long)MaxPageFaultsPerFrame);
+    if(PresentScaler)
+    {
+        present_layout Layout = PresentScaler->Layout;
+        printf("Present:    %dx%d into %dx%d (picture %dx%d, ", Layout.SourceWidth, Layout.SourceHeight,
+               PresentBuffer.Width, PresentBuffer.Height, Layout.Width, Layout.Height);
+        if(Layout.IntegerScale)
+        {
+            printf("integer %dx", Layout.IntegerScale);
+        }
+        else
+        {
+            printf("bilinear");
+        }
+        printf(")  |  mean %.3f ms  |  max %.3f ms\n", (float64)PresentNanoseconds / Settings.FrameCount / 1.0e6,
+               (float64)MaxPresentNanoseconds / 1.0e6);
+        if(FailedPresentCount)
+        {
+            printf("Present:    %d frames could not be presented\n", FailedPresentCount);
+        }
+    }
+    if(Settings.Overlay)
+    {
+        printf("Overlay:    mean %.1f us  |  max %.1f us  |  %.2f%% of the mean frame\n",
+               (float64)OverlayNanoseconds / Settings.FrameCount / 1.0e3, (float64)MaxOverlayNanoseconds / 1.0e3,
+               100.0*(float64)OverlayNanoseconds / (float64)TotalNanoseconds);
+    }
+    //The resizes happen between frames, so their cycles are turned into time at the rate the measured frames ran at
+    float64 CyclesPerMillisecond = (float64)TotalCycles / ((float64)TotalNanoseconds / 1.0e6);
+    printf("Swap chain: %d x %dx%d %s in one %.1f MB block  |  %llu swaps  |  %llu resizes, mean %.3f ms, max %.3f ms\n",
+           SwapChain.BufferCount, SwapChain.Width, SwapChain.Height, PixelFormatNames[SwapChain.Format],
+           (float64)SwapChainSize / (float64)Megabytes(1), (unsigned long long)SwapChain.SwapCount,
+           (unsigned long long)SwapChain.ResizeCount,
+           (float64)SwapChain.ResizeCycles / (float64)SwapChain.ResizeCount / CyclesPerMillisecond,
+           (float64)SwapChain.MaxResizeCycles / CyclesPerMillisecond);
+    if(GameMemory.AssetFileMemory)
+    {
+        mma_header *AssetHeader = (mma_header *)GameMemory.AssetFileMemory;
+        uint32 AssetCount = (GameMemory.AssetFileSize >= sizeof(mma_header)) ? AssetHeader->AssetCount : 0;
+        printf("Assets:     %u in %s (%.1f MB)  |  mapped in %.1f us, first frame %.3f ms  |  %u of %u loads done\n",
+               AssetCount, AssetPath, (float64)GameMemory.AssetFileSize / (float64)Megabytes(1), MapNanoseconds / 1.0e3,
+               FirstFrameNanoseconds / 1.0e6, LoadsDone, LoadsQueued);
+    }
+    if(Settings.AudioThread)
+    {
+        printf("Audio ring: %u blocks played%s%s  |  underruns %u  |  overruns %u\n",
+               AudioThread.BlocksPlayed, Settings.WavPath ? " into " : "", Settings.WavPath ? Settings.WavPath : "",
+               AudioRing.UnderrunCount, AudioRing.OverrunCount);
+        printf("Audio latency: last %.1f ms  |  max %.1f ms  |  samples per frame %d-%d  |  period %u, service interval %u samples\n",
+               AudioScheduler.LastLatencySeconds*1000.0f, AudioScheduler.MaxLatencySeconds*1000.0f,
+               AudioScheduler.MinSampleCount, AudioScheduler.MaxSampleCount,
+               AudioClock.GranularitySamples, AudioClock.ServiceIntervalSamples);
+    }
+
+    if(Settings.CaptureName)
+    {
+        printf("Capture:    %u frames to %s, %u samples to %s%s  |  dropped %u  |  writer %.2f ms per frame\n",
+               CaptureThread.FramesWritten, CaptureFrameFileName, CaptureThread.WavDataBytes / 4, CaptureWavFileName,
+               CaptureThread.WriteFailed ? " (WRITE FAILED)" : "", CaptureQueue.DroppedFrameCount,
+               CaptureThread.FramesWritten ? CaptureThread.WriteNanoseconds / 1.0e6 / CaptureThread.FramesWritten : 0.0);
+    }
+
+    if(Settings.RecordName || Settings.PlaybackName)
+    {
+        uint64 Checksum = LinuxChecksumMemory(Replay.GameMemoryBlock, Replay.GameMemorySize);
+        if(Replay.RecordingHandle)
+        {
+            LinuxEndRecordingInput(&Replay);
+            printf("Replay:     recorded %u frames to %s.state and %s.input  |  state checksum %016llx\n",
+                   Replay.FrameCount, Settings.RecordName, Settings.RecordName, (unsigned long long)Checksum);
+        }
+        else if(Replay.PlaybackHandle)
+        {
+            printf("Replay:     played %s, %u full loops + %u frames  |  state checksum %016llx",
+                   Settings.PlaybackName, Replay.LoopCount, Replay.FrameCount, (unsigned long long)Checksum);
+            if(Replay.LoopCount)
+            {
+                printf(", %016llx at the end of the first loop", (unsigned long long)Replay.FirstLoopChecksum);
+            }
+            printf("\n");
+        }
+    }
+
+    if(Settings.Pace)
+    {
+        frame_time_histogram *FrameTimes = &Pacer.FrameTimes;
+        printf("Pacing:     %d Hz (%.3f ms)  |  mean %.3f ms, std dev %.3f ms  |  p50 %.2f ms, p99 %.2f ms  |  missed %u of %u\n",
+               Settings.GameUpdateHz, FramePacerTargetSeconds(&Pacer)*1000.0f,
+               FrameTimeMean(FrameTimes)*1000.0f, FrameTimeStandardDeviation(FrameTimes)*1000.0f,
+               FrameTimePercentile(FrameTimes, 50.0f)*1000.0f, FrameTimePercentile(FrameTimes, 99.0f)*1000.0f,
+               Pacer.MissedFrameCount, Pacer.FrameCount);
+        printf("            spin %.1f us per frame, sleep margin %.1f us  |  process CPU %.1f%% of one core\n",
+               Pacer.FrameCount ? Pacer.SpinTicks / 1.0e3 / Pacer.FrameCount : 0.0, Pacer.SleepMargin / 1.0e3,
+               MeasuredSeconds > 0.0 ? 100.0*MeasuredCPUSeconds / MeasuredSeconds : 0.0);
+
+        //The histogram of the last FRAME_TIME_HISTORY frames, only the buckets that have any
+        uint32 MostInABucket = 1;
+        for(int BucketIndex = 0; BucketIndex < FRAME_HISTOGRAM_BUCKET_COUNT; ++BucketIndex)
+        {
+            MostInABucket = (FrameTimes->Buckets[BucketIndex] > MostInABucket) ? FrameTimes->Buckets[BucketIndex] : MostInABucket;
+        }
+        for(int BucketIndex = 0; BucketIndex < FRAME_HISTOGRAM_BUCKET_COUNT; ++BucketIndex)
+        {
+            uint32 Count = FrameTimes->Buckets[BucketIndex];
+            if(Count)
+            {
+                char Bar[51];
+                int BarLength = (int)((50*(uint64)Count + MostInABucket - 1) / MostInABucket);
+                memset(Bar, '#', BarLength);
+                Bar[BarLength] = 0;
+                printf("  %6.2f ms%s %5u %s\n", (BucketIndex + 1)*FRAME_HISTOGRAM_BUCKET_SECONDS*1000.0f,
+                       (BucketIndex == FRAME_HISTOGRAM_BUCKET_COUNT - 1) ? "+" : " ", Count, Bar);
+            }
+        }
+    }
+
+    if(Settings.Profile || Settings.TracePath)
+    {
+        memory_index TextSize = Megabytes(32);
+        char *Text = (char *)LinuxAllocateMemory(TextSize);
+        if(Text && Settings.Profile)
+        {
+            DebugWriteSummary(Text, TextSize);
+            printf("%s", Text);
+        }
+        if(Text && Settings.TracePath)
+        {
+            memory_index TraceSize = DebugWriteChromeTrace(Text, TextSize);
+            FILE *Trace = fopen(Settings.TracePath, "wb");
+            if(Trace)
+            {
+                fwrite(Text, TraceSize, 1, Trace);
+                fclose(Trace);
+                printf("Trace:      %llu KB written to %s\n", (unsigned long long)(TraceSize / Kilobytes(1)), Settings.TracePath);
+            }
+            else
+            {
+                fprintf(stderr, "Could not open %s\n", Settings.TracePath);
+            }
+        }
+    }
+
+    return 0;
+}
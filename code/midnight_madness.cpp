@@ -1,54 +1,240 @@
 #include "midnight_madness.h"
 
-internal void GameOutputSound(game_sound_output_buffer *SoundBuffer, int ToneHz)
+global_variable simd_level GlobalSIMDLevel = SIMDLevel_Scalar;
+global_variable blend_space GlobalBlendSpace = BlendSpace_SRGB;
+
+internal simd_level DetectSIMDLevel(void)
 {
-    local_persist float32 tSine;
-    int16 ToneVolume = 3000;
-    int WavePeriod = SoundBuffer->SamplesPerSecond/ToneHz;
+    simd_level Result = SIMDLevel_Scalar;
+
+    cpuid_result Leaf1 = CPUID(1, 0);
+    if(Leaf1.EDX & (1 << 26))
+    {
+        Result = SIMDLevel_SSE2;
+    }
+
+    //AVX2 needs both the CPU flag and an OS that saves the YMM registers (OSXSAVE + XCR0 bits 1 and 2)
+    cpuid_result Leaf0 = CPUID(0, 0);
+    bool32 OSSavesYMM = (Leaf1.ECX & (1 << 27)) && ((ReadXCR0() & 0x6) == 0x6);
+    if((Leaf0.EAX >= 7) && OSSavesYMM)
+    {
+        cpuid_result Leaf7 = CPUID(7, 0);
+        if(Leaf7.EBX & (1 << 5))
+        {
+            Result = SIMDLevel_AVX2;
+        }
+    }
+
+    return(Result);
+}
+
+internal simd_level GameSelectSIMDLevel(simd_level Requested)
+{
+    simd_level Supported = DetectSIMDLevel();
+    if((Requested == SIMDLevel_Auto) || (Requested > Supported))
+    {
+        GlobalSIMDLevel = Supported;
+    }
+    else
+    {
+        GlobalSIMDLevel = Requested;
+    }
+    return(GlobalSIMDLevel);
+}
+
+#include "midnight_madness_audio.cpp"
+#include "midnight_madness_debug.cpp"
+#include "midnight_madness_render.cpp"
+#include "midnight_madness_world.cpp"
+#include "midnight_madness_asset.cpp"
 
-    int16 *SampleOut = SoundBuffer->Samples;
+internal void GameOutputSound(game_state *GameState, game_sound_output_buffer *SoundBuffer)
+{
+    //The update only records which tone it wants, the frequency depends on the sample rate so it is set here
+    if(GameState->PlayingToneHz != GameState->ToneHz)
+    {
+        SetOscillatorFrequency(GameState->Oscillators.Voices + 0, (float32)GameState->ToneHz, SoundBuffer->SamplesPerSecond);
+        GameState->PlayingToneHz = GameState->ToneHz;
+    }
 
-    for(int i = 0; i < SoundBuffer->SampleCount; ++i)
+    //Everything is mixed in float32, one buffer per channel, then converted to int16 once at the end.
+    //The buffers are rounded up to a whole number of AVX2 registers.
+    temporary_memory MixMemory = BeginTemporaryMemory(&GameState->TransientArena);
+    int MixSampleCount = (SoundBuffer->SampleCount + 7) & ~7;
+    float32 *Channel0 = PushArray(&GameState->TransientArena, MixSampleCount, float32);
+    float32 *Channel1 = PushArray(&GameState->TransientArena, MixSampleCount, float32);
+    for(int i = 0; i < MixSampleCount; ++i)
     {
-        float32 SineValue = sinf(tSine);
-        int16 SampleValue = (int16)(SineValue * ToneVolume);
-        *SampleOut++ = SampleValue;
-        *SampleOut++ = SampleValue;
+        Channel0[i] = 0.0f;
+    }
 
-        tSine += 2.0f * Pi32 * 1.0f / (float32)WavePeriod;
+    //The oscillators are mono, so they go into the left channel and are copied to the right
+    RenderOscillatorBank(&GameState->Oscillators, SoundBuffer->SampleCount, Channel0);
+    for(int i = 0; i < MixSampleCount; ++i)
+    {
+        Channel1[i] = Channel0[i];
     }
+
+    MixPlayingSounds(&GameState->AudioState, SoundBuffer->SampleCount, Channel0, Channel1);
+    ConvertChannelsToInt16(SoundBuffer->SampleCount, Channel0, Channel1, SoundBuffer->Samples);
+
+    EndTemporaryMemory(MixMemory);
 }
-internal void RenderWeirdGradient(game_offscreen_buffer *Buffer, int XOffset, int YOffset)
+
+internal void GameUpdateAndRender(game_memory *Memory, game_input *Input, game_offscreen_buffer *Buffer)
 {
-    int Width = Buffer->Width;
-    int Height = Buffer->Height;
+    TIMED_FUNCTION();
 
-    uint8 *Row = (uint8 *)Buffer->Memory;
-    for(int Y = 0; Y < Buffer->Height; ++Y)
+    Assert(sizeof(game_state) <= Memory->PermanentStorageSize);
+
+    game_state *GameState = (game_state *)Memory->PermanentStorage;
+    if(!Memory->IsInitialized)
     {
-        uint32 *Pixel = (uint32 *)Row;
-        for(int X = 0; X < Buffer->Width; ++X)
+        //The game_state sits at the very start of permanent storage, everything after it is for the permanent arena
+        InitializeArena(&GameState->PermanentArena, Memory->PermanentStorageSize - sizeof(game_state),
+                        (uint8 *)Memory->PermanentStorage + sizeof(game_state));
+        InitializeArena(&GameState->TransientArena, Memory->TransientStorageSize, Memory->TransientStorage);
+
+        //The same 256 Hz test tone as before, now as voice 0 of the oscillator bank
+        int16 ToneVolume = 3000;
+        AddOscillator(&GameState->Oscillators, Waveform_Sine, 0.0f, ToneVolume, 1);
+        GameState->ToneHz = 256;
+        GameState->PlayingToneHz = 0;
+
+        InitializeAudioState(&GameState->AudioState, &GameState->PermanentArena);
+
+        InitializeWorld(&GameState->World);
+        GenerateTestWorld(&GameState->World, &GameState->PermanentArena);
+
+        InitializeTiledBackground(&GameState->Background, &GameState->PermanentArena, 256, 256);
+        GameState->TestSprite = MakeTestSprite(&GameState->PermanentArena, 64, 64);
+        GameState->tSpin = 0.0f;
+
+        //Everything the game uses is asked for up front, and pages in while the first frames are drawn without it
+        game_assets *Assets = &GameState->Assets;
+        InitializeAssets(Assets, &GameState->PermanentArena, Memory->AssetFileMemory, Memory->AssetFileSize);
+        for(uint32 SpriteIndex = 0; SpriteIndex < GetAssetCountOfType(Assets, Asset_Sprite); ++SpriteIndex)
         {
-            //The (Padding)RGB channels are BGR(Padding) in Windows
-            /*
-            32 bit Memory: BB GG RR xx
-            32 bit Register: xx RR GG BB 
-            */
+            LoadBitmap(Assets, GetBitmapFrom(Assets, Asset_Sprite, SpriteIndex), Memory->LowPriorityQueue, &Memory->PlatformAPI);
+        }
+        LoadSound(Assets, GetSoundFrom(Assets, Asset_Bell, 0), Memory->LowPriorityQueue, &Memory->PlatformAPI);
 
-            uint8 Blue= (X + XOffset);
-            uint8 Green = (Y + YOffset);
-            uint8 Red = 0;
-            uint8 Padding = 0;
+        Memory->IsInitialized = true;
+    }
 
-            *Pixel++ = ((Padding << 24) | (Red << 16) | (Green << 8) | Blue );
+    //Everything the game does is a function of its memory and its input, which is what makes a recorded session replay exactly
+    for(int ControllerIndex = 0; ControllerIndex < ArrayCount(Input->Controllers); ++ControllerIndex)
+    {
+        game_controller_input *Controller = GetController(Input, ControllerIndex);
+        Assert(&Controller->Terminator - &Controller->Buttons[0] == ArrayCount(Controller->Buttons));
+        if(!Controller->IsConnected)
+        {
+            continue;
         }
 
-        Row += Buffer->Pitch;
+        //Holding a direction scrolls the gradient faster, the action buttons bend the tone up or down
+        if(Controller->MoveLeft.EndedDown)
+        {
+            GameState->XOffset -= 4;
+        }
+        if(Controller->MoveRight.EndedDown)
+        {
+            GameState->XOffset += 4;
+        }
+        if(Controller->MoveUp.EndedDown)
+        {
+            GameState->YOffset -= 4;
+        }
+        if(Controller->MoveDown.EndedDown)
+        {
+            GameState->YOffset += 4;
+        }
+
+        //Rings the bell, if it has loaded by then
+        if(Controller->ActionLeft.EndedDown && Controller->ActionLeft.HalfTransitionCount)
+        {
+            loaded_sound *Bell = GetSound(&GameState->Assets, GetSoundFrom(&GameState->Assets, Asset_Bell, 0));
+            if(Bell)
+            {
+                PlaySound(&GameState->AudioState, Bell, false);
+            }
+        }
+
+        GameState->ToneHz = 256;
+        if(Controller->ActionUp.EndedDown)
+        {
+            GameState->ToneHz = 512;
+        }
+        else if(Controller->ActionDown.EndedDown)
+        {
+            GameState->ToneHz = 128;
+        }
     }
+
+    //Anything pushed on the transient arena only lives until the end of the frame
+    temporary_memory FrameMemory = BeginTemporaryMemory(&GameState->TransientArena);
+
+    //Everything to draw goes into a render group first, then it is drawn a tile at a time on every core
+    render_group *RenderGroup = AllocateRenderGroup(&GameState->TransientArena, Kilobytes(64));
+
+    //The same pixels either way. The tile is drawn here on the game's thread, so the render tiles only ever copy from it.
+    if(GradientIsFasterCopied(Buffer->Format))
+    {
+        DrawGradientBackground(&GameState->Background, Buffer->Format);
+        PushTiledBackground(RenderGroup, &GameState->Background, GameState->XOffset, GameState->YOffset);
+    }
+    else
+    {
+        PushGradient(RenderGroup, GameState->XOffset, GameState->YOffset);
+    }
+
+    //The world scrolls with the background, its camera is the same offsets
+    PushVisibleChunks(RenderGroup, &GameState->World, GameState->XOffset, GameState->YOffset, Buffer->Width, Buffer->Height);
+    ++GameState->XOffset;
+
+    //A translucent panel, the packed sprites in turn along it (or the test sprite, for any not loaded yet), and the test
+    //sprite again spinning as a bilinear quad
+    float32 Width = (float32)Buffer->Width;
+    float32 Height = (float32)Buffer->Height;
+    PushRectangle(RenderGroup, V2(0.1f*Width, 0.1f*Height), V2(0.9f*Width, 0.3f*Height), V4(0.0f, 0.0f, 0.25f, 0.5f));
+    for(int SpriteIndex = 0; SpriteIndex < 8; ++SpriteIndex)
+    {
+        loaded_bitmap *Sprite = GetBitmap(&GameState->Assets, GetBitmapFrom(&GameState->Assets, Asset_Sprite, SpriteIndex));
+        if(!Sprite)
+        {
+            Sprite = &GameState->TestSprite;
+        }
+        PushBitmap(RenderGroup, Sprite, V2(0.1f*Width + SpriteIndex*80.0f + 32.0f - 0.5f*Sprite->Width,
+                                           0.2f*Height - 0.5f*Sprite->Height));
+    }
+
+    v2 XAxis = 160.0f*V2(cosf(GameState->tSpin), sinf(GameState->tSpin));
+    v2 YAxis = Perp(XAxis);
+    v2 Center = V2(0.5f*Width, 0.6f*Height);
+    PushTexturedQuad(RenderGroup, Center - 0.5f*XAxis - 0.5f*YAxis, XAxis, YAxis, V4(1.0f, 1.0f, 1.0f, 1.0f),
+                     &GameState->TestSprite);
+
+    GameState->tSpin += 0.02f;
+    if(GameState->tSpin > 2.0f*Pi32)
+    {
+        GameState->tSpin -= 2.0f*Pi32;
+    }
+
+    TiledRenderGroupToOutput(Memory->RenderQueue, &Memory->PlatformAPI, RenderGroup, Buffer);
+
+    EndTemporaryMemory(FrameMemory);
+    CheckArena(&GameState->TransientArena);
 }
 
-internal void GameUpdateAndRender(game_offscreen_buffer *Buffer, int XOffset, int YOffset, game_sound_output_buffer *SoundBuffer, int ToneHz)
+//Called by the platform whenever it wants more sound, any number of times per frame (including zero).
+//Always on the same thread as GameUpdateAndRender, so the game state never needs a lock.
+internal void GameGetSoundSamples(game_memory *Memory, game_sound_output_buffer *SoundBuffer)
 {
-    GameOutputSound(SoundBuffer, ToneHz);
-    RenderWeirdGradient(Buffer, XOffset, YOffset);
-}
+    TIMED_FUNCTION(SoundBuffer->SampleCount);
+
+    Assert(Memory->IsInitialized);
+    game_state *GameState = (game_state *)Memory->PermanentStorage;
+
+    GameOutputSound(GameState, SoundBuffer);
+    CheckArena(&GameState->TransientArena);
+}
\ No newline at end of file
@@ -1,5 +1,21 @@
 #if !defined(MIDNIGHT_MADNESS_H)
 
+/*
+    MIDNIGHT_MADNESS_INTERNAL:
+        0 - Build for public release
+        1 - Build for developers only (fixed memory base address etc.)
+
+    MIDNIGHT_MADNESS_SLOW:
+        0 - No slow code allowed
+        1 - Slow code welcome (asserts)
+
+    MIDNIGHT_MADNESS_PROFILE:
+        0 - TIMED_BLOCK profiler compiled out
+        1 - TIMED_BLOCK profiler on (default, see midnight_madness_debug.h)
+*/
+
+#include <stddef.h>
+
 #define Pi32 3.14159265359f
 
 typedef short int16;
@@ -15,14 +31,108 @@ typedef int bool32;
 typedef float float32;
 typedef double float64;
 
+typedef size_t memory_index;
+
 
 
 #define local_persist static
 #define internal static
 #define global_variable static
 
+#define ArrayCount(Array) (int)(sizeof(Array) / sizeof((Array)[0]))
+
+#define Kilobytes(Value) ((Value)*1024LL)
+#define Megabytes(Value) (Kilobytes(Value)*1024LL)
+#define Gigabytes(Value) (Megabytes(Value)*1024LL)
+#define Terabytes(Value) (Gigabytes(Value)*1024LL)
+
+#if MIDNIGHT_MADNESS_SLOW
+//Writing to address zero crashes right on the line that failed, so the debugger stops there
+#define Assert(Expression) if(!(Expression)) {*(volatile int *)0 = 0;}
+#else
+#define Assert(Expression)
+#endif
+
+#define InvalidCodePath Assert(!"InvalidCodePath")
+#define InvalidDefaultCase default: {InvalidCodePath;} break
+
+#include "midnight_madness_intrinsics.h"
+#include "midnight_madness_debug.h"
+
 //Services that the platform provides to the game
 
+/*
+    Work queue: the platform runs a pool of worker threads, and the game hands them work through these two functions.
+    AddEntry queues Callback(Queue, Data) to run on any thread of the pool; CompleteAllWork returns once everything added
+    so far has run, helping out in the meantime. Only the thread that owns the queue (the one calling GameUpdateAndRender)
+    and the queue's own workers (from inside a callback) may add entries, and only the owner may wait.
+*/
+struct platform_work_queue;
+
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(platform_work_queue *Queue, void *Data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(platform_work_queue_callback);
+
+#define PLATFORM_ADD_ENTRY(name) void name(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data)
+typedef PLATFORM_ADD_ENTRY(platform_add_entry);
+
+#define PLATFORM_COMPLETE_ALL_WORK(name) void name(platform_work_queue *Queue)
+typedef PLATFORM_COMPLETE_ALL_WORK(platform_complete_all_work);
+
+struct platform_api
+{
+    platform_add_entry *AddEntry;
+    platform_complete_all_work *CompleteAllWork;
+};
+
+//All the memory the game will ever get. The platform reserves it once at startup, at a fixed base address in
+//internal builds, with every page already faulted in, so the game never allocates and never page faults in the frame loop.
+struct game_memory
+{
+    bool32 IsInitialized;
+
+    uint64 PermanentStorageSize;
+    void *PermanentStorage; //NOTE(Robin) REQUIRED to be cleared to zero at startup
+
+    uint64 TransientStorageSize;
+    void *TransientStorage; //NOTE(Robin) REQUIRED to be cleared to zero at startup
+
+    //NOTE(Robin) Can be 0, the game then renders on its own thread
+    platform_work_queue *RenderQueue;
+    //NOTE(Robin) Can be 0 too, assets are then paged in on the game's thread when they are asked for
+    platform_work_queue *LowPriorityQueue;
+    platform_api PlatformAPI;
+
+    //The packed asset file, memory mapped read only (see midnight_madness_file_formats.h). 0 if there is none.
+    void *AssetFileMemory;
+    uint64 AssetFileSize;
+};
+
+//How the pixels of a game_offscreen_buffer are laid out. The renderer has its own loops for every one of them (see
+//midnight_madness_render.h), so a smaller format is less memory to write and read back, not more work per pixel.
+enum pixel_format
+{
+    PixelFormat_BGRX8888, //NOTE(Robin) BB GG RR xx in memory, what a Windows DIB wants. Zero, so it is the default.
+    PixelFormat_RGBA8888, //NOTE(Robin) RR GG BB AA in memory
+    PixelFormat_RGB565, //NOTE(Robin) 16 bits, red in the top 5, then 6 of green and 5 of blue
+    PixelFormat_Indexed8, //NOTE(Robin) 8 bits, an index into the fixed palette RRRGGGBB (GetIndexed8Palette)
+
+    PixelFormat_Count,
+};
+
+inline int GetBytesPerPixel(pixel_format Format)
+{
+    int Result = 4;
+    if(Format == PixelFormat_RGB565)
+    {
+        Result = 2;
+    }
+    else if(Format == PixelFormat_Indexed8)
+    {
+        Result = 1;
+    }
+    return(Result);
+}
+
 //Services that the game provides to the platform
 //FOUR THINGS - timing, keyboard input, bitmap buffer to use, sound buffer to use
 struct game_offscreen_buffer
@@ -31,6 +141,7 @@ struct game_offscreen_buffer
     int Width;
     int Height;
     int Pitch;
+    pixel_format Format;
 };
 
 struct game_sound_output_buffer
@@ -40,7 +151,191 @@ struct game_sound_output_buffer
     int16 *Samples;
 };
 
-internal void GameUpdateAndRender(game_offscreen_buffer *Buffer, int XOffset, int YOffset, game_sound_output_buffer *SoundBuffer, int ToneHz);
+//Input is polled once a frame. For every button we get where it ended up, and how many times it went up or down
+//during the frame, so a press and release between two frames is not lost.
+struct game_button_state
+{
+    int HalfTransitionCount;
+    bool32 EndedDown;
+};
+
+struct game_controller_input
+{
+    bool32 IsConnected;
+
+    union
+    {
+        game_button_state Buttons[12];
+        struct
+        {
+            game_button_state MoveUp;
+            game_button_state MoveDown;
+            game_button_state MoveLeft;
+            game_button_state MoveRight;
+
+            game_button_state ActionUp;
+            game_button_state ActionDown;
+            game_button_state ActionLeft;
+            game_button_state ActionRight;
+
+            game_button_state LeftShoulder;
+            game_button_state RightShoulder;
+
+            game_button_state Back;
+            game_button_state Start;
+
+            //NOTE(Robin) All buttons must be added above this line
+            game_button_state Terminator;
+        };
+    };
+};
+
+//NOTE(Robin) Plain data with no pointers, so the platform can write it to a file and play it back as is
+struct game_input
+{
+    //TODO(Robin) Gamepads, for now controller 0 is the keyboard
+    game_controller_input Controllers[1];
+};
+
+inline game_controller_input *GetController(game_input *Input, int ControllerIndex)
+{
+    Assert(ControllerIndex < ArrayCount(Input->Controllers));
+    game_controller_input *Result = &Input->Controllers[ControllerIndex];
+    return(Result);
+}
+
+//Which instruction set the game's hot loops use. Auto picks the widest one CPUID says we have,
+//the others let the platform force a path (for benchmarking or comparing the output).
+enum simd_level
+{
+    SIMDLevel_Auto,
+    SIMDLevel_Scalar,
+    SIMDLevel_SSE2,
+    SIMDLevel_AVX2,
+
+    SIMDLevel_Count,
+};
+
+//Returns the level that will actually be used, which can be lower than the one requested if the CPU can't run it
+internal simd_level GameSelectSIMDLevel(simd_level Requested);
+
+//How translucent pixels are blended into the buffer. SRGB blends the stored bytes as they are, the way it has always
+//been done; Linear converts to linear light and back around every blend, which is correct and costs more.
+enum blend_space
+{
+    BlendSpace_SRGB,
+    BlendSpace_Linear,
+
+    BlendSpace_Count,
+};
+
+internal void GameSelectBlendSpace(blend_space Space);
+
+internal void GameUpdateAndRender(game_memory *Memory, game_input *Input, game_offscreen_buffer *Buffer);
+internal void GameGetSoundSamples(game_memory *Memory, game_sound_output_buffer *SoundBuffer);
+
+//Everything below is game only, the platform never needs to look inside
+
+//A memory arena is a stack: pushing hands out the next bytes, and a temporary_memory scope pops everything pushed
+//since it began in one go. No free lists, no per allocation bookkeeping, and no calls into the OS.
+struct memory_arena
+{
+    memory_index Size;
+    uint8 *Base;
+    memory_index Used;
+
+    int32 TempCount;
+};
+
+struct temporary_memory
+{
+    memory_arena *Arena;
+    memory_index Used;
+};
+
+internal void InitializeArena(memory_arena *Arena, memory_index Size, void *Base)
+{
+    Arena->Size = Size;
+    Arena->Base = (uint8 *)Base;
+    Arena->Used = 0;
+    Arena->TempCount = 0;
+}
+
+#define PushStruct(Arena, type, ...) (type *)PushSize_(Arena, sizeof(type), ## __VA_ARGS__)
+#define PushArray(Arena, Count, type, ...) (type *)PushSize_(Arena, (Count)*sizeof(type), ## __VA_ARGS__)
+#define PushSize(Arena, Size, ...) PushSize_(Arena, Size, ## __VA_ARGS__)
+
+//Alignment defaults to 16 so anything we push can be loaded straight into an SSE register
+internal void *PushSize_(memory_arena *Arena, memory_index Size, memory_index Alignment = 16)
+{
+    memory_index ResultPointer = (memory_index)Arena->Base + Arena->Used;
+    memory_index AlignmentOffset = 0;
+    memory_index AlignmentMask = Alignment - 1;
+    if(ResultPointer & AlignmentMask)
+    {
+        AlignmentOffset = Alignment - (ResultPointer & AlignmentMask);
+    }
+    Size += AlignmentOffset;
+
+    Assert((Arena->Used + Size) <= Arena->Size);
+    void *Result = (void *)(ResultPointer + AlignmentOffset);
+    Arena->Used += Size;
+
+    return(Result);
+}
+
+//Pops everything pushed since the matching BeginTemporaryMemory. Scopes nest, and have to be ended in reverse order.
+internal temporary_memory BeginTemporaryMemory(memory_arena *Arena)
+{
+    temporary_memory Result;
+
+    Result.Arena = Arena;
+    Result.Used = Arena->Used;
+
+    ++Arena->TempCount;
+
+    return(Result);
+}
+
+internal void EndTemporaryMemory(temporary_memory TempMem)
+{
+    memory_arena *Arena = TempMem.Arena;
+    Assert(Arena->Used >= TempMem.Used);
+    Arena->Used = TempMem.Used;
+    Assert(Arena->TempCount > 0);
+    --Arena->TempCount;
+}
+
+internal void CheckArena(memory_arena *Arena)
+{
+    Assert(Arena->TempCount == 0);
+}
+
+#include "midnight_madness_audio.h"
+#include "midnight_madness_render.h"
+#include "midnight_madness_world.h"
+#include "midnight_madness_file_formats.h"
+#include "midnight_madness_asset.h"
+
+struct game_state
+{
+    memory_arena PermanentArena;
+    memory_arena TransientArena;
+
+    int XOffset;
+    int YOffset;
+    int ToneHz;
+    int PlayingToneHz;
+    oscillator_bank Oscillators;
+    audio_state AudioState;
+
+    game_assets Assets;
+
+    world World;
+    tiled_background Background; //NOTE(Robin) One period of the gradient, copied out at XOffset, YOffset every frame
+    loaded_bitmap TestSprite; //NOTE(Robin) Drawn in place of the packed sprites until they are loaded
+    float32 tSpin;
+};
 
 #define MIDNIGHT_MADNESS_H
 #endif
\ No newline at end of file
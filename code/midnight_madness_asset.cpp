@@ -0,0 +1,207 @@
+#define ASSET_PAGE_SIZE 4096
+
+//Only looks at the header and the type table, however many assets the file has. FileMemory can be 0 (no asset file),
+//every asset ID is then 0 and nothing ever loads.
+internal void InitializeAssets(game_assets *Assets, memory_arena *Arena, void *FileMemory, uint64 FileSize)
+{
+    TIMED_FUNCTION();
+
+    Assets->FileMemory = 0;
+    Assets->FileSize = 0;
+    Assets->AssetCount = 0;
+
+    mma_header *Header = (mma_header *)FileMemory;
+    bool32 Valid = (FileMemory && (FileSize >= sizeof(mma_header)) &&
+                    (Header->MagicValue == MMA_MAGIC_VALUE) && (Header->Version == MMA_VERSION) &&
+                    (Header->AssetTypes <= FileSize) &&
+                    ((uint64)Header->AssetTypeCount*sizeof(mma_asset_type) <= (FileSize - Header->AssetTypes)) &&
+                    (Header->Assets <= FileSize) &&
+                    ((uint64)Header->AssetCount*sizeof(mma_asset) <= (FileSize - Header->Assets)));
+    if(Valid)
+    {
+        Assets->FileMemory = (uint8 *)FileMemory;
+        Assets->FileSize = FileSize;
+        Assets->AssetCount = Header->AssetCount;
+        Assets->Assets = (mma_asset *)(Assets->FileMemory + Header->Assets);
+
+        //NOTE(Robin) The permanent arena is zeroed, which is AssetState_Unloaded: nothing to do per asset
+        Assets->Slots = PushArray(Arena, Assets->AssetCount, asset_slot);
+
+        mma_asset_type *FileTypes = (mma_asset_type *)(Assets->FileMemory + Header->AssetTypes);
+        for(uint32 TypeIndex = 0; TypeIndex < Header->AssetTypeCount; ++TypeIndex)
+        {
+            mma_asset_type *Type = FileTypes + TypeIndex;
+            //Types this build doesn't know about are skipped, so newer files still load
+            if((Type->TypeID < Asset_Count) && (Type->FirstAssetIndex <= Type->OnePastLastAssetIndex) &&
+               (Type->OnePastLastAssetIndex <= Assets->AssetCount))
+            {
+                Assets->AssetTypes[Type->TypeID] = *Type;
+            }
+        }
+    }
+
+    Assets->LoadedCount = 0;
+    Assets->PendingCount = 0;
+    Assets->InvalidCount = 0;
+    Assets->PagesTouched = 0;
+}
+
+internal uint32 GetAssetCountOfType(game_assets *Assets, asset_type_id TypeID)
+{
+    mma_asset_type *Type = Assets->AssetTypes + TypeID;
+    uint32 Result = Type->OnePastLastAssetIndex - Type->FirstAssetIndex;
+    return(Result);
+}
+
+//The Index'th asset of the type, wrapping around. 0 if the file has none.
+internal uint32 GetAssetFrom(game_assets *Assets, asset_type_id TypeID, uint32 Index)
+{
+    uint32 Result = 0;
+    uint32 Count = GetAssetCountOfType(Assets, TypeID);
+    if(Count)
+    {
+        Result = Assets->AssetTypes[TypeID].FirstAssetIndex + (Index % Count);
+    }
+    return(Result);
+}
+
+internal bitmap_id GetBitmapFrom(game_assets *Assets, asset_type_id TypeID, uint32 Index)
+{
+    bitmap_id Result = {GetAssetFrom(Assets, TypeID, Index)};
+    return(Result);
+}
+
+internal sound_id GetSoundFrom(game_assets *Assets, asset_type_id TypeID, uint32 Index)
+{
+    sound_id Result = {GetAssetFrom(Assets, TypeID, Index)};
+    return(Result);
+}
+
+//Checks the index entry against the file, points the slot into the mapping, and pages the payload in
+internal PLATFORM_WORK_QUEUE_CALLBACK(LoadAssetWork)
+{
+    TIMED_FUNCTION();
+
+    asset_slot *Slot = (asset_slot *)Data;
+    game_assets *Assets = Slot->Assets;
+    mma_asset *Info = Assets->Assets + Slot->AssetIndex;
+
+    uint32 NewState = AssetState_Invalid;
+    if((Info->Kind == Slot->Kind) && (Info->DataOffset <= Assets->FileSize) &&
+       (Info->DataSize <= (Assets->FileSize - Info->DataOffset)))
+    {
+        uint8 *Payload = Assets->FileMemory + Info->DataOffset;
+        if(Info->Kind == MMA_Bitmap)
+        {
+            uint64 Width = Info->Bitmap.Width;
+            uint64 Height = Info->Bitmap.Height;
+            if((Width > 0) && (Width <= 65536) && (Height > 0) && (Height <= 65536) && (Width*Height*4 <= Info->DataSize))
+            {
+                Slot->Bitmap.Width = (int)Width;
+                Slot->Bitmap.Height = (int)Height;
+                Slot->Bitmap.Pitch = (int)Width*4;
+                Slot->Bitmap.Memory = Payload;
+                NewState = AssetState_Loaded;
+            }
+        }
+        else if(Info->Kind == MMA_Sound)
+        {
+            uint64 SampleCount = Info->Sound.SampleCount;
+            uint64 ChannelCount = Info->Sound.ChannelCount;
+            if((SampleCount < (1u << 31)) && ((ChannelCount == 1) || (ChannelCount == 2)) &&
+               ((SampleCount + 1)*ChannelCount*sizeof(int16) <= Info->DataSize))
+            {
+                Slot->Sound.SampleCount = (int)SampleCount;
+                Slot->Sound.ChannelCount = (int)ChannelCount;
+                Slot->Sound.Samples = (int16 *)Payload;
+                NewState = AssetState_Loaded;
+            }
+        }
+
+        if(NewState == AssetState_Loaded)
+        {
+            //Reading one byte of every page is what makes the OS read the page in, here and not in the frame loop
+            uint32 PageCount = 0;
+            for(uint64 Offset = 0; Offset < Info->DataSize; Offset += ASSET_PAGE_SIZE)
+            {
+                (void)((uint8 volatile *)Payload)[Offset];
+                ++PageCount;
+            }
+            AtomicAddU32(&Assets->PagesTouched, PageCount);
+        }
+    }
+
+    AtomicAddU32((NewState == AssetState_Loaded) ? &Assets->LoadedCount : &Assets->InvalidCount, 1);
+    AtomicAddU32(&Assets->PendingCount, (uint32)-1);
+
+    //Release: everything written into the slot above is visible before anyone can see it loaded
+    AtomicStoreRelease(&Slot->State, NewState);
+}
+
+//Game thread only. Queues the asset's load job if nothing has asked for it yet, on the game's thread if there is no queue.
+internal void LoadAsset(game_assets *Assets, uint32 AssetIndex, mma_asset_kind Kind,
+                        platform_work_queue *Queue, platform_api *Platform)
+{
+    if(AssetIndex && (AssetIndex < Assets->AssetCount))
+    {
+        asset_slot *Slot = Assets->Slots + AssetIndex;
+        if(Slot->State == AssetState_Unloaded)
+        {
+            Slot->Assets = Assets;
+            Slot->AssetIndex = AssetIndex;
+            Slot->Kind = Kind;
+            Slot->State = AssetState_Queued;
+            AtomicAddU32(&Assets->PendingCount, 1);
+
+            if(Queue)
+            {
+                Platform->AddEntry(Queue, LoadAssetWork, Slot);
+            }
+            else
+            {
+                LoadAssetWork(0, Slot);
+            }
+        }
+    }
+}
+
+internal void LoadBitmap(game_assets *Assets, bitmap_id ID, platform_work_queue *Queue, platform_api *Platform)
+{
+    LoadAsset(Assets, ID.Value, MMA_Bitmap, Queue, Platform);
+}
+
+internal void LoadSound(game_assets *Assets, sound_id ID, platform_work_queue *Queue, platform_api *Platform)
+{
+    LoadAsset(Assets, ID.Value, MMA_Sound, Queue, Platform);
+}
+
+internal asset_state GetAssetState(game_assets *Assets, uint32 AssetIndex)
+{
+    asset_state Result = AssetState_Invalid;
+    if(AssetIndex && (AssetIndex < Assets->AssetCount))
+    {
+        Result = (asset_state)AtomicLoadAcquire(&Assets->Slots[AssetIndex].State);
+    }
+    return(Result);
+}
+
+//0 until the bitmap has been loaded (asking for it doesn't load it, LoadBitmap does)
+internal loaded_bitmap *GetBitmap(game_assets *Assets, bitmap_id ID)
+{
+    loaded_bitmap *Result = 0;
+    if((GetAssetState(Assets, ID.Value) == AssetState_Loaded) && (Assets->Slots[ID.Value].Kind == MMA_Bitmap))
+    {
+        Result = &Assets->Slots[ID.Value].Bitmap;
+    }
+    return(Result);
+}
+
+internal loaded_sound *GetSound(game_assets *Assets, sound_id ID)
+{
+    loaded_sound *Result = 0;
+    if((GetAssetState(Assets, ID.Value) == AssetState_Loaded) && (Assets->Slots[ID.Value].Kind == MMA_Sound))
+    {
+        Result = &Assets->Slots[ID.Value].Sound;
+    }
+    return(Result);
+}
@@ -0,0 +1,74 @@
+#if !defined(MIDNIGHT_MADNESS_ASSET_H)
+
+/*
+    Assets come out of the packed asset file the platform memory maps (see midnight_madness_file_formats.h), and are
+    used right where they are in the mapping: a loaded_bitmap or loaded_sound just points into it.
+
+    - Opening the file reads the header and the small type table, nothing else. The index and the payloads are only
+      touched when an asset is asked for, so starting up costs the same with ten assets or ten thousand.
+    - Mapping a file doesn't read it, the first touch of every page does. To keep that off the game's thread, asking for
+      an asset queues a job on the platform's low priority queue that touches every page of the payload, and only then
+      marks the asset loaded. Until it is, GetBitmap/GetSound return 0 and the game draws or plays something else.
+    - Every asset has a slot holding its state, Unloaded -> Queued -> Loaded (or Invalid). Only the game's thread moves
+      it out of Unloaded (so a job is queued once), only the job moves it on from Queued, with a release store after the
+      slot is filled in, so a thread that sees Loaded sees the whole bitmap or sound.
+    - The slots are allocated in one go from the permanent arena, which is already zeroed: every asset starts Unloaded
+      without any per-asset work.
+
+    The slots live in game memory and point into the mapping, which in internal builds the platform maps at a fixed
+    address just like game memory, so a replay snapshot's loaded assets are still where it thinks they are.
+*/
+
+enum asset_state
+{
+    AssetState_Unloaded,
+    AssetState_Queued,
+    AssetState_Loaded,
+    AssetState_Invalid, //NOTE(Robin) Its index entry points outside the file or doesn't match what was asked for
+};
+
+struct bitmap_id
+{
+    uint32 Value;
+};
+
+struct sound_id
+{
+    uint32 Value;
+};
+
+struct asset_slot
+{
+    uint32 volatile State;
+    union
+    {
+        loaded_bitmap Bitmap;
+        loaded_sound Sound;
+    };
+
+    //Set when the load is queued: what the job needs to find its way back, and what was asked for
+    struct game_assets *Assets;
+    uint32 AssetIndex;
+    uint32 Kind; //NOTE(Robin) mma_asset_kind
+};
+
+struct game_assets
+{
+    uint8 *FileMemory;
+    uint64 FileSize;
+
+    uint32 AssetCount;
+    mma_asset *Assets; //NOTE(Robin) In the mapping, so reading one can page fault: only the load jobs do
+    asset_slot *Slots;
+
+    //Copied out of the file, it is tiny and looked at whenever the game picks an asset
+    mma_asset_type AssetTypes[Asset_Count];
+
+    uint32 volatile LoadedCount;
+    uint32 volatile PendingCount;
+    uint32 volatile InvalidCount;
+    uint32 volatile PagesTouched;
+};
+
+#define MIDNIGHT_MADNESS_ASSET_H
+#endif
@@ -0,0 +1,622 @@
+//The game's synthesiser: a bank of oscillators rendered into a float32 buffer, SIMD wide per voice
+
+internal void SetOscillatorFrequency(oscillator *Oscillator, float32 Hz, int SamplesPerSecond)
+{
+    //Computed in float64 so the increment is the closest uint32 to the real frequency
+    float64 Increment = ((float64)Hz * 4294967296.0) / (float64)SamplesPerSecond;
+    Oscillator->PhaseIncrement = (uint32)(Increment + 0.5);
+}
+
+internal oscillator *AddOscillator(oscillator_bank *Bank, oscillator_waveform Waveform, float32 Hz, float32 Volume, int SamplesPerSecond)
+{
+    oscillator *Result = 0;
+    if(Bank->VoiceCount < MAX_OSCILLATOR_COUNT)
+    {
+        Result = Bank->Voices + Bank->VoiceCount;
+        Result->Waveform = Waveform;
+        Result->Phase = 0;
+        Result->Volume = Volume;
+        SetOscillatorFrequency(Result, Hz, SamplesPerSecond);
+
+        //Every lane and every voice gets a different non-zero seed (xorshift gets stuck on zero)
+        for(int Lane = 0; Lane < OSCILLATOR_NOISE_LANES; ++Lane)
+        {
+            Result->NoiseState[Lane] = 0x9E3779B9u*(uint32)(Bank->VoiceCount*OSCILLATOR_NOISE_LANES + Lane + 1);
+        }
+
+        ++Bank->VoiceCount;
+    }
+    return(Result);
+}
+
+/*
+    All waveforms start from the phase as a signed fraction of a cycle, X = (int32)Phase / 2^31, which runs
+    0 -> 1 over the first half of the cycle and -1 -> 0 over the second half.
+
+    Sine is sin(Pi*X). X is folded into [-0.5, 0.5] (sin(Pi*X) = sin(Pi*(1 - X))) and then a 9th order odd polynomial
+    (the Taylor series of sin(Pi*X)) is accurate to about 4e-6 there, well below one int16 step. No table lookups,
+    so it vectorises without gathers.
+*/
+#define SINE_C1 3.14159265f
+#define SINE_C3 -5.16771278f
+#define SINE_C5 2.55016404f
+#define SINE_C7 -0.59926453f
+#define SINE_C9 0.08214589f
+
+internal float32 PhaseToFraction(uint32 Phase)
+{
+    return((float32)(int32)Phase*(1.0f / 2147483648.0f));
+}
+
+internal float32 SinePi(float32 X)
+{
+    if(X > 0.5f)
+    {
+        X = 1.0f - X;
+    }
+    else if(X < -0.5f)
+    {
+        X = -1.0f - X;
+    }
+    float32 X2 = X*X;
+    return(X*(SINE_C1 + X2*(SINE_C3 + X2*(SINE_C5 + X2*(SINE_C7 + X2*SINE_C9)))));
+}
+
+internal uint32 XorShift32(uint32 State)
+{
+    State ^= State << 13;
+    State ^= State >> 17;
+    State ^= State << 5;
+    return(State);
+}
+
+internal void RenderOscillatorScalar(oscillator *Oscillator, int SampleCount, float32 *Output)
+{
+    uint32 Phase = Oscillator->Phase;
+    uint32 Noise = Oscillator->NoiseState[0];
+    for(int SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex)
+    {
+        float32 X = PhaseToFraction(Phase);
+        float32 Value;
+        switch(Oscillator->Waveform)
+        {
+            case Waveform_Sine: {Value = SinePi(X);} break;
+            case Waveform_Square: {Value = (X < 0.0f) ? -1.0f : 1.0f;} break;
+            case Waveform_Saw: {Value = X;} break;
+            default:
+            {
+                Noise = XorShift32(Noise);
+                Value = PhaseToFraction(Noise);
+            } break;
+        }
+
+        Output[SampleIndex] += Value*Oscillator->Volume;
+        Phase += Oscillator->PhaseIncrement;
+    }
+    Oscillator->Phase = Phase;
+    Oscillator->NoiseState[0] = Noise;
+}
+
+//4 samples of one voice at a time
+internal void RenderOscillatorSSE2(oscillator *Oscillator, int SampleCount, float32 *Output)
+{
+    uint32 Increment = Oscillator->PhaseIncrement;
+    __m128i Phase = _mm_setr_epi32(Oscillator->Phase, Oscillator->Phase + Increment,
+                                   Oscillator->Phase + 2*Increment, Oscillator->Phase + 3*Increment);
+    __m128i PhaseStep = _mm_set1_epi32(4*Increment);
+    __m128i Noise = _mm_loadu_si128((__m128i *)Oscillator->NoiseState);
+
+    __m128 Volume = _mm_set1_ps(Oscillator->Volume);
+    __m128 PhaseScale = _mm_set1_ps(1.0f / 2147483648.0f);
+    __m128 One = _mm_set1_ps(1.0f);
+    __m128 Half = _mm_set1_ps(0.5f);
+    __m128 SignMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+    __m128 C1 = _mm_set1_ps(SINE_C1);
+    __m128 C3 = _mm_set1_ps(SINE_C3);
+    __m128 C5 = _mm_set1_ps(SINE_C5);
+    __m128 C7 = _mm_set1_ps(SINE_C7);
+    __m128 C9 = _mm_set1_ps(SINE_C9);
+
+    int SampleIndex = 0;
+    for(; SampleIndex + 4 <= SampleCount; SampleIndex += 4)
+    {
+        __m128 X = _mm_mul_ps(_mm_cvtepi32_ps(Phase), PhaseScale);
+        __m128 Value;
+        switch(Oscillator->Waveform)
+        {
+            case Waveform_Sine:
+            {
+                //Fold: |X| > 0.5 becomes sign(X) - X
+                __m128 Sign = _mm_and_ps(X, SignMask);
+                __m128 AbsX = _mm_andnot_ps(SignMask, X);
+                __m128 Folded = _mm_sub_ps(_mm_or_ps(One, Sign), X);
+                __m128 NeedsFold = _mm_cmpgt_ps(AbsX, Half);
+                X = _mm_or_ps(_mm_and_ps(NeedsFold, Folded), _mm_andnot_ps(NeedsFold, X));
+
+                __m128 X2 = _mm_mul_ps(X, X);
+                Value = _mm_add_ps(C7, _mm_mul_ps(X2, C9));
+                Value = _mm_add_ps(C5, _mm_mul_ps(X2, Value));
+                Value = _mm_add_ps(C3, _mm_mul_ps(X2, Value));
+                Value = _mm_add_ps(C1, _mm_mul_ps(X2, Value));
+                Value = _mm_mul_ps(X, Value);
+            } break;
+
+            case Waveform_Square:
+            {
+                Value = _mm_or_ps(One, _mm_and_ps(X, SignMask));
+            } break;
+
+            case Waveform_Saw:
+            {
+                Value = X;
+            } break;
+
+            default:
+            {
+                Noise = _mm_xor_si128(Noise, _mm_slli_epi32(Noise, 13));
+                Noise = _mm_xor_si128(Noise, _mm_srli_epi32(Noise, 17));
+                Noise = _mm_xor_si128(Noise, _mm_slli_epi32(Noise, 5));
+                Value = _mm_mul_ps(_mm_cvtepi32_ps(Noise), PhaseScale);
+            } break;
+        }
+
+        __m128 Mix = _mm_loadu_ps(Output + SampleIndex);
+        _mm_storeu_ps(Output + SampleIndex, _mm_add_ps(Mix, _mm_mul_ps(Value, Volume)));
+        Phase = _mm_add_epi32(Phase, PhaseStep);
+    }
+
+    Oscillator->Phase = (uint32)_mm_cvtsi128_si32(Phase);
+    _mm_storeu_si128((__m128i *)Oscillator->NoiseState, Noise);
+
+    RenderOscillatorScalar(Oscillator, SampleCount - SampleIndex, Output + SampleIndex);
+}
+
+//8 samples of one voice at a time, same math as the SSE2 version
+TARGET_AVX2 internal void RenderOscillatorAVX2(oscillator *Oscillator, int SampleCount, float32 *Output)
+{
+    uint32 Increment = Oscillator->PhaseIncrement;
+    __m256i Phase = _mm256_add_epi32(_mm256_set1_epi32(Oscillator->Phase),
+                                     _mm256_mullo_epi32(_mm256_set1_epi32(Increment), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256i PhaseStep = _mm256_set1_epi32(8*Increment);
+    __m256i Noise = _mm256_loadu_si256((__m256i *)Oscillator->NoiseState);
+
+    __m256 Volume = _mm256_set1_ps(Oscillator->Volume);
+    __m256 PhaseScale = _mm256_set1_ps(1.0f / 2147483648.0f);
+    __m256 One = _mm256_set1_ps(1.0f);
+    __m256 Half = _mm256_set1_ps(0.5f);
+    __m256 SignMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+    __m256 C1 = _mm256_set1_ps(SINE_C1);
+    __m256 C3 = _mm256_set1_ps(SINE_C3);
+    __m256 C5 = _mm256_set1_ps(SINE_C5);
+    __m256 C7 = _mm256_set1_ps(SINE_C7);
+    __m256 C9 = _mm256_set1_ps(SINE_C9);
+
+    int SampleIndex = 0;
+    for(; SampleIndex + 8 <= SampleCount; SampleIndex += 8)
+    {
+        __m256 X = _mm256_mul_ps(_mm256_cvtepi32_ps(Phase), PhaseScale);
+        __m256 Value;
+        switch(Oscillator->Waveform)
+        {
+            case Waveform_Sine:
+            {
+                __m256 Sign = _mm256_and_ps(X, SignMask);
+                __m256 AbsX = _mm256_andnot_ps(SignMask, X);
+                __m256 Folded = _mm256_sub_ps(_mm256_or_ps(One, Sign), X);
+                X = _mm256_blendv_ps(X, Folded, _mm256_cmp_ps(AbsX, Half, _CMP_GT_OQ));
+
+                __m256 X2 = _mm256_mul_ps(X, X);
+                Value = _mm256_add_ps(C7, _mm256_mul_ps(X2, C9));
+                Value = _mm256_add_ps(C5, _mm256_mul_ps(X2, Value));
+                Value = _mm256_add_ps(C3, _mm256_mul_ps(X2, Value));
+                Value = _mm256_add_ps(C1, _mm256_mul_ps(X2, Value));
+                Value = _mm256_mul_ps(X, Value);
+            } break;
+
+            case Waveform_Square:
+            {
+                Value = _mm256_or_ps(One, _mm256_and_ps(X, SignMask));
+            } break;
+
+            case Waveform_Saw:
+            {
+                Value = X;
+            } break;
+
+            default:
+            {
+                Noise = _mm256_xor_si256(Noise, _mm256_slli_epi32(Noise, 13));
+                Noise = _mm256_xor_si256(Noise, _mm256_srli_epi32(Noise, 17));
+                Noise = _mm256_xor_si256(Noise, _mm256_slli_epi32(Noise, 5));
+                Value = _mm256_mul_ps(_mm256_cvtepi32_ps(Noise), PhaseScale);
+            } break;
+        }
+
+        __m256 Mix = _mm256_loadu_ps(Output + SampleIndex);
+        _mm256_storeu_ps(Output + SampleIndex, _mm256_add_ps(Mix, _mm256_mul_ps(Value, Volume)));
+        Phase = _mm256_add_epi32(Phase, PhaseStep);
+    }
+
+    Oscillator->Phase = (uint32)_mm_cvtsi128_si32(_mm256_castsi256_si128(Phase));
+    _mm256_storeu_si256((__m256i *)Oscillator->NoiseState, Noise);
+
+    RenderOscillatorScalar(Oscillator, SampleCount - SampleIndex, Output + SampleIndex);
+}
+
+//Adds every voice of the bank into Output, which the caller clears
+internal void RenderOscillatorBank(oscillator_bank *Bank, int SampleCount, float32 *Output)
+{
+    TIMED_FUNCTION(SampleCount*Bank->VoiceCount);
+
+    for(int VoiceIndex = 0; VoiceIndex < Bank->VoiceCount; ++VoiceIndex)
+    {
+        oscillator *Oscillator = Bank->Voices + VoiceIndex;
+        switch(GlobalSIMDLevel)
+        {
+            case SIMDLevel_AVX2:
+            {
+                RenderOscillatorAVX2(Oscillator, SampleCount, Output);
+            } break;
+
+            case SIMDLevel_SSE2:
+            {
+                RenderOscillatorSSE2(Oscillator, SampleCount, Output);
+            } break;
+
+            default:
+            {
+                RenderOscillatorScalar(Oscillator, SampleCount, Output);
+            } break;
+        }
+    }
+}
+
+internal void InitializeAudioState(audio_state *AudioState, memory_arena *PermanentArena)
+{
+    AudioState->PermanentArena = PermanentArena;
+    AudioState->FirstPlayingSound = 0;
+    AudioState->FirstFreePlayingSound = 0;
+}
+
+//Pan goes from -1 (left) to 1 (right). Equal power, so a sound doesn't get quieter in the middle.
+internal void ChangeVolume(playing_sound *PlayingSound, float32 Volume, float32 Pan)
+{
+    float32 Angle = (Pan + 1.0f)*0.25f*Pi32;
+    PlayingSound->Gain[0] = Volume*cosf(Angle);
+    PlayingSound->Gain[1] = Volume*sinf(Angle);
+}
+
+//1 is the recorded pitch, 2 an octave up, 0.5 an octave down
+internal void ChangePitch(playing_sound *PlayingSound, float32 Pitch)
+{
+    if(Pitch > MAX_SOUND_PITCH)
+    {
+        Pitch = MAX_SOUND_PITCH;
+    }
+    PlayingSound->Step = (uint32)(Pitch*65536.0f + 0.5f);
+    if(PlayingSound->Step == 0)
+    {
+        PlayingSound->Step = 1;
+    }
+}
+
+internal playing_sound *PlaySound(audio_state *AudioState, loaded_sound *Sound, bool32 Looping)
+{
+    if(!AudioState->FirstFreePlayingSound)
+    {
+        AudioState->FirstFreePlayingSound = PushStruct(AudioState->PermanentArena, playing_sound);
+        AudioState->FirstFreePlayingSound->Next = 0;
+    }
+
+    playing_sound *PlayingSound = AudioState->FirstFreePlayingSound;
+    AudioState->FirstFreePlayingSound = PlayingSound->Next;
+
+    PlayingSound->Sound = Sound;
+    PlayingSound->Position = 0;
+    PlayingSound->Looping = Looping;
+    ChangeVolume(PlayingSound, 1.0f, 0.0f);
+    ChangePitch(PlayingSound, 1.0f);
+
+    PlayingSound->Next = AudioState->FirstPlayingSound;
+    AudioState->FirstPlayingSound = PlayingSound;
+
+    return(PlayingSound);
+}
+
+/*
+    The chunk mixers add Count output samples of one sound into Dest0/Dest1, starting at Position. The caller
+    guarantees every sample they need is inside the sound (plus the padding frame), and that Count*Step fits in
+    an int32, so positions relative to the start of the chunk can be kept in 16.16 in a 32 bit lane.
+*/
+internal void MixSoundChunkScalar(loaded_sound *Sound, uint64 Position, uint32 Step, int Count,
+                                  float32 Gain0, float32 Gain1, float32 *Dest0, float32 *Dest1)
+{
+    int ChannelCount = Sound->ChannelCount;
+    int16 *Base = Sound->Samples + (Position >> 16)*ChannelCount;
+    uint32 Relative = (uint32)(Position & 0xFFFF);
+    for(int SampleIndex = 0; SampleIndex < Count; ++SampleIndex)
+    {
+        int16 *Source = Base + (Relative >> 16)*ChannelCount;
+        float32 t = (float32)(Relative & 0xFFFF)*(1.0f / 65536.0f);
+
+        float32 Left0 = Source[0];
+        float32 Left1 = Source[ChannelCount];
+        float32 Left = Left0 + (Left1 - Left0)*t;
+        float32 Right = Left;
+        if(ChannelCount == 2)
+        {
+            float32 Right0 = Source[1];
+            float32 Right1 = Source[3];
+            Right = Right0 + (Right1 - Right0)*t;
+        }
+
+        Dest0[SampleIndex] += Gain0*Left;
+        Dest1[SampleIndex] += Gain1*Right;
+        Relative += Step;
+    }
+}
+
+//SSE2 has no gather, so the 4 source pairs are loaded one by one and all the math is done 4 wide
+internal void MixSoundChunkSSE2(loaded_sound *Sound, uint64 Position, uint32 Step, int Count,
+                                float32 Gain0, float32 Gain1, float32 *Dest0, float32 *Dest1)
+{
+    int ChannelCount = Sound->ChannelCount;
+    int16 *Base = Sound->Samples + (Position >> 16)*ChannelCount;
+    uint32 Relative = (uint32)(Position & 0xFFFF);
+
+    __m128 G0 = _mm_set1_ps(Gain0);
+    __m128 G1 = _mm_set1_ps(Gain1);
+    __m128 FractionScale = _mm_set1_ps(1.0f / 65536.0f);
+    __m128i FractionMask = _mm_set1_epi32(0xFFFF);
+    __m128i Positions = _mm_setr_epi32(Relative, Relative + Step, Relative + 2*Step, Relative + 3*Step);
+    __m128i PositionStep = _mm_set1_epi32(4*Step);
+
+    int SampleIndex = 0;
+    for(; SampleIndex + 4 <= Count; SampleIndex += 4)
+    {
+        int16 *S0 = Base + ((Relative) >> 16)*ChannelCount;
+        int16 *S1 = Base + ((Relative + Step) >> 16)*ChannelCount;
+        int16 *S2 = Base + ((Relative + 2*Step) >> 16)*ChannelCount;
+        int16 *S3 = Base + ((Relative + 3*Step) >> 16)*ChannelCount;
+        Relative += 4*Step;
+
+        __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(Positions, FractionMask)), FractionScale);
+        Positions = _mm_add_epi32(Positions, PositionStep);
+
+        __m128 Left0 = _mm_setr_ps(S0[0], S1[0], S2[0], S3[0]);
+        __m128 Left1 = _mm_setr_ps(S0[ChannelCount], S1[ChannelCount], S2[ChannelCount], S3[ChannelCount]);
+        __m128 Left = _mm_add_ps(Left0, _mm_mul_ps(_mm_sub_ps(Left1, Left0), t));
+        __m128 Right = Left;
+        if(ChannelCount == 2)
+        {
+            __m128 Right0 = _mm_setr_ps(S0[1], S1[1], S2[1], S3[1]);
+            __m128 Right1 = _mm_setr_ps(S0[3], S1[3], S2[3], S3[3]);
+            Right = _mm_add_ps(Right0, _mm_mul_ps(_mm_sub_ps(Right1, Right0), t));
+        }
+
+        _mm_storeu_ps(Dest0 + SampleIndex, _mm_add_ps(_mm_loadu_ps(Dest0 + SampleIndex), _mm_mul_ps(G0, Left)));
+        _mm_storeu_ps(Dest1 + SampleIndex, _mm_add_ps(_mm_loadu_ps(Dest1 + SampleIndex), _mm_mul_ps(G1, Right)));
+    }
+
+    MixSoundChunkScalar(Sound, (Position & ~(uint64)0xFFFF) + Relative, Step, Count - SampleIndex,
+                        Gain0, Gain1, Dest0 + SampleIndex, Dest1 + SampleIndex);
+}
+
+//AVX2 can gather. A 32 bit gather at a sample's address picks up that sample and the next one in a single load
+//(for stereo, the left/right pair), so interpolating 8 outputs costs one or two gathers.
+TARGET_AVX2 internal void MixSoundChunkAVX2(loaded_sound *Sound, uint64 Position, uint32 Step, int Count,
+                                            float32 Gain0, float32 Gain1, float32 *Dest0, float32 *Dest1)
+{
+    int ChannelCount = Sound->ChannelCount;
+    int16 *Base = Sound->Samples + (Position >> 16)*ChannelCount;
+    uint32 Relative = (uint32)(Position & 0xFFFF);
+
+    __m256 G0 = _mm256_set1_ps(Gain0);
+    __m256 G1 = _mm256_set1_ps(Gain1);
+    __m256 FractionScale = _mm256_set1_ps(1.0f / 65536.0f);
+    __m256i FractionMask = _mm256_set1_epi32(0xFFFF);
+    __m256i Positions = _mm256_add_epi32(_mm256_set1_epi32(Relative),
+                                         _mm256_mullo_epi32(_mm256_set1_epi32(Step), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256i PositionStep = _mm256_set1_epi32(8*Step);
+
+    int SampleIndex = 0;
+    for(; SampleIndex + 8 <= Count; SampleIndex += 8)
+    {
+        __m256i Index = _mm256_srli_epi32(Positions, 16);
+        __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(Positions, FractionMask)), FractionScale);
+
+        __m256 Left;
+        __m256 Right;
+        if(ChannelCount == 2)
+        {
+            //Frame N as L|R in one lane, and frame N+1 in another
+            __m256i Frame0 = _mm256_i32gather_epi32((int const *)Base, Index, 4);
+            __m256i Frame1 = _mm256_i32gather_epi32((int const *)(Base + 2), Index, 4);
+            __m256 Left0 = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(Frame0, 16), 16));
+            __m256 Left1 = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(Frame1, 16), 16));
+            __m256 Right0 = _mm256_cvtepi32_ps(_mm256_srai_epi32(Frame0, 16));
+            __m256 Right1 = _mm256_cvtepi32_ps(_mm256_srai_epi32(Frame1, 16));
+            Left = _mm256_add_ps(Left0, _mm256_mul_ps(_mm256_sub_ps(Left1, Left0), t));
+            Right = _mm256_add_ps(Right0, _mm256_mul_ps(_mm256_sub_ps(Right1, Right0), t));
+        }
+        else
+        {
+            //Sample N in the low half, sample N+1 in the high half
+            __m256i Pair = _mm256_i32gather_epi32((int const *)Base, Index, 2);
+            __m256 Left0 = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(Pair, 16), 16));
+            __m256 Left1 = _mm256_cvtepi32_ps(_mm256_srai_epi32(Pair, 16));
+            Left = _mm256_add_ps(Left0, _mm256_mul_ps(_mm256_sub_ps(Left1, Left0), t));
+            Right = Left;
+        }
+
+        _mm256_storeu_ps(Dest0 + SampleIndex, _mm256_add_ps(_mm256_loadu_ps(Dest0 + SampleIndex), _mm256_mul_ps(G0, Left)));
+        _mm256_storeu_ps(Dest1 + SampleIndex, _mm256_add_ps(_mm256_loadu_ps(Dest1 + SampleIndex), _mm256_mul_ps(G1, Right)));
+
+        Positions = _mm256_add_epi32(Positions, PositionStep);
+        Relative += 8*Step;
+    }
+
+    MixSoundChunkScalar(Sound, (Position & ~(uint64)0xFFFF) + Relative, Step, Count - SampleIndex,
+                        Gain0, Gain1, Dest0 + SampleIndex, Dest1 + SampleIndex);
+}
+
+//Adds every playing sound into the two channel buffers, and retires the ones that reach their end
+internal void MixPlayingSounds(audio_state *AudioState, int SampleCount, float32 *Channel0, float32 *Channel1)
+{
+    TIMED_FUNCTION(SampleCount);
+
+    for(playing_sound **PlayingSoundPtr = &AudioState->FirstPlayingSound; *PlayingSoundPtr;)
+    {
+        playing_sound *PlayingSound = *PlayingSoundPtr;
+        loaded_sound *Sound = PlayingSound->Sound;
+        uint64 End = (uint64)Sound->SampleCount << 16;
+        bool32 Finished = (Sound->SampleCount == 0);
+
+        int OutputIndex = 0;
+        while((OutputIndex < SampleCount) && !Finished)
+        {
+            uint64 OutputsLeftInSound = (End - PlayingSound->Position + PlayingSound->Step - 1) / PlayingSound->Step;
+            int Count = SampleCount - OutputIndex;
+            if(Count > MIX_CHUNK_SIZE)
+            {
+                Count = MIX_CHUNK_SIZE;
+            }
+            if((uint64)Count > OutputsLeftInSound)
+            {
+                Count = (int)OutputsLeftInSound;
+            }
+
+            float32 *Dest0 = Channel0 + OutputIndex;
+            float32 *Dest1 = Channel1 + OutputIndex;
+            switch(GlobalSIMDLevel)
+            {
+                case SIMDLevel_AVX2:
+                {
+                    MixSoundChunkAVX2(Sound, PlayingSound->Position, PlayingSound->Step, Count,
+                                      PlayingSound->Gain[0], PlayingSound->Gain[1], Dest0, Dest1);
+                } break;
+
+                case SIMDLevel_SSE2:
+                {
+                    MixSoundChunkSSE2(Sound, PlayingSound->Position, PlayingSound->Step, Count,
+                                      PlayingSound->Gain[0], PlayingSound->Gain[1], Dest0, Dest1);
+                } break;
+
+                default:
+                {
+                    MixSoundChunkScalar(Sound, PlayingSound->Position, PlayingSound->Step, Count,
+                                        PlayingSound->Gain[0], PlayingSound->Gain[1], Dest0, Dest1);
+                } break;
+            }
+
+            OutputIndex += Count;
+            PlayingSound->Position += (uint64)Count*PlayingSound->Step;
+            if(PlayingSound->Position >= End)
+            {
+                if(PlayingSound->Looping)
+                {
+                    //Modulo rather than minus, a very short sound at a high pitch can be stepped over more than once
+                    PlayingSound->Position %= End;
+                }
+                else
+                {
+                    Finished = true;
+                }
+            }
+        }
+
+        if(Finished)
+        {
+            *PlayingSoundPtr = PlayingSound->Next;
+            PlayingSound->Next = AudioState->FirstFreePlayingSound;
+            AudioState->FirstFreePlayingSound = PlayingSound;
+        }
+        else
+        {
+            PlayingSoundPtr = &PlayingSound->Next;
+        }
+    }
+}
+
+internal void ConvertChannelsToInt16Scalar(int SampleCount, float32 *Channel0, float32 *Channel1, int16 *SampleOut)
+{
+    for(int SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex)
+    {
+        float32 Left = Channel0[SampleIndex];
+        float32 Right = Channel1[SampleIndex];
+        Left = (Left > 32767.0f) ? 32767.0f : ((Left < -32768.0f) ? -32768.0f : Left);
+        Right = (Right > 32767.0f) ? 32767.0f : ((Right < -32768.0f) ? -32768.0f : Right);
+        *SampleOut++ = (int16)Left;
+        *SampleOut++ = (int16)Right;
+    }
+}
+
+//Clamping in float first matters: a float too big for an int32 converts to 0x80000000, which would saturate the wrong way.
+//After that, packs does the int32 -> int16 narrowing and unpack interleaves left and right.
+internal void ConvertChannelsToInt16SSE2(int SampleCount, float32 *Channel0, float32 *Channel1, int16 *SampleOut)
+{
+    __m128 Max = _mm_set1_ps(32767.0f);
+    __m128 Min = _mm_set1_ps(-32768.0f);
+
+    int SampleIndex = 0;
+    for(; SampleIndex + 8 <= SampleCount; SampleIndex += 8)
+    {
+        __m128i L0 = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(Channel0 + SampleIndex), Max), Min));
+        __m128i L1 = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(Channel0 + SampleIndex + 4), Max), Min));
+        __m128i R0 = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(Channel1 + SampleIndex), Max), Min));
+        __m128i R1 = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(Channel1 + SampleIndex + 4), Max), Min));
+
+        __m128i Left = _mm_packs_epi32(L0, L1);
+        __m128i Right = _mm_packs_epi32(R0, R1);
+
+        _mm_storeu_si128((__m128i *)(SampleOut + 2*SampleIndex), _mm_unpacklo_epi16(Left, Right));
+        _mm_storeu_si128((__m128i *)(SampleOut + 2*SampleIndex + 8), _mm_unpackhi_epi16(Left, Right));
+    }
+
+    ConvertChannelsToInt16Scalar(SampleCount - SampleIndex, Channel0 + SampleIndex, Channel1 + SampleIndex, SampleOut + 2*SampleIndex);
+}
+
+//packs works inside each 128 bit half, so the result is already in frame order per half; one byte shuffle interleaves it
+TARGET_AVX2 internal void ConvertChannelsToInt16AVX2(int SampleCount, float32 *Channel0, float32 *Channel1, int16 *SampleOut)
+{
+    __m256 Max = _mm256_set1_ps(32767.0f);
+    __m256 Min = _mm256_set1_ps(-32768.0f);
+    __m256i Interleave = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+                                          0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+
+    int SampleIndex = 0;
+    for(; SampleIndex + 8 <= SampleCount; SampleIndex += 8)
+    {
+        __m256i Left = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(Channel0 + SampleIndex), Max), Min));
+        __m256i Right = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(Channel1 + SampleIndex), Max), Min));
+
+        //Half 0: L0-3 R0-3, half 1: L4-7 R4-7
+        __m256i Packed = _mm256_packs_epi32(Left, Right);
+        _mm256_storeu_si256((__m256i *)(SampleOut + 2*SampleIndex), _mm256_shuffle_epi8(Packed, Interleave));
+    }
+
+    ConvertChannelsToInt16Scalar(SampleCount - SampleIndex, Channel0 + SampleIndex, Channel1 + SampleIndex, SampleOut + 2*SampleIndex);
+}
+
+internal void ConvertChannelsToInt16(int SampleCount, float32 *Channel0, float32 *Channel1, int16 *SampleOut)
+{
+    TIMED_FUNCTION(SampleCount);
+
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2:
+        {
+            ConvertChannelsToInt16AVX2(SampleCount, Channel0, Channel1, SampleOut);
+        } break;
+
+        case SIMDLevel_SSE2:
+        {
+            ConvertChannelsToInt16SSE2(SampleCount, Channel0, Channel1, SampleOut);
+        } break;
+
+        default:
+        {
+            ConvertChannelsToInt16Scalar(SampleCount, Channel0, Channel1, SampleOut);
+        } break;
+    }
+}
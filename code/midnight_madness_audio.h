@@ -0,0 +1,76 @@
+#if !defined(MIDNIGHT_MADNESS_AUDIO_H)
+
+/*
+    Oscillators keep their phase in a uint32 that wraps around once per cycle (0 = 0 degrees, 2^32 = 360 degrees).
+    Adding PhaseIncrement every sample is exact integer math, so unlike accumulating radians in a float32 it never
+    loses precision and never drifts, no matter how long we run. The only error is rounding the frequency once,
+    when PhaseIncrement is computed, which is less than SamplesPerSecond/2^33 Hz (about 0.000006 Hz at 48 kHz).
+*/
+
+#define MAX_OSCILLATOR_COUNT 64
+#define OSCILLATOR_NOISE_LANES 8
+
+enum oscillator_waveform
+{
+    Waveform_Sine,
+    Waveform_Square,
+    Waveform_Saw,
+    Waveform_Noise,
+};
+
+struct oscillator
+{
+    oscillator_waveform Waveform;
+    uint32 Phase;
+    uint32 PhaseIncrement;
+    float32 Volume; //NOTE(Robin) In int16 units, so 32767 is full scale
+
+    //Noise is a xorshift generator per SIMD lane, so 8 noise samples can be made at once
+    uint32 NoiseState[OSCILLATOR_NOISE_LANES];
+};
+
+struct oscillator_bank
+{
+    int VoiceCount;
+    oscillator Voices[MAX_OSCILLATOR_COUNT];
+};
+
+/*
+    The mixer plays loaded sounds on top of the oscillators. Everything is summed in float32 (in int16 units, so a gain
+    of 1 plays a sound at its recorded level) into one buffer per channel, and only converted to interleaved int16,
+    with saturation, once at the very end.
+
+    Positions are 48.16 fixed point so looping sounds never lose precision, and pitch is a 16.16 step per output
+    sample. Every output sample linearly interpolates between the two source samples around its position.
+*/
+
+#define MAX_SOUND_PITCH 16.0f
+#define MIX_CHUNK_SIZE 1024
+
+struct loaded_sound
+{
+    int SampleCount; //NOTE(Robin) In frames, one frame is one sample for every channel
+    int ChannelCount; //NOTE(Robin) 1 or 2, stereo is interleaved like game_sound_output_buffer
+    int16 *Samples; //NOTE(Robin) Must have one extra frame of zeros past SampleCount, the interpolation reads it
+};
+
+struct playing_sound
+{
+    loaded_sound *Sound;
+    float32 Gain[2];
+    uint64 Position;
+    uint32 Step;
+    bool32 Looping;
+
+    playing_sound *Next;
+};
+
+struct audio_state
+{
+    memory_arena *PermanentArena;
+    playing_sound *FirstPlayingSound;
+    playing_sound *FirstFreePlayingSound;
+};
+
+#define MIDNIGHT_MADNESS_AUDIO_H
+#endif
@@ -0,0 +1,220 @@
+#if !defined(MIDNIGHT_MADNESS_AUDIO_RING_H)
+
+/*
+    Lock-free single producer / single consumer ring of sound blocks, shared by the platform layers.
+
+    - The producer is the game thread. It gets the next free block, has GameGetSoundSamples write straight into it
+      (so nothing is copied), and publishes it.
+    - The consumer is the audio thread. It takes published blocks in order and hands them to the sound device.
+    - WriteIndex and ReadIndex only ever count up, and each one is only written by one thread, so no locks and no
+      compare-exchange are needed. Queued blocks = WriteIndex - ReadIndex, which stays right even when they wrap.
+    - Overruns are counted by the producer (the ring was full, the block was dropped), underruns by the consumer
+      (the device needed sound and the ring was empty, so it got silence).
+*/
+
+#define AUDIO_RING_CACHE_LINE 64
+
+struct audio_ring
+{
+    uint32 BlockCount; //NOTE(Robin) Must be a power of two
+    int SamplesPerBlock;
+    int16 *Samples;
+    int *BlockSampleCounts;
+
+    //The two indices are on their own cache lines, so the two threads don't keep stealing the line from each other
+    uint8 Pad0[AUDIO_RING_CACHE_LINE];
+    uint32 volatile WriteIndex;
+    uint32 volatile OverrunCount;
+    uint8 Pad1[AUDIO_RING_CACHE_LINE - 2*sizeof(uint32)];
+    uint32 volatile ReadIndex;
+    uint32 volatile UnderrunCount;
+    uint8 Pad2[AUDIO_RING_CACHE_LINE - 2*sizeof(uint32)];
+};
+
+internal memory_index AudioRingMemorySize(uint32 BlockCount, int SamplesPerBlock)
+{
+    memory_index Result = (memory_index)BlockCount*SamplesPerBlock*2*sizeof(int16) + BlockCount*sizeof(int);
+    return(Result);
+}
+
+internal void InitializeAudioRing(audio_ring *Ring, uint32 BlockCount, int SamplesPerBlock, void *Memory)
+{
+    Assert((BlockCount & (BlockCount - 1)) == 0);
+
+    Ring->BlockCount = BlockCount;
+    Ring->SamplesPerBlock = SamplesPerBlock;
+    Ring->Samples = (int16 *)Memory;
+    Ring->BlockSampleCounts = (int *)(Ring->Samples + (memory_index)BlockCount*SamplesPerBlock*2);
+    Ring->WriteIndex = 0;
+    Ring->ReadIndex = 0;
+    Ring->OverrunCount = 0;
+    Ring->UnderrunCount = 0;
+}
+
+internal uint32 AudioRingQueuedBlocks(audio_ring *Ring)
+{
+    uint32 Result = AtomicLoadAcquire(&Ring->WriteIndex) - AtomicLoadAcquire(&Ring->ReadIndex);
+    return(Result);
+}
+
+//Producer side. Returns 0 when the ring is full.
+internal int16 *BeginAudioRingWrite(audio_ring *Ring)
+{
+    int16 *Result = 0;
+
+    uint32 WriteIndex = Ring->WriteIndex;
+    uint32 ReadIndex = AtomicLoadAcquire(&Ring->ReadIndex);
+    if((WriteIndex - ReadIndex) < Ring->BlockCount)
+    {
+        uint32 Slot = WriteIndex & (Ring->BlockCount - 1);
+        Result = Ring->Samples + (memory_index)Slot*Ring->SamplesPerBlock*2;
+    }
+    else
+    {
+        //Only the producer writes the overrun count
+        Ring->OverrunCount = Ring->OverrunCount + 1;
+    }
+
+    return(Result);
+}
+
+internal void EndAudioRingWrite(audio_ring *Ring, int SampleCount)
+{
+    Assert(SampleCount <= Ring->SamplesPerBlock);
+
+    uint32 WriteIndex = Ring->WriteIndex;
+    Ring->BlockSampleCounts[WriteIndex & (Ring->BlockCount - 1)] = SampleCount;
+    //Release: the samples and the count have to be visible before the consumer can see the new index
+    AtomicStoreRelease(&Ring->WriteIndex, WriteIndex + 1);
+}
+
+//Consumer side. Returns 0 when the ring is empty, the consumer decides if that is an underrun.
+internal int16 *BeginAudioRingRead(audio_ring *Ring, int *SampleCount)
+{
+    int16 *Result = 0;
+
+    uint32 ReadIndex = Ring->ReadIndex;
+    uint32 WriteIndex = AtomicLoadAcquire(&Ring->WriteIndex);
+    if(ReadIndex != WriteIndex)
+    {
+        uint32 Slot = ReadIndex & (Ring->BlockCount - 1);
+        Result = Ring->Samples + (memory_index)Slot*Ring->SamplesPerBlock*2;
+        *SampleCount = Ring->BlockSampleCounts[Slot];
+    }
+
+    return(Result);
+}
+
+internal void EndAudioRingRead(audio_ring *Ring)
+{
+    //Release: we are done reading the block before the producer may reuse it
+    AtomicStoreRelease(&Ring->ReadIndex, Ring->ReadIndex + 1);
+}
+
+internal void CountAudioRingUnderrun(audio_ring *Ring)
+{
+    Ring->UnderrunCount = Ring->UnderrunCount + 1;
+}
+
+/*
+    Latency scheduling.
+
+    The audio thread publishes an audio_device_clock: how many samples the device has played, how many it has been
+    given (the game's, plus any silence it had to insert), how many it took from the ring, and what it learned about
+    the device: how far ahead of the play cursor the write cursor runs, how big the write cursor's jumps are, and how
+    long the audio thread itself takes to come back around.
+
+    The game thread uses that to write just enough sound each frame to last until the next frame's sound arrives,
+    plus that measured safety margin, instead of everything up to the play cursor. That bounds the latency at about
+    LatencyFrames frames plus the margin, and the samples written per frame follow the actual frame time.
+
+    All indices are sample counts that only go up and wrap at 2^32, so differences stay right.
+*/
+
+struct audio_device_clock
+{
+    uint32 volatile PlayedSampleIndex;
+    uint32 volatile WrittenSampleIndex;
+    uint32 volatile RingSamplesConsumed;
+
+    uint32 volatile WriteLeadSamples;
+    uint32 volatile GranularitySamples;
+    uint32 volatile ServiceIntervalSamples;
+};
+
+struct audio_scheduler
+{
+    int SamplesPerSecond;
+    int MaxSamplesPerFrame;
+    float32 LatencyFrames;
+
+    uint32 ProducedSampleIndex;
+
+    //Stats, game thread only
+    int LastSampleCount;
+    int MinSampleCount;
+    int MaxSampleCount;
+    float32 LastLatencySeconds;
+    float32 MaxLatencySeconds;
+};
+
+internal void InitializeAudioScheduler(audio_scheduler *Scheduler, int SamplesPerSecond, int MaxSamplesPerFrame, float32 LatencyFrames)
+{
+    Scheduler->SamplesPerSecond = SamplesPerSecond;
+    Scheduler->MaxSamplesPerFrame = MaxSamplesPerFrame;
+    Scheduler->LatencyFrames = LatencyFrames;
+    Scheduler->ProducedSampleIndex = 0;
+    Scheduler->LastSampleCount = 0;
+    Scheduler->MinSampleCount = MaxSamplesPerFrame;
+    Scheduler->MaxSampleCount = 0;
+    Scheduler->LastLatencySeconds = 0.0f;
+    Scheduler->MaxLatencySeconds = 0.0f;
+}
+
+//Samples queued between the game and the speaker: still in the ring, plus written to the device but not played yet
+internal uint32 AudioQueuedSamples(audio_scheduler *Scheduler, audio_device_clock *Clock)
+{
+    uint32 Played = AtomicLoadAcquire(&Clock->PlayedSampleIndex);
+    uint32 Written = AtomicLoadAcquire(&Clock->WrittenSampleIndex);
+    uint32 Consumed = AtomicLoadAcquire(&Clock->RingSamplesConsumed);
+
+    uint32 Result = (Scheduler->ProducedSampleIndex - Consumed) + (Written - Played);
+    return(Result);
+}
+
+//How many samples the game should produce this frame, ExpectedFrameSeconds being the time until it next gets to
+internal int ComputeAudioSamplesNeeded(audio_scheduler *Scheduler, audio_device_clock *Clock, float32 ExpectedFrameSeconds)
+{
+    uint32 SafetySamples = AtomicLoadAcquire(&Clock->WriteLeadSamples) + AtomicLoadAcquire(&Clock->GranularitySamples) +
+                           AtomicLoadAcquire(&Clock->ServiceIntervalSamples);
+    uint32 FrameSamples = (uint32)(ExpectedFrameSeconds*Scheduler->LatencyFrames*Scheduler->SamplesPerSecond);
+    uint32 TargetSamples = FrameSamples + SafetySamples;
+
+    uint32 Queued = AudioQueuedSamples(Scheduler, Clock);
+    int Result = (Queued < TargetSamples) ? (int)(TargetSamples - Queued) : 0;
+    if(Result > Scheduler->MaxSamplesPerFrame)
+    {
+        Result = Scheduler->MaxSamplesPerFrame;
+    }
+    return(Result);
+}
+
+//Call once per frame, after the samples went into the ring
+internal void RecordAudioSamplesProduced(audio_scheduler *Scheduler, audio_device_clock *Clock, int SampleCount)
+{
+    Scheduler->ProducedSampleIndex += SampleCount;
+
+    Scheduler->LastSampleCount = SampleCount;
+    Scheduler->MinSampleCount = (SampleCount < Scheduler->MinSampleCount) ? SampleCount : Scheduler->MinSampleCount;
+    Scheduler->MaxSampleCount = (SampleCount > Scheduler->MaxSampleCount) ? SampleCount : Scheduler->MaxSampleCount;
+
+    //The newest sample will be heard once everything queued in front of it has played
+    Scheduler->LastLatencySeconds = (float32)AudioQueuedSamples(Scheduler, Clock) / (float32)Scheduler->SamplesPerSecond;
+    if(Scheduler->LastLatencySeconds > Scheduler->MaxLatencySeconds)
+    {
+        Scheduler->MaxLatencySeconds = Scheduler->LastLatencySeconds;
+    }
+}
+
+#define MIDNIGHT_MADNESS_AUDIO_RING_H
+#endif
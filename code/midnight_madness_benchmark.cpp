@@ -0,0 +1,965 @@
+/*
+
+    Micro-benchmarks for the game layer, and the gate that keeps it from getting slower.
+
+    - Built with optimisations on and without asserts or the profiler (see build.sh), so it times the code players get.
+    - Every benchmark runs its function a batch at a time: the batch is sized once so it takes about -reptime ms, run
+      -warmup times to fill the caches and settle the clock, then -repeats times for the result. The per call time is
+      reported as the median, the fastest, the mean and the spread of the repeats.
+    - The results go out as JSON (-out, default midnight_madness_benchmark.json), one benchmark per line so a baseline
+      can be compared against with nothing more than strstr.
+    - With -runs N the whole set is timed N times over, and every benchmark keeps its middle run (by median). One run
+      catches whatever the machine was doing during those few seconds, so a baseline wants a few.
+    - With -baseline FILE every benchmark is compared with the same one there, and the run fails (exit code 1) if any
+      got slower than -threshold percent (default 35). It has to be slower in its median and in its fastest repeat
+      both, and stay that way when it is timed again: up to -retries more rounds (default 8), three seconds or more
+      apart, each timing every benchmark still slower once more and keeping the best median and the best fastest
+      repeat, so the retries of one benchmark are spread over half a minute and a neighbour hogging the core or the
+      memory bus for a while doesn't fail the run. On a shared virtual machine timings swing by tens of percent for
+      seconds at a time, which is what the threshold is set for; on a quiet machine a lower one catches more.
+      A benchmark the baseline has no entry for fails the run too (exit code 2, when nothing got slower), so a new
+      benchmark can't go ungated. Baselines only mean anything on the machine they were recorded on, the run warns
+      when the CPU isn't the same.
+
+    The benchmarks:
+    - gradient: RenderWeirdGradient at 320x180 up to 4K, with rows packed, padded out to a cache line, and padded by
+      one pixel (so no row after the first is aligned), with every SIMD path the CPU has.
+    - background: the same gradient copied out of its 256x256 tiled_background, the way the game draws it, at the same
+      sizes and pitches. It is only memcpy, so it has no SIMD paths of its own.
+    - sound: GameOutputSound (the oscillator bank, the mixer and the conversion to int16) for 128 samples up to a 10Hz
+      frame's worth at 48kHz, at three tones, with every SIMD path.
+    - overlay: DrawOverlay with a screenful of the performance overlay's lines (see midnight_madness_overlay.h) over a
+      720p and a 1080p frame, with every SIMD path. Pixels are the glyph cells drawn, spaces left out.
+    - blend: a translucent rectangle over a 720p frame, the same rectangle drawn a row at a time (rows are too small
+      for the table linear blending builds per rectangle), and a 256x256 sprite, each blended on the sRGB bytes and in
+      linear light, with every SIMD path: what getting blending right costs.
+    - soundfill: the copy Win32FillSoundBuffer makes into the regions DirectSound hands back, from a frame's samples
+      into a one second ring, once in one piece and once wrapping around its end.
+
+    Usage: midnight_madness_benchmark [-repeats N] [-warmup N] [-reptime MS] [-runs N] [-filter TEXT] [-out FILE]
+                                      [-baseline FILE [-threshold PERCENT] [-retries N]]
+
+    To refresh the stored baseline after a change that is meant to be slower (or on a new machine):
+        midnight_madness_benchmark -runs 5 -out ../code/midnight_madness_benchmark_baseline.json
+
+*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "midnight_madness.cpp"
+#include "midnight_madness_overlay.h"
+
+#define BENCHMARK_MAX_COUNT 256
+#define BENCHMARK_MAX_REPEATS 101
+#define BENCHMARK_MAX_RUNS 15
+#define BENCHMARK_RETRY_ROUND_NANOSECONDS 3000000000LL //NOTE(Robin) The least time from the start of one retry round to the next
+#define BENCHMARK_SAMPLES_PER_SECOND 48000
+#define BENCHMARK_SOUND_ARENA_SIZE Kilobytes(64) //NOTE(Robin) The mix buffers of a 10Hz frame at 48kHz are 38KB
+
+global_variable const char *BenchmarkSIMDLevelNames[SIMDLevel_Count] = {"auto", "scalar", "sse2", "avx2"};
+global_variable const char *BenchmarkBlendSpaceNames[BlendSpace_Count] = {"srgb", "linear"};
+
+enum benchmark_kind
+{
+    Benchmark_Gradient,
+    Benchmark_TiledBackground,
+    Benchmark_Overlay,
+    Benchmark_BlendRectangle,
+    Benchmark_BlendRows,
+    Benchmark_BlendBitmap,
+    Benchmark_Sound,
+    Benchmark_SoundFill,
+};
+
+//Everything a benchmark needs to run its function once, set up before it is timed
+struct benchmark_case
+{
+    benchmark_kind Kind;
+    simd_level Level; //NOTE(Robin) The sound fill has no SIMD path, it runs with the widest
+    blend_space BlendSpace; //NOTE(Robin) sRGB for everything but the blend benchmarks that say otherwise
+    char Name[64];
+    const char *Unit; //NOTE(Robin) What Throughput counts, per second
+    float64 WorkPerCall; //NOTE(Robin) Pixels or samples
+
+    game_offscreen_buffer Buffer;
+    tiled_background *Background;
+    debug_overlay *Overlay;
+    loaded_bitmap *Bitmap;
+    game_state *GameState; //NOTE(Robin) Shared by the sound benchmarks
+    int ToneHz;
+    game_sound_output_buffer SoundBuffer;
+    uint8 *Ring;
+    uint32 RingSize;
+    uint32 ByteToLock;
+};
+
+struct benchmark_result
+{
+    char Name[64];
+    const char *Unit;
+    int64 Iterations;
+    float64 MedianNanoseconds;
+    float64 MinNanoseconds;
+    float64 MeanNanoseconds;
+    float64 StdDevNanoseconds;
+    float64 Throughput;
+};
+
+struct benchmark_settings
+{
+    int Repeats;
+    int WarmupRepeats;
+    int RepMilliseconds;
+    int Runs;
+    char *Filter;
+    char *OutPath;
+    char *BaselinePath;
+    float64 ThresholdPercent;
+    int Retries;
+};
+
+//Written after every repeat so the compiler can't decide nobody looks at what the function wrote
+global_variable volatile uint32 GlobalBenchmarkSink;
+
+internal int64 BenchmarkGetNanoseconds(void)
+{
+    timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return((int64)Now.tv_sec*1000000000LL + (int64)Now.tv_nsec);
+}
+
+internal void *BenchmarkAllocate(memory_index Size)
+{
+    //Page aligned like everything the platforms allocate, and touched up front so no repeat pays for the page faults
+    void *Result = 0;
+    if(posix_memalign(&Result, 4096, Size) == 0)
+    {
+        memset(Result, 0, Size);
+    }
+    else
+    {
+        Result = 0;
+    }
+    return(Result);
+}
+
+internal void BenchmarkCPUName(char *Name, int NameSize)
+{
+    uint32 Brand[13] = {};
+    if(CPUID(0x80000000, 0).EAX >= 0x80000004)
+    {
+        for(uint32 Leaf = 0; Leaf < 3; ++Leaf)
+        {
+            cpuid_result Result = CPUID(0x80000002 + Leaf, 0);
+            Brand[4*Leaf + 0] = Result.EAX;
+            Brand[4*Leaf + 1] = Result.EBX;
+            Brand[4*Leaf + 2] = Result.ECX;
+            Brand[4*Leaf + 3] = Result.EDX;
+        }
+    }
+
+    //The brand string is padded with spaces on either side, and a JSON string can't have quotes in it
+    char *Source = (char *)Brand;
+    while(*Source == ' ')
+    {
+        ++Source;
+    }
+    int Length = 0;
+    for(; *Source && (Length < NameSize - 1); ++Source)
+    {
+        Name[Length++] = (*Source == '"') ? '\'' : *Source;
+    }
+    while((Length > 0) && (Name[Length - 1] == ' '))
+    {
+        --Length;
+    }
+    Name[Length] = 0;
+}
+
+internal void RunBenchmarkCase(benchmark_case *Case)
+{
+    switch(Case->Kind)
+    {
+        case Benchmark_Gradient:
+        {
+            RenderWeirdGradient(&Case->Buffer, 17, -5);
+        } break;
+
+        case Benchmark_TiledBackground:
+        {
+            DrawTiledBackground(&Case->Buffer, Case->Background, 17, -5, RectangleFromBuffer(&Case->Buffer));
+        } break;
+
+        case Benchmark_Overlay:
+        {
+            DrawOverlay(Case->Overlay, &Case->Buffer);
+        } break;
+
+        case Benchmark_BlendRectangle:
+        {
+            DrawRectangle(&Case->Buffer, V2(0.0f, 0.0f), V2((float32)Case->Buffer.Width, (float32)Case->Buffer.Height),
+                          V4(0.1f, 0.2f, 0.3f, 0.5f), RectangleFromBuffer(&Case->Buffer));
+        } break;
+
+        case Benchmark_BlendRows:
+        {
+            for(int Y = 0; Y < Case->Buffer.Height; ++Y)
+            {
+                DrawRectangle(&Case->Buffer, V2(0.0f, (float32)Y), V2((float32)Case->Buffer.Width, (float32)(Y + 1)),
+                              V4(0.1f, 0.2f, 0.3f, 0.5f), RectangleFromBuffer(&Case->Buffer));
+            }
+        } break;
+
+        case Benchmark_BlendBitmap:
+        {
+            DrawBitmap(&Case->Buffer, Case->Bitmap, V2(100.0f, 50.0f), RectangleFromBuffer(&Case->Buffer));
+        } break;
+
+        case Benchmark_Sound:
+        {
+            GameOutputSound(Case->GameState, &Case->SoundBuffer);
+        } break;
+
+        case Benchmark_SoundFill:
+        {
+            //Win32FillSoundBuffer's two CopyMemory calls, with the regions worked out the way DirectSound's Lock does
+            uint32 BytesToWrite = Case->SoundBuffer.SampleCount*2*sizeof(int16);
+            uint32 Region1Size = BytesToWrite;
+            if(Case->ByteToLock + BytesToWrite > Case->RingSize)
+            {
+                Region1Size = Case->RingSize - Case->ByteToLock;
+            }
+            uint32 Region2Size = BytesToWrite - Region1Size;
+
+            uint8 *SourceBytes = (uint8 *)Case->SoundBuffer.Samples;
+            memcpy(Case->Ring + Case->ByteToLock, SourceBytes, Region1Size);
+            if(Region2Size)
+            {
+                memcpy(Case->Ring, SourceBytes + Region1Size, Region2Size);
+            }
+        } break;
+    }
+}
+
+internal uint32 BenchmarkCaseOutput(benchmark_case *Case)
+{
+    uint32 Result = 0;
+    switch(Case->Kind)
+    {
+        case Benchmark_Gradient:
+        case Benchmark_TiledBackground:
+        case Benchmark_Overlay:
+        case Benchmark_BlendRectangle:
+        case Benchmark_BlendRows:
+        case Benchmark_BlendBitmap:
+        {
+            Result = *(uint32 *)Case->Buffer.Memory;
+        } break;
+
+        case Benchmark_Sound:
+        {
+            Result = (uint32)Case->SoundBuffer.Samples[0];
+        } break;
+
+        case Benchmark_SoundFill:
+        {
+            Result = (uint32)Case->Ring[Case->ByteToLock];
+        } break;
+    }
+    return(Result);
+}
+
+internal int CompareFloat64(const void *A, const void *B)
+{
+    float64 ValueA = *(float64 *)A;
+    float64 ValueB = *(float64 *)B;
+    int Result = (ValueA < ValueB) ? -1 : ((ValueA > ValueB) ? 1 : 0);
+    return(Result);
+}
+
+//One game_state for every sound benchmark, followed by its two arenas
+internal game_state *BenchmarkMakeGameState(void)
+{
+    game_state *GameState = (game_state *)BenchmarkAllocate(sizeof(game_state) + 2*BENCHMARK_SOUND_ARENA_SIZE);
+    return(GameState);
+}
+
+//Sets up the game_state GameOutputSound needs, the way the game's first frame does, with only the test tone playing.
+//Done before every time a sound benchmark is timed, so none starts where the one before left the state.
+internal void BenchmarkResetGameState(game_state *GameState, int ToneHz)
+{
+    uint8 *Arenas = (uint8 *)GameState + sizeof(game_state);
+    *GameState = {};
+    InitializeArena(&GameState->PermanentArena, BENCHMARK_SOUND_ARENA_SIZE, Arenas);
+    InitializeArena(&GameState->TransientArena, BENCHMARK_SOUND_ARENA_SIZE, Arenas + BENCHMARK_SOUND_ARENA_SIZE);
+    AddOscillator(&GameState->Oscillators, Waveform_Sine, 0.0f, 3000.0f, 1);
+    InitializeAudioState(&GameState->AudioState, &GameState->PermanentArena);
+    GameState->ToneHz = ToneHz;
+}
+
+internal int CompareResultMedians(const void *A, const void *B)
+{
+    int Result = CompareFloat64(&((benchmark_result *)A)->MedianNanoseconds, &((benchmark_result *)B)->MedianNanoseconds);
+    return(Result);
+}
+
+internal benchmark_result TimeBenchmarkCase(benchmark_case *Case, benchmark_settings *Settings)
+{
+    if(Case->Kind == Benchmark_Sound)
+    {
+        BenchmarkResetGameState(Case->GameState, Case->ToneHz);
+    }
+
+    benchmark_result Result = {};
+    memcpy(Result.Name, Case->Name, sizeof(Result.Name));
+    Result.Unit = Case->Unit;
+
+    //Doubles the batch until it takes long enough for the clock's own cost not to matter
+    int64 RepNanoseconds = (int64)Settings->RepMilliseconds*1000000LL;
+    int64 Iterations = 1;
+    for(;;)
+    {
+        int64 Start = BenchmarkGetNanoseconds();
+        for(int64 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            RunBenchmarkCase(Case);
+        }
+        int64 Elapsed = BenchmarkGetNanoseconds() - Start;
+        if((Elapsed >= RepNanoseconds/4) || (Iterations >= (1LL << 30)))
+        {
+            Iterations = (Elapsed > 0) ? (Iterations*RepNanoseconds + Elapsed - 1) / Elapsed : Iterations;
+            Iterations = (Iterations < 1) ? 1 : Iterations;
+            break;
+        }
+        Iterations *= 2;
+    }
+    Result.Iterations = Iterations;
+
+    float64 PerCall[BENCHMARK_MAX_REPEATS];
+    for(int Repeat = -Settings->WarmupRepeats; Repeat < Settings->Repeats; ++Repeat)
+    {
+        int64 Start = BenchmarkGetNanoseconds();
+        for(int64 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            RunBenchmarkCase(Case);
+        }
+        int64 Elapsed = BenchmarkGetNanoseconds() - Start;
+        GlobalBenchmarkSink += BenchmarkCaseOutput(Case);
+
+        if(Repeat >= 0)
+        {
+            PerCall[Repeat] = (float64)Elapsed / (float64)Iterations;
+        }
+    }
+
+    float64 Sum = 0.0;
+    float64 SumOfSquares = 0.0;
+    for(int Repeat = 0; Repeat < Settings->Repeats; ++Repeat)
+    {
+        Sum += PerCall[Repeat];
+        SumOfSquares += PerCall[Repeat]*PerCall[Repeat];
+    }
+    qsort(PerCall, Settings->Repeats, sizeof(float64), CompareFloat64);
+
+    Result.MedianNanoseconds = PerCall[Settings->Repeats/2];
+    Result.MinNanoseconds = PerCall[0];
+    Result.MeanNanoseconds = Sum / Settings->Repeats;
+    float64 Variance = SumOfSquares / Settings->Repeats - Result.MeanNanoseconds*Result.MeanNanoseconds;
+    Result.StdDevNanoseconds = (Variance > 0.0) ? sqrt(Variance) : 0.0;
+    Result.Throughput = Case->WorkPerCall / Result.MedianNanoseconds * 1.0e9;
+
+    return(Result);
+}
+
+internal bool32 BenchmarkMatchesFilter(char *Name, benchmark_settings *Settings)
+{
+    bool32 Result = (!Settings->Filter || strstr(Name, Settings->Filter));
+    return(Result);
+}
+
+//Every benchmark there is, in the order they run. Returns how many, or -1 if one couldn't get its memory.
+internal int MakeBenchmarkCases(benchmark_case *Cases, int MaxCaseCount, benchmark_settings *Settings, simd_level Supported)
+{
+    int CaseCount = 0;
+
+    //One buffer big enough for the biggest frame at the widest pitch, shared by every gradient
+    int Resolutions[][2] = {{320, 180}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+    const char *PitchNames[] = {"packed", "padded", "unaligned"};
+    int PitchPadding[] = {0, 64, 4};
+    void *FrameMemory = BenchmarkAllocate((memory_index)(3840*4 + 64)*2160);
+    if(!FrameMemory)
+    {
+        return(-1);
+    }
+    for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+    {
+        for(int ResolutionIndex = 0; ResolutionIndex < ArrayCount(Resolutions); ++ResolutionIndex)
+        {
+            for(int PitchIndex = 0; PitchIndex < ArrayCount(PitchNames); ++PitchIndex)
+            {
+                benchmark_case Case = {};
+                Case.Kind = Benchmark_Gradient;
+                Case.Level = (simd_level)Level;
+                int Width = Resolutions[ResolutionIndex][0];
+                int Height = Resolutions[ResolutionIndex][1];
+                snprintf(Case.Name, sizeof(Case.Name), "gradient/%s/%dx%d/%s", BenchmarkSIMDLevelNames[Level],
+                         Width, Height, PitchNames[PitchIndex]);
+                Case.Unit = "Mpixels/s";
+                Case.WorkPerCall = (float64)Width*Height / 1.0e6;
+                Case.Buffer.Memory = FrameMemory;
+                Case.Buffer.Width = Width;
+                Case.Buffer.Height = Height;
+                Case.Buffer.Pitch = Width*4 + PitchPadding[PitchIndex];
+                Case.Buffer.Format = PixelFormat_BGRX8888;
+                if(BenchmarkMatchesFilter(Case.Name, Settings) && (CaseCount < MaxCaseCount))
+                {
+                    Cases[CaseCount++] = Case;
+                }
+            }
+        }
+    }
+
+    //One tile shared by every background, drawn once like the game does on its first frame
+    memory_index TileMemorySize = Megabytes(1);
+    void *TileMemory = BenchmarkAllocate(TileMemorySize);
+    if(!TileMemory)
+    {
+        return(-1);
+    }
+    memory_arena TileArena;
+    InitializeArena(&TileArena, TileMemorySize, TileMemory);
+    tiled_background *Background = PushStruct(&TileArena, tiled_background);
+    InitializeTiledBackground(Background, &TileArena, 256, 256);
+    DrawGradientBackground(Background, PixelFormat_BGRX8888);
+    for(int ResolutionIndex = 0; ResolutionIndex < ArrayCount(Resolutions); ++ResolutionIndex)
+    {
+        for(int PitchIndex = 0; PitchIndex < ArrayCount(PitchNames); ++PitchIndex)
+        {
+            benchmark_case Case = {};
+            Case.Kind = Benchmark_TiledBackground;
+            Case.Level = Supported;
+            int Width = Resolutions[ResolutionIndex][0];
+            int Height = Resolutions[ResolutionIndex][1];
+            snprintf(Case.Name, sizeof(Case.Name), "background/%dx%d/%s", Width, Height, PitchNames[PitchIndex]);
+            Case.Unit = "Mpixels/s";
+            Case.WorkPerCall = (float64)Width*Height / 1.0e6;
+            Case.Buffer.Memory = FrameMemory;
+            Case.Buffer.Width = Width;
+            Case.Buffer.Height = Height;
+            Case.Buffer.Pitch = Width*4 + PitchPadding[PitchIndex];
+            Case.Buffer.Format = PixelFormat_BGRX8888;
+            Case.Background = Background;
+            if(BenchmarkMatchesFilter(Case.Name, Settings) && (CaseCount < MaxCaseCount))
+            {
+                Cases[CaseCount++] = Case;
+            }
+        }
+    }
+
+    //The lines the Linux build's -overlay shows, with the profiler on
+    debug_overlay *Overlay = (debug_overlay *)BenchmarkAllocate(sizeof(debug_overlay));
+    if(!Overlay)
+    {
+        return(-1);
+    }
+    InitializeOverlay(Overlay);
+    BeginOverlayText(Overlay);
+    OverlayPrint(Overlay, "Frame %d  %dx%d %s  %s  %d threads", 1234, 1280, 720, "bgrx8888", "avx2", 8);
+    OverlayPrint(Overlay, "Render %.3f ms  %.2f Mcycles", 1.274, 2.68);
+    OverlayPrint(Overlay, "Input to present %.3f ms (last frame)  pipeline depth %d", 2.513, 1);
+    OverlayPrint(Overlay, "Audio latency %.1f ms  max %.1f ms  underruns %u", 21.3, 24.9, 0);
+    OverlayPrint(Overlay, "Overlay %.1f us (last frame)", 61.2);
+    OverlayPrint(Overlay, "%-24s %6s %9s %6s", "Block", "calls", "cycles", "frame");
+    const char *BlockNames[] = {"GameUpdateAndRender", "TiledRenderGroupToOutput", "RenderGroupToOutput", "DrawTexturedQuad",
+                                "DrawTiledBackground", "DrawBitmap", "GameOutputSound", "DrawOverlay"};
+    for(int BlockIndex = 0; BlockIndex < ArrayCount(BlockNames); ++BlockIndex)
+    {
+        OverlayPrint(Overlay, "%-24.24s %6.1f %9.0f %5.1f%%", BlockNames[BlockIndex], 1.0f + BlockIndex,
+                     2680000.0f / (1 + BlockIndex), 100.0f / (1 + BlockIndex));
+    }
+    int OverlayGlyphCount = 0;
+    for(int LineIndex = 0; LineIndex < Overlay->LineCount; ++LineIndex)
+    {
+        for(char *Character = Overlay->Lines[LineIndex]; *Character; ++Character)
+        {
+            OverlayGlyphCount += (*Character != ' ') ? 1 : 0;
+        }
+    }
+    for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+    {
+        for(int ResolutionIndex = 1; ResolutionIndex <= 2; ++ResolutionIndex)
+        {
+            benchmark_case Case = {};
+            Case.Kind = Benchmark_Overlay;
+            Case.Level = (simd_level)Level;
+            int Width = Resolutions[ResolutionIndex][0];
+            int Height = Resolutions[ResolutionIndex][1];
+            snprintf(Case.Name, sizeof(Case.Name), "overlay/%s/%dx%d", BenchmarkSIMDLevelNames[Level], Width, Height);
+            Case.Unit = "Mpixels/s";
+            Case.WorkPerCall = (float64)OverlayGlyphCount*OVERLAY_CELL_WIDTH*OVERLAY_CELL_HEIGHT / 1.0e6;
+            Case.Buffer.Memory = FrameMemory;
+            Case.Buffer.Width = Width;
+            Case.Buffer.Height = Height;
+            Case.Buffer.Pitch = Width*4;
+            Case.Buffer.Format = PixelFormat_BGRX8888;
+            Case.Overlay = Overlay;
+            if(BenchmarkMatchesFilter(Case.Name, Settings) && (CaseCount < MaxCaseCount))
+            {
+                Cases[CaseCount++] = Case;
+            }
+        }
+    }
+
+    //A 256x256 sprite, soft edged so it has translucent pixels for linear blending to convert, along with opaque and
+    //clear ones, like the game's
+    memory_index SpriteMemorySize = Megabytes(1);
+    void *SpriteMemory = BenchmarkAllocate(SpriteMemorySize);
+    if(!SpriteMemory)
+    {
+        return(-1);
+    }
+    memory_arena SpriteArena;
+    InitializeArena(&SpriteArena, SpriteMemorySize, SpriteMemory);
+    loaded_bitmap *Sprite = PushStruct(&SpriteArena, loaded_bitmap);
+    *Sprite = MakeTestSprite(&SpriteArena, 256, 256);
+    benchmark_kind BlendKinds[] = {Benchmark_BlendRectangle, Benchmark_BlendRows, Benchmark_BlendBitmap};
+    const char *BlendKindNames[] = {"rectangle", "rows", "bitmap"};
+    for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+    {
+        for(int KindIndex = 0; KindIndex < ArrayCount(BlendKinds); ++KindIndex)
+        {
+            for(int Space = 0; Space < BlendSpace_Count; ++Space)
+            {
+                benchmark_case Case = {};
+                Case.Kind = BlendKinds[KindIndex];
+                Case.Level = (simd_level)Level;
+                Case.BlendSpace = (blend_space)Space;
+                snprintf(Case.Name, sizeof(Case.Name), "blend/%s/%s/%s", BenchmarkSIMDLevelNames[Level], BlendKindNames[KindIndex],
+                         BenchmarkBlendSpaceNames[Space]);
+                Case.Unit = "Mpixels/s";
+                Case.WorkPerCall = (Case.Kind == Benchmark_BlendBitmap) ? (float64)Sprite->Width*Sprite->Height / 1.0e6 :
+                                                                          (float64)1280*720 / 1.0e6;
+                Case.Buffer.Memory = FrameMemory;
+                Case.Buffer.Width = 1280;
+                Case.Buffer.Height = 720;
+                Case.Buffer.Pitch = 1280*4;
+                Case.Buffer.Format = PixelFormat_BGRX8888;
+                Case.Bitmap = Sprite;
+                if(BenchmarkMatchesFilter(Case.Name, Settings) && (CaseCount < MaxCaseCount))
+                {
+                    Cases[CaseCount++] = Case;
+                }
+            }
+        }
+    }
+
+    //The tone's phase carries on from call to call like in a game, from a state reset before each benchmark is timed
+    int SampleCounts[] = {128, BENCHMARK_SAMPLES_PER_SECOND/60, BENCHMARK_SAMPLES_PER_SECOND/30, BENCHMARK_SAMPLES_PER_SECOND/10};
+    int Tones[] = {128, 256, 512};
+    int16 *Samples = (int16 *)BenchmarkAllocate(BENCHMARK_SAMPLES_PER_SECOND*2*sizeof(int16));
+    game_state *GameState = BenchmarkMakeGameState();
+    if(!Samples || !GameState)
+    {
+        return(-1);
+    }
+    for(int Level = SIMDLevel_Scalar; Level <= Supported; ++Level)
+    {
+        for(int CountIndex = 0; CountIndex < ArrayCount(SampleCounts); ++CountIndex)
+        {
+            for(int ToneIndex = 0; ToneIndex < ArrayCount(Tones); ++ToneIndex)
+            {
+                benchmark_case Case = {};
+                Case.Kind = Benchmark_Sound;
+                Case.Level = (simd_level)Level;
+                snprintf(Case.Name, sizeof(Case.Name), "sound/%s/%d samples/%d Hz", BenchmarkSIMDLevelNames[Level],
+                         SampleCounts[CountIndex], Tones[ToneIndex]);
+                Case.Unit = "Msamples/s";
+                Case.WorkPerCall = (float64)SampleCounts[CountIndex] / 1.0e6;
+                Case.SoundBuffer.SamplesPerSecond = BENCHMARK_SAMPLES_PER_SECOND;
+                Case.SoundBuffer.SampleCount = SampleCounts[CountIndex];
+                Case.SoundBuffer.Samples = Samples;
+                Case.GameState = GameState;
+                Case.ToneHz = Tones[ToneIndex];
+                if(BenchmarkMatchesFilter(Case.Name, Settings) && (CaseCount < MaxCaseCount))
+                {
+                    Cases[CaseCount++] = Case;
+                }
+            }
+        }
+    }
+
+    //A one second ring of stereo int16, like the secondary buffer, written at its start and across its end
+    uint32 RingSize = BENCHMARK_SAMPLES_PER_SECOND*2*sizeof(int16);
+    uint8 *Ring = (uint8 *)BenchmarkAllocate(RingSize);
+    if(!Ring)
+    {
+        return(-1);
+    }
+    for(int CountIndex = 0; CountIndex < ArrayCount(SampleCounts); ++CountIndex)
+    {
+        for(int Wraps = 0; Wraps <= 1; ++Wraps)
+        {
+            benchmark_case Case = {};
+            Case.Kind = Benchmark_SoundFill;
+            Case.Level = Supported;
+            snprintf(Case.Name, sizeof(Case.Name), "soundfill/%d samples/%s", SampleCounts[CountIndex], Wraps ? "wrapping" : "one piece");
+            Case.Unit = "Msamples/s";
+            Case.WorkPerCall = (float64)SampleCounts[CountIndex] / 1.0e6;
+            Case.SoundBuffer.SamplesPerSecond = BENCHMARK_SAMPLES_PER_SECOND;
+            Case.SoundBuffer.SampleCount = SampleCounts[CountIndex];
+            Case.SoundBuffer.Samples = Samples;
+            Case.Ring = Ring;
+            Case.RingSize = RingSize;
+            //Half the samples go before the end of the ring and half after
+            Case.ByteToLock = Wraps ? RingSize - (SampleCounts[CountIndex]/2)*2*sizeof(int16) : 0;
+            if(BenchmarkMatchesFilter(Case.Name, Settings) && (CaseCount < MaxCaseCount))
+            {
+                Cases[CaseCount++] = Case;
+            }
+        }
+    }
+
+    return(CaseCount);
+}
+
+internal bool32 WriteBenchmarkJSON(char *Path, char *CPUName, benchmark_settings *Settings, benchmark_result *Results, int ResultCount)
+{
+    FILE *File = fopen(Path, "w");
+    bool32 Result = (File != 0);
+    if(File)
+    {
+        fprintf(File, "{\n");
+        fprintf(File, "  \"cpu\": \"%s\",\n", CPUName);
+        fprintf(File, "  \"compiler\": \"%s\",\n", __VERSION__);
+        fprintf(File, "  \"repeats\": %d,\n", Settings->Repeats);
+        fprintf(File, "  \"runs\": %d,\n", Settings->Runs);
+        fprintf(File, "  \"benchmarks\": [\n");
+        for(int ResultIndex = 0; ResultIndex < ResultCount; ++ResultIndex)
+        {
+            benchmark_result *Bench = Results + ResultIndex;
+            fprintf(File, "    {\"name\": \"%s\", \"iterations\": %lld, \"median_ns\": %.1f, \"min_ns\": %.1f, \"mean_ns\": %.1f, "
+                    "\"stddev_ns\": %.1f, \"throughput\": %.3f, \"unit\": \"%s\"}%s\n",
+                    Bench->Name, (long long)Bench->Iterations, Bench->MedianNanoseconds, Bench->MinNanoseconds,
+                    Bench->MeanNanoseconds, Bench->StdDevNanoseconds, Bench->Throughput, Bench->Unit,
+                    (ResultIndex + 1 < ResultCount) ? "," : "");
+        }
+        fprintf(File, "  ]\n");
+        fprintf(File, "}\n");
+        Result = (fclose(File) == 0);
+    }
+    return(Result);
+}
+
+//The whole file, zero terminated, or 0
+internal char *ReadEntireFile(char *Path)
+{
+    char *Result = 0;
+    FILE *File = fopen(Path, "rb");
+    if(File)
+    {
+        fseek(File, 0, SEEK_END);
+        long Size = ftell(File);
+        fseek(File, 0, SEEK_SET);
+        Result = (Size >= 0) ? (char *)malloc(Size + 1) : 0;
+        if(Result)
+        {
+            if(fread(Result, 1, Size, File) == (size_t)Size)
+            {
+                Result[Size] = 0;
+            }
+            else
+            {
+                free(Result);
+                Result = 0;
+            }
+        }
+        fclose(File);
+    }
+    return(Result);
+}
+
+//Finds "Key": in the benchmark's own line of the JSON we write, false if it isn't there
+internal bool32 FindBaselineValue(char *Baseline, char *Name, const char *Key, float64 *Value)
+{
+    bool32 Result = false;
+
+    char NameField[96];
+    snprintf(NameField, sizeof(NameField), "\"name\": \"%s\"", Name);
+    char *Line = strstr(Baseline, NameField);
+    if(Line)
+    {
+        char *LineEnd = strchr(Line, '\n');
+        char KeyField[32];
+        snprintf(KeyField, sizeof(KeyField), "\"%s\": ", Key);
+        char *Field = strstr(Line, KeyField);
+        if(Field && (!LineEnd || (Field < LineEnd)))
+        {
+            *Value = strtod(Field + strlen(KeyField), 0);
+            Result = true;
+        }
+    }
+
+    return(Result);
+}
+
+//Returns how many benchmarks got slower than the threshold, and how many the baseline has no entry for in MissingCount
+internal int CompareWithBaseline(char *Baseline, char *CPUName, benchmark_settings *Settings, benchmark_case *Cases,
+                                 benchmark_result *Results, int ResultCount, int *MissingCount)
+{
+    char CPUField[96];
+    snprintf(CPUField, sizeof(CPUField), "\"cpu\": \"%s\"", CPUName);
+    if(!strstr(Baseline, CPUField))
+    {
+        printf("WARNING: the baseline was recorded on a different CPU, the comparison says more about the machines than the code\n");
+    }
+
+    printf("\nAgainst %s (fails past +%.1f%% in both the median and the fastest repeat):\n",
+           Settings->BaselinePath, Settings->ThresholdPercent);
+
+    float64 BaselineMedians[BENCHMARK_MAX_COUNT];
+    float64 BaselineMins[BENCHMARK_MAX_COUNT];
+    bool32 InBaseline[BENCHMARK_MAX_COUNT];
+    bool32 Regressed[BENCHMARK_MAX_COUNT];
+    int RetryCounts[BENCHMARK_MAX_COUNT];
+    float64 Limit = 1.0 + Settings->ThresholdPercent / 100.0;
+    for(int ResultIndex = 0; ResultIndex < ResultCount; ++ResultIndex)
+    {
+        benchmark_result *Bench = Results + ResultIndex;
+        float64 *BaselineMedian = BaselineMedians + ResultIndex;
+        float64 *BaselineMin = BaselineMins + ResultIndex;
+        InBaseline[ResultIndex] = (FindBaselineValue(Baseline, Bench->Name, "median_ns", BaselineMedian) &&
+                                   FindBaselineValue(Baseline, Bench->Name, "min_ns", BaselineMin) &&
+                                   (*BaselineMedian > 0.0) && (*BaselineMin > 0.0));
+        Regressed[ResultIndex] = (InBaseline[ResultIndex] && ((Bench->MedianNanoseconds / *BaselineMedian) > Limit) &&
+                                  ((Bench->MinNanoseconds / *BaselineMin) > Limit));
+        RetryCounts[ResultIndex] = 0;
+    }
+
+    //Timed again while it looks slower, and the fastest time is the one that counts (and goes in the JSON). A round
+    //goes over every benchmark still slower, and rounds start at least three seconds apart, so a slow few seconds of
+    //the machine's don't get all the retries of one.
+    int64 RoundStart = BenchmarkGetNanoseconds();
+    for(int Round = 0; Round < Settings->Retries; ++Round)
+    {
+        int64 Waited = BenchmarkGetNanoseconds() - RoundStart;
+        if(Round && (Waited < BENCHMARK_RETRY_ROUND_NANOSECONDS))
+        {
+            int64 Wait = BENCHMARK_RETRY_ROUND_NANOSECONDS - Waited;
+            timespec Duration = {(time_t)(Wait / 1000000000LL), (long)(Wait % 1000000000LL)};
+            nanosleep(&Duration, 0);
+        }
+        RoundStart = BenchmarkGetNanoseconds();
+
+        for(int ResultIndex = 0; ResultIndex < ResultCount; ++ResultIndex)
+        {
+            if(Regressed[ResultIndex])
+            {
+                benchmark_result *Bench = Results + ResultIndex;
+                ++RetryCounts[ResultIndex];
+                GameSelectSIMDLevel(Cases[ResultIndex].Level);
+                GameSelectBlendSpace(Cases[ResultIndex].BlendSpace);
+                //The best median and the best fastest repeat are kept apart, either can come from any timing
+                benchmark_result Retry = TimeBenchmarkCase(Cases + ResultIndex, Settings);
+                float64 BestMin = (Retry.MinNanoseconds < Bench->MinNanoseconds) ? Retry.MinNanoseconds : Bench->MinNanoseconds;
+                if(Retry.MedianNanoseconds < Bench->MedianNanoseconds)
+                {
+                    *Bench = Retry;
+                }
+                Bench->MinNanoseconds = BestMin;
+                Regressed[ResultIndex] = (((Bench->MedianNanoseconds / BaselineMedians[ResultIndex]) > Limit) &&
+                                          ((Bench->MinNanoseconds / BaselineMins[ResultIndex]) > Limit));
+            }
+        }
+    }
+
+    int RegressionCount = 0;
+    *MissingCount = 0;
+    for(int ResultIndex = 0; ResultIndex < ResultCount; ++ResultIndex)
+    {
+        benchmark_result *Bench = Results + ResultIndex;
+        if(InBaseline[ResultIndex])
+        {
+            if(Regressed[ResultIndex])
+            {
+                ++RegressionCount;
+            }
+            printf("  %-44s %12.1f -> %12.1f ns  %+7.1f%%%s", Bench->Name, BaselineMedians[ResultIndex], Bench->MedianNanoseconds,
+                   (Bench->MedianNanoseconds / BaselineMedians[ResultIndex] - 1.0)*100.0, Regressed[ResultIndex] ? "  SLOWER" : "");
+            if(RetryCounts[ResultIndex])
+            {
+                printf("  (timed %d more times)", RetryCounts[ResultIndex]);
+            }
+            printf("\n");
+        }
+        else
+        {
+            ++*MissingCount;
+            printf("  %-44s %12s    %12.1f ns  NOT IN THE BASELINE\n", Bench->Name, "", Bench->MedianNanoseconds);
+        }
+    }
+
+    printf("%d of %d benchmarks slower than the baseline allows, %d not in it\n", RegressionCount, ResultCount, *MissingCount);
+    return(RegressionCount);
+}
+
+internal bool32 ParseBenchmarkArguments(int ArgCount, char **Args, benchmark_settings *Settings)
+{
+    bool32 Result = true;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        char *Value = (ArgIndex + 1 < ArgCount) ? Args[ArgIndex + 1] : 0;
+        if(!Value)
+        {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", Arg);
+            Result = false;
+        }
+        else if(strcmp(Arg, "-repeats") == 0)
+        {
+            Settings->Repeats = atoi(Value);
+        }
+        else if(strcmp(Arg, "-warmup") == 0)
+        {
+            Settings->WarmupRepeats = atoi(Value);
+        }
+        else if(strcmp(Arg, "-reptime") == 0)
+        {
+            Settings->RepMilliseconds = atoi(Value);
+        }
+        else if(strcmp(Arg, "-runs") == 0)
+        {
+            Settings->Runs = atoi(Value);
+        }
+        else if(strcmp(Arg, "-filter") == 0)
+        {
+            Settings->Filter = Value;
+        }
+        else if(strcmp(Arg, "-out") == 0)
+        {
+            Settings->OutPath = Value;
+        }
+        else if(strcmp(Arg, "-baseline") == 0)
+        {
+            Settings->BaselinePath = Value;
+        }
+        else if(strcmp(Arg, "-threshold") == 0)
+        {
+            Settings->ThresholdPercent = atof(Value);
+        }
+        else if(strcmp(Arg, "-retries") == 0)
+        {
+            Settings->Retries = atoi(Value);
+        }
+        else
+        {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", Arg);
+            Result = false;
+        }
+        ++ArgIndex;
+    }
+
+    if((Settings->Repeats < 1) || (Settings->Repeats > BENCHMARK_MAX_REPEATS) || (Settings->WarmupRepeats < 0) ||
+       (Settings->RepMilliseconds < 1) || (Settings->Runs < 1) || (Settings->Runs > BENCHMARK_MAX_RUNS) ||
+       (Settings->ThresholdPercent < 0.0) || (Settings->Retries < 0))
+    {
+        fprintf(stderr, "Repeats must be between 1 and %d, runs between 1 and %d, the rep time positive, and warm-up, "
+                "threshold and retries not negative\n", BENCHMARK_MAX_REPEATS, BENCHMARK_MAX_RUNS);
+        Result = false;
+    }
+
+    return(Result);
+}
+
+int main(int ArgCount, char **Args)
+{
+    benchmark_settings Settings = {};
+    Settings.Repeats = 15;
+    Settings.WarmupRepeats = 3;
+    Settings.RepMilliseconds = 10;
+    Settings.Runs = 1;
+    Settings.OutPath = (char *)"midnight_madness_benchmark.json";
+    Settings.ThresholdPercent = 35.0;
+    Settings.Retries = 8;
+    if(!ParseBenchmarkArguments(ArgCount, Args, &Settings))
+    {
+        fprintf(stderr, "Usage: %s [-repeats N] [-warmup N] [-reptime MS] [-runs N] [-filter TEXT] [-out FILE] "
+                "[-baseline FILE [-threshold PERCENT] [-retries N]]\n", Args[0]);
+        return 1;
+    }
+
+    //Read first, so a missing baseline fails the run before it spends a minute benchmarking
+    char *Baseline = 0;
+    if(Settings.BaselinePath)
+    {
+        Baseline = ReadEntireFile(Settings.BaselinePath);
+        if(!Baseline)
+        {
+            fprintf(stderr, "Could not read the baseline %s\n", Settings.BaselinePath);
+            return 1;
+        }
+    }
+
+    char CPUName[64];
+    BenchmarkCPUName(CPUName, sizeof(CPUName));
+    simd_level Supported = GameSelectSIMDLevel(SIMDLevel_Auto);
+
+    benchmark_case *Cases = (benchmark_case *)BenchmarkAllocate(BENCHMARK_MAX_COUNT*sizeof(benchmark_case));
+    benchmark_result *Results = (benchmark_result *)BenchmarkAllocate(BENCHMARK_MAX_COUNT*sizeof(benchmark_result));
+    benchmark_result *RunResults = (benchmark_result *)BenchmarkAllocate(BENCHMARK_MAX_RUNS*BENCHMARK_MAX_COUNT*sizeof(benchmark_result));
+    int CaseCount = (Cases && Results && RunResults) ? MakeBenchmarkCases(Cases, BENCHMARK_MAX_COUNT, &Settings, Supported) : -1;
+    if(CaseCount < 0)
+    {
+        fprintf(stderr, "Could not allocate benchmark memory\n");
+        return 1;
+    }
+
+    printf("%s  |  %s  |  %d benchmarks, %d repeats of ~%d ms after %d warm-up, %d run%s\n", CPUName, __VERSION__,
+           CaseCount, Settings.Repeats, Settings.RepMilliseconds, Settings.WarmupRepeats, Settings.Runs,
+           (Settings.Runs == 1) ? "" : "s");
+    for(int Run = 0; Run < Settings.Runs; ++Run)
+    {
+        if(Settings.Runs > 1)
+        {
+            printf("Run %d of %d\n", Run + 1, Settings.Runs);
+        }
+        for(int CaseIndex = 0; CaseIndex < CaseCount; ++CaseIndex)
+        {
+            benchmark_case *Case = Cases + CaseIndex;
+            GameSelectSIMDLevel(Case->Level);
+            GameSelectBlendSpace(Case->BlendSpace);
+            RunResults[CaseIndex*Settings.Runs + Run] = TimeBenchmarkCase(Case, &Settings);
+        }
+    }
+
+    for(int CaseIndex = 0; CaseIndex < CaseCount; ++CaseIndex)
+    {
+        benchmark_result *CaseRuns = RunResults + CaseIndex*Settings.Runs;
+        qsort(CaseRuns, Settings.Runs, sizeof(benchmark_result), CompareResultMedians);
+
+        benchmark_result *Result = Results + CaseIndex;
+        *Result = CaseRuns[Settings.Runs/2];
+        printf("  %-44s %12.1f ns  (min %.1f, +-%.1f%%)  %10.1f %s\n", Result->Name, Result->MedianNanoseconds,
+               Result->MinNanoseconds, 100.0*Result->StdDevNanoseconds / Result->MeanNanoseconds, Result->Throughput, Result->Unit);
+    }
+
+    int Result = 0;
+    if(Baseline)
+    {
+        int MissingCount = 0;
+        int RegressionCount = CompareWithBaseline(Baseline, CPUName, &Settings, Cases, Results, CaseCount, &MissingCount);
+        Result = (RegressionCount > 0) ? 1 : ((MissingCount > 0) ? 2 : 0);
+    }
+
+    if(!WriteBenchmarkJSON(Settings.OutPath, CPUName, &Settings, Results, CaseCount))
+    {
+        fprintf(stderr, "Could not write %s\n", Settings.OutPath);
+        return 1;
+    }
+    printf("Wrote %s\n", Settings.OutPath);
+
+    return(Result);
+}
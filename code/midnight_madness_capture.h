@@ -0,0 +1,227 @@
+#if !defined(MIDNIGHT_MADNESS_CAPTURE_H)
+
+/*
+    Frame and sound capture, shared by the platform layers.
+
+    A small pool of capture frames, each one a whole backbuffer plus room for a frame's worth of sound, passed from the
+    game thread to a writer thread the same lock-free way as the audio ring:
+    - The game thread takes the next free frame and makes its pixels this frame's backbuffer, so the game renders
+      straight into it, and the frame's sound goes into it too. Once the frame has been shown, handing it over is one
+      store. Nothing is copied and nothing is allocated, the pool is carved out of the platform's one allocation.
+    - The writer thread takes the published frames in order, writes them out (a PPM stream or raw BGRX pixels, and the
+      sound as a WAV) and gives them back to the pool. It sleeps on a semaphore the game thread signals once a frame.
+    - With a render thread (see midnight_madness_frame_pipeline.h) a frame is taken when it is rendered and handed
+      over when it is presented, frames later and on another thread. Taking only moves ReserveIndex, so the frames in
+      between stay the game's, and they are handed over in the order they were taken.
+    - When the writer is behind and there is no free frame, the game renders into the platform's own backbuffer as if
+      capture was off, and that frame (and its sound) is counted as dropped. The game never waits for the disk.
+
+    A PPM stream is just the frames one after another, each with its own header (ffmpeg -f image2pipe -c:v ppm reads
+    it). The raw stream is the pixels only: ffmpeg -f rawvideo -pixel_format bgra -video_size WxH.
+*/
+
+#define CAPTURE_CACHE_LINE 64
+
+enum capture_format
+{
+    CaptureFormat_PPM,
+    CaptureFormat_Raw,
+};
+
+struct capture_frame
+{
+    void *Pixels;
+    int16 *Samples;
+    int SampleCount;
+    uint32 FrameIndex;
+};
+
+struct capture_queue
+{
+    uint32 FrameCount; //NOTE(Robin) Must be a power of two
+    int Width;
+    int Height;
+    int Pitch;
+    int MaxSampleCount;
+    capture_format Format;
+    capture_frame *Frames;
+    uint8 *ConvertedPixels; //NOTE(Robin) Only the writer thread touches this, one frame as packed RGB for PPM
+
+    //The two indices are on their own cache lines, so the two threads don't keep stealing the line from each other
+    uint8 Pad0[CAPTURE_CACHE_LINE];
+    uint32 volatile WriteIndex;
+    uint32 volatile DroppedFrameCount;
+    uint32 ReserveIndex; //NOTE(Robin) Frames taken by the game, at or ahead of WriteIndex
+    uint8 Pad1[CAPTURE_CACHE_LINE - 3*sizeof(uint32)];
+    uint32 volatile ReadIndex;
+    uint8 Pad2[CAPTURE_CACHE_LINE - sizeof(uint32)];
+};
+
+internal memory_index CaptureAlign(memory_index Size)
+{
+    memory_index Result = (Size + CAPTURE_CACHE_LINE - 1) & ~(memory_index)(CAPTURE_CACHE_LINE - 1);
+    return(Result);
+}
+
+internal memory_index CaptureMemorySize(uint32 FrameCount, int Width, int Height, int MaxSampleCount)
+{
+    memory_index PixelSize = CaptureAlign((memory_index)Width*Height*4);
+    memory_index SampleSize = CaptureAlign((memory_index)MaxSampleCount*2*sizeof(int16));
+    memory_index Result = CaptureAlign(FrameCount*sizeof(capture_frame)) + FrameCount*(PixelSize + SampleSize) +
+                          CaptureAlign((memory_index)Width*Height*3);
+    return(Result);
+}
+
+//Memory has to be CaptureMemorySize bytes, aligned to a cache line
+internal void InitializeCaptureQueue(capture_queue *Queue, uint32 FrameCount, int Width, int Height, int MaxSampleCount,
+                                     capture_format Format, void *Memory)
+{
+    Assert((FrameCount & (FrameCount - 1)) == 0);
+
+    Queue->FrameCount = FrameCount;
+    Queue->Width = Width;
+    Queue->Height = Height;
+    Queue->Pitch = Width*4;
+    Queue->MaxSampleCount = MaxSampleCount;
+    Queue->Format = Format;
+
+    memory_index PixelSize = CaptureAlign((memory_index)Width*Height*4);
+    memory_index SampleSize = CaptureAlign((memory_index)MaxSampleCount*2*sizeof(int16));
+    uint8 *At = (uint8 *)Memory;
+    Queue->Frames = (capture_frame *)At;
+    At += CaptureAlign(FrameCount*sizeof(capture_frame));
+    for(uint32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        capture_frame *Frame = Queue->Frames + FrameIndex;
+        Frame->Pixels = At;
+        At += PixelSize;
+        Frame->Samples = (int16 *)At;
+        At += SampleSize;
+        Frame->SampleCount = 0;
+        Frame->FrameIndex = 0;
+    }
+    Queue->ConvertedPixels = At;
+
+    Queue->WriteIndex = 0;
+    Queue->ReserveIndex = 0;
+    Queue->ReadIndex = 0;
+    Queue->DroppedFrameCount = 0;
+}
+
+//Game thread. Returns 0 (and counts a dropped frame) when the writer still has every frame in the pool.
+internal capture_frame *BeginCaptureFrame(capture_queue *Queue, uint32 FrameIndex)
+{
+    capture_frame *Result = 0;
+
+    uint32 ReserveIndex = Queue->ReserveIndex;
+    uint32 ReadIndex = AtomicLoadAcquire(&Queue->ReadIndex);
+    if((ReserveIndex - ReadIndex) < Queue->FrameCount)
+    {
+        Queue->ReserveIndex = ReserveIndex + 1;
+        Result = Queue->Frames + (ReserveIndex & (Queue->FrameCount - 1));
+        Result->SampleCount = 0;
+        Result->FrameIndex = FrameIndex;
+    }
+    else
+    {
+        Queue->DroppedFrameCount = Queue->DroppedFrameCount + 1;
+    }
+
+    return(Result);
+}
+
+//Game thread (or the platform thread presenting it), once the frame is rendered, its sound is in and it has been shown.
+//Frames have to be ended in the order they were begun.
+internal void EndCaptureFrame(capture_queue *Queue)
+{
+    //Release: the pixels and samples have to be visible before the writer can see the new index
+    AtomicStoreRelease(&Queue->WriteIndex, Queue->WriteIndex + 1);
+}
+
+//Writer thread. Returns 0 when there is nothing to write.
+internal capture_frame *BeginCaptureRead(capture_queue *Queue)
+{
+    capture_frame *Result = 0;
+
+    uint32 ReadIndex = Queue->ReadIndex;
+    if(ReadIndex != AtomicLoadAcquire(&Queue->WriteIndex))
+    {
+        Result = Queue->Frames + (ReadIndex & (Queue->FrameCount - 1));
+    }
+
+    return(Result);
+}
+
+internal void EndCaptureRead(capture_queue *Queue)
+{
+    //Release: we are done reading the frame before the game thread may render into it again
+    AtomicStoreRelease(&Queue->ReadIndex, Queue->ReadIndex + 1);
+}
+
+//Writer thread. The PPM header goes in Dest, and the pixels to write after it (converted to RGB for PPM) are returned.
+internal uint8 *PrepareCaptureFrame(capture_queue *Queue, capture_frame *Frame, char *Dest, int DestSize,
+                                    int *HeaderSize, memory_index *PixelSize)
+{
+    uint8 *Result = (uint8 *)Frame->Pixels;
+    *HeaderSize = 0;
+    *PixelSize = (memory_index)Queue->Pitch*Queue->Height;
+
+    if(Queue->Format == CaptureFormat_PPM)
+    {
+        //The frame index goes in a comment, so a gap in the stream shows which frames were dropped
+        *HeaderSize = snprintf(Dest, DestSize, "P6\n# frame %u\n%d %d\n255\n", Frame->FrameIndex, Queue->Width, Queue->Height);
+
+        uint8 *Out = Queue->ConvertedPixels;
+        uint8 *Row = (uint8 *)Frame->Pixels;
+        for(int Y = 0; Y < Queue->Height; ++Y)
+        {
+            uint32 *Pixel = (uint32 *)Row;
+            for(int X = 0; X < Queue->Width; ++X)
+            {
+                //Pixels are 0xXXRRGGBB
+                uint32 Color = *Pixel++;
+                *Out++ = (uint8)(Color >> 16);
+                *Out++ = (uint8)(Color >> 8);
+                *Out++ = (uint8)(Color >> 0);
+            }
+            Row += Queue->Pitch;
+        }
+
+        Result = Queue->ConvertedPixels;
+        *PixelSize = (memory_index)Queue->Width*Queue->Height*3;
+    }
+
+    return(Result);
+}
+
+//The canonical 44 byte RIFF header for 16 bit stereo PCM
+#pragma pack(push, 1)
+struct wav_header
+{
+    char RIFF[4];
+    uint32 RIFFSize;
+    char WAVE[4];
+    char fmt[4];
+    uint32 fmtSize;
+    uint16 FormatTag;
+    uint16 Channels;
+    uint32 SamplesPerSec;
+    uint32 AvgBytesPerSec;
+    uint16 BlockAlign;
+    uint16 BitsPerSample;
+    char data[4];
+    uint32 DataSize;
+};
+#pragma pack(pop)
+
+internal wav_header MakeWavHeader(int SamplesPerSecond, uint32 DataBytes)
+{
+    wav_header Result = {{'R', 'I', 'F', 'F'}, 36 + DataBytes, {'W', 'A', 'V', 'E'},
+                         {'f', 'm', 't', ' '}, 16, 1, 2, (uint32)SamplesPerSecond,
+                         (uint32)SamplesPerSecond*4, 4, 16,
+                         {'d', 'a', 't', 'a'}, DataBytes};
+    return(Result);
+}
+
+#define MIDNIGHT_MADNESS_CAPTURE_H
+#endif
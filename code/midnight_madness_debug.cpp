@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+#if MIDNIGHT_MADNESS_PROFILE
+
+internal memory_index DebugStorageSize(void)
+{
+    return(sizeof(debug_table));
+}
+
+//Storage must be DebugStorageSize bytes of zeros. The first frame starts here, so whatever the platform does before
+//its first DebugEndFrame (loading, the first frame's setup) is counted in that frame's length along with its blocks.
+internal void DebugInitialize(void *Storage)
+{
+    GlobalDebugTable = (debug_table *)Storage;
+    GlobalDebugTable->LastFrameClock = __rdtsc();
+}
+
+//Optional, shows up as the thread's name in the trace
+internal void DebugNameThread(const char *Name)
+{
+    debug_thread_log *Log = DebugThreadLog ? DebugThreadLog : RegisterDebugThread();
+    if(Log)
+    {
+        Log->Name = Name;
+    }
+}
+
+internal void DebugCloseBlock(debug_table *Table, debug_frame *Frame, uint16 ThreadIndex, debug_open_block *Open, debug_event *Event)
+{
+    debug_record_stats *Stats = Frame->Stats + Open->RecordIndex;
+    ++Stats->CallCount;
+    Stats->HitCount += Event->HitCount;
+    Stats->Cycles += Event->Clock - Open->BeginClock;
+
+    debug_span *Span = Table->Spans + (Table->SpanCount++ & (DEBUG_SPAN_COUNT - 1));
+    Span->BeginClock = Open->BeginClock;
+    Span->EndClock = Event->Clock;
+    Span->HitCount = Event->HitCount;
+    Span->RecordIndex = Open->RecordIndex;
+    Span->ThreadIndex = ThreadIndex;
+}
+
+//Call once per frame, from one thread, with the wall clock time since the last call. Every block that ended since
+//the last call is counted in this frame.
+internal void DebugEndFrame(float32 SecondsElapsed)
+{
+    debug_table *Table = GlobalDebugTable;
+    if(!Table)
+    {
+        return;
+    }
+
+    uint64 FrameClock = __rdtsc();
+    debug_frame *Frame = Table->Frames + (Table->FrameCount % DEBUG_FRAME_COUNT);
+    Frame->BeginClock = Table->LastFrameClock;
+    Frame->EndClock = FrameClock;
+    Frame->Seconds = SecondsElapsed;
+    Frame->DroppedEventCount = 0;
+    for(int RecordIndex = 0; RecordIndex < MAX_DEBUG_RECORDS; ++RecordIndex)
+    {
+        Frame->Stats[RecordIndex] = {};
+    }
+
+    //The first frame started at DebugInitialize, not at the last call, so SecondsElapsed doesn't cover the same time
+    //and it doesn't count towards the cycles per second
+    if(Table->FrameCount)
+    {
+        Table->TotalCycles += Frame->EndClock - Frame->BeginClock;
+        Table->TotalSeconds += SecondsElapsed;
+    }
+
+    uint32 ThreadCount = AtomicLoadAcquire(&Table->ThreadCount);
+    ThreadCount = (ThreadCount < MAX_DEBUG_THREADS) ? ThreadCount : MAX_DEBUG_THREADS;
+    for(uint32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        debug_thread_log *Log = Table->Threads + ThreadIndex;
+
+        //Acquire: every event before WriteIndex is fully written
+        uint32 WriteIndex = AtomicLoadAcquire(&Log->WriteIndex);
+        for(uint32 ReadIndex = Log->ReadIndex; ReadIndex != WriteIndex; ++ReadIndex)
+        {
+            debug_event *Event = Log->Events + (ReadIndex & (DEBUG_EVENTS_PER_THREAD - 1));
+            if(Event->Type == DebugEvent_BeginBlock)
+            {
+                if(Log->OpenBlockCount < MAX_DEBUG_BLOCK_DEPTH)
+                {
+                    debug_open_block *Open = Log->OpenBlocks + Log->OpenBlockCount++;
+                    Open->BeginClock = Event->Clock;
+                    Open->RecordIndex = Event->RecordIndex;
+                }
+            }
+            else
+            {
+                //Normally this is the innermost open block. If events were dropped it might not be, so blocks whose
+                //end went missing are thrown away until we find the one this event ends.
+                while(Log->OpenBlockCount > 0)
+                {
+                    debug_open_block *Open = Log->OpenBlocks + --Log->OpenBlockCount;
+                    if(Open->RecordIndex == Event->RecordIndex)
+                    {
+                        DebugCloseBlock(Table, Frame, (uint16)ThreadIndex, Open, Event);
+                        break;
+                    }
+                }
+            }
+        }
+
+        //Release: we are done reading the events before the thread may overwrite them
+        AtomicStoreRelease(&Log->ReadIndex, WriteIndex);
+
+        uint32 DroppedEventCount = Log->DroppedEventCount;
+        Frame->DroppedEventCount += DroppedEventCount - Log->LastDroppedEventCount;
+        Log->LastDroppedEventCount = DroppedEventCount;
+    }
+
+    Table->LastFrameClock = FrameClock;
+    ++Table->FrameCount;
+}
+
+struct debug_text
+{
+    char *At;
+    char *End;
+};
+
+internal void DebugPrint(debug_text *Text, const char *Format, ...)
+{
+    memory_index Remaining = Text->End - Text->At;
+    va_list Args;
+    va_start(Args, Format);
+    int Count = vsnprintf(Text->At, Remaining, Format, Args);
+    va_end(Args);
+
+    //Whatever didn't fit is left out completely, and so is everything after it
+    if((Count >= 0) && ((memory_index)Count < Remaining))
+    {
+        Text->At += Count;
+    }
+    else
+    {
+        *Text->At = 0;
+        Text->End = Text->At;
+    }
+}
+
+internal float64 DebugCyclesPerSecond(debug_table *Table)
+{
+    float64 Result = (Table->TotalSeconds > 0.0) ? ((float64)Table->TotalCycles / Table->TotalSeconds) : 1.0e9;
+    return(Result);
+}
+
+//Per block averages over the frames still in the window
+internal memory_index DebugWriteSummary(char *Dest, memory_index DestSize)
+{
+    debug_text Text = {Dest, Dest + DestSize};
+    debug_table *Table = GlobalDebugTable;
+    if(!Table || !Table->FrameCount || !DestSize)
+    {
+        return(0);
+    }
+
+    uint32 FrameCount = (Table->FrameCount < DEBUG_FRAME_COUNT) ? Table->FrameCount : DEBUG_FRAME_COUNT;
+    debug_record_stats Totals[MAX_DEBUG_RECORDS] = {};
+    uint64 FrameCycles = 0;
+    uint32 DroppedEventCount = 0;
+    for(uint32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        debug_frame *Frame = Table->Frames + FrameIndex;
+        FrameCycles += Frame->EndClock - Frame->BeginClock;
+        DroppedEventCount += Frame->DroppedEventCount;
+        for(int RecordIndex = 0; RecordIndex < MAX_DEBUG_RECORDS; ++RecordIndex)
+        {
+            Totals[RecordIndex].CallCount += Frame->Stats[RecordIndex].CallCount;
+            Totals[RecordIndex].HitCount += Frame->Stats[RecordIndex].HitCount;
+            Totals[RecordIndex].Cycles += Frame->Stats[RecordIndex].Cycles;
+        }
+    }
+
+    float64 CyclesPerSecond = DebugCyclesPerSecond(Table);
+    DebugPrint(&Text, "Profile, last %u frames (%.3f ms, %.0f Mcycles per frame, dropped events %u):\n",
+               FrameCount, 1000.0*FrameCycles / FrameCount / CyclesPerSecond, FrameCycles / FrameCount / 1.0e6, DroppedEventCount);
+    DebugPrint(&Text, "  %-32s %10s %14s %8s %12s\n", "block", "calls", "cycles", "frame", "cycles/hit");
+    for(int RecordIndex = 0; RecordIndex < MAX_DEBUG_RECORDS; ++RecordIndex)
+    {
+        debug_record_stats *Total = Totals + RecordIndex;
+        if(Total->CallCount)
+        {
+            debug_record *Record = Table->Records + RecordIndex;
+            DebugPrint(&Text, "  %-32s %10.1f %14.0f %7.1f%% %12.1f\n", Record->BlockName,
+                       (float64)Total->CallCount / FrameCount, (float64)Total->Cycles / FrameCount,
+                       FrameCycles ? 100.0*Total->Cycles / FrameCycles : 0.0,
+                       Total->HitCount ? (float64)Total->Cycles / Total->HitCount : 0.0);
+        }
+    }
+
+    return(Text.At - Dest);
+}
+
+//Chrome trace-event JSON with every span still in the window as a complete ("X") event, frame ends as instant events
+internal memory_index DebugWriteChromeTrace(char *Dest, memory_index DestSize)
+{
+    debug_table *Table = GlobalDebugTable;
+    char Closing[] = "\n]}\n";
+    if(!Table || (DestSize < sizeof(Closing)))
+    {
+        return(0);
+    }
+
+    //Leave room to close the JSON however much of the rest fits
+    debug_text Text = {Dest, Dest + DestSize - sizeof(Closing)};
+
+    uint32 SpanCount = (Table->SpanCount < DEBUG_SPAN_COUNT) ? Table->SpanCount : DEBUG_SPAN_COUNT;
+    uint32 FirstSpan = Table->SpanCount - SpanCount;
+    uint32 FrameCount = (Table->FrameCount < DEBUG_FRAME_COUNT) ? Table->FrameCount : DEBUG_FRAME_COUNT;
+    uint32 FirstFrame = Table->FrameCount - FrameCount;
+
+    uint64 BaseClock = SpanCount ? Table->Spans[FirstSpan & (DEBUG_SPAN_COUNT - 1)].BeginClock : 0;
+    if(FrameCount && (!SpanCount || (Table->Frames[FirstFrame % DEBUG_FRAME_COUNT].BeginClock < BaseClock)))
+    {
+        BaseClock = Table->Frames[FirstFrame % DEBUG_FRAME_COUNT].BeginClock;
+    }
+    float64 MicrosecondsPerCycle = 1.0e6 / DebugCyclesPerSecond(Table);
+
+    DebugPrint(&Text, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    DebugPrint(&Text, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Midnight Madness\"}}");
+
+    uint32 ThreadCount = (Table->ThreadCount < MAX_DEBUG_THREADS) ? Table->ThreadCount : MAX_DEBUG_THREADS;
+    for(uint32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        const char *Name = Table->Threads[ThreadIndex].Name;
+        if(Name)
+        {
+            DebugPrint(&Text, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", ThreadIndex, Name);
+        }
+    }
+
+    for(uint32 FrameIndex = FirstFrame; FrameIndex != Table->FrameCount; ++FrameIndex)
+    {
+        debug_frame *Frame = Table->Frames + (FrameIndex % DEBUG_FRAME_COUNT);
+        DebugPrint(&Text, ",\n{\"name\":\"Frame %u\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":0,\"tid\":0}",
+                   FrameIndex, (Frame->EndClock - BaseClock)*MicrosecondsPerCycle);
+    }
+
+    for(uint32 SpanIndex = FirstSpan; SpanIndex != Table->SpanCount; ++SpanIndex)
+    {
+        debug_span *Span = Table->Spans + (SpanIndex & (DEBUG_SPAN_COUNT - 1));
+        debug_record *Record = Table->Records + Span->RecordIndex;
+
+        //Only the file's name, Windows paths are full of backslashes that would have to be escaped
+        const char *FileName = Record->FileName;
+        for(const char *At = Record->FileName; *At; ++At)
+        {
+            if((*At == '/') || (*At == '\\'))
+            {
+                FileName = At + 1;
+            }
+        }
+
+        DebugPrint(&Text, ",\n{\"name\":\"%s\",\"cat\":\"%s:%u\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"hits\":%u}}",
+                   Record->BlockName, FileName, Record->LineNumber, (Span->BeginClock - BaseClock)*MicrosecondsPerCycle,
+                   (Span->EndClock - Span->BeginClock)*MicrosecondsPerCycle, Span->ThreadIndex, Span->HitCount);
+    }
+
+    //The room for this was kept aside above
+    Text.End += sizeof(Closing);
+    DebugPrint(&Text, "%s", Closing);
+
+    return(Text.At - Dest);
+}
+
+//Only a few frames back, it is called every frame and the whole window takes a while to add up
+internal uint32 DebugGetTopBlocks(debug_block_summary *Blocks, uint32 MaxBlockCount, uint32 FrameCount)
+{
+    debug_table *Table = GlobalDebugTable;
+    if(!Table || !Table->FrameCount || !FrameCount)
+    {
+        return(0);
+    }
+
+    FrameCount = (FrameCount < Table->FrameCount) ? FrameCount : Table->FrameCount;
+    FrameCount = (FrameCount < DEBUG_FRAME_COUNT) ? FrameCount : DEBUG_FRAME_COUNT;
+    debug_record_stats Totals[MAX_DEBUG_RECORDS] = {};
+    uint64 FrameCycles = 0;
+    for(uint32 FrameOffset = 1; FrameOffset <= FrameCount; ++FrameOffset)
+    {
+        debug_frame *Frame = Table->Frames + ((Table->FrameCount - FrameOffset) % DEBUG_FRAME_COUNT);
+        FrameCycles += Frame->EndClock - Frame->BeginClock;
+        for(int RecordIndex = 0; RecordIndex < MAX_DEBUG_RECORDS; ++RecordIndex)
+        {
+            Totals[RecordIndex].CallCount += Frame->Stats[RecordIndex].CallCount;
+            Totals[RecordIndex].Cycles += Frame->Stats[RecordIndex].Cycles;
+        }
+    }
+
+    //Insertion into the few kept so far, most cycles first
+    uint32 Result = 0;
+    for(int RecordIndex = 0; RecordIndex < MAX_DEBUG_RECORDS; ++RecordIndex)
+    {
+        debug_record_stats *Total = Totals + RecordIndex;
+        if(!Total->CallCount)
+        {
+            continue;
+        }
+
+        float32 CyclesPerFrame = (float32)Total->Cycles / FrameCount;
+        uint32 Index = (Result < MaxBlockCount) ? Result++ : MaxBlockCount;
+        for(; (Index > 0) && (Blocks[Index - 1].CyclesPerFrame < CyclesPerFrame); --Index)
+        {
+            if(Index < MaxBlockCount)
+            {
+                Blocks[Index] = Blocks[Index - 1];
+            }
+        }
+        if(Index < MaxBlockCount)
+        {
+            debug_block_summary *Block = Blocks + Index;
+            Block->Name = Table->Records[RecordIndex].BlockName;
+            Block->CallsPerFrame = (float32)Total->CallCount / FrameCount;
+            Block->CyclesPerFrame = CyclesPerFrame;
+            Block->FrameFraction = FrameCycles ? (float32)Total->Cycles / FrameCycles : 0.0f;
+        }
+    }
+
+    return(Result);
+}
+
+#else
+
+internal memory_index DebugStorageSize(void) {return(0);}
+internal void DebugInitialize(void *Storage) {}
+internal void DebugNameThread(const char *Name) {}
+internal void DebugEndFrame(float32 SecondsElapsed) {}
+internal memory_index DebugWriteSummary(char *Dest, memory_index DestSize) {return(0);}
+internal memory_index DebugWriteChromeTrace(char *Dest, memory_index DestSize) {return(0);}
+internal uint32 DebugGetTopBlocks(debug_block_summary *Blocks, uint32 MaxBlockCount, uint32 FrameCount) {return(0);}
+
+#endif
@@ -0,0 +1,245 @@
+#if !defined(MIDNIGHT_MADNESS_DEBUG_H)
+
+/*
+    TIMED_BLOCK profiler, for the game and the platform layers alike.
+
+    TIMED_BLOCK("Name") (or TIMED_FUNCTION()) at the top of a scope records a begin event with __rdtsc when the scope
+    is entered, and an end event when it is left. The optional last argument is a hit count, e.g. how many pixels or
+    samples the block worked on, so the summary can show cycles per hit.
+
+    Every thread writes its events only into its own log, a single producer / single consumer ring like the audio
+    ring, so recording one is a handful of plain stores: no locks, and nothing that bounces between cores. Once per
+    frame the platform calls DebugEndFrame, which reads every thread's new events, pairs begins with ends, and adds them
+    up per block for that frame. The last DEBUG_FRAME_COUNT frames of totals and the last DEBUG_SPAN_COUNT blocks are
+    kept, for DebugWriteSummary and DebugWriteChromeTrace (load the JSON in chrome://tracing or ui.perfetto.dev).
+    A thread whose log fills up before the frame ends drops events and counts them, it never waits.
+
+    The debug_table lives in memory the platform hands to DebugInitialize, so like game memory it is allocated once
+    and already faulted in. Until then TIMED_BLOCK records nothing.
+
+    MIDNIGHT_MADNESS_PROFILE:
+        0 - TIMED_BLOCK compiles to nothing and the Debug functions are empty
+        1 - Profiler on (default, it is cheap enough to ship with)
+*/
+
+#if !defined(MIDNIGHT_MADNESS_PROFILE)
+#define MIDNIGHT_MADNESS_PROFILE 1
+#endif
+
+#if MIDNIGHT_MADNESS_PROFILE
+
+#define MAX_DEBUG_THREADS 32
+#define MAX_DEBUG_RECORDS 256
+#define MAX_DEBUG_BLOCK_DEPTH 64
+#define DEBUG_EVENTS_PER_THREAD 16384 //NOTE(Robin) Must be a power of two
+#define DEBUG_FRAME_COUNT 128
+#define DEBUG_SPAN_COUNT 65536 //NOTE(Robin) Must be a power of two
+#define DEBUG_CACHE_LINE 64
+
+enum debug_event_type
+{
+    DebugEvent_BeginBlock,
+    DebugEvent_EndBlock,
+};
+
+//Where a TIMED_BLOCK is, indexed by the __COUNTER__ it was given
+struct debug_record
+{
+    const char *FileName;
+    const char *BlockName;
+    uint32 LineNumber;
+};
+
+struct debug_event
+{
+    uint64 Clock;
+    uint32 HitCount;
+    uint16 RecordIndex;
+    uint8 Type;
+};
+
+struct debug_open_block
+{
+    uint64 BeginClock;
+    uint16 RecordIndex;
+};
+
+struct debug_thread_log
+{
+    //Written by the thread the log belongs to
+    uint32 volatile WriteIndex;
+    uint32 volatile DroppedEventCount;
+    const char *Name;
+    uint8 Pad0[DEBUG_CACHE_LINE - 2*sizeof(uint32) - sizeof(char *)];
+
+    //Written by DebugEndFrame. A block can begin in one frame and end in the next, so what is still open stays here.
+    uint32 volatile ReadIndex;
+    uint32 LastDroppedEventCount;
+    int OpenBlockCount;
+    debug_open_block OpenBlocks[MAX_DEBUG_BLOCK_DEPTH];
+
+    debug_event Events[DEBUG_EVENTS_PER_THREAD];
+};
+
+struct debug_record_stats
+{
+    uint32 CallCount;
+    uint32 HitCount;
+    uint64 Cycles;
+};
+
+struct debug_frame
+{
+    uint64 BeginClock;
+    uint64 EndClock;
+    float32 Seconds;
+    uint32 DroppedEventCount;
+    debug_record_stats Stats[MAX_DEBUG_RECORDS];
+};
+
+//One finished block, for the trace
+struct debug_span
+{
+    uint64 BeginClock;
+    uint64 EndClock;
+    uint32 HitCount;
+    uint16 RecordIndex;
+    uint16 ThreadIndex;
+};
+
+struct debug_table
+{
+    debug_record Records[MAX_DEBUG_RECORDS];
+    uint32 volatile ThreadCount;
+    debug_thread_log Threads[MAX_DEBUG_THREADS];
+
+    //Only touched by DebugEndFrame and the functions that read its results
+    uint32 FrameCount;
+    uint64 LastFrameClock;
+    uint64 TotalCycles;
+    float64 TotalSeconds;
+    debug_frame Frames[DEBUG_FRAME_COUNT];
+
+    uint32 SpanCount;
+    debug_span Spans[DEBUG_SPAN_COUNT];
+};
+
+global_variable debug_table *GlobalDebugTable;
+global_variable THREAD_LOCAL debug_thread_log *DebugThreadLog;
+
+//Gives the calling thread its log the first time it records anything
+internal debug_thread_log *RegisterDebugThread(void)
+{
+    debug_thread_log *Result = 0;
+
+    debug_table *Table = GlobalDebugTable;
+    if(Table && (Table->ThreadCount < MAX_DEBUG_THREADS))
+    {
+        uint32 ThreadIndex = AtomicAddU32(&Table->ThreadCount, 1);
+        if(ThreadIndex < MAX_DEBUG_THREADS)
+        {
+            Result = Table->Threads + ThreadIndex;
+            DebugThreadLog = Result;
+        }
+    }
+
+    return(Result);
+}
+
+inline void RecordDebugEvent(uint16 RecordIndex, debug_event_type Type, uint32 HitCount)
+{
+    debug_thread_log *Log = DebugThreadLog;
+    if(!Log)
+    {
+        Log = RegisterDebugThread();
+    }
+
+    if(Log)
+    {
+        uint32 WriteIndex = Log->WriteIndex;
+        if(WriteIndex - AtomicLoadAcquire(&Log->ReadIndex) < DEBUG_EVENTS_PER_THREAD)
+        {
+            debug_event *Event = Log->Events + (WriteIndex & (DEBUG_EVENTS_PER_THREAD - 1));
+            Event->Clock = __rdtsc();
+            Event->HitCount = HitCount;
+            Event->RecordIndex = RecordIndex;
+            Event->Type = (uint8)Type;
+
+            //Release: the event is written before DebugEndFrame can see it
+            AtomicStoreRelease(&Log->WriteIndex, WriteIndex + 1);
+        }
+        else
+        {
+            ++Log->DroppedEventCount;
+        }
+    }
+}
+
+struct timed_block
+{
+    uint16 RecordIndex;
+    uint32 HitCount;
+
+    timed_block(int Counter, const char *FileName, int LineNumber, const char *BlockName, uint32 HitCountInit)
+    {
+        Assert(Counter < MAX_DEBUG_RECORDS);
+        RecordIndex = (uint16)Counter;
+        HitCount = HitCountInit;
+
+        if(GlobalDebugTable)
+        {
+            debug_record *Record = GlobalDebugTable->Records + RecordIndex;
+            Record->FileName = FileName;
+            Record->BlockName = BlockName;
+            Record->LineNumber = LineNumber;
+        }
+
+        RecordDebugEvent(RecordIndex, DebugEvent_BeginBlock, 0);
+    }
+
+    ~timed_block()
+    {
+        RecordDebugEvent(RecordIndex, DebugEvent_EndBlock, HitCount);
+    }
+};
+
+//The hit count is optional, and gcc only drops the comma before an empty __VA_ARGS__ in its GNU modes, so the
+//macros pass it through an overload instead
+inline uint32 DebugHitCount(void) {return(1);}
+inline uint32 DebugHitCount(uint32 HitCount) {return(HitCount);}
+
+//__COUNTER__ gives every TIMED_BLOCK in the build its own record, __LINE__ gives the variable a unique name
+#define TIMED_BLOCK__(BlockName, Number, ...) timed_block TimedBlock_##Number(__COUNTER__, __FILE__, __LINE__, BlockName, DebugHitCount(__VA_ARGS__))
+#define TIMED_BLOCK_(BlockName, Number, ...) TIMED_BLOCK__(BlockName, Number, __VA_ARGS__)
+#define TIMED_BLOCK(BlockName, ...) TIMED_BLOCK_(BlockName, __LINE__, __VA_ARGS__)
+#define TIMED_FUNCTION(...) TIMED_BLOCK_(__FUNCTION__, __LINE__, __VA_ARGS__)
+
+#else
+
+#define TIMED_BLOCK(...)
+#define TIMED_FUNCTION(...)
+
+#endif
+
+//A block's share of the last few frames, for showing while the game runs
+struct debug_block_summary
+{
+    const char *Name;
+    float32 CallsPerFrame;
+    float32 CyclesPerFrame;
+    float32 FrameFraction; //NOTE(Robin) Of the frame's cycles, summed over every thread so it can go past 1
+};
+
+//Services the profiler provides to the platform, they exist (and do nothing) even when it is compiled out
+internal memory_index DebugStorageSize(void);
+internal void DebugInitialize(void *Storage);
+internal void DebugNameThread(const char *Name);
+internal void DebugEndFrame(float32 SecondsElapsed);
+//Both write text into Dest and return how many bytes they wrote, cutting the output short (but keeping the JSON valid) if it doesn't fit
+internal memory_index DebugWriteSummary(char *Dest, memory_index DestSize);
+internal memory_index DebugWriteChromeTrace(char *Dest, memory_index DestSize);
+//The MaxBlockCount blocks that took the most cycles over the last FrameCount frames, most first. Returns how many.
+internal uint32 DebugGetTopBlocks(debug_block_summary *Blocks, uint32 MaxBlockCount, uint32 FrameCount);
+
+#define MIDNIGHT_MADNESS_DEBUG_H
+#endif
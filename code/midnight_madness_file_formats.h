@@ -0,0 +1,88 @@
+#if !defined(MIDNIGHT_MADNESS_FILE_FORMATS_H)
+
+/*
+    The packed asset file (.mma), written by test_asset_builder and memory mapped by the platform.
+
+    header | asset type table | asset index | payloads
+
+    - The header says where the two tables are. The type table gives, for every asset_type_id, the range of the
+      index its assets take up, and the index has one mma_asset per asset: where its payload is and what it is.
+      Asset 0 is always the null asset, so an ID of 0 means "none".
+    - Every payload starts on a MMA_PAYLOAD_ALIGNMENT boundary, so no two assets share a page: paging one in never
+      pulls in part of another, and every payload is aligned for SIMD loads.
+    - Payloads are already in the layout the game uses, so the game points straight into the mapping and never copies
+      or converts anything:
+        bitmaps are 0xAARRGGBB with premultiplied alpha, top row first, Pitch = Width*4 (loaded_bitmap)
+        sounds are int16 with the channels interleaved, followed by one frame of zeros (loaded_sound)
+    - Everything is little endian and fixed size, and every offset is from the start of the file.
+*/
+
+#define MMA_CODE(a, b, c, d) (((uint32)(a) << 0) | ((uint32)(b) << 8) | ((uint32)(c) << 16) | ((uint32)(d) << 24))
+#define MMA_MAGIC_VALUE MMA_CODE('m', 'm', 'a', 'f')
+#define MMA_VERSION 1
+#define MMA_PAYLOAD_ALIGNMENT 4096
+
+enum asset_type_id
+{
+    Asset_None,
+
+    Asset_Sprite,
+    Asset_Bell,
+    Asset_Filler, //NOTE(Robin) Tiny bitmaps for testing how we do with lots of assets, none unless asked for
+
+    Asset_Count,
+};
+
+enum mma_asset_kind
+{
+    MMA_Bitmap,
+    MMA_Sound,
+};
+
+#pragma pack(push, 1)
+struct mma_header
+{
+    uint32 MagicValue;
+    uint32 Version;
+
+    uint32 AssetTypeCount;
+    uint32 AssetCount;
+
+    uint64 AssetTypes; //NOTE(Robin) mma_asset_type[AssetTypeCount]
+    uint64 Assets; //NOTE(Robin) mma_asset[AssetCount]
+};
+
+struct mma_asset_type
+{
+    uint32 TypeID;
+    uint32 FirstAssetIndex;
+    uint32 OnePastLastAssetIndex;
+};
+
+struct mma_bitmap
+{
+    uint32 Width;
+    uint32 Height;
+};
+
+struct mma_sound
+{
+    uint32 SampleCount; //NOTE(Robin) In frames, not counting the frame of zeros at the end
+    uint32 ChannelCount;
+};
+
+struct mma_asset
+{
+    uint64 DataOffset;
+    uint64 DataSize;
+    uint32 Kind;
+    union
+    {
+        mma_bitmap Bitmap;
+        mma_sound Sound;
+    };
+};
+#pragma pack(pop)
+
+#define MIDNIGHT_MADNESS_FILE_FORMATS_H
+#endif
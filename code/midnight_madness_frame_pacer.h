@@ -0,0 +1,200 @@
+#if !defined(MIDNIGHT_MADNESS_FRAME_PACER_H)
+
+/*
+    Frame pacing, shared by the platform layers. Times are in the platform's own clock ticks (QueryPerformanceCounter
+    counts on Windows, nanoseconds on Linux).
+
+    Every frame has a deadline, TicksPerFrame after the last one. When the frame's work is done the platform sleeps
+    until SleepMargin before the deadline, then spins the rest, because the OS wakes us up late by some amount that
+    depends on the timer resolution. The margin is learned: it follows the worst oversleep we have seen (fading out
+    slowly), so with a 1ms timer the spin is well under a millisecond. It is capped at MaxSleepMargin (2ms unless the
+    platform knows its sleep is coarser), because an oversleep can also be another thread of ours running, and
+    spinning longer would only take more of its time.
+
+    A frame that finishes after its deadline is missed. We don't try to catch up by running the next frames back to
+    back (that is just more jitter), the next deadline is one frame from now, and how many deadlines went by is counted.
+
+    The time between frames goes into a rolling histogram of the last FRAME_TIME_HISTORY frames, which is what the
+    frame time variance is read from.
+*/
+
+#define FRAME_TIME_HISTORY 512
+#define FRAME_HISTOGRAM_BUCKET_COUNT 160
+#define FRAME_HISTOGRAM_BUCKET_SECONDS 0.00025f //NOTE(Robin) So 40ms in all, the last bucket is everything longer
+
+struct frame_time_histogram
+{
+    uint32 FrameCount;
+    float32 History[FRAME_TIME_HISTORY];
+    uint32 Buckets[FRAME_HISTOGRAM_BUCKET_COUNT];
+    float64 Sum;
+    float64 SumOfSquares;
+};
+
+struct frame_pacer
+{
+    int64 TicksPerSecond;
+    int64 TicksPerFrame;
+    int64 NextDeadline;
+    int64 LastFrameStart;
+    int64 SleepMargin;
+    int64 MaxSleepMargin;
+
+    uint32 FrameCount;
+    uint32 MissedFrameCount;
+    int64 SpinTicks;
+
+    frame_time_histogram FrameTimes;
+};
+
+internal int FrameHistogramBucket(float32 Seconds)
+{
+    int Result = (int)(Seconds / FRAME_HISTOGRAM_BUCKET_SECONDS);
+    Result = (Result < 0) ? 0 : Result;
+    Result = (Result < FRAME_HISTOGRAM_BUCKET_COUNT) ? Result : FRAME_HISTOGRAM_BUCKET_COUNT - 1;
+    return(Result);
+}
+
+internal void RecordFrameTime(frame_time_histogram *Histogram, float32 Seconds)
+{
+    float32 *Slot = Histogram->History + (Histogram->FrameCount % FRAME_TIME_HISTORY);
+    if(Histogram->FrameCount >= FRAME_TIME_HISTORY)
+    {
+        //The oldest frame drops out of the window
+        --Histogram->Buckets[FrameHistogramBucket(*Slot)];
+        Histogram->Sum -= *Slot;
+        Histogram->SumOfSquares -= (float64)*Slot * *Slot;
+    }
+
+    *Slot = Seconds;
+    ++Histogram->Buckets[FrameHistogramBucket(Seconds)];
+    Histogram->Sum += Seconds;
+    Histogram->SumOfSquares += (float64)Seconds*Seconds;
+    ++Histogram->FrameCount;
+}
+
+internal uint32 FrameHistogramCount(frame_time_histogram *Histogram)
+{
+    uint32 Result = (Histogram->FrameCount < FRAME_TIME_HISTORY) ? Histogram->FrameCount : FRAME_TIME_HISTORY;
+    return(Result);
+}
+
+internal float32 FrameTimeMean(frame_time_histogram *Histogram)
+{
+    uint32 Count = FrameHistogramCount(Histogram);
+    float32 Result = Count ? (float32)(Histogram->Sum / Count) : 0.0f;
+    return(Result);
+}
+
+internal float32 FrameTimeStandardDeviation(frame_time_histogram *Histogram)
+{
+    uint32 Count = FrameHistogramCount(Histogram);
+    float64 Variance = 0.0;
+    if(Count)
+    {
+        float64 Mean = Histogram->Sum / Count;
+        Variance = Histogram->SumOfSquares / Count - Mean*Mean;
+    }
+    float32 Result = (Variance > 0.0) ? (float32)sqrt(Variance) : 0.0f;
+    return(Result);
+}
+
+//The upper edge of the bucket the percentile falls in, so it is never off by more than one bucket
+internal float32 FrameTimePercentile(frame_time_histogram *Histogram, float32 Percentile)
+{
+    uint32 Count = FrameHistogramCount(Histogram);
+    uint32 Wanted = (uint32)(Percentile*0.01f*Count);
+    uint32 Seen = 0;
+    int BucketIndex = 0;
+    for(; BucketIndex < FRAME_HISTOGRAM_BUCKET_COUNT - 1; ++BucketIndex)
+    {
+        Seen += Histogram->Buckets[BucketIndex];
+        if(Seen > Wanted)
+        {
+            break;
+        }
+    }
+    float32 Result = (BucketIndex + 1)*FRAME_HISTOGRAM_BUCKET_SECONDS;
+    return(Result);
+}
+
+internal void InitializeFramePacer(frame_pacer *Pacer, int64 TicksPerSecond, int RefreshHz, int64 Now)
+{
+    *Pacer = {};
+    Pacer->TicksPerSecond = TicksPerSecond;
+    Pacer->TicksPerFrame = TicksPerSecond / RefreshHz;
+    Pacer->NextDeadline = Now + Pacer->TicksPerFrame;
+    Pacer->LastFrameStart = Now;
+
+    //Start out assuming the OS wakes us up within a millisecond, the first few sleeps will tell
+    Pacer->SleepMargin = TicksPerSecond / 1000;
+    Pacer->MaxSleepMargin = TicksPerSecond / 500;
+}
+
+//Keeps the deadlines, forgets the counts and the histogram, e.g. after warming up
+internal void ResetFramePacerStats(frame_pacer *Pacer)
+{
+    Pacer->FrameCount = 0;
+    Pacer->MissedFrameCount = 0;
+    Pacer->SpinTicks = 0;
+    Pacer->FrameTimes = {};
+}
+
+internal float32 FramePacerTargetSeconds(frame_pacer *Pacer)
+{
+    float32 Result = (float32)Pacer->TicksPerFrame / (float32)Pacer->TicksPerSecond;
+    return(Result);
+}
+
+//When the coarse sleep should end, which is in the past if there is no time to sleep
+internal int64 FramePacerWakeTime(frame_pacer *Pacer)
+{
+    int64 Result = Pacer->NextDeadline - Pacer->SleepMargin;
+    return(Result);
+}
+
+//The platform asked to sleep until Target and woke up at Woke
+internal void FramePacerSlept(frame_pacer *Pacer, int64 Target, int64 Woke)
+{
+    //Keep a tenth of a millisecond on top of the worst oversleep
+    int64 Oversleep = Woke - Target;
+    int64 Wanted = Oversleep + Pacer->TicksPerSecond/10000;
+    if(Wanted > Pacer->SleepMargin)
+    {
+        Pacer->SleepMargin = Wanted;
+    }
+    else
+    {
+        Pacer->SleepMargin -= (Pacer->SleepMargin - Wanted) / 32;
+    }
+
+    int64 MaxSleepMargin = (Pacer->MaxSleepMargin < Pacer->TicksPerFrame) ? Pacer->MaxSleepMargin : Pacer->TicksPerFrame;
+    if(Pacer->SleepMargin > MaxSleepMargin)
+    {
+        Pacer->SleepMargin = MaxSleepMargin;
+    }
+}
+
+//Call right as the new frame starts, Now being at or after the deadline
+internal void AdvanceFramePacer(frame_pacer *Pacer, int64 Now)
+{
+    int64 Late = Now - Pacer->NextDeadline;
+
+    //A tenth of a frame late is still the right frame, more than that is a missed one
+    if(Late > Pacer->TicksPerFrame/10)
+    {
+        Pacer->MissedFrameCount += (uint32)(1 + Late / Pacer->TicksPerFrame);
+        Pacer->NextDeadline = Now + Pacer->TicksPerFrame;
+    }
+    else
+    {
+        Pacer->NextDeadline += Pacer->TicksPerFrame;
+    }
+
+    RecordFrameTime(&Pacer->FrameTimes, (float32)(Now - Pacer->LastFrameStart) / (float32)Pacer->TicksPerSecond);
+    Pacer->LastFrameStart = Now;
+    ++Pacer->FrameCount;
+}
+
+#define MIDNIGHT_MADNESS_FRAME_PACER_H
+#endif
@@ -0,0 +1,172 @@
+#if !defined(MIDNIGHT_MADNESS_FRAME_PIPELINE_H)
+
+/*
+    The frame pipeline, shared by the platform layers: a render thread builds frame N+1 while the platform's own
+    thread presents frame N and pumps messages, so presenting and waiting for the deadline no longer add to the time
+    the game has to build a frame.
+
+    A small ring of slots, one per frame in flight, going through three hands in order:
+    - The platform thread samples the input, stamps when it did, and submits the frame.
+    - The render thread runs GameUpdateAndRender and GameGetSoundSamples for it, into the swap chain's next buffer,
+      and marks it rendered.
+    - The platform thread presents it and retires it, and how long it took from the input being sampled to the frame
+      going out is the frame's latency.
+    The three counts only ever go up and each one is written by one thread, like the audio ring. The platform signals
+    the render thread when a frame is submitted and is signalled back when one is rendered, with its own semaphores.
+
+    Depth is how many frames the render thread may get ahead of the one being presented, the trade between the two:
+    - 0: no render thread, the platform thread renders each frame itself right after submitting it and presents it
+      right away. The lowest latency, and presenting takes its time out of the frame.
+    - 1: the render thread builds the next frame while this one is presented, one frame more latency.
+    - 2: it may get two frames ahead, which soaks up a slow frame without missing a deadline, two frames more.
+    Every frame in flight has its own backbuffer, plus the one on screen, so the swap chain needs Depth + 2 buffers.
+
+    Only one thread at a time runs the game: the render thread from its first frame until it is stopped. Whatever
+    the platform does to game memory (snapshots, restoring one) waits until the render thread has caught up with every
+    frame submitted (FramePipelineIsRendered), and whatever it does to the backbuffers (resizing) until every one of
+    them has been presented too (FramePipelineIsEmpty).
+*/
+
+#define FRAME_PIPELINE_MAX_DEPTH 2
+#define FRAME_PIPELINE_SLOT_COUNT 4 //NOTE(Robin) A power of two, more than FRAME_PIPELINE_MAX_DEPTH + 1
+#define FRAME_PIPELINE_CACHE_LINE 64
+
+struct frame_pipeline_slot
+{
+    //Filled in by the platform thread when it submits the frame
+    game_input Input;
+    uint32 FrameIndex;
+    uint32 PlatformFlags; //NOTE(Robin) The platform's own, e.g. Linux playback going back to its snapshot
+    int64 InputTicks;
+    float32 ExpectedFrameSeconds; //NOTE(Robin) How long the platform expects the frame to last, for how much sound to write
+    input_event_batch InputEvents; //NOTE(Robin) The events folded into Input, see midnight_madness_input_latency.h
+
+    //Filled in by whoever renders it
+    game_offscreen_buffer Buffer;
+    capture_frame *CaptureFrame;
+    int64 RenderStartTicks;
+    int64 RenderEndTicks;
+    uint64 RenderCycles;
+    uint64 PageFaults;
+};
+
+struct frame_pipeline
+{
+    uint32 Depth;
+    frame_pipeline_slot Slots[FRAME_PIPELINE_SLOT_COUNT];
+
+    //Each count on its own cache line, so the two threads don't keep stealing the line from each other
+    uint8 Pad0[FRAME_PIPELINE_CACHE_LINE];
+    uint32 volatile SubmittedCount;
+    uint32 PresentedCount; //NOTE(Robin) Only the platform thread reads or writes this one
+    uint8 Pad1[FRAME_PIPELINE_CACHE_LINE - 2*sizeof(uint32)];
+    uint32 volatile RenderedCount;
+    uint8 Pad2[FRAME_PIPELINE_CACHE_LINE - sizeof(uint32)];
+
+    //Input to present, in the platform's clock ticks, over every frame retired since the last reset
+    uint32 LatencyCount;
+    int64 LatencyTicksSum;
+    int64 MaxLatencyTicks;
+};
+
+internal void InitializeFramePipeline(frame_pipeline *Pipeline, uint32 Depth)
+{
+    Assert(Depth <= FRAME_PIPELINE_MAX_DEPTH);
+
+    *Pipeline = {};
+    Pipeline->Depth = Depth;
+}
+
+//Platform thread. The slot to fill in, the pipeline always has room for one more frame than Depth.
+internal frame_pipeline_slot *BeginFrameSubmit(frame_pipeline *Pipeline)
+{
+    uint32 SubmittedCount = Pipeline->SubmittedCount;
+    Assert((SubmittedCount - Pipeline->PresentedCount) <= Pipeline->Depth);
+
+    frame_pipeline_slot *Result = Pipeline->Slots + (SubmittedCount & (FRAME_PIPELINE_SLOT_COUNT - 1));
+    return(Result);
+}
+
+internal void EndFrameSubmit(frame_pipeline *Pipeline)
+{
+    //Release: the input has to be visible before the render thread can see the frame
+    AtomicStoreRelease(&Pipeline->SubmittedCount, Pipeline->SubmittedCount + 1);
+}
+
+//Render thread (or the platform thread at depth 0). Returns 0 when there is nothing submitted to render.
+internal frame_pipeline_slot *BeginFrameRender(frame_pipeline *Pipeline)
+{
+    frame_pipeline_slot *Result = 0;
+
+    uint32 RenderedCount = Pipeline->RenderedCount;
+    if(RenderedCount != AtomicLoadAcquire(&Pipeline->SubmittedCount))
+    {
+        Result = Pipeline->Slots + (RenderedCount & (FRAME_PIPELINE_SLOT_COUNT - 1));
+    }
+
+    return(Result);
+}
+
+internal void EndFrameRender(frame_pipeline *Pipeline)
+{
+    //Release: the pixels, the sound and the timings have to be visible before the frame can be presented
+    AtomicStoreRelease(&Pipeline->RenderedCount, Pipeline->RenderedCount + 1);
+}
+
+//Platform thread. More frames in flight than Depth, the oldest one has to go out before the next is submitted.
+internal bool32 FramePipelineMustPresent(frame_pipeline *Pipeline)
+{
+    bool32 Result = ((Pipeline->SubmittedCount - Pipeline->PresentedCount) > Pipeline->Depth);
+    return(Result);
+}
+
+//Platform thread. Everything submitted has been rendered, so the render thread is waiting and not touching the game.
+internal bool32 FramePipelineIsRendered(frame_pipeline *Pipeline)
+{
+    bool32 Result = (Pipeline->SubmittedCount == AtomicLoadAcquire(&Pipeline->RenderedCount));
+    return(Result);
+}
+
+//Platform thread. Everything submitted has been presented too, so no backbuffer is in use but the one on screen.
+internal bool32 FramePipelineIsEmpty(frame_pipeline *Pipeline)
+{
+    bool32 Result = (Pipeline->SubmittedCount == Pipeline->PresentedCount);
+    return(Result);
+}
+
+//Platform thread. The oldest frame not yet presented, or 0 if it hasn't been rendered yet.
+internal frame_pipeline_slot *BeginFramePresent(frame_pipeline *Pipeline)
+{
+    frame_pipeline_slot *Result = 0;
+
+    uint32 PresentedCount = Pipeline->PresentedCount;
+    if(PresentedCount != AtomicLoadAcquire(&Pipeline->RenderedCount))
+    {
+        Result = Pipeline->Slots + (PresentedCount & (FRAME_PIPELINE_SLOT_COUNT - 1));
+    }
+
+    return(Result);
+}
+
+//Platform thread, once the frame is out at PresentTicks. The slot can be submitted again after this. Returns the
+//frame's latency.
+internal int64 EndFramePresent(frame_pipeline *Pipeline, frame_pipeline_slot *Slot, int64 PresentTicks)
+{
+    int64 Result = PresentTicks - Slot->InputTicks;
+    ++Pipeline->LatencyCount;
+    Pipeline->LatencyTicksSum += Result;
+    Pipeline->MaxLatencyTicks = (Result > Pipeline->MaxLatencyTicks) ? Result : Pipeline->MaxLatencyTicks;
+
+    ++Pipeline->PresentedCount;
+    return(Result);
+}
+
+internal void ResetFramePipelineStats(frame_pipeline *Pipeline)
+{
+    Pipeline->LatencyCount = 0;
+    Pipeline->LatencyTicksSum = 0;
+    Pipeline->MaxLatencyTicks = 0;
+}
+
+#define MIDNIGHT_MADNESS_FRAME_PIPELINE_H
+#endif
@@ -0,0 +1,137 @@
+#if !defined(MIDNIGHT_MADNESS_INPUT_LATENCY_H)
+
+/*
+    Input to present latency for every input event, shared by the platform layers. The frame pipeline times a frame
+    from when its input was sampled, this times each key press and release from when it arrived:
+    - The platform stamps an event with when it arrived (for Windows, when the message was posted, not when it came
+      out of the queue) as it folds it into the frame's input, and adds it to the frame's batch.
+    - The batch goes along with the input through the frame pipeline to the GameUpdateAndRender that consumes it.
+    - When that frame is presented, every event in it is retired into the histogram, split into the time it waited
+      for the frame to sample it, the time the frame took to be rendered, and the time it then waited to go out.
+
+    Presenting is as close to the photons as we get: the scan out after it (up to a refresh, more with the compositor)
+    is not counted.
+*/
+
+#define INPUT_LATENCY_MAX_EVENTS_PER_FRAME 16
+#define INPUT_LATENCY_BUCKET_COUNT 400
+#define INPUT_LATENCY_BUCKET_SECONDS 0.00025f //NOTE(Robin) So 100ms in all, the last bucket is everything longer
+
+struct input_event_stamp
+{
+    int64 ArrivalTicks;
+    uint32 ButtonIndex; //NOTE(Robin) Into game_controller_input::Buttons
+    bool32 IsDown;
+};
+
+//The events folded into one frame's input
+struct input_event_batch
+{
+    uint32 EventCount;
+    uint32 DroppedCount; //NOTE(Robin) Past INPUT_LATENCY_MAX_EVENTS_PER_FRAME, they still reach the game but aren't timed
+    input_event_stamp Events[INPUT_LATENCY_MAX_EVENTS_PER_FRAME];
+};
+
+struct input_latency_stats
+{
+    int64 TicksPerSecond;
+
+    uint32 EventCount;
+    uint32 DroppedCount;
+    uint32 Buckets[INPUT_LATENCY_BUCKET_COUNT];
+    float64 Sum;
+    float32 MaxSeconds;
+
+    //Where the time went, summed over every event
+    float64 QueuedSum; //NOTE(Robin) Arrival to the frame sampling it
+    float64 RenderingSum; //NOTE(Robin) Sampled to rendered
+    float64 PresentingSum; //NOTE(Robin) Rendered to presented
+};
+
+internal void AddInputEvent(input_event_batch *Batch, int64 ArrivalTicks, uint32 ButtonIndex, bool32 IsDown)
+{
+    if(Batch->EventCount < INPUT_LATENCY_MAX_EVENTS_PER_FRAME)
+    {
+        input_event_stamp *Event = Batch->Events + Batch->EventCount++;
+        Event->ArrivalTicks = ArrivalTicks;
+        Event->ButtonIndex = ButtonIndex;
+        Event->IsDown = IsDown;
+    }
+    else
+    {
+        ++Batch->DroppedCount;
+    }
+}
+
+internal void InitializeInputLatencyStats(input_latency_stats *Stats, int64 TicksPerSecond)
+{
+    *Stats = {};
+    Stats->TicksPerSecond = TicksPerSecond;
+}
+
+internal void ResetInputLatencyStats(input_latency_stats *Stats)
+{
+    InitializeInputLatencyStats(Stats, Stats->TicksPerSecond);
+}
+
+//Once the frame the batch went into is out. An event can't have arrived after its frame sampled the input, so the
+//queued time never goes negative unless the clocks disagree, and then it counts as none.
+internal void RecordInputLatencies(input_latency_stats *Stats, input_event_batch *Batch,
+                                   int64 InputTicks, int64 RenderEndTicks, int64 PresentTicks)
+{
+    float32 SecondsPerTick = 1.0f / (float32)Stats->TicksPerSecond;
+    float32 RenderingSeconds = (float32)(RenderEndTicks - InputTicks)*SecondsPerTick;
+    float32 PresentingSeconds = (float32)(PresentTicks - RenderEndTicks)*SecondsPerTick;
+
+    for(uint32 EventIndex = 0; EventIndex < Batch->EventCount; ++EventIndex)
+    {
+        int64 ArrivalTicks = Batch->Events[EventIndex].ArrivalTicks;
+        ArrivalTicks = (ArrivalTicks < InputTicks) ? ArrivalTicks : InputTicks;
+        float32 QueuedSeconds = (float32)(InputTicks - ArrivalTicks)*SecondsPerTick;
+        float32 Seconds = QueuedSeconds + RenderingSeconds + PresentingSeconds;
+
+        int BucketIndex = (int)(Seconds / INPUT_LATENCY_BUCKET_SECONDS);
+        BucketIndex = (BucketIndex < 0) ? 0 : BucketIndex;
+        BucketIndex = (BucketIndex < INPUT_LATENCY_BUCKET_COUNT) ? BucketIndex : INPUT_LATENCY_BUCKET_COUNT - 1;
+        ++Stats->Buckets[BucketIndex];
+
+        ++Stats->EventCount;
+        Stats->Sum += Seconds;
+        Stats->MaxSeconds = (Seconds > Stats->MaxSeconds) ? Seconds : Stats->MaxSeconds;
+        Stats->QueuedSum += QueuedSeconds;
+        Stats->RenderingSum += RenderingSeconds;
+        Stats->PresentingSum += PresentingSeconds;
+    }
+    Stats->DroppedCount += Batch->DroppedCount;
+}
+
+internal float32 InputLatencyMean(input_latency_stats *Stats, float64 Sum)
+{
+    float32 Result = Stats->EventCount ? (float32)(Sum / Stats->EventCount) : 0.0f;
+    return(Result);
+}
+
+//The upper edge of the bucket the percentile falls in, like FrameTimePercentile
+internal float32 InputLatencyPercentile(input_latency_stats *Stats, float32 Percentile)
+{
+    float32 Result = 0.0f;
+    if(Stats->EventCount)
+    {
+        uint32 Wanted = (uint32)(Percentile*0.01f*Stats->EventCount);
+        uint32 Seen = 0;
+        int BucketIndex = 0;
+        for(; BucketIndex < INPUT_LATENCY_BUCKET_COUNT - 1; ++BucketIndex)
+        {
+            Seen += Stats->Buckets[BucketIndex];
+            if(Seen > Wanted)
+            {
+                break;
+            }
+        }
+        Result = (BucketIndex + 1)*INPUT_LATENCY_BUCKET_SECONDS;
+    }
+    return(Result);
+}
+
+#define MIDNIGHT_MADNESS_INPUT_LATENCY_H
+#endif
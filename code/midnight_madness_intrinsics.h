@@ -0,0 +1,127 @@
+#if !defined(MIDNIGHT_MADNESS_INTRINSICS_H)
+
+//Compiler specific stuff lives here, so the game code never has to care whether it is built with cl or gcc/clang
+
+//SSE2 is part of x64 itself, so every x64 CPU has it and we can always compile it in.
+//AVX2 is not, so those functions have to be compiled for AVX2 on their own and only called when CPUID says the CPU can run them.
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+//cl lets you use any intrinsic in any function, it is up to us to not call it on the wrong CPU
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+//gcc/clang only generate AVX2 instructions in functions that are marked for it
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+struct cpuid_result
+{
+    uint32 EAX;
+    uint32 EBX;
+    uint32 ECX;
+    uint32 EDX;
+};
+
+internal cpuid_result CPUID(uint32 Leaf, uint32 Subleaf)
+{
+    cpuid_result Result = {};
+#if defined(_MSC_VER)
+    int Registers[4];
+    __cpuidex(Registers, Leaf, Subleaf);
+    Result.EAX = Registers[0];
+    Result.EBX = Registers[1];
+    Result.ECX = Registers[2];
+    Result.EDX = Registers[3];
+#else
+    __cpuid_count(Leaf, Subleaf, Result.EAX, Result.EBX, Result.ECX, Result.EDX);
+#endif
+    return(Result);
+}
+
+//XCR0 tells us which register files the OS actually saves on a context switch
+internal uint64 ReadXCR0(void)
+{
+#if defined(_MSC_VER)
+    return(_xgetbv(0));
+#else
+    uint32 Low;
+    uint32 High;
+    __asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+    return(((uint64)High << 32) | Low);
+#endif
+}
+
+//Lock-free code between threads needs loads that are not moved before, and stores that are not moved after, the memory
+//accesses around them. x64 already orders plain loads and stores that way, so all we have to stop is the compiler.
+#if defined(_MSC_VER)
+internal uint32 AtomicLoadAcquire(uint32 volatile *Value)
+{
+    uint32 Result = *Value;
+    _ReadWriteBarrier();
+    return(Result);
+}
+
+internal void AtomicStoreRelease(uint32 volatile *Dest, uint32 Value)
+{
+    _ReadWriteBarrier();
+    *Dest = Value;
+}
+
+//Returns the value from before the add
+internal uint32 AtomicAddU32(uint32 volatile *Value, uint32 Addend)
+{
+    return((uint32)_InterlockedExchangeAdd((long volatile *)Value, (long)Addend));
+}
+
+//Returns the value from before, the exchange happened if that is Expected
+internal uint32 AtomicCompareExchangeU32(uint32 volatile *Value, uint32 Expected, uint32 New)
+{
+    return((uint32)_InterlockedCompareExchange((long volatile *)Value, (long)New, (long)Expected));
+}
+
+//The one reordering x64 does: a store followed by a load from somewhere else. This stops that too.
+internal void FullMemoryBarrier(void)
+{
+    _mm_mfence();
+}
+
+#define THREAD_LOCAL __declspec(thread)
+#else
+internal uint32 AtomicLoadAcquire(uint32 volatile *Value)
+{
+    return(__atomic_load_n(Value, __ATOMIC_ACQUIRE));
+}
+
+internal void AtomicStoreRelease(uint32 volatile *Dest, uint32 Value)
+{
+    __atomic_store_n(Dest, Value, __ATOMIC_RELEASE);
+}
+
+//Returns the value from before the add
+internal uint32 AtomicAddU32(uint32 volatile *Value, uint32 Addend)
+{
+    return(__atomic_fetch_add(Value, Addend, __ATOMIC_SEQ_CST));
+}
+
+//Returns the value from before, the exchange happened if that is Expected
+internal uint32 AtomicCompareExchangeU32(uint32 volatile *Value, uint32 Expected, uint32 New)
+{
+    __atomic_compare_exchange_n(Value, &Expected, New, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return(Expected);
+}
+
+//The one reordering x64 does: a store followed by a load from somewhere else. This stops that too.
+internal void FullMemoryBarrier(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#define THREAD_LOCAL __thread
+#endif
+
+#define MIDNIGHT_MADNESS_INTRINSICS_H
+#endif
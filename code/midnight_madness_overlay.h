@@ -0,0 +1,274 @@
+#if !defined(MIDNIGHT_MADNESS_OVERLAY_H)
+
+/*
+    The performance overlay, shared by the platform layers: a few lines of text (frame times, cycles, latencies, the
+    profiler's busiest blocks) drawn over the frame the platform is about to present, so the numbers are there in any
+    build without a debugger attached.
+
+    - The font is a 5x7 bitmap font embedded below, printable ASCII only. InitializeOverlay rasterises it once into
+      a glyph atlas, a strip of 0xAARRGGBB premultiplied cells, each glyph doubled in size with a drop shadow so it
+      reads over anything.
+    - Each line of text is put together from the atlas a cell row at a time with memcpy, into one line bitmap, which is
+      then blended over the frame with the renderer's DrawBitmap, a call per run of characters between spaces: the
+      SIMD paths get spans as long as a word instead of one glyph's width, and the gaps cost nothing.
+    - The platform prints the lines after BeginOverlayText, and DrawOverlay draws them. Everything from the one to the
+      other, formatting included, is timed (LastCycles) so the overlay can show what it costs itself.
+
+    It is drawn by the platform's thread into the frame being presented, after the game is done with it, so the game
+    never knows it is there. A capture taken with it on has it in the frames.
+*/
+
+#define OVERLAY_GLYPH_FIRST 32
+#define OVERLAY_GLYPH_COUNT 95
+#define OVERLAY_FONT_WIDTH 5
+#define OVERLAY_FONT_HEIGHT 7
+#define OVERLAY_SCALE 2
+#define OVERLAY_CELL_WIDTH ((OVERLAY_FONT_WIDTH + 1)*OVERLAY_SCALE) //NOTE(Robin) One font pixel for the shadow and the gap
+#define OVERLAY_CELL_HEIGHT ((OVERLAY_FONT_HEIGHT + 1)*OVERLAY_SCALE)
+#define OVERLAY_LINE_HEIGHT (OVERLAY_CELL_HEIGHT + OVERLAY_SCALE)
+#define OVERLAY_MAX_LINES 24
+#define OVERLAY_MAX_LINE_LENGTH 128
+#define OVERLAY_MARGIN 8
+
+//One byte per row, top row first, the leftmost pixel in bit 4
+global_variable uint8 OverlayFont[OVERLAY_GLYPH_COUNT][OVERLAY_FONT_HEIGHT] =
+{
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, //space
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, //!
+    {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00}, //"
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, //#
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, //$
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, //%
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, //&
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, //quote
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, //(
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, //)
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, //*
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, //+
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, //,
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, //-
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, //.
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, ///
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, //0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, //1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, //2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, //3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, //4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, //5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, //6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, //7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, //8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, //9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, //:
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, //;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, //<
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, //=
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, //>
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, //?
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E}, //@
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, //A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, //B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, //C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, //D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, //E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, //F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, //G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, //H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, //I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, //J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, //K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, //L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, //M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, //N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, //O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, //P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, //Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, //R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, //S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, //T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, //U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, //V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, //W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, //X
+    {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, //Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, //Z
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, //[
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, //backslash
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, //]
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00}, //^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}, //_
+    {0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00}, //`
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}, //a
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E}, //b
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E}, //c
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F}, //d
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}, //e
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08}, //f
+    {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E}, //g
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11}, //h
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E}, //i
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C}, //j
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12}, //k
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, //l
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11}, //m
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11}, //n
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E}, //o
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10}, //p
+    {0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01}, //q
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10}, //r
+    {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E}, //s
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06}, //t
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D}, //u
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04}, //v
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A}, //w
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11}, //x
+    {0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E}, //y
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F}, //z
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02}, //{
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, //|
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08}, //}
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00}, //~
+};
+
+struct debug_overlay
+{
+    uint32 Atlas[OVERLAY_CELL_HEIGHT][OVERLAY_GLYPH_COUNT*OVERLAY_CELL_WIDTH];
+    uint32 Line[OVERLAY_CELL_HEIGHT][OVERLAY_MAX_LINE_LENGTH*OVERLAY_CELL_WIDTH];
+
+    int LineCount;
+    char Lines[OVERLAY_MAX_LINES][OVERLAY_MAX_LINE_LENGTH + 1];
+
+    uint64 BeginCycles;
+    uint64 LastCycles; //NOTE(Robin) BeginOverlayText to the end of DrawOverlay, last time round
+};
+
+internal void InitializeOverlay(debug_overlay *Overlay)
+{
+    *Overlay = {};
+
+    //Every font pixel is a square of OVERLAY_SCALE, and its shadow one font pixel down and right wherever that isn't
+    //lit itself
+    uint32 Lit = 0xFFFFFFFF;
+    uint32 Shadow = 0xFF000000;
+    for(int GlyphIndex = 0; GlyphIndex < OVERLAY_GLYPH_COUNT; ++GlyphIndex)
+    {
+        uint8 *Rows = OverlayFont[GlyphIndex];
+        for(int Y = 0; Y < OVERLAY_FONT_HEIGHT + 1; ++Y)
+        {
+            for(int X = 0; X < OVERLAY_FONT_WIDTH + 1; ++X)
+            {
+                bool32 IsLit = ((Y < OVERLAY_FONT_HEIGHT) && (X < OVERLAY_FONT_WIDTH) &&
+                                (Rows[Y] & (1 << (OVERLAY_FONT_WIDTH - 1 - X))));
+                bool32 IsShadow = ((Y > 0) && (X > 0) && (X - 1 < OVERLAY_FONT_WIDTH) &&
+                                   (Rows[Y - 1] & (1 << (OVERLAY_FONT_WIDTH - X))));
+                uint32 Color = IsLit ? Lit : (IsShadow ? Shadow : 0);
+
+                for(int SubY = 0; SubY < OVERLAY_SCALE; ++SubY)
+                {
+                    for(int SubX = 0; SubX < OVERLAY_SCALE; ++SubX)
+                    {
+                        Overlay->Atlas[Y*OVERLAY_SCALE + SubY][GlyphIndex*OVERLAY_CELL_WIDTH + X*OVERLAY_SCALE + SubX] = Color;
+                    }
+                }
+            }
+        }
+    }
+}
+
+internal void BeginOverlayText(debug_overlay *Overlay)
+{
+    Overlay->BeginCycles = __rdtsc();
+    Overlay->LineCount = 0;
+}
+
+//One line, cut short if it is too long. Lines past OVERLAY_MAX_LINES are left out.
+internal void OverlayPrint(debug_overlay *Overlay, const char *Format, ...)
+{
+    if(Overlay->LineCount < OVERLAY_MAX_LINES)
+    {
+        char *Line = Overlay->Lines[Overlay->LineCount++];
+        va_list Args;
+        va_start(Args, Format);
+        vsnprintf(Line, OVERLAY_MAX_LINE_LENGTH + 1, Format, Args);
+        va_end(Args);
+    }
+}
+
+//The busiest blocks the profiler saw over the last few frames, if it is on
+internal void OverlayPrintProfile(debug_overlay *Overlay, uint32 MaxBlockCount)
+{
+    debug_block_summary Blocks[OVERLAY_MAX_LINES];
+    MaxBlockCount = (MaxBlockCount < OVERLAY_MAX_LINES) ? MaxBlockCount : OVERLAY_MAX_LINES;
+    uint32 BlockCount = DebugGetTopBlocks(Blocks, MaxBlockCount, 16);
+    if(BlockCount)
+    {
+        OverlayPrint(Overlay, "%-24s %6s %9s %6s", "Block", "calls", "cycles", "frame");
+    }
+    for(uint32 BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+    {
+        debug_block_summary *Block = Blocks + BlockIndex;
+        OverlayPrint(Overlay, "%-24.24s %6.1f %9.0f %5.1f%%", Block->Name, Block->CallsPerFrame,
+                     Block->CyclesPerFrame, 100.0f*Block->FrameFraction);
+    }
+}
+
+//Characters the font doesn't have come out as '?'
+inline int GetOverlayGlyphIndex(char Character)
+{
+    int Result = (int)(uint8)Character - OVERLAY_GLYPH_FIRST;
+    if((Result < 0) || (Result >= OVERLAY_GLYPH_COUNT))
+    {
+        Result = '?' - OVERLAY_GLYPH_FIRST;
+    }
+    return(Result);
+}
+
+//Top left of the buffer, as many lines as fit
+internal void DrawOverlay(debug_overlay *Overlay, game_offscreen_buffer *Buffer)
+{
+    TIMED_FUNCTION();
+
+    rectangle2i ClipRect = RectangleFromBuffer(Buffer);
+    for(int LineIndex = 0; LineIndex < Overlay->LineCount; ++LineIndex)
+    {
+        int Y = OVERLAY_MARGIN + LineIndex*OVERLAY_LINE_HEIGHT;
+        if(Y + OVERLAY_CELL_HEIGHT > Buffer->Height)
+        {
+            break;
+        }
+
+        //A space blends nothing but costs as much as any other character, so spaces are where the line is cut up
+        char *Text = Overlay->Lines[LineIndex];
+        int Length = (int)strlen(Text);
+        int RunStart = -1;
+        for(int CharacterIndex = 0; CharacterIndex <= Length; ++CharacterIndex)
+        {
+            bool32 IsSpace = ((CharacterIndex == Length) || (Text[CharacterIndex] == ' '));
+            if(!IsSpace)
+            {
+                int GlyphIndex = GetOverlayGlyphIndex(Text[CharacterIndex]);
+                for(int Row = 0; Row < OVERLAY_CELL_HEIGHT; ++Row)
+                {
+                    memcpy(&Overlay->Line[Row][CharacterIndex*OVERLAY_CELL_WIDTH], &Overlay->Atlas[Row][GlyphIndex*OVERLAY_CELL_WIDTH],
+                           OVERLAY_CELL_WIDTH*sizeof(uint32));
+                }
+                RunStart = (RunStart < 0) ? CharacterIndex : RunStart;
+            }
+            else if(RunStart >= 0)
+            {
+                loaded_bitmap Run;
+                Run.Width = (CharacterIndex - RunStart)*OVERLAY_CELL_WIDTH;
+                Run.Height = OVERLAY_CELL_HEIGHT;
+                Run.Pitch = sizeof(Overlay->Line[0]);
+                Run.Memory = &Overlay->Line[0][RunStart*OVERLAY_CELL_WIDTH];
+                DrawBitmap(Buffer, &Run, V2((float32)(OVERLAY_MARGIN + RunStart*OVERLAY_CELL_WIDTH), (float32)Y), ClipRect);
+                RunStart = -1;
+            }
+        }
+    }
+
+    Overlay->LastCycles = __rdtsc() - Overlay->BeginCycles;
+}
+
+#define MIDNIGHT_MADNESS_OVERLAY_H
+#endif
@@ -0,0 +1,430 @@
+#if !defined(MIDNIGHT_MADNESS_PRESENT_H)
+
+/*
+    Presentation scaling, shared by the platform layers: gets the game's backbuffer onto a window (or any buffer) of
+    another size, so the platform only ever blits 1:1 and the cost of that is ours to measure.
+
+    - The picture keeps its aspect ratio. It is made as big as the window allows and centered, and the bars left over
+      above and below, or left and right, are black.
+    - When that size is a whole multiple of the backbuffer (1280x720 into 2560x1440 or 3840x2160) every pixel is simply
+      replicated: a scaled row is built with SIMD shuffles and then copied down for the rows that repeat it.
+    - Any other size is bilinear. Filtering is separable: a source row is first resampled to the picture's width (every
+      output pixel blends the two source pixels around it), then every output row blends the two resampled rows around
+      it. The two most recent resampled rows are kept, so each source row is resampled once however many output rows
+      use it, and the expensive horizontal pass runs for 720 rows rather than 1080 or 2160.
+    - The weights are 8 bit fixed point and every step rounds the same way on every path, so the SIMD paths write the
+      same bytes as scalar. Where each output column samples from is worked out once, when the sizes change.
+*/
+
+#define PRESENT_MAX_WIDTH 8192
+
+struct present_layout
+{
+    int SourceWidth;
+    int SourceHeight;
+    int DestWidth;
+    int DestHeight;
+
+    //Where the picture goes in the destination, everything outside it is bars
+    int OffsetX;
+    int OffsetY;
+    int Width;
+    int Height;
+
+    int IntegerScale; //NOTE(Robin) 0 when the picture has to be filtered
+};
+
+struct present_scaler
+{
+    present_layout Layout; //NOTE(Robin) What the column tables were built for
+    bool32 TablesValid;
+
+    //For output column X: the left source pixel, and the weight of the right one (0..256) once for every channel.
+    //SourceX + 1 is always inside the row.
+    int32 SourceX[PRESENT_MAX_WIDTH];
+    uint16 FractionX[PRESENT_MAX_WIDTH*4];
+
+    //The last two source rows resampled to the picture's width, and which rows they are (-1 for none)
+    int32 ResampledSourceY[2];
+    uint32 ResampledRows[2][PRESENT_MAX_WIDTH];
+};
+
+//The biggest picture with the source's aspect ratio that fits, centered
+internal present_layout ComputePresentLayout(int SourceWidth, int SourceHeight, int DestWidth, int DestHeight)
+{
+    present_layout Result = {};
+    Result.SourceWidth = SourceWidth;
+    Result.SourceHeight = SourceHeight;
+    Result.DestWidth = DestWidth;
+    Result.DestHeight = DestHeight;
+
+    if((int64)DestWidth*SourceHeight <= (int64)DestHeight*SourceWidth)
+    {
+        Result.Width = DestWidth;
+        Result.Height = (int)(((int64)DestWidth*SourceHeight + SourceWidth/2) / SourceWidth);
+    }
+    else
+    {
+        Result.Height = DestHeight;
+        Result.Width = (int)(((int64)DestHeight*SourceWidth + SourceHeight/2) / SourceHeight);
+    }
+    Result.Width = (Result.Width < 1) ? 1 : Result.Width;
+    Result.Height = (Result.Height < 1) ? 1 : Result.Height;
+
+    if(((Result.Width % SourceWidth) == 0) && (Result.Height == (Result.Width / SourceWidth)*SourceHeight))
+    {
+        Result.IntegerScale = Result.Width / SourceWidth;
+    }
+
+    Result.OffsetX = (DestWidth - Result.Width) / 2;
+    Result.OffsetY = (DestHeight - Result.Height) / 2;
+
+    return(Result);
+}
+
+//Where output pixel Index of Count samples from, in a source Size pixels long: the pixel left of (or above) the sample
+//point, and the weight of the next one in 1/256ths. Pixel centers line up, and the edges are clamped.
+internal void PresentSamplePosition(int Index, int Count, int Size, int32 *SourceIndex, uint32 *Fraction)
+{
+    int64 Position = (((int64)(2*Index + 1)*Size - Count)*256) / (2*(int64)Count);
+    Position = (Position < 0) ? 0 : Position;
+
+    *SourceIndex = (int32)(Position >> 8);
+    *Fraction = (uint32)(Position & 255);
+    if(*SourceIndex >= Size - 1)
+    {
+        *SourceIndex = Size - 1;
+        *Fraction = 0;
+    }
+}
+
+internal void BuildPresentTables(present_scaler *Scaler, present_layout *Layout)
+{
+    for(int X = 0; X < Layout->Width; ++X)
+    {
+        uint32 Fraction;
+        PresentSamplePosition(X, Layout->Width, Layout->SourceWidth, Scaler->SourceX + X, &Fraction);
+        if(Scaler->SourceX[X] == Layout->SourceWidth - 1)
+        {
+            //All of the last pixel, taken as the right one of the last pair so nothing past the row is read
+            Scaler->SourceX[X] -= 1;
+            Fraction = 256;
+        }
+        for(int Channel = 0; Channel < 4; ++Channel)
+        {
+            Scaler->FractionX[4*X + Channel] = (uint16)Fraction;
+        }
+    }
+
+    Scaler->Layout = *Layout;
+    Scaler->TablesValid = true;
+}
+
+//(A*(256 - F) + B*F + 128) >> 8 for each of the four bytes: the one rounding step every path does the same way.
+//Two channels at a time, 16 bits apart: the sum never goes past 65408, so one channel never spills into the next.
+inline uint32 LerpPixel8(uint32 A, uint32 B, uint32 F)
+{
+    uint32 InvF = 256 - F;
+    uint32 RedBlue = ((((A & 0x00FF00FF)*InvF + (B & 0x00FF00FF)*F + 0x00800080) >> 8) & 0x00FF00FF);
+    uint32 AlphaGreen = ((((A >> 8) & 0x00FF00FF)*InvF + ((B >> 8) & 0x00FF00FF)*F + 0x00800080) & 0xFF00FF00);
+    uint32 Result = RedBlue | AlphaGreen;
+    return(Result);
+}
+
+//Vertical pass: Dest[X] = Row0[X] blended towards Row1[X] by F
+internal void BlendRowsScalar(uint32 *Dest, uint32 *Row0, uint32 *Row1, uint32 F, int Count)
+{
+    for(int X = 0; X < Count; ++X)
+    {
+        Dest[X] = LerpPixel8(Row0[X], Row1[X], F);
+    }
+}
+
+//Horizontal pass: output pixel X blends Row[SourceX[X]] towards the pixel after it
+internal void ResampleRowScalar(uint32 *Dest, uint32 *Row, int32 *SourceX, uint16 *FractionX, int Count)
+{
+    for(int X = 0; X < Count; ++X)
+    {
+        Dest[X] = LerpPixel8(Row[SourceX[X]], Row[SourceX[X] + 1], FractionX[4*X]);
+    }
+}
+
+//Every source pixel Scale times
+internal void ReplicateRowScalar(uint32 *Dest, uint32 *Source, int SourceCount, int Scale)
+{
+    for(int X = 0; X < SourceCount; ++X)
+    {
+        for(int Repeat = 0; Repeat < Scale; ++Repeat)
+        {
+            *Dest++ = Source[X];
+        }
+    }
+}
+
+//The blend on 16 bit lanes, two pixels' worth: it never goes past 65408, so it fits
+inline __m128i LerpLanes8SSE2(__m128i A, __m128i B, __m128i F)
+{
+    __m128i InvF = _mm_sub_epi16(_mm_set1_epi16(256), F);
+    __m128i Sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(A, InvF), _mm_mullo_epi16(B, F)), _mm_set1_epi16(128));
+    __m128i Result = _mm_srli_epi16(Sum, 8);
+    return(Result);
+}
+
+internal void BlendRowsSSE2(uint32 *Dest, uint32 *Row0, uint32 *Row1, uint32 F, int Count)
+{
+    __m128i Zero = _mm_setzero_si128();
+    __m128i Fraction = _mm_set1_epi16((int16)F);
+    int X = 0;
+    for(; X + 4 <= Count; X += 4)
+    {
+        __m128i A = _mm_loadu_si128((__m128i *)(Row0 + X));
+        __m128i B = _mm_loadu_si128((__m128i *)(Row1 + X));
+        __m128i Lo = LerpLanes8SSE2(_mm_unpacklo_epi8(A, Zero), _mm_unpacklo_epi8(B, Zero), Fraction);
+        __m128i Hi = LerpLanes8SSE2(_mm_unpackhi_epi8(A, Zero), _mm_unpackhi_epi8(B, Zero), Fraction);
+        _mm_storeu_si128((__m128i *)(Dest + X), _mm_packus_epi16(Lo, Hi));
+    }
+    BlendRowsScalar(Dest + X, Row0 + X, Row1 + X, F, Count - X);
+}
+
+internal void ResampleRowSSE2(uint32 *Dest, uint32 *Row, int32 *SourceX, uint16 *FractionX, int Count)
+{
+    __m128i Zero = _mm_setzero_si128();
+    int X = 0;
+    for(; X + 4 <= Count; X += 4)
+    {
+        int32 *Index = SourceX + X;
+        __m128i A = _mm_setr_epi32(Row[Index[0]], Row[Index[1]], Row[Index[2]], Row[Index[3]]);
+        __m128i B = _mm_setr_epi32(Row[Index[0] + 1], Row[Index[1] + 1], Row[Index[2] + 1], Row[Index[3] + 1]);
+        __m128i FLo = _mm_loadu_si128((__m128i *)(FractionX + 4*X));
+        __m128i FHi = _mm_loadu_si128((__m128i *)(FractionX + 4*X + 8));
+        __m128i Lo = LerpLanes8SSE2(_mm_unpacklo_epi8(A, Zero), _mm_unpacklo_epi8(B, Zero), FLo);
+        __m128i Hi = LerpLanes8SSE2(_mm_unpackhi_epi8(A, Zero), _mm_unpackhi_epi8(B, Zero), FHi);
+        _mm_storeu_si128((__m128i *)(Dest + X), _mm_packus_epi16(Lo, Hi));
+    }
+    ResampleRowScalar(Dest + X, Row, SourceX + X, FractionX + 4*X, Count - X);
+}
+
+//2x, 3x and 4x are shuffles of four source pixels, anything bigger stores each pixel four at a time
+internal void ReplicateRowSSE2(uint32 *Dest, uint32 *Source, int SourceCount, int Scale)
+{
+    int X = 0;
+    if(Scale == 2)
+    {
+        for(; X + 4 <= SourceCount; X += 4)
+        {
+            __m128i Pixels = _mm_loadu_si128((__m128i *)(Source + X));
+            _mm_storeu_si128((__m128i *)(Dest + 0), _mm_unpacklo_epi32(Pixels, Pixels));
+            _mm_storeu_si128((__m128i *)(Dest + 4), _mm_unpackhi_epi32(Pixels, Pixels));
+            Dest += 8;
+        }
+    }
+    else if(Scale == 3)
+    {
+        for(; X + 4 <= SourceCount; X += 4)
+        {
+            __m128i Pixels = _mm_loadu_si128((__m128i *)(Source + X));
+            _mm_storeu_si128((__m128i *)(Dest + 0), _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(1, 0, 0, 0)));
+            _mm_storeu_si128((__m128i *)(Dest + 4), _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(2, 2, 1, 1)));
+            _mm_storeu_si128((__m128i *)(Dest + 8), _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(3, 3, 3, 2)));
+            Dest += 12;
+        }
+    }
+    else if(Scale >= 4)
+    {
+        //The last store of a pixel can overlap the next pixel's first, which rewrites it with the right value anyway.
+        //The very last pixel of the row is left to the scalar loop, so nothing is written past the row.
+        for(; X + 1 < SourceCount; ++X)
+        {
+            __m128i Pixel = _mm_set1_epi32((int32)Source[X]);
+            for(int Repeat = 0; Repeat < Scale; Repeat += 4)
+            {
+                _mm_storeu_si128((__m128i *)(Dest + Repeat), Pixel);
+            }
+            Dest += Scale;
+        }
+    }
+    ReplicateRowScalar(Dest, Source + X, SourceCount - X, Scale);
+}
+
+//Eight pixels' worth of 16 bit lanes, in order: the low four of A and B in one register, the high four in the other
+TARGET_AVX2 inline __m256i LerpLanes8AVX2(__m256i A, __m256i B, __m256i F)
+{
+    __m256i InvF = _mm256_sub_epi16(_mm256_set1_epi16(256), F);
+    __m256i Sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(A, InvF), _mm256_mullo_epi16(B, F)), _mm256_set1_epi16(128));
+    __m256i Result = _mm256_srli_epi16(Sum, 8);
+    return(Result);
+}
+
+//Packs two registers of four pixels each back into eight pixels, in order (packus works within 128 bit lanes)
+TARGET_AVX2 inline __m256i PackPixelsAVX2(__m256i Lo, __m256i Hi)
+{
+    __m256i Result = _mm256_permute4x64_epi64(_mm256_packus_epi16(Lo, Hi), _MM_SHUFFLE(3, 1, 2, 0));
+    return(Result);
+}
+
+TARGET_AVX2 internal void BlendRowsAVX2(uint32 *Dest, uint32 *Row0, uint32 *Row1, uint32 F, int Count)
+{
+    __m256i Fraction = _mm256_set1_epi16((int16)F);
+    int X = 0;
+    for(; X + 8 <= Count; X += 8)
+    {
+        __m256i A = _mm256_loadu_si256((__m256i *)(Row0 + X));
+        __m256i B = _mm256_loadu_si256((__m256i *)(Row1 + X));
+        __m256i Lo = LerpLanes8AVX2(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(A)),
+                                    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(B)), Fraction);
+        __m256i Hi = LerpLanes8AVX2(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(A, 1)),
+                                    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(B, 1)), Fraction);
+        _mm256_storeu_si256((__m256i *)(Dest + X), PackPixelsAVX2(Lo, Hi));
+    }
+    BlendRowsScalar(Dest + X, Row0 + X, Row1 + X, F, Count - X);
+}
+
+TARGET_AVX2 internal void ResampleRowAVX2(uint32 *Dest, uint32 *Row, int32 *SourceX, uint16 *FractionX, int Count)
+{
+    __m256i One = _mm256_set1_epi32(1);
+    int X = 0;
+    for(; X + 8 <= Count; X += 8)
+    {
+        __m256i Index = _mm256_loadu_si256((__m256i *)(SourceX + X));
+        __m256i A = _mm256_i32gather_epi32((int const *)Row, Index, 4);
+        __m256i B = _mm256_i32gather_epi32((int const *)Row, _mm256_add_epi32(Index, One), 4);
+        __m256i FLo = _mm256_loadu_si256((__m256i *)(FractionX + 4*X));
+        __m256i FHi = _mm256_loadu_si256((__m256i *)(FractionX + 4*X + 16));
+        __m256i Lo = LerpLanes8AVX2(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(A)),
+                                    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(B)), FLo);
+        __m256i Hi = LerpLanes8AVX2(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(A, 1)),
+                                    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(B, 1)), FHi);
+        _mm256_storeu_si256((__m256i *)(Dest + X), PackPixelsAVX2(Lo, Hi));
+    }
+    ResampleRowScalar(Dest + X, Row, SourceX + X, FractionX + 4*X, Count - X);
+}
+
+internal void BlendRows(uint32 *Dest, uint32 *Row0, uint32 *Row1, uint32 F, int Count)
+{
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2: {BlendRowsAVX2(Dest, Row0, Row1, F, Count);} break;
+        case SIMDLevel_SSE2: {BlendRowsSSE2(Dest, Row0, Row1, F, Count);} break;
+        default: {BlendRowsScalar(Dest, Row0, Row1, F, Count);} break;
+    }
+}
+
+internal void ResampleRow(uint32 *Dest, uint32 *Row, int32 *SourceX, uint16 *FractionX, int Count)
+{
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2: {ResampleRowAVX2(Dest, Row, SourceX, FractionX, Count);} break;
+        case SIMDLevel_SSE2: {ResampleRowSSE2(Dest, Row, SourceX, FractionX, Count);} break;
+        default: {ResampleRowScalar(Dest, Row, SourceX, FractionX, Count);} break;
+    }
+}
+
+//Replicating is all stores, SSE2 already keeps up with memory
+internal void ReplicateRow(uint32 *Dest, uint32 *Source, int SourceCount, int Scale)
+{
+    if(GlobalSIMDLevel >= SIMDLevel_SSE2)
+    {
+        ReplicateRowSSE2(Dest, Source, SourceCount, Scale);
+    }
+    else
+    {
+        ReplicateRowScalar(Dest, Source, SourceCount, Scale);
+    }
+}
+
+internal void FillPresentRect(game_offscreen_buffer *Dest, int MinX, int MinY, int MaxX, int MaxY)
+{
+    for(int Y = MinY; Y < MaxY; ++Y)
+    {
+        memset((uint8 *)Dest->Memory + (memory_index)Y*Dest->Pitch + MinX*4, 0, (memory_index)(MaxX - MinX)*4);
+    }
+}
+
+//Scales Source into Dest, bars and all. Returns false, leaving Dest alone, for a size the scaler can't handle.
+internal bool32 PresentScaled(present_scaler *Scaler, game_offscreen_buffer *Source, game_offscreen_buffer *Dest)
+{
+    if((Source->Width < 2) || (Source->Height <= 0) || (Source->Width > PRESENT_MAX_WIDTH) ||
+       (Dest->Width <= 0) || (Dest->Height <= 0) || (Dest->Width > PRESENT_MAX_WIDTH))
+    {
+        return(false);
+    }
+
+    TIMED_FUNCTION(Dest->Width*Dest->Height);
+
+    present_layout Layout = ComputePresentLayout(Source->Width, Source->Height, Dest->Width, Dest->Height);
+    if(!Scaler->TablesValid || (memcmp(&Layout, &Scaler->Layout, sizeof(Layout)) != 0))
+    {
+        BuildPresentTables(Scaler, &Layout);
+    }
+
+    //A new frame, so nothing resampled yet is any good
+    Scaler->ResampledSourceY[0] = -1;
+    Scaler->ResampledSourceY[1] = -1;
+
+    int MaxX = Layout.OffsetX + Layout.Width;
+    int MaxY = Layout.OffsetY + Layout.Height;
+    FillPresentRect(Dest, 0, 0, Dest->Width, Layout.OffsetY);
+    FillPresentRect(Dest, 0, MaxY, Dest->Width, Dest->Height);
+    FillPresentRect(Dest, 0, Layout.OffsetY, Layout.OffsetX, MaxY);
+    FillPresentRect(Dest, MaxX, Layout.OffsetY, Dest->Width, MaxY);
+
+    uint8 *SourceMemory = (uint8 *)Source->Memory;
+    uint8 *DestRow = (uint8 *)Dest->Memory + (memory_index)Layout.OffsetY*Dest->Pitch + Layout.OffsetX*4;
+    if(Layout.IntegerScale)
+    {
+        int Scale = Layout.IntegerScale;
+        for(int SourceY = 0; SourceY < Source->Height; ++SourceY)
+        {
+            uint8 *FirstRow = DestRow;
+            ReplicateRow((uint32 *)FirstRow, (uint32 *)(SourceMemory + (memory_index)SourceY*Source->Pitch), Source->Width, Scale);
+            DestRow += Dest->Pitch;
+            for(int Repeat = 1; Repeat < Scale; ++Repeat)
+            {
+                memcpy(DestRow, FirstRow, (memory_index)Layout.Width*4);
+                DestRow += Dest->Pitch;
+            }
+        }
+    }
+    else
+    {
+        for(int Y = 0; Y < Layout.Height; ++Y)
+        {
+            int32 SourceY;
+            uint32 FractionY;
+            PresentSamplePosition(Y, Layout.Height, Source->Height, &SourceY, &FractionY);
+
+            //The rows come in order, so the one needed is either one of the last two or the next one down
+            uint32 *Rows[2];
+            int NeededCount = (FractionY != 0) ? 2 : 1;
+            for(int Needed = 0; Needed < NeededCount; ++Needed)
+            {
+                int32 WantedY = SourceY + Needed;
+                int Slot = (Scaler->ResampledSourceY[0] == WantedY) ? 0 : ((Scaler->ResampledSourceY[1] == WantedY) ? 1 : -1);
+                if(Slot < 0)
+                {
+                    //Replace whichever of the two is further up, it won't be needed again
+                    Slot = (Scaler->ResampledSourceY[0] < Scaler->ResampledSourceY[1]) ? 0 : 1;
+                    ResampleRow(Scaler->ResampledRows[Slot], (uint32 *)(SourceMemory + (memory_index)WantedY*Source->Pitch),
+                                Scaler->SourceX, Scaler->FractionX, Layout.Width);
+                    Scaler->ResampledSourceY[Slot] = WantedY;
+                }
+                Rows[Needed] = Scaler->ResampledRows[Slot];
+            }
+
+            if(FractionY != 0)
+            {
+                BlendRows((uint32 *)DestRow, Rows[0], Rows[1], FractionY, Layout.Width);
+            }
+            else
+            {
+                memcpy(DestRow, Rows[0], (memory_index)Layout.Width*4);
+            }
+            DestRow += Dest->Pitch;
+        }
+    }
+
+    return(true);
+}
+
+#define MIDNIGHT_MADNESS_PRESENT_H
+#endif
@@ -0,0 +1,2114 @@
+//Software renderer, see midnight_madness_render.h
+
+/*
+    Pixel formats. Everything is computed as 0xAARRGGBB and only converted on the way in and out of the buffer, so a
+    format is a struct of those conversions: one pixel at a time, 4 pixels to and from an SSE2 register and 8 to and
+    from an AVX2 one, always as 32 bit 0xAARRGGBB lanes. Every loop that touches the buffer is a template on it, and
+    the format is picked once per primitive (once per tile for a render group), never per pixel.
+
+    Narrowing a channel truncates it and widening repeats its top bits in the bottom ones, so a pixel that is widened
+    and narrowed again comes back unchanged: pixels a SIMD path loads but masks off are stored back exactly as they were.
+    The formats with no alpha read back as opaque.
+*/
+
+struct pixel_format_bgrx8888
+{
+    typedef uint32 pixel;
+
+    static inline pixel Pack(uint32 Color)
+    {
+        return(Color);
+    }
+
+    static inline uint32 Unpack(pixel Pixel)
+    {
+        return(Pixel);
+    }
+
+    static inline __m128i LoadSSE2(pixel *Pixels)
+    {
+        __m128i Result = _mm_loadu_si128((__m128i *)Pixels);
+        return(Result);
+    }
+
+    static inline void StoreSSE2(pixel *Pixels, __m128i Colors)
+    {
+        _mm_storeu_si128((__m128i *)Pixels, Colors);
+    }
+
+    TARGET_AVX2 static inline __m256i LoadAVX2(pixel *Pixels)
+    {
+        __m256i Result = _mm256_loadu_si256((__m256i *)Pixels);
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline void StoreAVX2(pixel *Pixels, __m256i Colors)
+    {
+        _mm256_storeu_si256((__m256i *)Pixels, Colors);
+    }
+
+    //16 pixels, so the narrow formats can pack two registers into one store
+    TARGET_AVX2 static inline void StorePairAVX2(pixel *Pixels, __m256i Colors0, __m256i Colors1)
+    {
+        StoreAVX2(Pixels, Colors0);
+        StoreAVX2(Pixels + 8, Colors1);
+    }
+};
+
+//Red and blue trade places, which is its own inverse, so packing and unpacking are the same thing
+struct pixel_format_rgba8888
+{
+    typedef uint32 pixel;
+
+    static inline pixel Pack(uint32 Color)
+    {
+        pixel Result = (Color & 0xFF00FF00) | ((Color >> 16) & 0xFF) | ((Color & 0xFF) << 16);
+        return(Result);
+    }
+
+    static inline uint32 Unpack(pixel Pixel)
+    {
+        uint32 Result = Pack(Pixel);
+        return(Result);
+    }
+
+    static inline __m128i SwapRedBlueSSE2(__m128i Colors)
+    {
+        __m128i MaskFF = _mm_set1_epi32(0xFF);
+        __m128i Result = _mm_or_si128(_mm_and_si128(Colors, _mm_set1_epi32(0xFF00FF00)),
+                                      _mm_or_si128(_mm_and_si128(_mm_srli_epi32(Colors, 16), MaskFF),
+                                                   _mm_slli_epi32(_mm_and_si128(Colors, MaskFF), 16)));
+        return(Result);
+    }
+
+    static inline __m128i LoadSSE2(pixel *Pixels)
+    {
+        __m128i Result = SwapRedBlueSSE2(_mm_loadu_si128((__m128i *)Pixels));
+        return(Result);
+    }
+
+    static inline void StoreSSE2(pixel *Pixels, __m128i Colors)
+    {
+        _mm_storeu_si128((__m128i *)Pixels, SwapRedBlueSSE2(Colors));
+    }
+
+    TARGET_AVX2 static inline __m256i SwapRedBlueAVX2(__m256i Colors)
+    {
+        __m256i Shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                           2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        __m256i Result = _mm256_shuffle_epi8(Colors, Shuffle);
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline __m256i LoadAVX2(pixel *Pixels)
+    {
+        __m256i Result = SwapRedBlueAVX2(_mm256_loadu_si256((__m256i *)Pixels));
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline void StoreAVX2(pixel *Pixels, __m256i Colors)
+    {
+        _mm256_storeu_si256((__m256i *)Pixels, SwapRedBlueAVX2(Colors));
+    }
+
+    TARGET_AVX2 static inline void StorePairAVX2(pixel *Pixels, __m256i Colors0, __m256i Colors1)
+    {
+        StoreAVX2(Pixels, Colors0);
+        StoreAVX2(Pixels + 8, Colors1);
+    }
+};
+
+struct pixel_format_rgb565
+{
+    typedef uint16 pixel;
+
+    static inline pixel Pack(uint32 Color)
+    {
+        pixel Result = (pixel)(((Color >> 8) & 0xF800) | ((Color >> 5) & 0x07E0) | ((Color >> 3) & 0x001F));
+        return(Result);
+    }
+
+    static inline uint32 Unpack(pixel Pixel)
+    {
+        uint32 Red = (Pixel >> 11) & 0x1F;
+        uint32 Green = (Pixel >> 5) & 0x3F;
+        uint32 Blue = Pixel & 0x1F;
+        uint32 Result = (0xFF000000 | (((Red << 3) | (Red >> 2)) << 16) | (((Green << 2) | (Green >> 4)) << 8) |
+                         ((Blue << 3) | (Blue >> 2)));
+        return(Result);
+    }
+
+    //Lanes of 0xAARRGGBB to lanes of 0x0000RGB565 and back
+    static inline __m128i PackLanesSSE2(__m128i Colors)
+    {
+        __m128i Result = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(Colors, 8), _mm_set1_epi32(0xF800)),
+                                                   _mm_and_si128(_mm_srli_epi32(Colors, 5), _mm_set1_epi32(0x07E0))),
+                                      _mm_and_si128(_mm_srli_epi32(Colors, 3), _mm_set1_epi32(0x001F)));
+        return(Result);
+    }
+
+    static inline __m128i UnpackLanesSSE2(__m128i Pixels)
+    {
+        __m128i Red = _mm_and_si128(_mm_srli_epi32(Pixels, 11), _mm_set1_epi32(0x1F));
+        __m128i Green = _mm_and_si128(_mm_srli_epi32(Pixels, 5), _mm_set1_epi32(0x3F));
+        __m128i Blue = _mm_and_si128(Pixels, _mm_set1_epi32(0x1F));
+        Red = _mm_or_si128(_mm_slli_epi32(Red, 3), _mm_srli_epi32(Red, 2));
+        Green = _mm_or_si128(_mm_slli_epi32(Green, 2), _mm_srli_epi32(Green, 4));
+        Blue = _mm_or_si128(_mm_slli_epi32(Blue, 3), _mm_srli_epi32(Blue, 2));
+        __m128i Result = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0xFF000000), _mm_slli_epi32(Red, 16)),
+                                      _mm_or_si128(_mm_slli_epi32(Green, 8), Blue));
+        return(Result);
+    }
+
+    static inline __m128i LoadSSE2(pixel *Pixels)
+    {
+        __m128i Result = UnpackLanesSSE2(_mm_unpacklo_epi16(_mm_loadl_epi64((__m128i *)Pixels), _mm_setzero_si128()));
+        return(Result);
+    }
+
+    static inline void StoreSSE2(pixel *Pixels, __m128i Colors)
+    {
+        //SSE2 only packs with signed saturation, so the 16 bits are sign extended first to come through unchanged
+        __m128i Packed = _mm_srai_epi32(_mm_slli_epi32(PackLanesSSE2(Colors), 16), 16);
+        _mm_storel_epi64((__m128i *)Pixels, _mm_packs_epi32(Packed, Packed));
+    }
+
+    TARGET_AVX2 static inline __m256i PackLanesAVX2(__m256i Colors)
+    {
+        __m256i Result = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(Colors, 8), _mm256_set1_epi32(0xF800)),
+                                                         _mm256_and_si256(_mm256_srli_epi32(Colors, 5), _mm256_set1_epi32(0x07E0))),
+                                         _mm256_and_si256(_mm256_srli_epi32(Colors, 3), _mm256_set1_epi32(0x001F)));
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline __m256i UnpackLanesAVX2(__m256i Pixels)
+    {
+        __m256i Red = _mm256_and_si256(_mm256_srli_epi32(Pixels, 11), _mm256_set1_epi32(0x1F));
+        __m256i Green = _mm256_and_si256(_mm256_srli_epi32(Pixels, 5), _mm256_set1_epi32(0x3F));
+        __m256i Blue = _mm256_and_si256(Pixels, _mm256_set1_epi32(0x1F));
+        Red = _mm256_or_si256(_mm256_slli_epi32(Red, 3), _mm256_srli_epi32(Red, 2));
+        Green = _mm256_or_si256(_mm256_slli_epi32(Green, 2), _mm256_srli_epi32(Green, 4));
+        Blue = _mm256_or_si256(_mm256_slli_epi32(Blue, 3), _mm256_srli_epi32(Blue, 2));
+        __m256i Result = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(0xFF000000), _mm256_slli_epi32(Red, 16)),
+                                         _mm256_or_si256(_mm256_slli_epi32(Green, 8), Blue));
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline __m256i LoadAVX2(pixel *Pixels)
+    {
+        __m256i Result = UnpackLanesAVX2(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)Pixels)));
+        return(Result);
+    }
+
+    //The pack works within each 128 bit half, the permute brings the two halves' 4 pixels together
+    TARGET_AVX2 static inline void StoreAVX2(pixel *Pixels, __m256i Colors)
+    {
+        __m256i Packed = PackLanesAVX2(Colors);
+        Packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(Packed, Packed), 0x08);
+        _mm_storeu_si128((__m128i *)Pixels, _mm256_castsi256_si128(Packed));
+    }
+
+    TARGET_AVX2 static inline void StorePairAVX2(pixel *Pixels, __m256i Colors0, __m256i Colors1)
+    {
+        __m256i Packed = _mm256_packus_epi32(PackLanesAVX2(Colors0), PackLanesAVX2(Colors1));
+        _mm256_storeu_si256((__m256i *)Pixels, _mm256_permute4x64_epi64(Packed, 0xD8));
+    }
+};
+
+struct pixel_format_indexed8
+{
+    typedef uint8 pixel;
+
+    static inline pixel Pack(uint32 Color)
+    {
+        pixel Result = (pixel)(((Color >> 16) & 0xE0) | ((Color >> 11) & 0x1C) | ((Color >> 6) & 0x03));
+        return(Result);
+    }
+
+    static inline uint32 Unpack(pixel Pixel)
+    {
+        uint32 Red = Pixel >> 5;
+        uint32 Green = (Pixel >> 2) & 0x7;
+        uint32 Blue = Pixel & 0x3;
+        uint32 Result = (0xFF000000 | (((Red << 5) | (Red << 2) | (Red >> 1)) << 16) |
+                         (((Green << 5) | (Green << 2) | (Green >> 1)) << 8) | (Blue*0x55));
+        return(Result);
+    }
+
+    static inline __m128i PackLanesSSE2(__m128i Colors)
+    {
+        __m128i Result = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(Colors, 16), _mm_set1_epi32(0xE0)),
+                                                   _mm_and_si128(_mm_srli_epi32(Colors, 11), _mm_set1_epi32(0x1C))),
+                                      _mm_and_si128(_mm_srli_epi32(Colors, 6), _mm_set1_epi32(0x03)));
+        return(Result);
+    }
+
+    static inline __m128i UnpackLanesSSE2(__m128i Pixels)
+    {
+        __m128i Red = _mm_srli_epi32(Pixels, 5);
+        __m128i Green = _mm_and_si128(_mm_srli_epi32(Pixels, 2), _mm_set1_epi32(0x7));
+        __m128i Blue = _mm_and_si128(Pixels, _mm_set1_epi32(0x3));
+        Red = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(Red, 5), _mm_slli_epi32(Red, 2)), _mm_srli_epi32(Red, 1));
+        Green = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(Green, 5), _mm_slli_epi32(Green, 2)), _mm_srli_epi32(Green, 1));
+        Blue = _mm_or_si128(_mm_or_si128(Blue, _mm_slli_epi32(Blue, 2)), _mm_or_si128(_mm_slli_epi32(Blue, 4), _mm_slli_epi32(Blue, 6)));
+        __m128i Result = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0xFF000000), _mm_slli_epi32(Red, 16)),
+                                      _mm_or_si128(_mm_slli_epi32(Green, 8), Blue));
+        return(Result);
+    }
+
+    static inline __m128i LoadSSE2(pixel *Pixels)
+    {
+        __m128i Zero = _mm_setzero_si128();
+        __m128i Bytes = _mm_cvtsi32_si128(*(int32 *)Pixels);
+        __m128i Result = UnpackLanesSSE2(_mm_unpacklo_epi16(_mm_unpacklo_epi8(Bytes, Zero), Zero));
+        return(Result);
+    }
+
+    static inline void StoreSSE2(pixel *Pixels, __m128i Colors)
+    {
+        __m128i Packed = PackLanesSSE2(Colors);
+        Packed = _mm_packs_epi32(Packed, Packed);
+        *(int32 *)Pixels = _mm_cvtsi128_si32(_mm_packus_epi16(Packed, Packed));
+    }
+
+    TARGET_AVX2 static inline __m256i PackLanesAVX2(__m256i Colors)
+    {
+        __m256i Result = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(Colors, 16), _mm256_set1_epi32(0xE0)),
+                                                         _mm256_and_si256(_mm256_srli_epi32(Colors, 11), _mm256_set1_epi32(0x1C))),
+                                         _mm256_and_si256(_mm256_srli_epi32(Colors, 6), _mm256_set1_epi32(0x03)));
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline __m256i UnpackLanesAVX2(__m256i Pixels)
+    {
+        __m256i Red = _mm256_srli_epi32(Pixels, 5);
+        __m256i Green = _mm256_and_si256(_mm256_srli_epi32(Pixels, 2), _mm256_set1_epi32(0x7));
+        __m256i Blue = _mm256_and_si256(Pixels, _mm256_set1_epi32(0x3));
+        Red = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(Red, 5), _mm256_slli_epi32(Red, 2)), _mm256_srli_epi32(Red, 1));
+        Green = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(Green, 5), _mm256_slli_epi32(Green, 2)), _mm256_srli_epi32(Green, 1));
+        Blue = _mm256_mullo_epi32(Blue, _mm256_set1_epi32(0x55));
+        __m256i Result = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(0xFF000000), _mm256_slli_epi32(Red, 16)),
+                                         _mm256_or_si256(_mm256_slli_epi32(Green, 8), Blue));
+        return(Result);
+    }
+
+    TARGET_AVX2 static inline __m256i LoadAVX2(pixel *Pixels)
+    {
+        __m256i Result = UnpackLanesAVX2(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)Pixels)));
+        return(Result);
+    }
+
+    //After the two packs each 128 bit half has its 4 pixels in its lowest 32 bits, the permute puts them side by side
+    TARGET_AVX2 static inline void StoreAVX2(pixel *Pixels, __m256i Colors)
+    {
+        __m256i Packed = PackLanesAVX2(Colors);
+        Packed = _mm256_packus_epi32(Packed, Packed);
+        Packed = _mm256_packus_epi16(Packed, Packed);
+        Packed = _mm256_permutevar8x32_epi32(Packed, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+        _mm_storel_epi64((__m128i *)Pixels, _mm256_castsi256_si128(Packed));
+    }
+
+    TARGET_AVX2 static inline void StorePairAVX2(pixel *Pixels, __m256i Colors0, __m256i Colors1)
+    {
+        __m256i Packed = _mm256_packus_epi32(PackLanesAVX2(Colors0), PackLanesAVX2(Colors1));
+        Packed = _mm256_packus_epi16(Packed, Packed);
+        Packed = _mm256_permutevar8x32_epi32(Packed, _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0));
+        _mm_storeu_si128((__m128i *)Pixels, _mm256_castsi256_si128(Packed));
+    }
+};
+
+//What every index of PixelFormat_Indexed8 stands for, as 0xFFRRGGBB, for whoever has to display it
+internal void GetIndexed8Palette(uint32 *Palette)
+{
+    for(uint32 Index = 0; Index < 256; ++Index)
+    {
+        Palette[Index] = pixel_format_indexed8::Unpack((uint8)Index);
+    }
+}
+
+//The pixel repeated to fill 32 bits, for filling 16 or 32 bytes at a time whatever the format
+template<typename format>
+inline uint32 RepeatPixel(typename format::pixel Pixel)
+{
+    uint32 Result = Pixel;
+    for(int Shift = 8*sizeof(Pixel); Shift < 32; Shift *= 2)
+    {
+        Result |= Result << Shift;
+    }
+    return(Result);
+}
+
+//The reference version, one pixel at a time. The SIMD versions have to produce exactly the same bytes.
+template<typename format>
+internal void RenderWeirdGradientScalar(game_offscreen_buffer *Buffer, int XOffset, int YOffset)
+{
+    typedef typename format::pixel pixel;
+
+    uint8 *Row = (uint8 *)Buffer->Memory;
+    for(int Y = 0; Y < Buffer->Height; ++Y)
+    {
+        pixel *Pixel = (pixel *)Row;
+        for(int X = 0; X < Buffer->Width; ++X)
+        {
+            //Computed as 0xAARRGGBB, which BGRX8888 stores as is: BB GG RR xx in memory
+            uint8 Blue= (X + XOffset);
+            uint8 Green = (Y + YOffset);
+            uint8 Red = 0;
+            uint8 Padding = 0;
+
+            *Pixel++ = format::Pack((Padding << 24) | (Red << 16) | (Green << 8) | Blue);
+        }
+
+        Row += Buffer->Pitch;
+    }
+}
+
+//4 pixels per instruction. Green is the same for the whole row, so only Blue has to be computed per pixel.
+template<typename format>
+internal void RenderWeirdGradientSSE2(game_offscreen_buffer *Buffer, int XOffset, int YOffset)
+{
+    typedef typename format::pixel pixel;
+
+    __m128i ByteMask = _mm_set1_epi32(0xFF);
+    __m128i Four = _mm_set1_epi32(4);
+
+    uint8 *Row = (uint8 *)Buffer->Memory;
+    for(int Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32 Green = (uint8)(Y + YOffset);
+        __m128i GreenShifted = _mm_set1_epi32(Green << 8);
+        __m128i BlueX = _mm_setr_epi32(XOffset, XOffset + 1, XOffset + 2, XOffset + 3);
+
+        pixel *Pixel = (pixel *)Row;
+        int X = 0;
+        for(; X + 4 <= Buffer->Width; X += 4)
+        {
+            __m128i Color = _mm_or_si128(_mm_and_si128(BlueX, ByteMask), GreenShifted);
+            //The rows don't have to be 16 byte aligned (Pitch is up to the platform), so store unaligned
+            format::StoreSSE2(Pixel, Color);
+            Pixel += 4;
+            BlueX = _mm_add_epi32(BlueX, Four);
+        }
+
+        for(; X < Buffer->Width; ++X)
+        {
+            uint8 Blue = (X + XOffset);
+            *Pixel++ = format::Pack((Green << 8) | Blue);
+        }
+
+        Row += Buffer->Pitch;
+    }
+}
+
+//16 pixels per loop, two registers' worth
+template<typename format>
+TARGET_AVX2 internal void RenderWeirdGradientAVX2(game_offscreen_buffer *Buffer, int XOffset, int YOffset)
+{
+    typedef typename format::pixel pixel;
+
+    __m256i ByteMask = _mm256_set1_epi32(0xFF);
+    __m256i Eight = _mm256_set1_epi32(8);
+    __m256i Sixteen = _mm256_set1_epi32(16);
+
+    uint8 *Row = (uint8 *)Buffer->Memory;
+    for(int Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32 Green = (uint8)(Y + YOffset);
+        __m256i GreenShifted = _mm256_set1_epi32(Green << 8);
+        __m256i BlueX0 = _mm256_add_epi32(_mm256_set1_epi32(XOffset), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i BlueX1 = _mm256_add_epi32(BlueX0, Eight);
+
+        pixel *Pixel = (pixel *)Row;
+        int X = 0;
+        for(; X + 16 <= Buffer->Width; X += 16)
+        {
+            __m256i Color0 = _mm256_or_si256(_mm256_and_si256(BlueX0, ByteMask), GreenShifted);
+            __m256i Color1 = _mm256_or_si256(_mm256_and_si256(BlueX1, ByteMask), GreenShifted);
+            format::StorePairAVX2(Pixel, Color0, Color1);
+            Pixel += 16;
+            BlueX0 = _mm256_add_epi32(BlueX0, Sixteen);
+            BlueX1 = _mm256_add_epi32(BlueX1, Sixteen);
+        }
+
+        if(X + 8 <= Buffer->Width)
+        {
+            __m256i Color0 = _mm256_or_si256(_mm256_and_si256(BlueX0, ByteMask), GreenShifted);
+            format::StoreAVX2(Pixel, Color0);
+            Pixel += 8;
+            X += 8;
+        }
+
+        for(; X < Buffer->Width; ++X)
+        {
+            uint8 Blue = (X + XOffset);
+            *Pixel++ = format::Pack((Green << 8) | Blue);
+        }
+
+        Row += Buffer->Pitch;
+    }
+}
+
+template<typename format>
+internal void RenderWeirdGradient(game_offscreen_buffer *Buffer, int XOffset, int YOffset)
+{
+    TIMED_FUNCTION(Buffer->Width*Buffer->Height);
+
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2:
+        {
+            RenderWeirdGradientAVX2<format>(Buffer, XOffset, YOffset);
+        } break;
+
+        case SIMDLevel_SSE2:
+        {
+            RenderWeirdGradientSSE2<format>(Buffer, XOffset, YOffset);
+        } break;
+
+        default:
+        {
+            RenderWeirdGradientScalar<format>(Buffer, XOffset, YOffset);
+        } break;
+    }
+}
+
+inline int32 RoundReal32ToInt32(float32 Real)
+{
+    int32 Result = (int32)floorf(Real + 0.5f);
+    return(Result);
+}
+
+inline uint32 PackColor(v4 Color)
+{
+    float32 Channels[4] = {Color.B, Color.G, Color.R, Color.A};
+    uint32 Result = 0;
+    for(int Channel = 0; Channel < 4; ++Channel)
+    {
+        int32 Value = RoundReal32ToInt32(Channels[Channel]*255.0f);
+        Value = (Value < 0) ? 0 : ((Value > 255) ? 255 : Value);
+        Result |= (uint32)Value << (8*Channel);
+    }
+    return(Result);
+}
+
+//Value/255 rounded to nearest, exact for every product of two bytes, and cheap enough to do 16 at a time in SIMD
+inline uint32 Div255(uint32 Value)
+{
+    Value += 128;
+    uint32 Result = (Value + (Value >> 8)) >> 8;
+    return(Result);
+}
+
+//Dest = Source + Dest*(1 - SourceAlpha), all four bytes, in integers
+inline uint32 BlendPremultiplied(uint32 Dest, uint32 Source)
+{
+    uint32 InvAlpha = 255 - (Source >> 24);
+    uint32 Result = 0;
+    for(int Shift = 0; Shift < 32; Shift += 8)
+    {
+        uint32 Channel = ((Source >> Shift) & 0xFF) + Div255(((Dest >> Shift) & 0xFF)*InvAlpha);
+        Channel = (Channel > 255) ? 255 : Channel;
+        Result |= Channel << Shift;
+    }
+    return(Result);
+}
+
+//The same blend for 4 pixels: every byte widened to 16 bits, multiplied by its pixel's 255 - alpha, divided by 255
+inline __m128i BlendPremultipliedSSE2(__m128i Dest, __m128i Source)
+{
+    __m128i Zero = _mm_setzero_si128();
+    __m128i Half = _mm_set1_epi16(128);
+
+    //255 - alpha in both 16 bit halves of every pixel, then spread over the 4 lanes each widened pixel takes up
+    __m128i InvAlpha = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(Source, 24));
+    InvAlpha = _mm_or_si128(InvAlpha, _mm_slli_epi32(InvAlpha, 16));
+    __m128i InvAlphaLo = _mm_unpacklo_epi32(InvAlpha, InvAlpha);
+    __m128i InvAlphaHi = _mm_unpackhi_epi32(InvAlpha, InvAlpha);
+
+    __m128i Lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(Dest, Zero), InvAlphaLo), Half);
+    __m128i Hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(Dest, Zero), InvAlphaHi), Half);
+    Lo = _mm_srli_epi16(_mm_add_epi16(Lo, _mm_srli_epi16(Lo, 8)), 8);
+    Hi = _mm_srli_epi16(_mm_add_epi16(Hi, _mm_srli_epi16(Hi, 8)), 8);
+
+    __m128i Result = _mm_adds_epu8(Source, _mm_packus_epi16(Lo, Hi));
+    return(Result);
+}
+
+//8 pixels. The unpacks and the pack both work within each 128 bit half, so the pixels come back out in order.
+TARGET_AVX2 inline __m256i BlendPremultipliedAVX2(__m256i Dest, __m256i Source)
+{
+    __m256i Zero = _mm256_setzero_si256();
+    __m256i Half = _mm256_set1_epi16(128);
+
+    __m256i InvAlpha = _mm256_sub_epi32(_mm256_set1_epi32(255), _mm256_srli_epi32(Source, 24));
+    InvAlpha = _mm256_or_si256(InvAlpha, _mm256_slli_epi32(InvAlpha, 16));
+    __m256i InvAlphaLo = _mm256_unpacklo_epi32(InvAlpha, InvAlpha);
+    __m256i InvAlphaHi = _mm256_unpackhi_epi32(InvAlpha, InvAlpha);
+
+    __m256i Lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(Dest, Zero), InvAlphaLo), Half);
+    __m256i Hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(Dest, Zero), InvAlphaHi), Half);
+    Lo = _mm256_srli_epi16(_mm256_add_epi16(Lo, _mm256_srli_epi16(Lo, 8)), 8);
+    Hi = _mm256_srli_epi16(_mm256_add_epi16(Hi, _mm256_srli_epi16(Hi, 8)), 8);
+
+    __m256i Result = _mm256_adds_epu8(Source, _mm256_packus_epi16(Lo, Hi));
+    return(Result);
+}
+
+//Spans are runs of pixels within one row. Color spans (Source == 0) fill with, or blend, one color.
+
+template<typename format>
+internal void DrawSpanScalar(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    typedef typename format::pixel pixel;
+
+    if(Source)
+    {
+        for(int X = 0; X < Count; ++X)
+        {
+            Dest[X] = format::Pack(BlendPremultiplied(format::Unpack(Dest[X]), Source[X]));
+        }
+    }
+    else if((Color >> 24) == 0xFF)
+    {
+        pixel Packed = format::Pack(Color);
+        for(int X = 0; X < Count; ++X)
+        {
+            Dest[X] = Packed;
+        }
+    }
+    else
+    {
+        for(int X = 0; X < Count; ++X)
+        {
+            Dest[X] = format::Pack(BlendPremultiplied(format::Unpack(Dest[X]), Color));
+        }
+    }
+}
+
+template<typename format>
+internal void DrawSpanSSE2(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    typedef typename format::pixel pixel;
+
+    //Rows don't have to be aligned (Pitch and the clipped X are up to the caller), so everything loads and stores unaligned
+    int X = 0;
+    if(Source)
+    {
+        for(; X + 4 <= Count; X += 4)
+        {
+            __m128i D = format::LoadSSE2(Dest + X);
+            __m128i S = _mm_loadu_si128((__m128i *)(Source + X));
+            format::StoreSSE2(Dest + X, BlendPremultipliedSSE2(D, S));
+        }
+    }
+    else if((Color >> 24) == 0xFF)
+    {
+        //A fill is the same 16 bytes over and over, however many pixels that is
+        int PixelsPerStore = 16 / sizeof(pixel);
+        __m128i S = _mm_set1_epi32(RepeatPixel<format>(format::Pack(Color)));
+        for(; X + PixelsPerStore <= Count; X += PixelsPerStore)
+        {
+            _mm_storeu_si128((__m128i *)(Dest + X), S);
+        }
+    }
+    else
+    {
+        __m128i S = _mm_set1_epi32(Color);
+        for(; X + 4 <= Count; X += 4)
+        {
+            __m128i D = format::LoadSSE2(Dest + X);
+            format::StoreSSE2(Dest + X, BlendPremultipliedSSE2(D, S));
+        }
+    }
+
+    DrawSpanScalar<format>(Dest + X, Source ? Source + X : 0, Color, Count - X);
+}
+
+template<typename format>
+TARGET_AVX2 internal void DrawSpanAVX2(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    typedef typename format::pixel pixel;
+
+    int X = 0;
+    if(Source)
+    {
+        for(; X + 8 <= Count; X += 8)
+        {
+            __m256i D = format::LoadAVX2(Dest + X);
+            __m256i S = _mm256_loadu_si256((__m256i *)(Source + X));
+            format::StoreAVX2(Dest + X, BlendPremultipliedAVX2(D, S));
+        }
+    }
+    else if((Color >> 24) == 0xFF)
+    {
+        int PixelsPerStore = 32 / sizeof(pixel);
+        __m256i S = _mm256_set1_epi32(RepeatPixel<format>(format::Pack(Color)));
+        for(; X + PixelsPerStore <= Count; X += PixelsPerStore)
+        {
+            _mm256_storeu_si256((__m256i *)(Dest + X), S);
+        }
+    }
+    else
+    {
+        __m256i S = _mm256_set1_epi32(Color);
+        for(; X + 8 <= Count; X += 8)
+        {
+            __m256i D = format::LoadAVX2(Dest + X);
+            format::StoreAVX2(Dest + X, BlendPremultipliedAVX2(D, S));
+        }
+    }
+
+    //What is left is less than one AVX2 register, the SSE2 path takes as much of it as it can. That path isn't VEX
+    //encoded, so the upper halves are cleared first: SSE2 after dirty AVX registers pays for the transition, which made
+    //spans with a tail (text, say) slower here than with SSE2 alone.
+    _mm256_zeroupper();
+    DrawSpanSSE2<format>(Dest + X, Source ? Source + X : 0, Color, Count - X);
+}
+
+template<typename format>
+internal void DrawSpanSRGB(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2:
+        {
+            DrawSpanAVX2<format>(Dest, Source, Color, Count);
+        } break;
+
+        case SIMDLevel_SSE2:
+        {
+            DrawSpanSSE2<format>(Dest, Source, Color, Count);
+        } break;
+
+        default:
+        {
+            DrawSpanScalar<format>(Dest, Source, Color, Count);
+        } break;
+    }
+}
+
+/*
+    Blending in linear light. The bytes in the buffer and in bitmaps are sRGB, which is fine to store but wrong to
+    blend: half covered white over black comes out as byte 128, which looks a lot darker than half as bright. With
+    BlendSpace_Linear, translucent spans go through three passes per chunk of a row instead of one blend per pixel:
+
+    - Dest and Source are converted to 15 bit linear, 0..32767, through SRGBToLinear15. Source is premultiplied in
+      sRGB, so it is unpremultiplied first, converted, and premultiplied again in linear.
+    - Dest = Source + Dest*(1 - SourceAlpha) on the 16 bit values, 8 channels per SSE2 instruction.
+    - Back to bytes through Linear15ToByte, which is indexed by the top 12 bits.
+
+    Every step is integer table lookups and shifts, no pow(), and every SIMD path writes the same bytes as the scalar
+    one. Alpha rides along in the same lanes, with its own linear (not sRGB) half of each table. An opaque pixel comes
+    back exactly as it went in, so opaque fills and the opaque parts of bitmaps cost and look the same as before.
+
+    Textured quads sample their texels as they always do, and hand them to the same span blend a row at a time.
+*/
+
+#define LINEAR_BLEND_CHUNK 64 //NOTE(Robin) Pixels per pass, a multiple of 8
+#define LINEAR_TABLE_MIN_PIXELS 4096 //NOTE(Robin) About where building a rectangle's table pays for itself
+#define LINEAR_QUAD_SEGMENT 256 //NOTE(Robin) Pixels of a textured quad's row sampled before they are blended
+
+//[0, 256): sRGB byte to linear, [256, 512): alpha byte to 0..32767. Padded, the AVX2 gathers read 32 bits.
+global_variable uint16 SRGBToLinear15[512 + 2];
+//[0, 4096): top 12 bits of linear to sRGB byte, [4096, 8192): the same for alpha. Padded for the gathers too.
+global_variable uint8 Linear15ToByte[8192 + 4];
+//255*65536/Alpha, rounded, to unpremultiply a byte with a multiply and a shift. 0 leaves additive colors as they are.
+global_variable uint32 UnpremultiplyFactor[256];
+//Alpha*32768/255 to premultiply 15 bit linear again, and 32768 (leave it alone) for 0 and for the alpha lane
+global_variable uint16 PremultiplyFactor[256 + 2];
+
+internal float32 SRGBToLinear(float32 Value)
+{
+    float32 Result = (Value <= 0.04045f) ? (Value / 12.92f) : powf((Value + 0.055f) / 1.055f, 2.4f);
+    return(Result);
+}
+
+internal float32 LinearToSRGB(float32 Value)
+{
+    float32 Result = (Value <= 0.0031308f) ? (Value*12.92f) : (1.055f*powf(Value, 1.0f / 2.4f) - 0.055f);
+    return(Result);
+}
+
+internal void BuildSRGBTables(void)
+{
+    for(uint32 Byte = 0; Byte < 256; ++Byte)
+    {
+        SRGBToLinear15[Byte] = (uint16)(SRGBToLinear(Byte / 255.0f)*32767.0f + 0.5f);
+        SRGBToLinear15[256 + Byte] = (uint16)((Byte*32767 + 127) / 255);
+        UnpremultiplyFactor[Byte] = Byte ? ((255*65536 + Byte/2) / Byte) : 65536;
+        PremultiplyFactor[Byte] = Byte ? (uint16)((Byte*32768 + 127) / 255) : 32768;
+    }
+
+    for(uint32 Index = 0; Index < 4096; ++Index)
+    {
+        //Rounded from the middle of the 8 values that share the index
+        float32 Linear = ((Index << 3) + 4) / 32767.0f;
+        Linear = (Linear > 1.0f) ? 1.0f : Linear;
+        Linear15ToByte[Index] = (uint8)(LinearToSRGB(Linear)*255.0f + 0.5f);
+        Linear15ToByte[4096 + Index] = (uint8)(Linear*255.0f + 0.5f);
+    }
+
+    //Every byte has an index of its own (the smallest step, between the darkest bytes, is 10 linear values, more than 8), and that index
+    //gives the byte back, so a pixel nothing is blended into survives a trip through linear untouched
+    for(uint32 Byte = 0; Byte < 256; ++Byte)
+    {
+        Linear15ToByte[SRGBToLinear15[Byte] >> 3] = (uint8)Byte;
+        Linear15ToByte[4096 + (SRGBToLinear15[256 + Byte] >> 3)] = (uint8)Byte;
+    }
+}
+
+//Picking linear builds the tables first, the first time. Only the platform calls this, before anything is drawn.
+internal void GameSelectBlendSpace(blend_space Space)
+{
+    if((Space == BlendSpace_Linear) && (SRGBToLinear15[255] == 0))
+    {
+        BuildSRGBTables();
+    }
+    GlobalBlendSpace = Space;
+}
+
+//B, G, R, A of one 0xAARRGGBB pixel, as 15 bit linear
+inline void LinearFromDest(uint32 Pixel, uint16 *Linear)
+{
+    Linear[0] = SRGBToLinear15[Pixel & 0xFF];
+    Linear[1] = SRGBToLinear15[(Pixel >> 8) & 0xFF];
+    Linear[2] = SRGBToLinear15[(Pixel >> 16) & 0xFF];
+    Linear[3] = SRGBToLinear15[256 + (Pixel >> 24)];
+}
+
+//The same for a premultiplied pixel, which stays premultiplied
+inline void LinearFromSource(uint32 Pixel, uint16 *Linear)
+{
+    uint32 Alpha = Pixel >> 24;
+    uint32 Unpremultiply = UnpremultiplyFactor[Alpha];
+    uint32 Premultiply = PremultiplyFactor[Alpha];
+    for(int Channel = 0; Channel < 3; ++Channel)
+    {
+        uint32 Byte = (((Pixel >> 8*Channel) & 0xFF)*Unpremultiply + 0x8000) >> 16;
+        Byte = (Byte > 255) ? 255 : Byte;
+        Linear[Channel] = (uint16)((SRGBToLinear15[Byte]*Premultiply) >> 15);
+    }
+    Linear[3] = SRGBToLinear15[256 + Alpha];
+}
+
+inline uint32 SRGBFromLinear(uint16 *Linear)
+{
+    uint32 Result = ((uint32)Linear15ToByte[Linear[0] >> 3] |
+                     ((uint32)Linear15ToByte[Linear[1] >> 3] << 8) |
+                     ((uint32)Linear15ToByte[Linear[2] >> 3] << 16) |
+                     ((uint32)Linear15ToByte[4096 + (Linear[3] >> 3)] << 24));
+    return(Result);
+}
+
+//SourceAlpha is 0..32767, and 32767 has to take all of Dest away, hence scaling it to 0..32768 first
+inline uint16 BlendLinear15(uint16 Dest, uint16 Source, uint16 SourceAlpha)
+{
+    uint32 Alpha = SourceAlpha + (SourceAlpha >> 14);
+    uint32 Result = Source + Dest - ((2*Dest*Alpha) >> 16);
+    Result = (Result > 32767) ? 32767 : Result;
+    return((uint16)Result);
+}
+
+//The blend pass on whole chunks: Count pixels, 4 channels each
+inline void BlendLinearChunkScalar(uint16 *Dest, uint16 *Source, int Count)
+{
+    for(int Index = 0; Index < 4*Count; ++Index)
+    {
+        Dest[Index] = BlendLinear15(Dest[Index], Source[Index], Source[Index | 3]);
+    }
+}
+
+//2 pixels per instruction. mulhi is (a*b) >> 16, so Dest is doubled going in to make it the same >> 15 as above.
+inline void BlendLinearChunkSSE2(uint16 *Dest, uint16 *Source, int Count)
+{
+    __m128i Max = _mm_set1_epi16((int16)0x8000);
+    int Index = 0;
+    for(; Index + 8 <= 4*Count; Index += 8)
+    {
+        __m128i D = _mm_loadu_si128((__m128i *)(Dest + Index));
+        __m128i S = _mm_loadu_si128((__m128i *)(Source + Index));
+        __m128i Alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(S, 0xFF), 0xFF);
+        Alpha = _mm_add_epi16(Alpha, _mm_srli_epi16(Alpha, 14));
+        __m128i Result = _mm_adds_epu16(S, _mm_sub_epi16(D, _mm_mulhi_epu16(_mm_slli_epi16(D, 1), Alpha)));
+        //Clamped to 32767: saturate at 65535 a half up, and come back down
+        Result = _mm_subs_epu16(_mm_adds_epu16(Result, Max), Max);
+        _mm_storeu_si128((__m128i *)(Dest + Index), Result);
+    }
+    BlendLinearChunkScalar(Dest + Index, Source + Index, Count - Index/4);
+}
+
+TARGET_AVX2 inline void BlendLinearChunkAVX2(uint16 *Dest, uint16 *Source, int Count)
+{
+    __m256i Max = _mm256_set1_epi16((int16)0x8000);
+    int Index = 0;
+    for(; Index + 16 <= 4*Count; Index += 16)
+    {
+        __m256i D = _mm256_loadu_si256((__m256i *)(Dest + Index));
+        __m256i S = _mm256_loadu_si256((__m256i *)(Source + Index));
+        __m256i Alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(S, 0xFF), 0xFF);
+        Alpha = _mm256_add_epi16(Alpha, _mm256_srli_epi16(Alpha, 14));
+        __m256i Result = _mm256_adds_epu16(S, _mm256_sub_epi16(D, _mm256_mulhi_epu16(_mm256_slli_epi16(D, 1), Alpha)));
+        Result = _mm256_subs_epu16(_mm256_adds_epu16(Result, Max), Max);
+        _mm256_storeu_si256((__m256i *)(Dest + Index), Result);
+    }
+    BlendLinearChunkScalar(Dest + Index, Source + Index, Count - Index/4);
+}
+
+//The 4 bytes of 2 pixels, one per 32 bit lane, through SRGBToLinear15: alpha lanes look in the second half
+TARGET_AVX2 inline __m256i GatherLinear15AVX2(__m256i Bytes)
+{
+    __m256i AlphaHalf = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+    __m256i Result = _mm256_i32gather_epi32((int *)SRGBToLinear15, _mm256_add_epi32(Bytes, AlphaHalf), 2);
+    Result = _mm256_and_si256(Result, _mm256_set1_epi32(0xFFFF));
+    return(Result);
+}
+
+//8 pixels to 32 channels of 15 bit linear, the same order they are in as bytes. SourceIsPremultiplied goes the long
+//way round of LinearFromSource.
+TARGET_AVX2 inline void LinearFromPixelsAVX2(__m256i Pixels, uint16 *Linear, bool32 SourceIsPremultiplied)
+{
+    __m128i Lo = _mm256_castsi256_si128(Pixels);
+    __m128i Hi = _mm256_extracti128_si256(Pixels, 1);
+    __m256i Bytes[4] =
+    {
+        _mm256_cvtepu8_epi32(Lo), _mm256_cvtepu8_epi32(_mm_srli_si128(Lo, 8)),
+        _mm256_cvtepu8_epi32(Hi), _mm256_cvtepu8_epi32(_mm_srli_si128(Hi, 8)),
+    };
+
+    __m256i Channels[4];
+    for(int Pair = 0; Pair < 4; ++Pair)
+    {
+        if(SourceIsPremultiplied)
+        {
+            __m256i Alpha = _mm256_shuffle_epi32(Bytes[Pair], 0xFF);
+            __m256i Unpremultiply = _mm256_i32gather_epi32((int *)UnpremultiplyFactor, Alpha, 4);
+            __m256i Unpremultiplied = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(Bytes[Pair], Unpremultiply),
+                                                                         _mm256_set1_epi32(0x8000)), 16);
+            Unpremultiplied = _mm256_min_epu32(Unpremultiplied, _mm256_set1_epi32(255));
+            Unpremultiplied = _mm256_blend_epi32(Unpremultiplied, Bytes[Pair], 0x88);
+
+            __m256i Premultiply = _mm256_i32gather_epi32((int *)PremultiplyFactor, Alpha, 2);
+            Premultiply = _mm256_and_si256(Premultiply, _mm256_set1_epi32(0xFFFF));
+            Premultiply = _mm256_blend_epi32(Premultiply, _mm256_set1_epi32(32768), 0x88);
+            Channels[Pair] = _mm256_srli_epi32(_mm256_mullo_epi32(GatherLinear15AVX2(Unpremultiplied), Premultiply), 15);
+        }
+        else
+        {
+            Channels[Pair] = GatherLinear15AVX2(Bytes[Pair]);
+        }
+    }
+
+    //packus works within each 128 bit half, which leaves the pixels 0, 2, 1, 3: the permute puts them back
+    __m256i First = _mm256_permute4x64_epi64(_mm256_packus_epi32(Channels[0], Channels[1]), 0xD8);
+    __m256i Second = _mm256_permute4x64_epi64(_mm256_packus_epi32(Channels[2], Channels[3]), 0xD8);
+    _mm256_storeu_si256((__m256i *)Linear, First);
+    _mm256_storeu_si256((__m256i *)(Linear + 16), Second);
+}
+
+//32 channels of 15 bit linear back to 8 pixels
+TARGET_AVX2 inline __m256i PixelsFromLinearAVX2(uint16 *Linear)
+{
+    __m256i AlphaHalf = _mm256_setr_epi32(0, 0, 0, 4096, 0, 0, 0, 4096);
+    __m256i Bytes[4];
+    for(int Pair = 0; Pair < 4; ++Pair)
+    {
+        __m256i Channels = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)(Linear + 8*Pair)));
+        __m256i Index = _mm256_add_epi32(_mm256_srli_epi32(Channels, 3), AlphaHalf);
+        Bytes[Pair] = _mm256_and_si256(_mm256_i32gather_epi32((int *)Linear15ToByte, Index, 1), _mm256_set1_epi32(0xFF));
+    }
+
+    //Pixels come out of the packs 0, 2, 4, 6, 1, 3, 5, 7
+    __m256i Result = _mm256_packus_epi16(_mm256_packus_epi32(Bytes[0], Bytes[1]), _mm256_packus_epi32(Bytes[2], Bytes[3]));
+    Result = _mm256_permutevar8x32_epi32(Result, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    return(Result);
+}
+
+template<typename format>
+internal void DrawSpanLinearScalar(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count,
+                                   bool32 BlendWithSSE2)
+{
+    uint16 DestLinear[4*LINEAR_BLEND_CHUNK];
+    uint16 SourceLinear[4*LINEAR_BLEND_CHUNK];
+    if(!Source)
+    {
+        LinearFromSource(Color, SourceLinear);
+        for(int X = 1; X < LINEAR_BLEND_CHUNK; ++X)
+        {
+            memcpy(SourceLinear + 4*X, SourceLinear, 4*sizeof(uint16));
+        }
+    }
+
+    for(int ChunkX = 0; ChunkX < Count; ChunkX += LINEAR_BLEND_CHUNK)
+    {
+        int ChunkCount = ((Count - ChunkX) < LINEAR_BLEND_CHUNK) ? (Count - ChunkX) : LINEAR_BLEND_CHUNK;
+        for(int X = 0; X < ChunkCount; ++X)
+        {
+            LinearFromDest(format::Unpack(Dest[ChunkX + X]), DestLinear + 4*X);
+        }
+        if(Source)
+        {
+            for(int X = 0; X < ChunkCount; ++X)
+            {
+                LinearFromSource(Source[ChunkX + X], SourceLinear + 4*X);
+            }
+        }
+
+        if(BlendWithSSE2)
+        {
+            BlendLinearChunkSSE2(DestLinear, SourceLinear, ChunkCount);
+        }
+        else
+        {
+            BlendLinearChunkScalar(DestLinear, SourceLinear, ChunkCount);
+        }
+
+        for(int X = 0; X < ChunkCount; ++X)
+        {
+            Dest[ChunkX + X] = format::Pack(SRGBFromLinear(DestLinear + 4*X));
+        }
+    }
+}
+
+//The conversions are table lookups, which SSE2 has no instruction for, so only the blend pass is SIMD
+template<typename format>
+internal void DrawSpanLinearSSE2(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    DrawSpanLinearScalar<format>(Dest, Source, Color, Count, true);
+}
+
+//AVX2 has gathers, so the conversions go 8 pixels at a time too. Chunks that don't come to a multiple of 8 pixels
+//(the end of a span) convert what is left one pixel at a time.
+template<typename format>
+TARGET_AVX2 internal void DrawSpanLinearAVX2(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    uint16 DestLinear[4*LINEAR_BLEND_CHUNK];
+    uint16 SourceLinear[4*LINEAR_BLEND_CHUNK];
+    if(!Source)
+    {
+        LinearFromSource(Color, SourceLinear);
+        for(int X = 1; X < LINEAR_BLEND_CHUNK; ++X)
+        {
+            memcpy(SourceLinear + 4*X, SourceLinear, 4*sizeof(uint16));
+        }
+    }
+
+    for(int ChunkX = 0; ChunkX < Count; ChunkX += LINEAR_BLEND_CHUNK)
+    {
+        int ChunkCount = ((Count - ChunkX) < LINEAR_BLEND_CHUNK) ? (Count - ChunkX) : LINEAR_BLEND_CHUNK;
+        int X = 0;
+        for(; X + 8 <= ChunkCount; X += 8)
+        {
+            LinearFromPixelsAVX2(format::LoadAVX2(Dest + ChunkX + X), DestLinear + 4*X, false);
+            if(Source)
+            {
+                LinearFromPixelsAVX2(_mm256_loadu_si256((__m256i *)(Source + ChunkX + X)), SourceLinear + 4*X, true);
+            }
+        }
+        for(; X < ChunkCount; ++X)
+        {
+            LinearFromDest(format::Unpack(Dest[ChunkX + X]), DestLinear + 4*X);
+            if(Source)
+            {
+                LinearFromSource(Source[ChunkX + X], SourceLinear + 4*X);
+            }
+        }
+
+        BlendLinearChunkAVX2(DestLinear, SourceLinear, ChunkCount);
+
+        X = 0;
+        for(; X + 8 <= ChunkCount; X += 8)
+        {
+            format::StoreAVX2(Dest + ChunkX + X, PixelsFromLinearAVX2(DestLinear + 4*X));
+        }
+        for(; X < ChunkCount; ++X)
+        {
+            Dest[ChunkX + X] = format::Pack(SRGBFromLinear(DestLinear + 4*X));
+        }
+    }
+}
+
+template<typename format>
+internal void DrawSpanLinearTranslucent(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2:
+        {
+            DrawSpanLinearAVX2<format>(Dest, Source, Color, Count);
+        } break;
+
+        case SIMDLevel_SSE2:
+        {
+            DrawSpanLinearSSE2<format>(Dest, Source, Color, Count);
+        } break;
+
+        default:
+        {
+            DrawSpanLinearScalar<format>(Dest, Source, Color, Count, false);
+        } break;
+    }
+}
+
+//An opaque pixel comes out of the blend as it went in, and a clear one leaves Dest as it was, so a bitmap's span is
+//split into runs and only the translucent ones (the edges of a sprite, say) pay for going through linear. Opaque runs
+//blend in sRGB, which gives the same bytes without the conversions.
+template<typename format>
+internal void DrawSpanLinear(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    if(Source)
+    {
+        int X = 0;
+        while(X < Count)
+        {
+            uint32 First = Source[X];
+            int RunEnd = X + 1;
+            if(First == 0)
+            {
+                while((RunEnd < Count) && (Source[RunEnd] == 0))
+                {
+                    ++RunEnd;
+                }
+            }
+            else if((First >> 24) == 0xFF)
+            {
+                while((RunEnd < Count) && ((Source[RunEnd] >> 24) == 0xFF))
+                {
+                    ++RunEnd;
+                }
+                DrawSpanSRGB<format>(Dest + X, Source + X, 0, RunEnd - X);
+            }
+            else
+            {
+                while((RunEnd < Count) && Source[RunEnd] && ((Source[RunEnd] >> 24) != 0xFF))
+                {
+                    ++RunEnd;
+                }
+                DrawSpanLinearTranslucent<format>(Dest + X, Source + X, 0, RunEnd - X);
+            }
+            X = RunEnd;
+        }
+    }
+    else
+    {
+        DrawSpanLinearTranslucent<format>(Dest, 0, Color, Count);
+    }
+}
+
+//Blending one color, each channel that comes out depends on nothing but the same channel of Dest, so the whole blend
+//is a byte to byte table per channel: exactly what DrawSpanLinear would have written, at 4 lookups a pixel
+internal void BuildLinearColorTable(uint32 Color, uint8 Table[4][256])
+{
+    uint16 Source[4];
+    LinearFromSource(Color, Source);
+    for(uint32 Byte = 0; Byte < 256; ++Byte)
+    {
+        for(int Channel = 0; Channel < 3; ++Channel)
+        {
+            Table[Channel][Byte] = Linear15ToByte[BlendLinear15(SRGBToLinear15[Byte], Source[Channel], Source[3]) >> 3];
+        }
+        Table[3][Byte] = Linear15ToByte[4096 + (BlendLinear15(SRGBToLinear15[256 + Byte], Source[3], Source[3]) >> 3)];
+    }
+}
+
+template<typename format>
+internal void DrawSpanThroughTable(typename format::pixel *Dest, uint8 Table[4][256], int Count)
+{
+    for(int X = 0; X < Count; ++X)
+    {
+        uint32 Pixel = format::Unpack(Dest[X]);
+        Dest[X] = format::Pack((uint32)Table[0][Pixel & 0xFF] |
+                               ((uint32)Table[1][(Pixel >> 8) & 0xFF] << 8) |
+                               ((uint32)Table[2][(Pixel >> 16) & 0xFF] << 16) |
+                               ((uint32)Table[3][Pixel >> 24] << 24));
+    }
+}
+
+//Opaque color spans are the same in either blend space, so they always take the fast fill
+template<typename format>
+internal void DrawSpan(typename format::pixel *Dest, uint32 *Source, uint32 Color, int Count)
+{
+    if((GlobalBlendSpace == BlendSpace_Linear) && (Source || ((Color >> 24) != 0xFF)))
+    {
+        DrawSpanLinear<format>(Dest, Source, Color, Count);
+    }
+    else
+    {
+        DrawSpanSRGB<format>(Dest, Source, Color, Count);
+    }
+}
+
+//The part of ClipRect that is inside the buffer, the only pixels a primitive may touch
+internal rectangle2i ClipToBuffer(game_offscreen_buffer *Buffer, rectangle2i ClipRect)
+{
+    rectangle2i Result = Intersect(ClipRect, RectangleFromBuffer(Buffer));
+    return(Result);
+}
+
+internal void InitializeTiledBackground(tiled_background *Background, memory_arena *Arena, int Width, int Height)
+{
+    *Background = {};
+    Background->Width = Width;
+    Background->Height = Height;
+    Background->Memory = PushSize(Arena, (memory_index)2*Width*Height*4);
+}
+
+//The first period of the tile, for the caller to draw one period of the background into. Nothing can be copied out
+//of the tile again until EndTiledBackground.
+internal game_offscreen_buffer BeginTiledBackground(tiled_background *Background, pixel_format Format)
+{
+    Background->IsDrawn = false;
+    Background->Format = Format;
+    Background->Pitch = 2*Background->Width*GetBytesPerPixel(Format);
+
+    game_offscreen_buffer Result = {};
+    Result.Memory = Background->Memory;
+    Result.Width = Background->Width;
+    Result.Height = Background->Height;
+    Result.Pitch = Background->Pitch;
+    Result.Format = Format;
+    return(Result);
+}
+
+//Repeats the period that was drawn once to its right
+internal void EndTiledBackground(tiled_background *Background)
+{
+    memory_index PeriodSize = (memory_index)Background->Width*GetBytesPerPixel(Background->Format);
+    uint8 *Row = (uint8 *)Background->Memory;
+    for(int Y = 0; Y < Background->Height; ++Y)
+    {
+        memcpy(Row + PeriodSize, Row, PeriodSize);
+        Row += Background->Pitch;
+    }
+    Background->IsDrawn = true;
+}
+
+internal bool32 TiledBackgroundIsDrawn(tiled_background *Background, pixel_format Format)
+{
+    bool32 Result = (Background->IsDrawn && (Background->Format == Format));
+    return(Result);
+}
+
+//Into 0 up to Period, whichever side of zero Value is on
+inline int WrapToPeriod(int Value, int Period)
+{
+    int Result = Value % Period;
+    Result += (Result < 0) ? Period : 0;
+    return(Result);
+}
+
+/*
+    Pixel (X, Y) of the buffer is pixel (X + XOffset, Y + YOffset) of the endless background, the same as the gradient's
+    offsets, so scrolling costs nothing: only where in the tile each row starts changes. Every row is the same span
+    of the tile, one period at a time, so this is as fast as the buffer can be written, whatever the format.
+*/
+internal void DrawTiledBackground(game_offscreen_buffer *Buffer, tiled_background *Background, int XOffset, int YOffset,
+                                  rectangle2i ClipRect)
+{
+    Assert(TiledBackgroundIsDrawn(Background, Buffer->Format));
+
+    rectangle2i Clip = ClipToBuffer(Buffer, ClipRect);
+    if((Clip.MinX < Clip.MaxX) && (Clip.MinY < Clip.MaxY))
+    {
+        TIMED_FUNCTION((Clip.MaxX - Clip.MinX)*(Clip.MaxY - Clip.MinY));
+
+        int BytesPerPixel = GetBytesPerPixel(Buffer->Format);
+        memory_index PeriodSize = (memory_index)Background->Width*BytesPerPixel;
+        memory_index RowSize = (memory_index)(Clip.MaxX - Clip.MinX)*BytesPerPixel;
+        uint8 *SourceColumn = (uint8 *)Background->Memory + WrapToPeriod(Clip.MinX + XOffset, Background->Width)*BytesPerPixel;
+        int SourceY = WrapToPeriod(Clip.MinY + YOffset, Background->Height);
+
+        uint8 *DestRow = (uint8 *)Buffer->Memory + (memory_index)Clip.MinX*BytesPerPixel + (memory_index)Clip.MinY*Buffer->Pitch;
+        for(int Y = Clip.MinY; Y < Clip.MaxY; ++Y)
+        {
+            uint8 *Source = SourceColumn + (memory_index)SourceY*Background->Pitch;
+            uint8 *Dest = DestRow;
+            for(memory_index SizeLeft = RowSize; SizeLeft;)
+            {
+                memory_index Size = (SizeLeft < PeriodSize) ? SizeLeft : PeriodSize;
+                memcpy(Dest, Source, Size);
+                Dest += Size;
+                SizeLeft -= Size;
+            }
+
+            SourceY = (SourceY + 1 < Background->Height) ? SourceY + 1 : 0;
+            DestRow += Buffer->Pitch;
+        }
+    }
+}
+
+//Fills the pixels whose centers are inside [Min, Max), so rectangles that share an edge never overlap or leave a gap
+template<typename format>
+internal void DrawRectangle(game_offscreen_buffer *Buffer, v2 vMin, v2 vMax, v4 Color, rectangle2i ClipRect)
+{
+    rectangle2i Clip = ClipToBuffer(Buffer, ClipRect);
+    int32 MinX = RoundReal32ToInt32(vMin.X);
+    int32 MinY = RoundReal32ToInt32(vMin.Y);
+    int32 MaxX = RoundReal32ToInt32(vMax.X);
+    int32 MaxY = RoundReal32ToInt32(vMax.Y);
+
+    MinX = (MinX < Clip.MinX) ? Clip.MinX : MinX;
+    MinY = (MinY < Clip.MinY) ? Clip.MinY : MinY;
+    MaxX = (MaxX > Clip.MaxX) ? Clip.MaxX : MaxX;
+    MaxY = (MaxY > Clip.MaxY) ? Clip.MaxY : MaxY;
+
+    typedef typename format::pixel pixel;
+    uint32 PackedColor = PackColor(Color);
+    uint8 *Row = (uint8 *)Buffer->Memory + MinX*sizeof(pixel) + (memory_index)MinY*Buffer->Pitch;
+    bool32 LinearThroughTable = ((GlobalBlendSpace == BlendSpace_Linear) && ((PackedColor >> 24) != 0xFF) &&
+                                 (MaxX > MinX) && (MaxY > MinY) && ((MaxX - MinX)*(MaxY - MinY) >= LINEAR_TABLE_MIN_PIXELS));
+    if(LinearThroughTable)
+    {
+        uint8 Table[4][256];
+        BuildLinearColorTable(PackedColor, Table);
+        for(int Y = MinY; Y < MaxY; ++Y)
+        {
+            DrawSpanThroughTable<format>((pixel *)Row, Table, MaxX - MinX);
+            Row += Buffer->Pitch;
+        }
+    }
+    else
+    {
+        for(int Y = MinY; Y < MaxY; ++Y)
+        {
+            DrawSpan<format>((pixel *)Row, 0, PackedColor, MaxX - MinX);
+            Row += Buffer->Pitch;
+        }
+    }
+}
+
+//Top left corner at Position, snapped to the nearest pixel
+template<typename format>
+internal void DrawBitmap(game_offscreen_buffer *Buffer, loaded_bitmap *Bitmap, v2 Position, rectangle2i ClipRect)
+{
+    rectangle2i Clip = ClipToBuffer(Buffer, ClipRect);
+    int32 MinX = RoundReal32ToInt32(Position.X);
+    int32 MinY = RoundReal32ToInt32(Position.Y);
+    int32 MaxX = MinX + Bitmap->Width;
+    int32 MaxY = MinY + Bitmap->Height;
+
+    //Whatever is clipped off the top and left is skipped in the bitmap too
+    int32 SourceOffsetX = 0;
+    int32 SourceOffsetY = 0;
+    if(MinX < Clip.MinX)
+    {
+        SourceOffsetX = Clip.MinX - MinX;
+        MinX = Clip.MinX;
+    }
+    if(MinY < Clip.MinY)
+    {
+        SourceOffsetY = Clip.MinY - MinY;
+        MinY = Clip.MinY;
+    }
+    MaxX = (MaxX > Clip.MaxX) ? Clip.MaxX : MaxX;
+    MaxY = (MaxY > Clip.MaxY) ? Clip.MaxY : MaxY;
+
+    typedef typename format::pixel pixel;
+    uint8 *SourceRow = (uint8 *)Bitmap->Memory + SourceOffsetX*4 + (memory_index)SourceOffsetY*Bitmap->Pitch;
+    uint8 *DestRow = (uint8 *)Buffer->Memory + MinX*sizeof(pixel) + (memory_index)MinY*Buffer->Pitch;
+    for(int Y = MinY; Y < MaxY; ++Y)
+    {
+        DrawSpan<format>((pixel *)DestRow, (uint32 *)SourceRow, 0, MaxX - MinX);
+        DestRow += Buffer->Pitch;
+        SourceRow += Bitmap->Pitch;
+    }
+}
+
+/*
+    Textured quads. The quad is Origin + U*XAxis + V*YAxis for U and V in 0..1, with XAxis and YAxis at right angles
+    (any length and rotation). Every pixel center in its bounding box is projected onto the two axes to get its U and V,
+    and the texture is sampled there with bilinear filtering, treating texel i as centered on i + 0.5 and clamping at
+    the edges. The texture is tinted by the (premultiplied) Color and blended like everything else, in float32.
+
+    The SIMD paths do 4 or 8 pixels of a row at a time with exactly the scalar path's operations in the same order.
+    SSE2 leaves the last few pixels of a row to the scalar path; AVX2 masks off the lanes past the end instead, since
+    on a rotated sprite those tails are a good part of every row.
+*/
+
+struct textured_quad
+{
+    int MinX;
+    int MinY;
+    int MaxX;
+    int MaxY;
+
+    v2 Origin;
+    v2 nXAxis; //NOTE(Robin) The axes divided by their length squared, so a dot product with them gives U and V directly
+    v2 nYAxis;
+    float32 Tint[4]; //NOTE(Robin) In memory order: B, G, R, A
+
+    loaded_bitmap *Texture;
+    float32 TextureWidth;
+    float32 TextureHeight;
+    float32 MaxTexelX; //NOTE(Robin) Width - 1, the last texel center a sample can clamp to
+    float32 MaxTexelY;
+    float32 MaxX0; //NOTE(Robin) Width - 2, so the right hand texel of the 2x2 block is always in the texture
+    float32 MaxY0;
+};
+
+template<typename format>
+internal void DrawTexturedQuadPixel(textured_quad *Quad, int X, float32 dY, typename format::pixel *Pixel)
+{
+    float32 dX = ((float32)X + 0.5f) - Quad->Origin.X;
+    float32 U = dX*Quad->nXAxis.X + dY*Quad->nXAxis.Y;
+    float32 V = dX*Quad->nYAxis.X + dY*Quad->nYAxis.Y;
+    if((U >= 0.0f) && (U <= 1.0f) && (V >= 0.0f) && (V <= 1.0f))
+    {
+        //The same clamps as _mm_max_ps and _mm_min_ps, so the SIMD paths get the same answer
+        float32 tX = U*Quad->TextureWidth - 0.5f;
+        float32 tY = V*Quad->TextureHeight - 0.5f;
+        tX = (tX > 0.0f) ? tX : 0.0f;
+        tY = (tY > 0.0f) ? tY : 0.0f;
+        tX = (tX < Quad->MaxTexelX) ? tX : Quad->MaxTexelX;
+        tY = (tY < Quad->MaxTexelY) ? tY : Quad->MaxTexelY;
+
+        float32 X0 = (float32)(int32)tX;
+        float32 Y0 = (float32)(int32)tY;
+        X0 = (X0 < Quad->MaxX0) ? X0 : Quad->MaxX0;
+        Y0 = (Y0 < Quad->MaxY0) ? Y0 : Quad->MaxY0;
+        float32 fX = tX - X0;
+        float32 fY = tY - Y0;
+        float32 InvfX = 1.0f - fX;
+        float32 InvfY = 1.0f - fY;
+
+        loaded_bitmap *Texture = Quad->Texture;
+        uint8 *TexelPtr = (uint8 *)Texture->Memory + (int32)X0*4 + (memory_index)(int32)Y0*Texture->Pitch;
+        uint32 TexelA = *(uint32 *)TexelPtr;
+        uint32 TexelB = *(uint32 *)(TexelPtr + 4);
+        uint32 TexelC = *(uint32 *)(TexelPtr + Texture->Pitch);
+        uint32 TexelD = *(uint32 *)(TexelPtr + Texture->Pitch + 4);
+
+        float32 Texel[4];
+        for(int Channel = 0; Channel < 4; ++Channel)
+        {
+            int Shift = 8*Channel;
+            float32 Top = InvfX*(float32)((TexelA >> Shift) & 0xFF) + fX*(float32)((TexelB >> Shift) & 0xFF);
+            float32 Bottom = InvfX*(float32)((TexelC >> Shift) & 0xFF) + fX*(float32)((TexelD >> Shift) & 0xFF);
+            Texel[Channel] = (InvfY*Top + fY*Bottom)*Quad->Tint[Channel];
+        }
+
+        float32 InvAlpha = 1.0f - Texel[3]*(1.0f/255.0f);
+        uint32 Dest = format::Unpack(*Pixel);
+        uint32 Result = 0;
+        for(int Channel = 0; Channel < 4; ++Channel)
+        {
+            int Shift = 8*Channel;
+            float32 Blended = Texel[Channel] + InvAlpha*(float32)((Dest >> Shift) & 0xFF);
+            Blended = (Blended < 255.0f) ? Blended : 255.0f;
+            Result |= (uint32)(int32)(Blended + 0.5f) << Shift;
+        }
+        *Pixel = format::Pack(Result);
+    }
+}
+
+//The rows functions draw pixels MinX up to MaxX of row Y of the quad, Pixels being the one at MinX
+template<typename format>
+internal void DrawTexturedQuadRowScalar(textured_quad *Quad, int Y, int MinX, int MaxX, typename format::pixel *Pixels)
+{
+    float32 dY = ((float32)Y + 0.5f) - Quad->Origin.Y;
+    for(int X = MinX; X < MaxX; ++X)
+    {
+        DrawTexturedQuadPixel<format>(Quad, X, dY, Pixels + (X - MinX));
+    }
+}
+
+#define UnpackChannelSSE2(Pixels, Shift) _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(Pixels, Shift), MaskFF))
+#define BilinearSSE2(A, B, C, D) _mm_add_ps(_mm_mul_ps(InvfY, _mm_add_ps(_mm_mul_ps(InvfX, A), _mm_mul_ps(fX, B))), \
+                                            _mm_mul_ps(fY, _mm_add_ps(_mm_mul_ps(InvfX, C), _mm_mul_ps(fX, D))))
+
+template<typename format>
+internal void DrawTexturedQuadRowSSE2(textured_quad *Quad, int Y, int MinX, int MaxX, typename format::pixel *Pixels)
+{
+    loaded_bitmap *Texture = Quad->Texture;
+
+    __m128 Zero = _mm_set1_ps(0.0f);
+    __m128 One = _mm_set1_ps(1.0f);
+    __m128 Half = _mm_set1_ps(0.5f);
+    __m128 Four = _mm_set1_ps(4.0f);
+    __m128 Max255 = _mm_set1_ps(255.0f);
+    __m128 Inv255 = _mm_set1_ps(1.0f/255.0f);
+    __m128i MaskFF = _mm_set1_epi32(0xFF);
+    __m128 OriginX = _mm_set1_ps(Quad->Origin.X);
+    __m128 nXAxisX = _mm_set1_ps(Quad->nXAxis.X);
+    __m128 nYAxisX = _mm_set1_ps(Quad->nYAxis.X);
+    __m128 TextureWidth = _mm_set1_ps(Quad->TextureWidth);
+    __m128 TextureHeight = _mm_set1_ps(Quad->TextureHeight);
+    __m128 MaxTexelX = _mm_set1_ps(Quad->MaxTexelX);
+    __m128 MaxTexelY = _mm_set1_ps(Quad->MaxTexelY);
+    __m128 MaxX0 = _mm_set1_ps(Quad->MaxX0);
+    __m128 MaxY0 = _mm_set1_ps(Quad->MaxY0);
+    __m128 TintB = _mm_set1_ps(Quad->Tint[0]);
+    __m128 TintG = _mm_set1_ps(Quad->Tint[1]);
+    __m128 TintR = _mm_set1_ps(Quad->Tint[2]);
+    __m128 TintA = _mm_set1_ps(Quad->Tint[3]);
+
+    float32 dY = ((float32)Y + 0.5f) - Quad->Origin.Y;
+    __m128 dYnXAxisY = _mm_set1_ps(dY*Quad->nXAxis.Y);
+    __m128 dYnYAxisY = _mm_set1_ps(dY*Quad->nYAxis.Y);
+
+    int X = MinX;
+    __m128 PixelX = _mm_cvtepi32_ps(_mm_setr_epi32(X, X + 1, X + 2, X + 3));
+    for(; X + 4 <= MaxX; X += 4)
+    {
+        __m128 dX = _mm_sub_ps(_mm_add_ps(PixelX, Half), OriginX);
+        PixelX = _mm_add_ps(PixelX, Four);
+        __m128 U = _mm_add_ps(_mm_mul_ps(dX, nXAxisX), dYnXAxisY);
+        __m128 V = _mm_add_ps(_mm_mul_ps(dX, nYAxisX), dYnYAxisY);
+        __m128 Inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(U, Zero), _mm_cmple_ps(U, One)),
+                                   _mm_and_ps(_mm_cmpge_ps(V, Zero), _mm_cmple_ps(V, One)));
+        if(_mm_movemask_ps(Inside) == 0)
+        {
+            continue;
+        }
+
+        __m128 tX = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(U, TextureWidth), Half), Zero), MaxTexelX);
+        __m128 tY = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(V, TextureHeight), Half), Zero), MaxTexelY);
+        __m128 X0 = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(tX)), MaxX0);
+        __m128 Y0 = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(tY)), MaxY0);
+        __m128 fX = _mm_sub_ps(tX, X0);
+        __m128 fY = _mm_sub_ps(tY, Y0);
+        __m128 InvfX = _mm_sub_ps(One, fX);
+        __m128 InvfY = _mm_sub_ps(One, fY);
+
+        //SSE2 has no gather, so the 16 texels are fetched one at a time
+        int32 TexelX[4];
+        int32 TexelY[4];
+        _mm_storeu_si128((__m128i *)TexelX, _mm_cvttps_epi32(X0));
+        _mm_storeu_si128((__m128i *)TexelY, _mm_cvttps_epi32(Y0));
+        uint32 Fetched[4][4];
+        for(int Lane = 0; Lane < 4; ++Lane)
+        {
+            uint8 *TexelPtr = (uint8 *)Texture->Memory + TexelX[Lane]*4 + (memory_index)TexelY[Lane]*Texture->Pitch;
+            Fetched[0][Lane] = *(uint32 *)TexelPtr;
+            Fetched[1][Lane] = *(uint32 *)(TexelPtr + 4);
+            Fetched[2][Lane] = *(uint32 *)(TexelPtr + Texture->Pitch);
+            Fetched[3][Lane] = *(uint32 *)(TexelPtr + Texture->Pitch + 4);
+        }
+        __m128i TexelA = _mm_loadu_si128((__m128i *)Fetched[0]);
+        __m128i TexelB = _mm_loadu_si128((__m128i *)Fetched[1]);
+        __m128i TexelC = _mm_loadu_si128((__m128i *)Fetched[2]);
+        __m128i TexelD = _mm_loadu_si128((__m128i *)Fetched[3]);
+
+        __m128 TexelBlue = _mm_mul_ps(BilinearSSE2(UnpackChannelSSE2(TexelA, 0), UnpackChannelSSE2(TexelB, 0),
+                                                   UnpackChannelSSE2(TexelC, 0), UnpackChannelSSE2(TexelD, 0)), TintB);
+        __m128 TexelGreen = _mm_mul_ps(BilinearSSE2(UnpackChannelSSE2(TexelA, 8), UnpackChannelSSE2(TexelB, 8),
+                                                    UnpackChannelSSE2(TexelC, 8), UnpackChannelSSE2(TexelD, 8)), TintG);
+        __m128 TexelRed = _mm_mul_ps(BilinearSSE2(UnpackChannelSSE2(TexelA, 16), UnpackChannelSSE2(TexelB, 16),
+                                                  UnpackChannelSSE2(TexelC, 16), UnpackChannelSSE2(TexelD, 16)), TintR);
+        __m128 TexelAlpha = _mm_mul_ps(BilinearSSE2(UnpackChannelSSE2(TexelA, 24), UnpackChannelSSE2(TexelB, 24),
+                                                    UnpackChannelSSE2(TexelC, 24), UnpackChannelSSE2(TexelD, 24)), TintA);
+
+        __m128i Dest = format::LoadSSE2(Pixels + (X - MinX));
+        __m128 InvAlpha = _mm_sub_ps(One, _mm_mul_ps(TexelAlpha, Inv255));
+        __m128 Blue = _mm_min_ps(_mm_add_ps(TexelBlue, _mm_mul_ps(InvAlpha, UnpackChannelSSE2(Dest, 0))), Max255);
+        __m128 Green = _mm_min_ps(_mm_add_ps(TexelGreen, _mm_mul_ps(InvAlpha, UnpackChannelSSE2(Dest, 8))), Max255);
+        __m128 Red = _mm_min_ps(_mm_add_ps(TexelRed, _mm_mul_ps(InvAlpha, UnpackChannelSSE2(Dest, 16))), Max255);
+        __m128 Alpha = _mm_min_ps(_mm_add_ps(TexelAlpha, _mm_mul_ps(InvAlpha, UnpackChannelSSE2(Dest, 24))), Max255);
+
+        __m128i Result = _mm_or_si128(_mm_or_si128(_mm_cvttps_epi32(_mm_add_ps(Blue, Half)),
+                                                   _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(Green, Half)), 8)),
+                                      _mm_or_si128(_mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(Red, Half)), 16),
+                                                   _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(Alpha, Half)), 24)));
+
+        //Pixels outside the quad keep what was there
+        __m128i Mask = _mm_castps_si128(Inside);
+        Result = _mm_or_si128(_mm_and_si128(Mask, Result), _mm_andnot_si128(Mask, Dest));
+        format::StoreSSE2(Pixels + (X - MinX), Result);
+    }
+
+    for(; X < MaxX; ++X)
+    {
+        DrawTexturedQuadPixel<format>(Quad, X, dY, Pixels + (X - MinX));
+    }
+}
+
+#define UnpackChannelAVX2(Pixels, Shift) _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(Pixels, Shift), MaskFF))
+#define BilinearAVX2(A, B, C, D) _mm256_add_ps(_mm256_mul_ps(InvfY, _mm256_add_ps(_mm256_mul_ps(InvfX, A), _mm256_mul_ps(fX, B))), \
+                                               _mm256_mul_ps(fY, _mm256_add_ps(_mm256_mul_ps(InvfX, C), _mm256_mul_ps(fX, D))))
+
+//Same as the SSE2 path 8 pixels wide, with the texels fetched by gathers and no scalar tail
+template<typename format>
+TARGET_AVX2 internal void DrawTexturedQuadRowAVX2(textured_quad *Quad, int Y, int MinX, int MaxX, typename format::pixel *Pixels)
+{
+    typedef typename format::pixel pixel;
+    loaded_bitmap *Texture = Quad->Texture;
+    Assert((Texture->Pitch % 4) == 0);
+    int *TexelBase = (int *)Texture->Memory;
+
+    __m256 Zero = _mm256_set1_ps(0.0f);
+    __m256 One = _mm256_set1_ps(1.0f);
+    __m256 Half = _mm256_set1_ps(0.5f);
+    __m256 Eight = _mm256_set1_ps(8.0f);
+    __m256 Max255 = _mm256_set1_ps(255.0f);
+    __m256 Inv255 = _mm256_set1_ps(1.0f/255.0f);
+    __m256i MaskFF = _mm256_set1_epi32(0xFF);
+    __m256i TexelOne = _mm256_set1_epi32(1);
+    __m256i LaneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i TexelRow = _mm256_set1_epi32(Texture->Pitch/4);
+    __m256 OriginX = _mm256_set1_ps(Quad->Origin.X);
+    __m256 nXAxisX = _mm256_set1_ps(Quad->nXAxis.X);
+    __m256 nYAxisX = _mm256_set1_ps(Quad->nYAxis.X);
+    __m256 TextureWidth = _mm256_set1_ps(Quad->TextureWidth);
+    __m256 TextureHeight = _mm256_set1_ps(Quad->TextureHeight);
+    __m256 MaxTexelX = _mm256_set1_ps(Quad->MaxTexelX);
+    __m256 MaxTexelY = _mm256_set1_ps(Quad->MaxTexelY);
+    __m256 MaxX0 = _mm256_set1_ps(Quad->MaxX0);
+    __m256 MaxY0 = _mm256_set1_ps(Quad->MaxY0);
+    __m256 TintB = _mm256_set1_ps(Quad->Tint[0]);
+    __m256 TintG = _mm256_set1_ps(Quad->Tint[1]);
+    __m256 TintR = _mm256_set1_ps(Quad->Tint[2]);
+    __m256 TintA = _mm256_set1_ps(Quad->Tint[3]);
+
+    float32 dY = ((float32)Y + 0.5f) - Quad->Origin.Y;
+    __m256 dYnXAxisY = _mm256_set1_ps(dY*Quad->nXAxis.Y);
+    __m256 dYnYAxisY = _mm256_set1_ps(dY*Quad->nYAxis.Y);
+
+    int X = MinX;
+    __m256 PixelX = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(X), LaneIndex));
+    for(; X < MaxX; X += 8)
+    {
+        //The last group of a row can run past MaxX, its extra lanes are masked off and never loaded or stored
+        int GroupCount = (X + 8 > MaxX) ? (MaxX - X) : 8;
+        __m256i ColumnMask = _mm256_cmpgt_epi32(_mm256_set1_epi32(MaxX - X), LaneIndex);
+
+        __m256 dX = _mm256_sub_ps(_mm256_add_ps(PixelX, Half), OriginX);
+        PixelX = _mm256_add_ps(PixelX, Eight);
+        __m256 U = _mm256_add_ps(_mm256_mul_ps(dX, nXAxisX), dYnXAxisY);
+        __m256 V = _mm256_add_ps(_mm256_mul_ps(dX, nYAxisX), dYnYAxisY);
+        __m256 Inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(U, Zero, _CMP_GE_OQ), _mm256_cmp_ps(U, One, _CMP_LE_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(V, Zero, _CMP_GE_OQ), _mm256_cmp_ps(V, One, _CMP_LE_OQ)));
+        Inside = _mm256_and_ps(Inside, _mm256_castsi256_ps(ColumnMask));
+        if(_mm256_movemask_ps(Inside) == 0)
+        {
+            continue;
+        }
+
+        __m256 tX = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_mul_ps(U, TextureWidth), Half), Zero), MaxTexelX);
+        __m256 tY = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_mul_ps(V, TextureHeight), Half), Zero), MaxTexelY);
+        __m256 X0 = _mm256_min_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(tX)), MaxX0);
+        __m256 Y0 = _mm256_min_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(tY)), MaxY0);
+        __m256 fX = _mm256_sub_ps(tX, X0);
+        __m256 fY = _mm256_sub_ps(tY, Y0);
+        __m256 InvfX = _mm256_sub_ps(One, fX);
+        __m256 InvfY = _mm256_sub_ps(One, fY);
+
+        //Texel indices, in pixels from the start of the texture. The clamps keep every lane in the texture,
+        //the lanes outside the quad included, so the gathers need no mask.
+        __m256i TexelIndex = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(Y0), TexelRow), _mm256_cvttps_epi32(X0));
+        __m256i TexelA = _mm256_i32gather_epi32(TexelBase, TexelIndex, 4);
+        __m256i TexelB = _mm256_i32gather_epi32(TexelBase, _mm256_add_epi32(TexelIndex, TexelOne), 4);
+        __m256i TexelC = _mm256_i32gather_epi32(TexelBase, _mm256_add_epi32(TexelIndex, TexelRow), 4);
+        __m256i TexelD = _mm256_i32gather_epi32(TexelBase, _mm256_add_epi32(_mm256_add_epi32(TexelIndex, TexelRow), TexelOne), 4);
+
+        __m256 TexelBlue = _mm256_mul_ps(BilinearAVX2(UnpackChannelAVX2(TexelA, 0), UnpackChannelAVX2(TexelB, 0),
+                                                      UnpackChannelAVX2(TexelC, 0), UnpackChannelAVX2(TexelD, 0)), TintB);
+        __m256 TexelGreen = _mm256_mul_ps(BilinearAVX2(UnpackChannelAVX2(TexelA, 8), UnpackChannelAVX2(TexelB, 8),
+                                                       UnpackChannelAVX2(TexelC, 8), UnpackChannelAVX2(TexelD, 8)), TintG);
+        __m256 TexelRed = _mm256_mul_ps(BilinearAVX2(UnpackChannelAVX2(TexelA, 16), UnpackChannelAVX2(TexelB, 16),
+                                                     UnpackChannelAVX2(TexelC, 16), UnpackChannelAVX2(TexelD, 16)), TintR);
+        __m256 TexelAlpha = _mm256_mul_ps(BilinearAVX2(UnpackChannelAVX2(TexelA, 24), UnpackChannelAVX2(TexelB, 24),
+                                                       UnpackChannelAVX2(TexelC, 24), UnpackChannelAVX2(TexelD, 24)), TintA);
+
+        //Only 32 bit lanes have masked loads and stores, so whatever the format a partial group goes through a copy
+        pixel Partial[8] = {};
+        pixel *GroupPixels = Pixels + (X - MinX);
+        if(GroupCount < 8)
+        {
+            for(int Lane = 0; Lane < GroupCount; ++Lane)
+            {
+                Partial[Lane] = GroupPixels[Lane];
+            }
+            GroupPixels = Partial;
+        }
+        __m256i Dest = format::LoadAVX2(GroupPixels);
+        __m256 InvAlpha = _mm256_sub_ps(One, _mm256_mul_ps(TexelAlpha, Inv255));
+        __m256 Blue = _mm256_min_ps(_mm256_add_ps(TexelBlue, _mm256_mul_ps(InvAlpha, UnpackChannelAVX2(Dest, 0))), Max255);
+        __m256 Green = _mm256_min_ps(_mm256_add_ps(TexelGreen, _mm256_mul_ps(InvAlpha, UnpackChannelAVX2(Dest, 8))), Max255);
+        __m256 Red = _mm256_min_ps(_mm256_add_ps(TexelRed, _mm256_mul_ps(InvAlpha, UnpackChannelAVX2(Dest, 16))), Max255);
+        __m256 Alpha = _mm256_min_ps(_mm256_add_ps(TexelAlpha, _mm256_mul_ps(InvAlpha, UnpackChannelAVX2(Dest, 24))), Max255);
+
+        __m256i Result = _mm256_or_si256(_mm256_or_si256(_mm256_cvttps_epi32(_mm256_add_ps(Blue, Half)),
+                                                         _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_add_ps(Green, Half)), 8)),
+                                         _mm256_or_si256(_mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_add_ps(Red, Half)), 16),
+                                                         _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_add_ps(Alpha, Half)), 24)));
+
+        __m256i Mask = _mm256_castps_si256(Inside);
+        Result = _mm256_blendv_epi8(Dest, Result, Mask);
+        format::StoreAVX2(GroupPixels, Result);
+        if(GroupCount < 8)
+        {
+            for(int Lane = 0; Lane < GroupCount; ++Lane)
+            {
+                Pixels[X - MinX + Lane] = Partial[Lane];
+            }
+        }
+    }
+}
+
+template<typename format>
+internal void DrawTexturedQuadRow(textured_quad *Quad, int Y, int MinX, int MaxX, typename format::pixel *Pixels)
+{
+    switch(GlobalSIMDLevel)
+    {
+        case SIMDLevel_AVX2:
+        {
+            DrawTexturedQuadRowAVX2<format>(Quad, Y, MinX, MaxX, Pixels);
+        } break;
+
+        case SIMDLevel_SSE2:
+        {
+            DrawTexturedQuadRowSSE2<format>(Quad, Y, MinX, MaxX, Pixels);
+        } break;
+
+        default:
+        {
+            DrawTexturedQuadRowScalar<format>(Quad, Y, MinX, MaxX, Pixels);
+        } break;
+    }
+}
+
+//The texture has to be at least 2x2. Color tints it, and is premultiplied like everything else.
+template<typename format>
+internal void DrawTexturedQuad(game_offscreen_buffer *Buffer, v2 Origin, v2 XAxis, v2 YAxis, v4 Color, loaded_bitmap *Texture,
+                               rectangle2i ClipRect)
+{
+    Assert((Texture->Width >= 2) && (Texture->Height >= 2));
+
+    textured_quad Quad;
+
+    //The bounding box of the four corners, in whole pixels, clipped to the buffer
+    v2 Corners[4] = {Origin, Origin + XAxis, Origin + YAxis, Origin + XAxis + YAxis};
+    float32 MinXf = Corners[0].X;
+    float32 MinYf = Corners[0].Y;
+    float32 MaxXf = Corners[0].X;
+    float32 MaxYf = Corners[0].Y;
+    for(int CornerIndex = 1; CornerIndex < 4; ++CornerIndex)
+    {
+        v2 Corner = Corners[CornerIndex];
+        MinXf = (Corner.X < MinXf) ? Corner.X : MinXf;
+        MinYf = (Corner.Y < MinYf) ? Corner.Y : MinYf;
+        MaxXf = (Corner.X > MaxXf) ? Corner.X : MaxXf;
+        MaxYf = (Corner.Y > MaxYf) ? Corner.Y : MaxYf;
+    }
+
+    //Clamped as floats first, so a quad far off screen can't overflow the conversion
+    rectangle2i Clip = ClipToBuffer(Buffer, ClipRect);
+    float32 ClipMinX = (float32)Clip.MinX;
+    float32 ClipMinY = (float32)Clip.MinY;
+    float32 ClipMaxX = (float32)Clip.MaxX;
+    float32 ClipMaxY = (float32)Clip.MaxY;
+    MinXf = (MinXf < ClipMinX) ? ClipMinX : ((MinXf > ClipMaxX) ? ClipMaxX : MinXf);
+    MinYf = (MinYf < ClipMinY) ? ClipMinY : ((MinYf > ClipMaxY) ? ClipMaxY : MinYf);
+    MaxXf = (MaxXf < ClipMinX) ? ClipMinX : ((MaxXf > ClipMaxX) ? ClipMaxX : MaxXf);
+    MaxYf = (MaxYf < ClipMinY) ? ClipMinY : ((MaxYf > ClipMaxY) ? ClipMaxY : MaxYf);
+    Quad.MinX = (int)floorf(MinXf);
+    Quad.MinY = (int)floorf(MinYf);
+    Quad.MaxX = (int)ceilf(MaxXf);
+    Quad.MaxY = (int)ceilf(MaxYf);
+
+    float32 XAxisLengthSq = Inner(XAxis, XAxis);
+    float32 YAxisLengthSq = Inner(YAxis, YAxis);
+    if((XAxisLengthSq <= 0.0f) || (YAxisLengthSq <= 0.0f))
+    {
+        return;
+    }
+
+    Quad.Origin = Origin;
+    Quad.nXAxis = (1.0f / XAxisLengthSq)*XAxis;
+    Quad.nYAxis = (1.0f / YAxisLengthSq)*YAxis;
+    Quad.Tint[0] = Color.B;
+    Quad.Tint[1] = Color.G;
+    Quad.Tint[2] = Color.R;
+    Quad.Tint[3] = Color.A;
+    Quad.Texture = Texture;
+    Quad.TextureWidth = (float32)Texture->Width;
+    Quad.TextureHeight = (float32)Texture->Height;
+    Quad.MaxTexelX = (float32)(Texture->Width - 1);
+    Quad.MaxTexelY = (float32)(Texture->Height - 1);
+    Quad.MaxX0 = (float32)(Texture->Width - 2);
+    Quad.MaxY0 = (float32)(Texture->Height - 2);
+
+    typedef typename format::pixel pixel;
+    uint8 *Row = (uint8 *)Buffer->Memory + (memory_index)Quad.MinY*Buffer->Pitch;
+    for(int Y = Quad.MinY; Y < Quad.MaxY; ++Y)
+    {
+        pixel *Pixels = (pixel *)Row;
+        if(GlobalBlendSpace == BlendSpace_Linear)
+        {
+            //Drawn over zeros, the float blend leaves just the texel, rounded. Those are then blended in linear like a
+            //bitmap's pixels, and the zeros outside the quad leave Dest alone.
+            for(int SegmentMinX = Quad.MinX; SegmentMinX < Quad.MaxX; SegmentMinX += LINEAR_QUAD_SEGMENT)
+            {
+                int SegmentMaxX = ((Quad.MaxX - SegmentMinX) < LINEAR_QUAD_SEGMENT) ? Quad.MaxX : (SegmentMinX + LINEAR_QUAD_SEGMENT);
+                uint32 Texels[LINEAR_QUAD_SEGMENT];
+                memset(Texels, 0, (SegmentMaxX - SegmentMinX)*sizeof(uint32));
+                DrawTexturedQuadRow<pixel_format_bgrx8888>(&Quad, Y, SegmentMinX, SegmentMaxX, Texels);
+                DrawSpanLinear<format>(Pixels + SegmentMinX, Texels, 0, SegmentMaxX - SegmentMinX);
+            }
+        }
+        else
+        {
+            DrawTexturedQuadRow<format>(&Quad, Y, Quad.MinX, Quad.MaxX, Pixels + Quad.MinX);
+        }
+        Row += Buffer->Pitch;
+    }
+}
+
+internal render_group *AllocateRenderGroup(memory_arena *Arena, memory_index MaxPushBufferSize)
+{
+    render_group *Result = PushStruct(Arena, render_group);
+    Result->MaxPushBufferSize = MaxPushBufferSize;
+    Result->PushBufferSize = 0;
+    Result->PushBufferBase = (uint8 *)PushSize(Arena, MaxPushBufferSize);
+    return(Result);
+}
+
+#define PushRenderElement(Group, type) (type *)PushRenderElement_(Group, sizeof(type), RenderEntryType_##type)
+inline void *PushRenderElement_(render_group *Group, memory_index Size, render_entry_type Type)
+{
+    void *Result = 0;
+
+    Size += sizeof(render_entry_header);
+    if((Group->PushBufferSize + Size) <= Group->MaxPushBufferSize)
+    {
+        render_entry_header *Header = (render_entry_header *)(Group->PushBufferBase + Group->PushBufferSize);
+        Header->Type = Type;
+        Result = (uint8 *)Header + sizeof(*Header);
+        Group->PushBufferSize += Size;
+    }
+    else
+    {
+        InvalidCodePath;
+    }
+
+    return(Result);
+}
+
+inline void PushGradient(render_group *Group, int XOffset, int YOffset)
+{
+    render_entry_gradient *Entry = PushRenderElement(Group, render_entry_gradient);
+    if(Entry)
+    {
+        Entry->XOffset = XOffset;
+        Entry->YOffset = YOffset;
+    }
+}
+
+//Has to be drawn, in the format of the buffer the group goes to, before the group is
+inline void PushTiledBackground(render_group *Group, tiled_background *Background, int XOffset, int YOffset)
+{
+    render_entry_tiled_background *Entry = PushRenderElement(Group, render_entry_tiled_background);
+    if(Entry)
+    {
+        Entry->Background = Background;
+        Entry->XOffset = XOffset;
+        Entry->YOffset = YOffset;
+    }
+}
+
+inline void PushRectangle(render_group *Group, v2 Min, v2 Max, v4 Color)
+{
+    render_entry_rectangle *Entry = PushRenderElement(Group, render_entry_rectangle);
+    if(Entry)
+    {
+        Entry->Min = Min;
+        Entry->Max = Max;
+        Entry->Color = Color;
+    }
+}
+
+inline void PushTileGrid(render_group *Group, uint8 *Tiles, int32 TileCountX, int32 TileCountY, int32 TileSide,
+                         int32 MinX, int32 MinY, v4 *Colors)
+{
+    render_entry_tile_grid *Entry = PushRenderElement(Group, render_entry_tile_grid);
+    if(Entry)
+    {
+        Entry->Tiles = Tiles;
+        Entry->TileCountX = TileCountX;
+        Entry->TileCountY = TileCountY;
+        Entry->TileSide = TileSide;
+        Entry->MinX = MinX;
+        Entry->MinY = MinY;
+        Entry->Colors = Colors;
+    }
+}
+
+inline void PushBitmap(render_group *Group, loaded_bitmap *Bitmap, v2 Position)
+{
+    render_entry_bitmap *Entry = PushRenderElement(Group, render_entry_bitmap);
+    if(Entry)
+    {
+        Entry->Bitmap = Bitmap;
+        Entry->Position = Position;
+    }
+}
+
+inline void PushTexturedQuad(render_group *Group, v2 Origin, v2 XAxis, v2 YAxis, v4 Color, loaded_bitmap *Texture)
+{
+    render_entry_textured_quad *Entry = PushRenderElement(Group, render_entry_textured_quad);
+    if(Entry)
+    {
+        Entry->Origin = Origin;
+        Entry->XAxis = XAxis;
+        Entry->YAxis = YAxis;
+        Entry->Color = Color;
+        Entry->Texture = Texture;
+    }
+}
+
+//Only the tiles that overlap the clip rectangle are looked at, a render tile's worth of them at most
+template<typename format>
+internal void DrawTileGrid(game_offscreen_buffer *Buffer, render_entry_tile_grid *Grid, rectangle2i ClipRect)
+{
+    rectangle2i Clip = ClipToBuffer(Buffer, ClipRect);
+    int32 Side = Grid->TileSide;
+    int32 MinTileX = (Clip.MinX > Grid->MinX) ? (Clip.MinX - Grid->MinX) / Side : 0;
+    int32 MinTileY = (Clip.MinY > Grid->MinY) ? (Clip.MinY - Grid->MinY) / Side : 0;
+    int32 MaxTileX = (Clip.MaxX > Grid->MinX) ? (Clip.MaxX - Grid->MinX + Side - 1) / Side : 0;
+    int32 MaxTileY = (Clip.MaxY > Grid->MinY) ? (Clip.MaxY - Grid->MinY + Side - 1) / Side : 0;
+    MaxTileX = (MaxTileX < Grid->TileCountX) ? MaxTileX : Grid->TileCountX;
+    MaxTileY = (MaxTileY < Grid->TileCountY) ? MaxTileY : Grid->TileCountY;
+
+    for(int32 TileY = MinTileY; TileY < MaxTileY; ++TileY)
+    {
+        uint8 *Tile = Grid->Tiles + TileY*Grid->TileCountX + MinTileX;
+        for(int32 TileX = MinTileX; TileX < MaxTileX; ++TileX)
+        {
+            uint8 Value = *Tile++;
+            if(Value)
+            {
+                v2 Min = V2((float32)(Grid->MinX + TileX*Side), (float32)(Grid->MinY + TileY*Side));
+                DrawRectangle<format>(Buffer, Min, Min + V2((float32)Side, (float32)Side), Grid->Colors[Value], Clip);
+            }
+        }
+    }
+}
+
+//Draws every entry, in order, touching only the pixels in ClipRect
+template<typename format>
+internal void RenderGroupToOutput(render_group *Group, game_offscreen_buffer *Buffer, rectangle2i ClipRect)
+{
+    TIMED_FUNCTION();
+
+    typedef typename format::pixel pixel;
+    rectangle2i Clip = ClipToBuffer(Buffer, ClipRect);
+    for(memory_index BaseAddress = 0; BaseAddress < Group->PushBufferSize;)
+    {
+        render_entry_header *Header = (render_entry_header *)(Group->PushBufferBase + BaseAddress);
+        BaseAddress += sizeof(*Header);
+        void *Data = (uint8 *)Header + sizeof(*Header);
+
+        switch(Header->Type)
+        {
+            case RenderEntryType_render_entry_gradient:
+            {
+                render_entry_gradient *Entry = (render_entry_gradient *)Data;
+
+                //The gradient has no clipping of its own, so it gets a buffer that is just the clip rectangle
+                if((Clip.MinX < Clip.MaxX) && (Clip.MinY < Clip.MaxY))
+                {
+                    game_offscreen_buffer ClipBuffer = *Buffer;
+                    ClipBuffer.Memory = (uint8 *)Buffer->Memory + Clip.MinX*sizeof(pixel) + (memory_index)Clip.MinY*Buffer->Pitch;
+                    ClipBuffer.Width = Clip.MaxX - Clip.MinX;
+                    ClipBuffer.Height = Clip.MaxY - Clip.MinY;
+                    RenderWeirdGradient<format>(&ClipBuffer, Entry->XOffset + Clip.MinX, Entry->YOffset + Clip.MinY);
+                }
+                BaseAddress += sizeof(*Entry);
+            } break;
+
+            case RenderEntryType_render_entry_tiled_background:
+            {
+                render_entry_tiled_background *Entry = (render_entry_tiled_background *)Data;
+                DrawTiledBackground(Buffer, Entry->Background, Entry->XOffset, Entry->YOffset, Clip);
+                BaseAddress += sizeof(*Entry);
+            } break;
+
+            case RenderEntryType_render_entry_rectangle:
+            {
+                render_entry_rectangle *Entry = (render_entry_rectangle *)Data;
+                DrawRectangle<format>(Buffer, Entry->Min, Entry->Max, Entry->Color, Clip);
+                BaseAddress += sizeof(*Entry);
+            } break;
+
+            case RenderEntryType_render_entry_tile_grid:
+            {
+                render_entry_tile_grid *Entry = (render_entry_tile_grid *)Data;
+                DrawTileGrid<format>(Buffer, Entry, Clip);
+                BaseAddress += sizeof(*Entry);
+            } break;
+
+            case RenderEntryType_render_entry_bitmap:
+            {
+                render_entry_bitmap *Entry = (render_entry_bitmap *)Data;
+                DrawBitmap<format>(Buffer, Entry->Bitmap, Entry->Position, Clip);
+                BaseAddress += sizeof(*Entry);
+            } break;
+
+            case RenderEntryType_render_entry_textured_quad:
+            {
+                render_entry_textured_quad *Entry = (render_entry_textured_quad *)Data;
+                DrawTexturedQuad<format>(Buffer, Entry->Origin, Entry->XAxis, Entry->YAxis, Entry->Color, Entry->Texture, Clip);
+                BaseAddress += sizeof(*Entry);
+            } break;
+
+            InvalidDefaultCase;
+        }
+    }
+}
+
+/*
+    The way in for everything outside the renderer: pick the format's loops from the buffer. A render group is drawn
+    with one format for all of its entries, so the switch happens once per group (once per tile), not per primitive.
+*/
+#define DispatchOnPixelFormat(Format, Function, ...) \
+    switch(Format) \
+    { \
+        case PixelFormat_BGRX8888: {Function<pixel_format_bgrx8888>(__VA_ARGS__);} break; \
+        case PixelFormat_RGBA8888: {Function<pixel_format_rgba8888>(__VA_ARGS__);} break; \
+        case PixelFormat_RGB565: {Function<pixel_format_rgb565>(__VA_ARGS__);} break; \
+        case PixelFormat_Indexed8: {Function<pixel_format_indexed8>(__VA_ARGS__);} break; \
+        InvalidDefaultCase; \
+    }
+
+internal void RenderWeirdGradient(game_offscreen_buffer *Buffer, int XOffset, int YOffset)
+{
+    DispatchOnPixelFormat(Buffer->Format, RenderWeirdGradient, Buffer, XOffset, YOffset);
+}
+
+//The gradient as a tiled_background, drawn again only if the buffers have changed format. Width and Height have to
+//be multiples of 256, the gradient's own period.
+internal void DrawGradientBackground(tiled_background *Background, pixel_format Format)
+{
+    Assert(((Background->Width % 256) == 0) && ((Background->Height % 256) == 0));
+
+    if(!TiledBackgroundIsDrawn(Background, Format))
+    {
+        game_offscreen_buffer Period = BeginTiledBackground(Background, Format);
+        RenderWeirdGradient(&Period, 0, 0);
+        EndTiledBackground(Background);
+    }
+}
+
+//Copying the tile reads a pixel for every one it writes, computing the gradient only writes, so for 32 bit pixels
+//the AVX2 gradient is already as fast as the buffer can be written and stays ahead of the copy (0.42 against 0.51 ms
+//at 1080p). Narrower pixels, or no AVX2, and the copy is the faster one: 2x for RGB565, 5x for Indexed8.
+internal bool32 GradientIsFasterCopied(pixel_format Format)
+{
+    bool32 Result = ((GetBytesPerPixel(Format) < 4) || (GlobalSIMDLevel < SIMDLevel_AVX2));
+    return(Result);
+}
+
+internal void DrawRectangle(game_offscreen_buffer *Buffer, v2 vMin, v2 vMax, v4 Color, rectangle2i ClipRect)
+{
+    DispatchOnPixelFormat(Buffer->Format, DrawRectangle, Buffer, vMin, vMax, Color, ClipRect);
+}
+
+internal void DrawBitmap(game_offscreen_buffer *Buffer, loaded_bitmap *Bitmap, v2 Position, rectangle2i ClipRect)
+{
+    DispatchOnPixelFormat(Buffer->Format, DrawBitmap, Buffer, Bitmap, Position, ClipRect);
+}
+
+internal void DrawTexturedQuad(game_offscreen_buffer *Buffer, v2 Origin, v2 XAxis, v2 YAxis, v4 Color, loaded_bitmap *Texture,
+                               rectangle2i ClipRect)
+{
+    DispatchOnPixelFormat(Buffer->Format, DrawTexturedQuad, Buffer, Origin, XAxis, YAxis, Color, Texture, ClipRect);
+}
+
+internal void RenderGroupToOutput(render_group *Group, game_offscreen_buffer *Buffer, rectangle2i ClipRect)
+{
+    DispatchOnPixelFormat(Buffer->Format, RenderGroupToOutput, Group, Buffer, ClipRect);
+}
+
+struct tile_render_work
+{
+    render_group *Group;
+    game_offscreen_buffer *Buffer;
+    rectangle2i ClipRect;
+};
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(DoTiledRenderWork)
+{
+    tile_render_work *Work = (tile_render_work *)Data;
+    RenderGroupToOutput(Work->Group, Work->Buffer, Work->ClipRect);
+}
+
+/*
+    Tiles are TILE_WIDTH pixels wide, a multiple of every SIMD width so only the last tile of a row has a tail, and
+    TILE_HEIGHT rows tall: 256x64 pixels is 64KB, which a core's L2 holds while every entry is drawn into it. At 1080p
+    that is 136 jobs, plenty for the work stealing to even out tiles that are slower than others (the ones with sprites).
+*/
+#define TILE_WIDTH 256
+#define TILE_HEIGHT 64
+#define MAX_RENDER_TILES 1024
+
+internal void TiledRenderGroupToOutput(platform_work_queue *Queue, platform_api *Platform, render_group *Group,
+                                       game_offscreen_buffer *Buffer)
+{
+    TIMED_FUNCTION();
+
+    if(!Queue)
+    {
+        RenderGroupToOutput(Group, Buffer, RectangleFromBuffer(Buffer));
+        return;
+    }
+
+    int TileWidth = TILE_WIDTH;
+    int TileHeight = TILE_HEIGHT;
+    int TileCountX = (Buffer->Width + TileWidth - 1) / TileWidth;
+    int TileCountY = (Buffer->Height + TileHeight - 1) / TileHeight;
+    while(TileCountX*TileCountY > MAX_RENDER_TILES)
+    {
+        //Only a buffer far bigger than any screen gets here, taller tiles it is
+        TileHeight *= 2;
+        TileCountY = (Buffer->Height + TileHeight - 1) / TileHeight;
+    }
+
+    tile_render_work WorkArray[MAX_RENDER_TILES];
+    int WorkCount = 0;
+    for(int TileY = 0; TileY < TileCountY; ++TileY)
+    {
+        for(int TileX = 0; TileX < TileCountX; ++TileX)
+        {
+            tile_render_work *Work = WorkArray + WorkCount++;
+            Work->Group = Group;
+            Work->Buffer = Buffer;
+            Work->ClipRect.MinX = TileX*TileWidth;
+            Work->ClipRect.MinY = TileY*TileHeight;
+            Work->ClipRect.MaxX = Work->ClipRect.MinX + TileWidth;
+            Work->ClipRect.MaxY = Work->ClipRect.MinY + TileHeight;
+
+            Platform->AddEntry(Queue, DoTiledRenderWork, Work);
+        }
+    }
+
+    Platform->CompleteAllWork(Queue);
+}
+
+//A soft edged disc with a color gradient across it, something to test the bitmap paths with until there are assets
+internal loaded_bitmap MakeTestSprite(memory_arena *Arena, int Width, int Height)
+{
+    loaded_bitmap Result;
+    Result.Width = Width;
+    Result.Height = Height;
+    Result.Pitch = Width*4;
+    Result.Memory = PushSize(Arena, (memory_index)Result.Pitch*Height);
+
+    uint8 *Row = (uint8 *)Result.Memory;
+    for(int Y = 0; Y < Height; ++Y)
+    {
+        uint32 *Pixel = (uint32 *)Row;
+        for(int X = 0; X < Width; ++X)
+        {
+            float32 U = ((float32)X + 0.5f) / (float32)Width;
+            float32 V = ((float32)Y + 0.5f) / (float32)Height;
+            float32 dX = 2.0f*U - 1.0f;
+            float32 dY = 2.0f*V - 1.0f;
+            float32 Alpha = 4.0f*(1.0f - sqrtf(dX*dX + dY*dY));
+            Alpha = (Alpha < 0.0f) ? 0.0f : ((Alpha > 1.0f) ? 1.0f : Alpha);
+
+            *Pixel++ = PackColor(V4(Alpha*U, Alpha*(1.0f - V), Alpha*0.75f, Alpha));
+        }
+        Row += Result.Pitch;
+    }
+
+    return(Result);
+}
@@ -0,0 +1,213 @@
+#if !defined(MIDNIGHT_MADNESS_RENDER_H)
+
+/*
+    Software renderer, drawing straight into the game_offscreen_buffer.
+
+    - Colors are premultiplied alpha everywhere: a v4 color is R, G, B, A in 0..1 with R, G, B already multiplied by A,
+      and bitmap pixels are 0xAARRGGBB the same way. Blending is then always Dest = Source + Dest*(1 - SourceAlpha).
+    - Rectangles and bitmaps snap to whole pixels and blend in integers, exactly: every SIMD path writes the same bytes
+      as the scalar one. They blend the sRGB bytes as they are, unless the platform picks BlendSpace_Linear, which
+      blends in linear light through lookup tables (see midnight_madness_render.cpp). Textured quads follow the same
+      choice, their texels going through the same blend. The gradient blends nothing.
+    - Textured quads are placed with sub-pixel precision: each pixel center is mapped into the texture, which is sampled
+      with bilinear filtering. The float math is done in the same order on every path, so they match exactly too.
+    - Every primitive is clipped to the buffer and to a clip rectangle, rows are Pitch bytes apart, and nothing is
+      written past a row's Width.
+    - The buffer can be in any pixel_format. Pixels are still computed as 0xAARRGGBB and only converted when they are
+      read from or written to the buffer, by loops compiled separately for every format, so for a given format every
+      path still writes the same bytes.
+
+    The game doesn't draw directly, it pushes what it wants drawn into a render_group, a push buffer in the frame's
+    transient memory. TiledRenderGroupToOutput then cuts the buffer into tiles and hands each one to the platform's
+    work queue as a job that draws the whole group clipped to that tile. A tile is a few dozen rows of a few hundred
+    pixels, so what a job touches stays in that core's cache while every entry is drawn into it, and since clipping
+    never changes how a pixel is computed the tiled frame is byte for byte the single threaded one.
+
+    A background that repeats, like the gradient (every 256x256 pixels), doesn't have to be computed every frame: one
+    period of it is drawn into a tiled_background once, and from then on it is copied out at whatever offset the frame
+    is scrolled to, a memcpy or two per row.
+*/
+
+struct v2
+{
+    float32 X;
+    float32 Y;
+};
+
+inline v2 V2(float32 X, float32 Y)
+{
+    v2 Result = {X, Y};
+    return(Result);
+}
+
+inline v2 operator+(v2 A, v2 B)
+{
+    v2 Result = {A.X + B.X, A.Y + B.Y};
+    return(Result);
+}
+
+inline v2 operator-(v2 A, v2 B)
+{
+    v2 Result = {A.X - B.X, A.Y - B.Y};
+    return(Result);
+}
+
+inline v2 operator*(float32 A, v2 B)
+{
+    v2 Result = {A*B.X, A*B.Y};
+    return(Result);
+}
+
+inline float32 Inner(v2 A, v2 B)
+{
+    float32 Result = A.X*B.X + A.Y*B.Y;
+    return(Result);
+}
+
+//Rotated a quarter turn counterclockwise (clockwise on screen, since Y goes down)
+inline v2 Perp(v2 A)
+{
+    v2 Result = {-A.Y, A.X};
+    return(Result);
+}
+
+struct v4
+{
+    float32 R;
+    float32 G;
+    float32 B;
+    float32 A;
+};
+
+inline v4 V4(float32 R, float32 G, float32 B, float32 A)
+{
+    v4 Result = {R, G, B, A};
+    return(Result);
+}
+
+//0xAARRGGBB, premultiplied alpha, top row first
+struct loaded_bitmap
+{
+    int Width;
+    int Height;
+    int Pitch;
+    void *Memory;
+};
+
+//Pixels from Min up to but not including Max
+struct rectangle2i
+{
+    int32 MinX;
+    int32 MinY;
+    int32 MaxX;
+    int32 MaxY;
+};
+
+inline rectangle2i Intersect(rectangle2i A, rectangle2i B)
+{
+    rectangle2i Result;
+    Result.MinX = (A.MinX < B.MinX) ? B.MinX : A.MinX;
+    Result.MinY = (A.MinY < B.MinY) ? B.MinY : A.MinY;
+    Result.MaxX = (A.MaxX > B.MaxX) ? B.MaxX : A.MaxX;
+    Result.MaxY = (A.MaxY > B.MaxY) ? B.MaxY : A.MaxY;
+    return(Result);
+}
+
+inline rectangle2i RectangleFromBuffer(game_offscreen_buffer *Buffer)
+{
+    rectangle2i Result = {0, 0, Buffer->Width, Buffer->Height};
+    return(Result);
+}
+
+/*
+    One period of a repeating background, in the format of the buffers it is copied into. The tile is kept two periods
+    wide, so from any X in the first period a whole period's worth of pixels follows without wrapping, and a row of the
+    buffer is copied in spans of up to Width pixels. Its memory is sized for 4 bytes per pixel, so it can be drawn
+    again in any format.
+*/
+struct tiled_background
+{
+    int Width; //NOTE(Robin) The period
+    int Height;
+    int Pitch; //NOTE(Robin) Two periods' worth of pixels in Format
+    void *Memory;
+
+    bool32 IsDrawn;
+    pixel_format Format;
+};
+
+enum render_entry_type
+{
+    RenderEntryType_render_entry_gradient,
+    RenderEntryType_render_entry_tiled_background,
+    RenderEntryType_render_entry_rectangle,
+    RenderEntryType_render_entry_tile_grid,
+    RenderEntryType_render_entry_bitmap,
+    RenderEntryType_render_entry_textured_quad,
+};
+
+//Every entry in the push buffer is a header followed by the entry of that type
+struct render_entry_header
+{
+    render_entry_type Type;
+};
+
+//Fills everything, so it is the first entry of a frame
+struct render_entry_gradient
+{
+    int XOffset;
+    int YOffset;
+};
+
+//Fills everything too, copied from a background already drawn in the buffer's format
+struct render_entry_tiled_background
+{
+    tiled_background *Background;
+    int XOffset;
+    int YOffset;
+};
+
+struct render_entry_rectangle
+{
+    v2 Min;
+    v2 Max;
+    v4 Color;
+};
+
+//A grid of TileSide pixel squares, a byte each, from (MinX, MinY): 0 is left alone, anything else is filled with that
+//entry of Colors
+struct render_entry_tile_grid
+{
+    uint8 *Tiles; //NOTE(Robin) Row by row, TileCountX to a row
+    int32 TileCountX;
+    int32 TileCountY;
+    int32 TileSide;
+    int32 MinX;
+    int32 MinY;
+    v4 *Colors;
+};
+
+struct render_entry_bitmap
+{
+    loaded_bitmap *Bitmap;
+    v2 Position;
+};
+
+struct render_entry_textured_quad
+{
+    v2 Origin;
+    v2 XAxis;
+    v2 YAxis;
+    v4 Color;
+    loaded_bitmap *Texture;
+};
+
+struct render_group
+{
+    memory_index MaxPushBufferSize;
+    memory_index PushBufferSize;
+    uint8 *PushBufferBase;
+};
+
+#define MIDNIGHT_MADNESS_RENDER_H
+#endif
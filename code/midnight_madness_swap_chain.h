@@ -0,0 +1,137 @@
+#if !defined(MIDNIGHT_MADNESS_SWAP_CHAIN_H)
+
+/*
+    The backbuffers, shared by the platform layers.
+
+    A swap chain of 2 to 4 backbuffers, carved out of one allocation the platform makes at startup, big enough for
+    every buffer at the largest size it will ever be asked for (more than 2 for a render thread running ahead, see
+    midnight_madness_frame_pipeline.h):
+    - The game draws into the draw buffer. Swapping makes that the present buffer, which the platform shows (and
+      shows again on every repaint), and moves drawing on to the next one, so the frame being shown is never the one
+      being drawn.
+    - Resizing only changes how the buffers are laid out in the memory they already have and clears them to black,
+      no OS calls. What it cost, and how often it happened, is kept for the frame stats next to the swap count.
+    - Every buffer starts on a page boundary and rows are packed (Pitch = Width*BytesPerPixel), which is what a DIB
+      wants, so the platform can hand one straight to the OS to show.
+*/
+
+#define SWAP_CHAIN_MAX_BUFFERS 4
+#define SWAP_CHAIN_PAGE_SIZE 4096
+
+//Everything the platform has a window or a capture for, 4K at 32 bits per pixel
+#define SWAP_CHAIN_MAX_WIDTH 3840
+#define SWAP_CHAIN_MAX_HEIGHT 2160
+
+struct swap_chain
+{
+    uint8 *Memory;
+    memory_index BufferSize; //NOTE(Robin) Bytes per buffer, a whole number of pages
+    int BufferCount;
+    int MaxWidth;
+    int MaxHeight;
+
+    int Width;
+    int Height;
+    int Pitch;
+    pixel_format Format;
+
+    int DrawIndex;
+    int PresentIndex;
+
+    uint64 SwapCount;
+    uint64 ResizeCount;
+    uint64 ResizeCycles; //NOTE(Robin) Summed over every resize
+    uint64 MaxResizeCycles;
+};
+
+internal memory_index SwapChainBufferSize(int MaxWidth, int MaxHeight)
+{
+    memory_index Size = (memory_index)MaxWidth*MaxHeight*4;
+    memory_index Result = (Size + SWAP_CHAIN_PAGE_SIZE - 1) & ~(memory_index)(SWAP_CHAIN_PAGE_SIZE - 1);
+    return(Result);
+}
+
+internal memory_index SwapChainMemorySize(int MaxWidth, int MaxHeight, int BufferCount)
+{
+    memory_index Result = BufferCount*SwapChainBufferSize(MaxWidth, MaxHeight);
+    return(Result);
+}
+
+//Memory has to be SwapChainMemorySize bytes, page aligned. The chain has no size until it is resized.
+internal void InitializeSwapChain(swap_chain *Chain, void *Memory, int MaxWidth, int MaxHeight, int BufferCount)
+{
+    Assert((BufferCount >= 2) && (BufferCount <= SWAP_CHAIN_MAX_BUFFERS));
+
+    *Chain = {};
+    Chain->Memory = (uint8 *)Memory;
+    Chain->BufferSize = SwapChainBufferSize(MaxWidth, MaxHeight);
+    Chain->BufferCount = BufferCount;
+    Chain->MaxWidth = MaxWidth;
+    Chain->MaxHeight = MaxHeight;
+    Chain->PresentIndex = BufferCount - 1;
+}
+
+//False, and nothing changes, if the buffers would not fit in the memory the chain was given
+internal bool32 ResizeSwapChain(swap_chain *Chain, int Width, int Height, pixel_format Format)
+{
+    uint64 StartCycles = __rdtsc();
+
+    int Pitch = Width*GetBytesPerPixel(Format);
+    bool32 Result = ((Width > 0) && (Height > 0) && (Width <= Chain->MaxWidth) && (Height <= Chain->MaxHeight));
+    if(Result)
+    {
+        Chain->Width = Width;
+        Chain->Height = Height;
+        Chain->Pitch = Pitch;
+        Chain->Format = Format;
+
+        //Only what the new size uses, the rest of every buffer is never looked at
+        for(int BufferIndex = 0; BufferIndex < Chain->BufferCount; ++BufferIndex)
+        {
+            memset(Chain->Memory + BufferIndex*Chain->BufferSize, 0, (memory_index)Pitch*Height);
+        }
+
+        uint64 Cycles = __rdtsc() - StartCycles;
+        ++Chain->ResizeCount;
+        Chain->ResizeCycles += Cycles;
+        Chain->MaxResizeCycles = (Cycles > Chain->MaxResizeCycles) ? Cycles : Chain->MaxResizeCycles;
+    }
+
+    return(Result);
+}
+
+internal game_offscreen_buffer GetSwapChainBuffer(swap_chain *Chain, int BufferIndex)
+{
+    game_offscreen_buffer Result = {};
+    Result.Memory = Chain->Memory + BufferIndex*Chain->BufferSize;
+    Result.Width = Chain->Width;
+    Result.Height = Chain->Height;
+    Result.Pitch = Chain->Pitch;
+    Result.Format = Chain->Format;
+    return(Result);
+}
+
+//What the game draws this frame into
+internal game_offscreen_buffer GetDrawBuffer(swap_chain *Chain)
+{
+    game_offscreen_buffer Result = GetSwapChainBuffer(Chain, Chain->DrawIndex);
+    return(Result);
+}
+
+//The last frame the game finished, what the platform shows
+internal game_offscreen_buffer GetPresentBuffer(swap_chain *Chain)
+{
+    game_offscreen_buffer Result = GetSwapChainBuffer(Chain, Chain->PresentIndex);
+    return(Result);
+}
+
+//The game is done with the draw buffer: it is the one to show now, and the next frame goes into the next buffer
+internal void SwapBackbuffers(swap_chain *Chain)
+{
+    Chain->PresentIndex = Chain->DrawIndex;
+    Chain->DrawIndex = (Chain->DrawIndex + 1) % Chain->BufferCount;
+    ++Chain->SwapCount;
+}
+
+#define MIDNIGHT_MADNESS_SWAP_CHAIN_H
+#endif
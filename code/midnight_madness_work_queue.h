@@ -0,0 +1,210 @@
+#if !defined(MIDNIGHT_MADNESS_WORK_QUEUE_H)
+
+/*
+    The work queue behind platform_add_entry and platform_complete_all_work, shared by the platform layers. The
+    platform owns the threads and the semaphore they sleep on, everything else is here.
+
+    Every thread of a queue has its own deque of entries (thread 0 is the owner, the thread that adds the work and
+    waits for it, and it runs entries too while it waits):
+    - A thread adds entries to the bottom of its own deque and takes them back from the bottom, newest first, so
+      work a job adds for itself is still in that core's cache when it runs.
+    - A thread with nothing left in its own deque steals from the top of another one, oldest first. The owner adds a
+      frame's worth of tiles to its deque in one go, and the workers spread them out among themselves by stealing.
+    - This is the Chase-Lev deque: the owner's end needs no atomic operation at all except when it takes the very
+      last entry, and thieves only race each other (and that last take) with one compare-exchange on Top.
+
+    The deques are fixed size, nothing is allocated. A deque that is full runs the entry right away instead.
+    A worker that finds no work anywhere sleeps on the platform's semaphore, which is signalled once per entry added.
+    The owner, waiting for the last entries that are running on other threads, yields its core instead of sleeping.
+*/
+
+#define WORK_QUEUE_MAX_THREADS 32
+#define WORK_QUEUE_DEQUE_SIZE 1024 //NOTE(Robin) Must be a power of two
+#define WORK_QUEUE_CACHE_LINE 64
+
+struct platform_work_queue_entry
+{
+    platform_work_queue_callback *Callback;
+    void *Data;
+};
+
+struct work_queue_deque
+{
+    //The owner's end, plus what only the owner writes
+    uint32 volatile Bottom;
+    uint32 EntriesRun;
+    uint32 EntriesStolen;
+    uint8 Pad0[WORK_QUEUE_CACHE_LINE - 3*sizeof(uint32)];
+
+    //The thieves' end
+    uint32 volatile Top;
+    uint8 Pad1[WORK_QUEUE_CACHE_LINE - sizeof(uint32)];
+
+    platform_work_queue_entry Entries[WORK_QUEUE_DEQUE_SIZE];
+};
+
+struct platform_work_queue
+{
+    uint32 ThreadCount; //NOTE(Robin) Counting the owner
+    void *WakeSemaphore; //NOTE(Robin) The platform's: a HANDLE on Windows, a sem_t * on Linux
+    uint8 Pad0[WORK_QUEUE_CACHE_LINE - sizeof(uint32) - sizeof(void *)];
+
+    uint32 volatile CompletionGoal;
+    uint8 Pad1[WORK_QUEUE_CACHE_LINE - sizeof(uint32)];
+    uint32 volatile CompletionCount;
+    uint8 Pad2[WORK_QUEUE_CACHE_LINE - sizeof(uint32)];
+
+    work_queue_deque Deques[WORK_QUEUE_MAX_THREADS];
+};
+
+//Which queue the current thread works for, and which of its deques is the thread's own
+global_variable THREAD_LOCAL platform_work_queue *WorkQueueOfThread;
+global_variable THREAD_LOCAL uint32 WorkQueueThreadIndex;
+
+//Queue has to be zeroed
+internal void InitializeWorkQueue(platform_work_queue *Queue, uint32 ThreadCount, void *WakeSemaphore)
+{
+    Assert((ThreadCount > 0) && (ThreadCount <= WORK_QUEUE_MAX_THREADS));
+    Queue->ThreadCount = ThreadCount;
+    Queue->WakeSemaphore = WakeSemaphore;
+    Queue->CompletionGoal = 0;
+    Queue->CompletionCount = 0;
+}
+
+//Every thread of the queue calls this before touching it, the owner with index 0
+internal void RegisterWorkQueueThread(platform_work_queue *Queue, uint32 ThreadIndex)
+{
+    Assert(ThreadIndex < Queue->ThreadCount);
+    WorkQueueOfThread = Queue;
+    WorkQueueThreadIndex = ThreadIndex;
+}
+
+internal uint32 GetWorkQueueThreadIndex(platform_work_queue *Queue)
+{
+    uint32 Result = (WorkQueueOfThread == Queue) ? WorkQueueThreadIndex : 0;
+    return(Result);
+}
+
+//Owner of the deque only. Fails when the deque is full.
+internal bool32 PushWorkQueueDeque(work_queue_deque *Deque, platform_work_queue_entry Entry)
+{
+    bool32 Result = false;
+
+    uint32 Bottom = Deque->Bottom;
+    uint32 Top = AtomicLoadAcquire(&Deque->Top);
+    if((Bottom - Top) < WORK_QUEUE_DEQUE_SIZE)
+    {
+        Deque->Entries[Bottom & (WORK_QUEUE_DEQUE_SIZE - 1)] = Entry;
+
+        //Release: the entry has to be visible before a thief can see the new Bottom
+        AtomicStoreRelease(&Deque->Bottom, Bottom + 1);
+        Result = true;
+    }
+
+    return(Result);
+}
+
+//Owner of the deque only, the newest entry
+internal bool32 TakeWorkQueueDeque(work_queue_deque *Deque, platform_work_queue_entry *Entry)
+{
+    bool32 Result = false;
+
+    //Claim the bottom entry first, then look at Top. The full barrier stops the load of Top from moving above the
+    //store to Bottom, or a thief and we could both take the same entry.
+    uint32 Bottom = Deque->Bottom - 1;
+    Deque->Bottom = Bottom;
+    FullMemoryBarrier();
+    uint32 Top = Deque->Top;
+
+    int32 Count = (int32)(Bottom - Top);
+    if(Count >= 0)
+    {
+        *Entry = Deque->Entries[Bottom & (WORK_QUEUE_DEQUE_SIZE - 1)];
+        Result = true;
+        if(Count == 0)
+        {
+            //The last entry, thieves may be after it too: whoever moves Top first gets it
+            Result = (AtomicCompareExchangeU32(&Deque->Top, Top, Top + 1) == Top);
+            Deque->Bottom = Bottom + 1;
+        }
+    }
+    else
+    {
+        //Was empty
+        Deque->Bottom = Bottom + 1;
+    }
+
+    return(Result);
+}
+
+//Any thread, the oldest entry. Fails when the deque is empty or another thread got there first.
+internal bool32 StealWorkQueueDeque(work_queue_deque *Deque, platform_work_queue_entry *Entry)
+{
+    bool32 Result = false;
+
+    uint32 Top = AtomicLoadAcquire(&Deque->Top);
+    FullMemoryBarrier();
+    uint32 Bottom = AtomicLoadAcquire(&Deque->Bottom);
+    if((int32)(Bottom - Top) > 0)
+    {
+        //Read the entry before claiming it, once Top moves the owner may overwrite the slot
+        *Entry = Deque->Entries[Top & (WORK_QUEUE_DEQUE_SIZE - 1)];
+        Result = (AtomicCompareExchangeU32(&Deque->Top, Top, Top + 1) == Top);
+    }
+
+    return(Result);
+}
+
+//Queues the entry on the calling thread's own deque. The platform signals its semaphore after this.
+internal void AddWorkQueueEntry(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data)
+{
+    //Counted before it can possibly run, so the owner never sees everything done while this is still on its way
+    AtomicAddU32(&Queue->CompletionGoal, 1);
+
+    platform_work_queue_entry Entry = {Callback, Data};
+    work_queue_deque *Deque = Queue->Deques + GetWorkQueueThreadIndex(Queue);
+    if(!PushWorkQueueDeque(Deque, Entry))
+    {
+        Callback(Queue, Data);
+        AtomicAddU32(&Queue->CompletionCount, 1);
+    }
+}
+
+//Runs one entry, its own deque's newest or else the oldest one it can steal. Returns false if there was nothing to run.
+internal bool32 DoNextWorkQueueEntry(platform_work_queue *Queue, uint32 ThreadIndex)
+{
+    work_queue_deque *Own = Queue->Deques + ThreadIndex;
+    platform_work_queue_entry Entry;
+    bool32 Found = TakeWorkQueueDeque(Own, &Entry);
+
+    //The victims are tried in order starting after us, so the thieves don't all pile onto the same deque first
+    for(uint32 Offset = 1; !Found && (Offset < Queue->ThreadCount); ++Offset)
+    {
+        uint32 VictimIndex = (ThreadIndex + Offset) % Queue->ThreadCount;
+        Found = StealWorkQueueDeque(Queue->Deques + VictimIndex, &Entry);
+        if(Found)
+        {
+            ++Own->EntriesStolen;
+        }
+    }
+
+    if(Found)
+    {
+        Entry.Callback(Queue, Entry.Data);
+        ++Own->EntriesRun;
+
+        //Release: whatever the entry wrote is visible before the owner can see it counted
+        AtomicAddU32(&Queue->CompletionCount, 1);
+    }
+
+    return(Found);
+}
+
+internal bool32 IsWorkQueueDone(platform_work_queue *Queue)
+{
+    bool32 Result = (AtomicLoadAcquire(&Queue->CompletionCount) == AtomicLoadAcquire(&Queue->CompletionGoal));
+    return(Result);
+}
+
+#define MIDNIGHT_MADNESS_WORK_QUEUE_H
+#endif
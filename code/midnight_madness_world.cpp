@@ -0,0 +1,188 @@
+//Sparse chunked tile map, see midnight_madness_world.h
+
+//Premultiplied, opaque: walls, in three shades
+global_variable v4 WorldTileColors[WORLD_TILE_VALUE_COUNT] =
+{
+    {0.0f, 0.0f, 0.0f, 0.0f}, //NOTE(Robin) Never drawn
+    {0.55f, 0.45f, 0.3f, 1.0f},
+    {0.35f, 0.4f, 0.5f, 1.0f},
+    {0.6f, 0.25f, 0.25f, 1.0f},
+};
+
+//Rounds towards minus infinity, where / rounds towards zero. Denominator has to be positive.
+inline int64 FloorDivide64(int64 Numerator, int64 Denominator)
+{
+    int64 Result = Numerator / Denominator;
+    Result -= ((Numerator % Denominator) < 0) ? 1 : 0;
+    return(Result);
+}
+
+internal void InitializeWorld(world *World)
+{
+    World->ChunkCount = 0;
+    for(uint32 HashIndex = 0; HashIndex < ArrayCount(World->ChunkHash); ++HashIndex)
+    {
+        World->ChunkHash[HashIndex] = 0;
+    }
+}
+
+//The shift rounds towards minus infinity, so tile -1 is the last tile of chunk -1
+inline world_position GetWorldPosition(int32 TileX, int32 TileY)
+{
+    world_position Result;
+    Result.ChunkX = TileX >> WORLD_CHUNK_SHIFT;
+    Result.ChunkY = TileY >> WORLD_CHUNK_SHIFT;
+    Result.TileIndex = (uint32)(TileY & WORLD_CHUNK_MASK)*WORLD_CHUNK_DIM + (uint32)(TileX & WORLD_CHUNK_MASK);
+    return(Result);
+}
+
+//Both coordinates in one 64 bit key, through MurmurHash3's finalizer, so every bit of either reaches the slot's bits
+//and chunks along a line or a diagonal spread over the whole table
+inline uint32 GetChunkHashSlot(int32 ChunkX, int32 ChunkY)
+{
+    uint64 Key = ((uint64)(uint32)ChunkX << 32) | (uint64)(uint32)ChunkY;
+    Key ^= Key >> 33;
+    Key *= 0xFF51AFD7ED558CCDULL;
+    Key ^= Key >> 33;
+    Key *= 0xC4CEB9FE1A85EC53ULL;
+    Key ^= Key >> 33;
+    uint32 Result = (uint32)Key & (WORLD_CHUNK_HASH_COUNT - 1);
+    return(Result);
+}
+
+//Returns 0 if the chunk has nothing in it, unless there is an Arena to make it with
+internal world_chunk *GetWorldChunk(world *World, int32 ChunkX, int32 ChunkY, memory_arena *Arena = 0)
+{
+    uint32 HashSlot = GetChunkHashSlot(ChunkX, ChunkY);
+
+    world_chunk *Result = World->ChunkHash[HashSlot];
+    while(Result && ((Result->ChunkX != ChunkX) || (Result->ChunkY != ChunkY)))
+    {
+        Result = Result->NextInHash;
+    }
+
+    if(!Result && Arena)
+    {
+        Result = PushStruct(Arena, world_chunk);
+        Result->ChunkX = ChunkX;
+        Result->ChunkY = ChunkY;
+        memset(Result->Tiles, 0, sizeof(Result->Tiles));
+        Result->NextInHash = World->ChunkHash[HashSlot];
+        World->ChunkHash[HashSlot] = Result;
+        ++World->ChunkCount;
+    }
+
+    return(Result);
+}
+
+internal uint8 GetTileValue(world *World, int32 TileX, int32 TileY)
+{
+    uint8 Result = 0;
+
+    world_position Position = GetWorldPosition(TileX, TileY);
+    world_chunk *Chunk = GetWorldChunk(World, Position.ChunkX, Position.ChunkY);
+    if(Chunk)
+    {
+        Result = Chunk->Tiles[Position.TileIndex];
+    }
+
+    return(Result);
+}
+
+internal void SetTileValue(world *World, memory_arena *Arena, int32 TileX, int32 TileY, uint8 Value)
+{
+    Assert(Value < WORLD_TILE_VALUE_COUNT);
+
+    world_position Position = GetWorldPosition(TileX, TileY);
+    world_chunk *Chunk = GetWorldChunk(World, Position.ChunkX, Position.ChunkY, Arena);
+    Chunk->Tiles[Position.TileIndex] = Value;
+}
+
+/*
+    Pushes a tile grid for every populated chunk the screen overlaps, and returns how many. The chunks the screen
+    overlaps come straight from the camera, so this is a hash lookup per chunk on screen (a few dozen at 4K), however
+    many chunks there are. Worked out in 64 bits, a chunk millions of pixels away still lands in the right place.
+*/
+internal uint32 PushVisibleChunks(render_group *Group, world *World, int32 CameraX, int32 CameraY,
+                                  int32 ScreenWidth, int32 ScreenHeight)
+{
+    uint32 Result = 0;
+
+    int64 ChunkSideInPixels = WORLD_CHUNK_DIM*WORLD_TILE_SIDE_IN_PIXELS;
+    int64 MinChunkX = FloorDivide64((int64)CameraX, ChunkSideInPixels);
+    int64 MinChunkY = FloorDivide64((int64)CameraY, ChunkSideInPixels);
+    int64 MaxChunkX = FloorDivide64((int64)CameraX + ScreenWidth - 1, ChunkSideInPixels);
+    int64 MaxChunkY = FloorDivide64((int64)CameraY + ScreenHeight - 1, ChunkSideInPixels);
+
+    for(int64 ChunkY = MinChunkY; ChunkY <= MaxChunkY; ++ChunkY)
+    {
+        for(int64 ChunkX = MinChunkX; ChunkX <= MaxChunkX; ++ChunkX)
+        {
+            world_chunk *Chunk = GetWorldChunk(World, (int32)ChunkX, (int32)ChunkY);
+            if(Chunk)
+            {
+                int32 MinX = (int32)(ChunkX*ChunkSideInPixels - CameraX);
+                int32 MinY = (int32)(ChunkY*ChunkSideInPixels - CameraY);
+                PushTileGrid(Group, Chunk->Tiles, WORLD_CHUNK_DIM, WORLD_CHUNK_DIM, WORLD_TILE_SIDE_IN_PIXELS, MinX, MinY,
+                             WorldTileColors);
+                ++Result;
+            }
+        }
+    }
+
+    return(Result);
+}
+
+//Deterministic, so a recorded session finds the same world when it is played back
+inline uint32 NextWorldRandom(uint32 *Series)
+{
+    *Series ^= *Series << 13;
+    *Series ^= *Series >> 17;
+    *Series ^= *Series << 5;
+    return(*Series);
+}
+
+//One chunk's worth of room: walls all round, with a doorway through the middle of each one
+internal void MakeWorldRoom(world *World, memory_arena *Arena, int32 ChunkX, int32 ChunkY, uint8 Value)
+{
+    int32 MinTileX = ChunkX*WORLD_CHUNK_DIM;
+    int32 MinTileY = ChunkY*WORLD_CHUNK_DIM;
+    for(int32 Offset = 0; Offset < WORLD_CHUNK_DIM; ++Offset)
+    {
+        bool32 IsDoorway = ((Offset == WORLD_CHUNK_DIM/2 - 1) || (Offset == WORLD_CHUNK_DIM/2));
+        if(!IsDoorway)
+        {
+            SetTileValue(World, Arena, MinTileX + Offset, MinTileY, Value);
+            SetTileValue(World, Arena, MinTileX + Offset, MinTileY + WORLD_CHUNK_DIM - 1, Value);
+            SetTileValue(World, Arena, MinTileX, MinTileY + Offset, Value);
+            SetTileValue(World, Arena, MinTileX + WORLD_CHUNK_DIM - 1, MinTileY + Offset, Value);
+        }
+    }
+}
+
+/*
+    Until there is a real one: a band of rooms, about half the chunks in it, running a long way right of the origin
+    the way the camera scrolls, a few rows either side of it, and a handful of rooms millions of tiles out to show
+    that how far apart chunks are costs nothing.
+*/
+internal void GenerateTestWorld(world *World, memory_arena *Arena)
+{
+    uint32 Series = 0x1234567;
+    for(int32 ChunkY = -3; ChunkY <= 3; ++ChunkY)
+    {
+        for(int32 ChunkX = -16; ChunkX < 2048; ++ChunkX)
+        {
+            uint32 Random = NextWorldRandom(&Series);
+            if(Random & 1)
+            {
+                MakeWorldRoom(World, Arena, ChunkX, ChunkY, (uint8)(1 + (Random >> 1) % (WORLD_TILE_VALUE_COUNT - 1)));
+            }
+        }
+    }
+
+    int32 FarChunks[][2] = {{100000, 100000}, {-100000, 50000}, {4000000, -4000000}, {-4000000, -4000000}};
+    for(int FarIndex = 0; FarIndex < ArrayCount(FarChunks); ++FarIndex)
+    {
+        MakeWorldRoom(World, Arena, FarChunks[FarIndex][0], FarChunks[FarIndex][1], 3);
+    }
+}
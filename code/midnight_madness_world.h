@@ -0,0 +1,49 @@
+#if !defined(MIDNIGHT_MADNESS_WORLD_H)
+
+/*
+    The world, a tile map on int32 tile coordinates, of which only the parts with something in them take any memory.
+    The camera is in int32 pixels though, so only the tiles within about 2^26 of the origin (2^31 pixels over
+    WORLD_TILE_SIDE_IN_PIXELS) can ever be on screen.
+
+    - Tiles are grouped in chunks of WORLD_CHUNK_DIM x WORLD_CHUNK_DIM, and a chunk only exists once a tile in it is
+      set. Chunks are found through a hash table on their chunk coordinates, chained through the chunks themselves,
+      and come out of the arena they are set with: the memory used goes with how many chunks are populated, not with
+      how far apart they are.
+    - A tile is a byte, 0 for nothing (the background shows through) and anything else an index into WorldTileColors.
+    - The camera is in world pixels, the same as the gradient's offsets: pixel (X, Y) of the screen is pixel
+      (X + CameraX, Y + CameraY) of the world. PushVisibleChunks works out which chunks the screen overlaps and looks
+      up only those, so what a frame costs goes with the size of the screen, not of the world.
+*/
+
+#define WORLD_CHUNK_SHIFT 4
+#define WORLD_CHUNK_DIM (1 << WORLD_CHUNK_SHIFT)
+#define WORLD_CHUNK_MASK (WORLD_CHUNK_DIM - 1)
+#define WORLD_CHUNK_HASH_COUNT 4096 //NOTE(Robin) A power of two
+#define WORLD_TILE_SIDE_IN_PIXELS 32
+#define WORLD_TILE_VALUE_COUNT 4
+
+struct world_chunk
+{
+    int32 ChunkX;
+    int32 ChunkY;
+    world_chunk *NextInHash;
+
+    uint8 Tiles[WORLD_CHUNK_DIM*WORLD_CHUNK_DIM]; //NOTE(Robin) Row by row, top row first
+};
+
+struct world
+{
+    uint32 ChunkCount;
+    world_chunk *ChunkHash[WORLD_CHUNK_HASH_COUNT];
+};
+
+//Where a tile is: which chunk, and where in it
+struct world_position
+{
+    int32 ChunkX;
+    int32 ChunkY;
+    uint32 TileIndex; //NOTE(Robin) Into world_chunk::Tiles
+};
+
+#define MIDNIGHT_MADNESS_WORLD_H
+#endif
@@ -0,0 +1,286 @@
+/*
+
+    Writes the packed asset file the game memory maps (see midnight_madness_file_formats.h).
+
+    There is no art yet, so every asset is made up here: a few sprites and a bell, all procedural, already in the
+    game's own pixel and sample formats. -filler N adds N tiny bitmaps the game never uses, to check that how long the
+    game takes to open the file doesn't depend on how many assets are in it.
+
+    Usage: test_asset_builder [-filler N] [FILE]   (default midnight_madness.mma)
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "midnight_madness.h"
+
+#define BUILDER_SAMPLES_PER_SECOND 48000
+
+struct asset_builder
+{
+    uint32 MaxAssetCount;
+    uint32 AssetCount;
+    mma_asset *Assets;
+    void **Payloads;
+
+    uint32 AssetTypeCount;
+    mma_asset_type AssetTypes[Asset_Count];
+    mma_asset_type *CurrentType;
+};
+
+internal void BeginAssetType(asset_builder *Builder, asset_type_id TypeID)
+{
+    Assert(!Builder->CurrentType);
+    Assert(Builder->AssetTypeCount < Asset_Count);
+    Builder->CurrentType = Builder->AssetTypes + Builder->AssetTypeCount++;
+    Builder->CurrentType->TypeID = TypeID;
+    Builder->CurrentType->FirstAssetIndex = Builder->AssetCount;
+    Builder->CurrentType->OnePastLastAssetIndex = Builder->AssetCount;
+}
+
+internal void EndAssetType(asset_builder *Builder)
+{
+    Assert(Builder->CurrentType);
+    Builder->CurrentType->OnePastLastAssetIndex = Builder->AssetCount;
+    Builder->CurrentType = 0;
+}
+
+internal mma_asset *AddAsset(asset_builder *Builder, mma_asset_kind Kind, uint64 DataSize)
+{
+    Assert(Builder->AssetCount < Builder->MaxAssetCount);
+    uint32 AssetIndex = Builder->AssetCount++;
+    mma_asset *Asset = Builder->Assets + AssetIndex;
+    memset(Asset, 0, sizeof(*Asset));
+    Asset->Kind = Kind;
+    Asset->DataSize = DataSize;
+    Builder->Payloads[AssetIndex] = calloc(1, DataSize);
+    return(Asset);
+}
+
+internal float32 Clamp01(float32 Value)
+{
+    float32 Result = (Value < 0.0f) ? 0.0f : ((Value > 1.0f) ? 1.0f : Value);
+    return(Result);
+}
+
+//Straight color in, premultiplied 0xAARRGGBB out
+internal uint32 PackPremultiplied(float32 R, float32 G, float32 B, float32 A)
+{
+    uint32 Result = (((uint32)(Clamp01(A)*255.0f + 0.5f) << 24) |
+                     ((uint32)(Clamp01(R*A)*255.0f + 0.5f) << 16) |
+                     ((uint32)(Clamp01(G*A)*255.0f + 0.5f) << 8) |
+                     ((uint32)(Clamp01(B*A)*255.0f + 0.5f) << 0));
+    return(Result);
+}
+
+enum sprite_shape
+{
+    SpriteShape_Disc,
+    SpriteShape_Ring,
+    SpriteShape_Diamond,
+    SpriteShape_Star,
+};
+
+//Coverage is found from the distance to the shape's edge, with a pixel's worth of soft edge
+internal void AddSprite(asset_builder *Builder, int Width, int Height, sprite_shape Shape, float32 R, float32 G, float32 B)
+{
+    mma_asset *Asset = AddAsset(Builder, MMA_Bitmap, (uint64)Width*Height*4);
+    Asset->Bitmap.Width = Width;
+    Asset->Bitmap.Height = Height;
+
+    uint32 *Pixel = (uint32 *)Builder->Payloads[Builder->AssetCount - 1];
+    float32 EdgeWidth = 2.0f / (float32)Width;
+    for(int Y = 0; Y < Height; ++Y)
+    {
+        for(int X = 0; X < Width; ++X)
+        {
+            float32 dX = 2.0f*(((float32)X + 0.5f) / (float32)Width) - 1.0f;
+            float32 dY = 2.0f*(((float32)Y + 0.5f) / (float32)Height) - 1.0f;
+            float32 Radius = sqrtf(dX*dX + dY*dY);
+
+            float32 Distance = 0.0f; //NOTE(Robin) Negative inside the shape
+            switch(Shape)
+            {
+                case SpriteShape_Disc: {Distance = Radius - 0.9f;} break;
+                case SpriteShape_Ring: {Distance = fabsf(Radius - 0.7f) - 0.2f;} break;
+                case SpriteShape_Diamond: {Distance = (fabsf(dX) + fabsf(dY) - 0.95f)*0.7071f;} break;
+                case SpriteShape_Star:
+                {
+                    float32 Angle = atan2f(dY, dX);
+                    Distance = Radius - (0.6f + 0.3f*cosf(5.0f*Angle));
+                } break;
+            }
+
+            float32 Alpha = Clamp01(0.5f - Distance / EdgeWidth);
+            float32 Shade = 1.0f - 0.4f*Radius;
+            *Pixel++ = PackPremultiplied(Shade*R, Shade*G, Shade*B, Alpha);
+        }
+    }
+}
+
+//A struck bell: a few inharmonic partials, the higher ones dying away faster, panned apart a little
+internal void AddBell(asset_builder *Builder, float32 BaseHz, float32 Seconds)
+{
+    uint32 SampleCount = (uint32)(Seconds*BUILDER_SAMPLES_PER_SECOND);
+    uint32 ChannelCount = 2;
+    //NOTE(Robin) One more frame, of zeros, for the mixer's interpolation
+    mma_asset *Asset = AddAsset(Builder, MMA_Sound, (uint64)(SampleCount + 1)*ChannelCount*sizeof(int16));
+    Asset->Sound.SampleCount = SampleCount;
+    Asset->Sound.ChannelCount = ChannelCount;
+
+    float32 Ratios[] = {0.5f, 1.0f, 1.183f, 1.506f, 2.0f, 2.514f};
+    float32 Volumes[] = {0.35f, 1.0f, 0.6f, 0.45f, 0.3f, 0.2f};
+    int16 *Sample = (int16 *)Builder->Payloads[Builder->AssetCount - 1];
+    for(uint32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex)
+    {
+        float32 t = (float32)SampleIndex / (float32)BUILDER_SAMPLES_PER_SECOND;
+        float32 Left = 0.0f;
+        float32 Right = 0.0f;
+        for(int PartialIndex = 0; PartialIndex < ArrayCount(Ratios); ++PartialIndex)
+        {
+            float32 Hz = BaseHz*Ratios[PartialIndex];
+            float32 Decay = expf(-t*(1.5f + 1.2f*PartialIndex));
+            float32 Value = Volumes[PartialIndex]*Decay*sinf(2.0f*Pi32*Hz*t);
+            float32 Pan = (PartialIndex & 1) ? 0.65f : 0.35f;
+            Left += (1.0f - Pan)*Value;
+            Right += Pan*Value;
+        }
+
+        //A couple of milliseconds of attack, so it doesn't click
+        float32 Attack = Clamp01(t / 0.002f);
+        *Sample++ = (int16)(6000.0f*Attack*Left);
+        *Sample++ = (int16)(6000.0f*Attack*Right);
+    }
+}
+
+internal uint64 AlignUp(uint64 Value, uint64 Alignment)
+{
+    uint64 Result = (Value + Alignment - 1) & ~(Alignment - 1);
+    return(Result);
+}
+
+internal bool32 WritePadding(FILE *Out, uint64 Count)
+{
+    local_persist uint8 Zeros[MMA_PAYLOAD_ALIGNMENT];
+    bool32 Result = true;
+    while(Result && Count)
+    {
+        uint64 Chunk = (Count < sizeof(Zeros)) ? Count : sizeof(Zeros);
+        Result = (fwrite(Zeros, 1, Chunk, Out) == Chunk);
+        Count -= Chunk;
+    }
+    return(Result);
+}
+
+internal bool32 WriteAssetFile(asset_builder *Builder, char *FileName)
+{
+    FILE *Out = fopen(FileName, "wb");
+    if(!Out)
+    {
+        fprintf(stderr, "Could not open %s\n", FileName);
+        return(false);
+    }
+
+    mma_header Header = {};
+    Header.MagicValue = MMA_MAGIC_VALUE;
+    Header.Version = MMA_VERSION;
+    Header.AssetTypeCount = Builder->AssetTypeCount;
+    Header.AssetCount = Builder->AssetCount;
+    Header.AssetTypes = sizeof(Header);
+    Header.Assets = AlignUp(Header.AssetTypes + Header.AssetTypeCount*sizeof(mma_asset_type), 8);
+
+    //The payloads go after the index, each on its own page
+    uint64 DataOffset = AlignUp(Header.Assets + (uint64)Header.AssetCount*sizeof(mma_asset), MMA_PAYLOAD_ALIGNMENT);
+    for(uint32 AssetIndex = 1; AssetIndex < Builder->AssetCount; ++AssetIndex)
+    {
+        mma_asset *Asset = Builder->Assets + AssetIndex;
+        Asset->DataOffset = DataOffset;
+        DataOffset = AlignUp(DataOffset + Asset->DataSize, MMA_PAYLOAD_ALIGNMENT);
+    }
+
+    bool32 Written = ((fwrite(&Header, sizeof(Header), 1, Out) == 1) &&
+                      (fwrite(Builder->AssetTypes, sizeof(mma_asset_type), Header.AssetTypeCount, Out) == Header.AssetTypeCount) &&
+                      WritePadding(Out, Header.Assets - (Header.AssetTypes + Header.AssetTypeCount*sizeof(mma_asset_type))) &&
+                      (fwrite(Builder->Assets, sizeof(mma_asset), Header.AssetCount, Out) == Header.AssetCount));
+
+    uint64 WriteOffset = Header.Assets + (uint64)Header.AssetCount*sizeof(mma_asset);
+    for(uint32 AssetIndex = 1; Written && (AssetIndex < Builder->AssetCount); ++AssetIndex)
+    {
+        mma_asset *Asset = Builder->Assets + AssetIndex;
+        Written = (WritePadding(Out, Asset->DataOffset - WriteOffset) &&
+                   (fwrite(Builder->Payloads[AssetIndex], 1, Asset->DataSize, Out) == Asset->DataSize));
+        WriteOffset = Asset->DataOffset + Asset->DataSize;
+    }
+
+    //The last payload is padded out too, so every asset's pages are whole
+    Written = Written && WritePadding(Out, AlignUp(WriteOffset, MMA_PAYLOAD_ALIGNMENT) - WriteOffset);
+    Written = (fclose(Out) == 0) && Written;
+    if(Written)
+    {
+        printf("%s: %u assets, %.1f MB\n", FileName, Builder->AssetCount, (float64)AlignUp(WriteOffset, MMA_PAYLOAD_ALIGNMENT) / (float64)Megabytes(1));
+    }
+    else
+    {
+        fprintf(stderr, "Could not write %s\n", FileName);
+    }
+
+    return(Written);
+}
+
+int main(int ArgCount, char **Args)
+{
+    char *FileName = (char *)"midnight_madness.mma";
+    uint32 FillerCount = 0;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "-filler") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            FillerCount = (uint32)strtoul(Args[++ArgIndex], 0, 10);
+        }
+        else if(Args[ArgIndex][0] != '-')
+        {
+            FileName = Args[ArgIndex];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-filler N] [FILE]\n", Args[0]);
+            return 1;
+        }
+    }
+
+    asset_builder Builder = {};
+    Builder.MaxAssetCount = 64 + FillerCount;
+    Builder.Assets = (mma_asset *)calloc(Builder.MaxAssetCount, sizeof(mma_asset));
+    Builder.Payloads = (void **)calloc(Builder.MaxAssetCount, sizeof(void *));
+    if(!Builder.Assets || !Builder.Payloads)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    //Asset 0 is the null asset
+    Builder.AssetCount = 1;
+
+    BeginAssetType(&Builder, Asset_Sprite);
+    AddSprite(&Builder, 64, 64, SpriteShape_Disc, 1.0f, 0.55f, 0.2f);
+    AddSprite(&Builder, 64, 64, SpriteShape_Ring, 0.3f, 0.8f, 1.0f);
+    AddSprite(&Builder, 48, 48, SpriteShape_Diamond, 0.5f, 1.0f, 0.4f);
+    AddSprite(&Builder, 64, 64, SpriteShape_Star, 1.0f, 0.9f, 0.3f);
+    EndAssetType(&Builder);
+
+    BeginAssetType(&Builder, Asset_Bell);
+    AddBell(&Builder, 523.25f, 2.0f);
+    EndAssetType(&Builder);
+
+    BeginAssetType(&Builder, Asset_Filler);
+    for(uint32 FillerIndex = 0; FillerIndex < FillerCount; ++FillerIndex)
+    {
+        AddSprite(&Builder, 8, 8, SpriteShape_Disc, (float32)(FillerIndex % 7) / 6.0f, 0.5f, 0.5f);
+    }
+    EndAssetType(&Builder);
+
+    return(WriteAssetFile(&Builder, FileName) ? 0 : 1);
+}
@@ -8,10 +8,22 @@
 */
 #include <windows.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <dsound.h>
+#include <psapi.h>
 #include <math.h>
+#include <stdlib.h>
 
 #include "midnight_madness.cpp"
+#include "midnight_madness_audio_ring.h"
+#include "midnight_madness_frame_pacer.h"
+#include "midnight_madness_capture.h"
+#include "midnight_madness_work_queue.h"
+#include "midnight_madness_present.h"
+#include "midnight_madness_swap_chain.h"
+#include "midnight_madness_input_latency.h"
+#include "midnight_madness_frame_pipeline.h"
+#include "midnight_madness_overlay.h"
 
 
 
@@ -21,11 +33,7 @@
 /*
 Partial list of stuff to do for the platform layer:
 - Saved game location
-- Getting handle to our own exe file
-- Asset loading path
-- Multithreading
 - Raw Input (support for multiple keyboards)
-- Sleep/timeBeginPeriod
 - ClipCursor() (for multimonitor support)
 - Fullscreen support - 
 - WM-SETCURSOR (control cursir visibility)
@@ -51,8 +59,18 @@ struct win32_offscreen_buffer
 };
 
 global_variable bool GlobalRunning;
+//The game draws into the swap chain's buffers, GlobalBackbuffer is the one being shown (WM_PAINT included)
+global_variable swap_chain GlobalSwapChain;
 global_variable win32_offscreen_buffer GlobalBackbuffer;
 global_variable LPDIRECTSOUNDBUFFER GlobalSecondaryBuffer;
+global_variable bool32 GlobalWriteTrace;
+//The window sized buffer the back buffer is scaled into when the window isn't 1280x720, blitted without stretching.
+//Allocated once for the biggest window the swap chain supports, resizing the window only reshapes it.
+global_variable win32_offscreen_buffer GlobalPresentBuffer;
+global_variable present_scaler *GlobalPresentScaler;
+//F3 shows and hides it, it starts out shown in internal builds
+global_variable debug_overlay GlobalOverlay;
+global_variable bool32 GlobalShowOverlay = MIDNIGHT_MADNESS_INTERNAL;
 
 
 struct win32_window_dimension
@@ -64,17 +82,103 @@ struct win32_window_dimension
 struct win32_sound_output
 {
     int SamplesPerSecond;
-    int ToneHz;
     uint32 RunningSampleIndex;
-    int WavePeriod;
-    //int HalfWavePeriod = WavePeriod/2;
     int BytesPerSample;
     int SecondaryBufferSize;
     int ToneVolume;
 };
 
-internal void Win32FillSoundBuffer(win32_sound_output *SoundOutput, DWORD ByteToLock, DWORD BytesToWrite, game_sound_output_buffer *SourceBuffer)
+//Everything the audio thread needs. It owns GlobalSecondaryBuffer and SoundOutput->RunningSampleIndex from the moment
+//it starts, the game thread only ever touches the ring and reads the clock.
+struct win32_audio_thread
 {
+    audio_ring *Ring;
+    audio_device_clock *Clock;
+    win32_sound_output *SoundOutput;
+    int16 *Silence;
+    int64 PerfCountFrequency;
+    bool32 volatile Running;
+};
+
+//Writes out the capture frames the game thread publishes, and hands them back to the pool
+struct win32_capture_thread
+{
+    capture_queue *Queue;
+    int SamplesPerSecond;
+    HANDLE FramesPublished;
+    HANDLE FrameFile;
+    HANDLE WavFile;
+    uint32 WavDataBytes;
+    uint32 FramesWritten;
+    bool32 volatile Running;
+};
+
+//Renders the frames the main thread submits, see midnight_madness_frame_pipeline.h. At depth 0 there is no thread and
+//the main thread renders them itself, through the same Win32RenderFrame.
+struct win32_render_thread
+{
+    frame_pipeline *Pipeline;
+    game_memory *GameMemory;
+    capture_queue *CaptureQueue; //NOTE(Robin) 0 unless capturing
+    audio_ring *AudioRing;
+    audio_scheduler *AudioScheduler;
+    audio_device_clock *AudioClock;
+    win32_sound_output *SoundOutput;
+    HANDLE FramesSubmitted;
+    HANDLE FramesRendered;
+    HANDLE Thread;
+    bool32 volatile Running;
+};
+
+//The render queue's worker threads. The thread that starts the queue is its owner, thread 0.
+struct win32_worker
+{
+    struct win32_work_queue *WorkQueue;
+    uint32 ThreadIndex;
+    HANDLE Thread;
+};
+
+struct win32_work_queue
+{
+    platform_work_queue *Queue;
+    uint32 ThreadCount; //NOTE(Robin) The owner and the workers that started
+    bool32 volatile Running;
+    win32_worker Workers[WORK_QUEUE_MAX_THREADS];
+};
+
+//Looped live recording: 'L' starts recording, 'L' again stops it and starts playing it back, over and over, until
+//the third 'L'. The game memory is copied into a memory mapped file when recording starts and copied back every time
+//playback loops, and the input for every frame in between is streamed to a second file.
+struct win32_replay_buffer
+{
+    HANDLE FileHandle;
+    HANDLE MemoryMap;
+    char FileName[MAX_PATH];
+    void *MemoryBlock;
+};
+
+struct win32_state
+{
+    uint64 TotalSize;
+    void *GameMemoryBlock;
+    win32_replay_buffer ReplayBuffer;
+
+    HANDLE RecordingHandle;
+    bool32 IsRecording;
+
+    HANDLE PlaybackHandle;
+    bool32 IsPlayingBack;
+
+    //NOTE(Robin) Both drained before game memory is snapshotted or restored, so no frame or asset load is halfway
+    //through either way
+    win32_render_thread *RenderThread;
+    platform_work_queue *LoadQueue;
+};
+
+//False if the buffer couldn't be locked, then nothing was written and RunningSampleIndex is where it was
+internal bool32 Win32FillSoundBuffer(win32_sound_output *SoundOutput, DWORD ByteToLock, DWORD BytesToWrite, game_sound_output_buffer *SourceBuffer)
+{
+    bool32 Result = false;
     VOID *Region1;
     DWORD Region1Size;
     VOID *Region2;
@@ -86,31 +190,156 @@ internal void Win32FillSoundBuffer(win32_sound_output *SoundOutput, DWORD ByteTo
     {
     //TODO(Robin) assert that Region1Size and Region2Size are valid
 
+        //The game already wrote the samples in exactly the format the buffer uses, so each region is one straight copy
         DWORD Region1SampleCount = Region1Size/SoundOutput->BytesPerSample;
-        int16 *DestSample = (int16 *)Region1;
-        int16 *SourceSample = SourceBuffer -> Samples;
-        for(DWORD i = 0; i < Region1SampleCount; ++i)
-        {
-            *DestSample++ = *SourceSample++;
-            *DestSample++ = *SourceSample++;
-            ++SoundOutput->RunningSampleIndex;
-        }
+        uint8 *SourceBytes = (uint8 *)SourceBuffer->Samples;
+        CopyMemory(Region1, SourceBytes, Region1Size);
+        SourceBytes += Region1Size;
 
         DWORD Region2SampleCount = Region2Size/SoundOutput->BytesPerSample;
-        DestSample = (int16 *)Region2;
-        for(DWORD i = 0; i < Region2SampleCount; ++i)
+        if(Region2)
         {
-            *DestSample++ = *SourceSample++;
-            *DestSample++ = *SourceSample++;
-            ++SoundOutput->RunningSampleIndex;
+            CopyMemory(Region2, SourceBytes, Region2Size);
         }
 
+        SoundOutput->RunningSampleIndex += Region1SampleCount + Region2SampleCount;
+
         GlobalSecondaryBuffer->Unlock(Region1, Region1Size, Region2, Region2Size);
+        Result = true;
     }
+
+    return(Result);
 }
 
 
 
+//The audio thread hands DirectSound whatever the game put in the ring, as soon as it is there. How much that is, and so
+//the latency, is up to the game's scheduler; this thread just measures the device for it. Sample indices count from
+//the play cursor at startup: SoundOutput->RunningSampleIndex is the next sample to write, PlayedSampleIndex follows
+//the play cursor. If the ring runs dry right as the write cursor reaches the end of what we wrote, the device gets a
+//little silence instead of whatever stale sound was left in the buffer, and that counts as an underrun.
+internal DWORD WINAPI Win32AudioThreadProc(LPVOID Parameter)
+{
+    win32_audio_thread *Thread = (win32_audio_thread *)Parameter;
+    win32_sound_output *SoundOutput = Thread->SoundOutput;
+    audio_ring *Ring = Thread->Ring;
+    audio_device_clock *Clock = Thread->Clock;
+    DWORD BufferSize = SoundOutput->SecondaryBufferSize;
+    DWORD BytesPerSample = SoundOutput->BytesPerSample;
+    uint32 BufferSamples = BufferSize / BytesPerSample;
+    uint32 SamplesPerSecond = SoundOutput->SamplesPerSecond;
+
+    DWORD LastPlayCursor = 0;
+    DWORD LastWriteCursor = 0;
+    GlobalSecondaryBuffer->GetCurrentPosition(&LastPlayCursor, &LastWriteCursor);
+
+    //Start at the write cursor, everything before it is already committed to the hardware
+    uint32 PlayedSampleIndex = 0;
+    uint32 RingSamplesConsumed = 0;
+    uint32 WriteLead = ((LastWriteCursor + BufferSize - LastPlayCursor) % BufferSize) / BytesPerSample;
+    uint32 Granularity = 0;
+    uint32 ServiceInterval = 0;
+    DWORD ByteToLock = LastWriteCursor;
+    SoundOutput->RunningSampleIndex = WriteLead;
+
+    DebugNameThread("Audio");
+
+    LARGE_INTEGER LastWake;
+    QueryPerformanceCounter(&LastWake);
+
+    while(Thread->Running)
+    {
+        //How long it took to get back here is part of the safety margin, Sleep(1) can easily be 15ms.
+        //Take the worst case, but let it fade so one hiccup doesn't add latency forever.
+        LARGE_INTEGER Wake;
+        QueryPerformanceCounter(&Wake);
+        uint32 Interval = (uint32)(((Wake.QuadPart - LastWake.QuadPart)*SamplesPerSecond) / Thread->PerfCountFrequency);
+        ServiceInterval = (Interval > ServiceInterval) ? Interval : ServiceInterval - (ServiceInterval - Interval)/64;
+        LastWake = Wake;
+
+        {
+            TIMED_BLOCK("Win32AudioService");
+
+            DWORD PlayCursor;
+            DWORD WriteCursor;
+            if(SUCCEEDED(GlobalSecondaryBuffer->GetCurrentPosition(&PlayCursor, &WriteCursor)))
+            {
+                PlayedSampleIndex += ((PlayCursor + BufferSize - LastPlayCursor) % BufferSize) / BytesPerSample;
+                LastPlayCursor = PlayCursor;
+                WriteLead = ((WriteCursor + BufferSize - PlayCursor) % BufferSize) / BytesPerSample;
+
+                //The write cursor doesn't move smoothly, it jumps ahead a driver-sized chunk at a time. The biggest jump
+                //is how much sound can become committed at once. Anything over 100ms is us stalling, not the device.
+                if(WriteCursor != LastWriteCursor)
+                {
+                    uint32 Jump = ((WriteCursor + BufferSize - LastWriteCursor) % BufferSize) / BytesPerSample;
+                    if((Jump > Granularity) && (Jump < SamplesPerSecond/10))
+                    {
+                        Granularity = Jump;
+                    }
+                    LastWriteCursor = WriteCursor;
+                }
+
+                uint32 SafeSampleIndex = PlayedSampleIndex + WriteLead;
+                if((int32)(SoundOutput->RunningSampleIndex - SafeSampleIndex) < 0)
+                {
+                    //The write cursor went past everything we wrote. Start again from the write cursor.
+                    CountAudioRingUnderrun(Ring);
+                    SoundOutput->RunningSampleIndex = SafeSampleIndex;
+                    ByteToLock = WriteCursor;
+                }
+
+                game_sound_output_buffer Source = {};
+                Source.SamplesPerSecond = SamplesPerSecond;
+                while((Source.Samples = BeginAudioRingRead(Ring, &Source.SampleCount)) != 0)
+                {
+                    //Never queue so much that we would wrap around onto the play cursor
+                    uint32 Queued = SoundOutput->RunningSampleIndex - PlayedSampleIndex;
+                    if(Queued + Source.SampleCount + Granularity >= BufferSamples)
+                    {
+                        break;
+                    }
+
+                    //A block that couldn't be written stays in the ring for the next time around
+                    DWORD BytesToWrite = Source.SampleCount*BytesPerSample;
+                    if(!Win32FillSoundBuffer(SoundOutput, ByteToLock, BytesToWrite, &Source))
+                    {
+                        break;
+                    }
+                    EndAudioRingRead(Ring);
+
+                    ByteToLock = (ByteToLock + BytesToWrite) % BufferSize;
+                    RingSamplesConsumed += Source.SampleCount;
+                }
+
+                if(!Source.Samples && (SoundOutput->RunningSampleIndex - SafeSampleIndex < Granularity))
+                {
+                    //Nothing from the game, and the write cursor is about to reach stale sound
+                    CountAudioRingUnderrun(Ring);
+                    Source.Samples = Thread->Silence;
+                    Source.SampleCount = (Granularity < (uint32)Ring->SamplesPerBlock) ? Granularity : Ring->SamplesPerBlock;
+                    DWORD BytesToWrite = Source.SampleCount*BytesPerSample;
+                    if(Win32FillSoundBuffer(SoundOutput, ByteToLock, BytesToWrite, &Source))
+                    {
+                        ByteToLock = (ByteToLock + BytesToWrite) % BufferSize;
+                    }
+                }
+
+                AtomicStoreRelease(&Clock->PlayedSampleIndex, PlayedSampleIndex);
+                AtomicStoreRelease(&Clock->WrittenSampleIndex, SoundOutput->RunningSampleIndex);
+                AtomicStoreRelease(&Clock->RingSamplesConsumed, RingSamplesConsumed);
+                AtomicStoreRelease(&Clock->WriteLeadSamples, WriteLead);
+                AtomicStoreRelease(&Clock->GranularitySamples, Granularity);
+                AtomicStoreRelease(&Clock->ServiceIntervalSamples, ServiceInterval);
+            }
+        }
+
+        Sleep(1);
+    }
+
+    return(0);
+}
+
 internal void Win32InitDSound(HWND Window, int32 SamplesPerSecond, int32 BufferSize)
 {
     HMODULE DSoundLibrary = LoadLibraryA("dsound.dll");
@@ -140,56 +369,724 @@ internal void Win32InitDSound(HWND Window, int32 SamplesPerSecond, int32 BufferS
                 BufferDescription.dwSize = sizeof(BufferDescription);
                 BufferDescription.dwFlags = DSBCAPS_PRIMARYBUFFER;
 
-                //Create a primary buffer
-                LPDIRECTSOUNDBUFFER PrimaryBuffer;
-                if SUCCEEDED((DirectSound -> CreateSoundBuffer(&BufferDescription, &PrimaryBuffer, 0)))
-                {
-                    //What should the graph of the sound look like
-                    
-                   if(SUCCEEDED(PrimaryBuffer->SetFormat(&WaveFormat)))
-                   {
-                   }
-                   else
-                   {
-                    //TODO(Robin) Diagnostics
-                   }
-                }
-                else
-                {
-                }
+                //Create a primary buffer
+                LPDIRECTSOUNDBUFFER PrimaryBuffer;
+                if SUCCEEDED((DirectSound -> CreateSoundBuffer(&BufferDescription, &PrimaryBuffer, 0)))
+                {
+                    //What should the graph of the sound look like
+                    
+                   if(SUCCEEDED(PrimaryBuffer->SetFormat(&WaveFormat)))
+                   {
+                   }
+                   else
+                   {
+                    //TODO(Robin) Diagnostics
+                   }
+                }
+                else
+                {
+                }
+            }
+            else
+            {
+                //TODO(Robin) Diagnostic
+            }
+        
+            //This is the sound
+            DSBUFFERDESC BufferDescription = {};
+            BufferDescription.dwSize = sizeof(BufferDescription);
+            BufferDescription.dwFlags = 0;
+            BufferDescription.dwBufferBytes = BufferSize;
+            BufferDescription.lpwfxFormat = &WaveFormat;
+
+            if SUCCEEDED((DirectSound -> CreateSoundBuffer(&BufferDescription, &GlobalSecondaryBuffer, 0)))
+                {
+                    //What should the graph of the sound look like
+                    
+                   if(SUCCEEDED(GlobalSecondaryBuffer->SetFormat(&WaveFormat)))
+                   {
+
+                   }
+                   else
+                   {
+                    //TODO(Robin) Diagnostics
+                   }
+            }
+            else
+            {
+                //TODO(Robin) Diagntostic
+
+            }
+        }
+    }
+}
+
+//Large pages need the "Lock pages in memory" privilege, which has to be granted to the user and then switched on for the process
+internal bool32 Win32EnableLockMemoryPrivilege(void)
+{
+    bool32 Result = false;
+
+    HANDLE Token;
+    if(OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES|TOKEN_QUERY, &Token))
+    {
+        TOKEN_PRIVILEGES Privileges = {};
+        Privileges.PrivilegeCount = 1;
+        Privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        if(LookupPrivilegeValueA(0, "SeLockMemoryPrivilege", &Privileges.Privileges[0].Luid))
+        {
+            AdjustTokenPrivileges(Token, FALSE, &Privileges, 0, 0, 0);
+            //AdjustTokenPrivileges "succeeds" even when the user doesn't hold the privilege, so check the last error
+            Result = (GetLastError() == ERROR_SUCCESS);
+        }
+        CloseHandle(Token);
+    }
+
+    return(Result);
+}
+
+//Reserves and commits the one block of memory everything else is carved out of.
+//Large pages are tried first (fewer TLB misses, and they are locked in physical memory so they can never fault),
+//then we fall back to normal pages and touch every one of them so all the page faults happen here, at startup.
+internal void *Win32AllocateGameMemory(LPVOID BaseAddress, uint64 Size, bool32 *UsedLargePages)
+{
+    void *Result = 0;
+    *UsedLargePages = false;
+
+    SIZE_T LargePageSize = GetLargePageMinimum();
+    if(LargePageSize && Win32EnableLockMemoryPrivilege())
+    {
+        uint64 LargeSize = (Size + LargePageSize - 1) & ~((uint64)LargePageSize - 1);
+        Result = VirtualAlloc(BaseAddress, LargeSize, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE);
+        *UsedLargePages = (Result != 0);
+    }
+
+    if(!Result)
+    {
+        Result = VirtualAlloc(BaseAddress, Size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        if(Result)
+        {
+            SYSTEM_INFO SystemInfo;
+            GetSystemInfo(&SystemInfo);
+            volatile uint8 *Page = (volatile uint8 *)Result;
+            for(uint64 Offset = 0; Offset < Size; Offset += SystemInfo.dwPageSize)
+            {
+                Page[Offset] = 0;
+            }
+        }
+    }
+
+    return(Result);
+}
+
+//Read only, at BaseAddress if it is free. Mapping reads nothing, a page is read the first time it is touched.
+internal void *Win32MapFile(char *FileName, LPVOID BaseAddress, uint64 *Size)
+{
+    void *Result = 0;
+    *Size = 0;
+
+    HANDLE FileHandle = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+    if(FileHandle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER FileSize;
+        if(GetFileSizeEx(FileHandle, &FileSize) && (FileSize.QuadPart > 0))
+        {
+            HANDLE MemoryMap = CreateFileMappingA(FileHandle, 0, PAGE_READONLY, 0, 0, 0);
+            if(MemoryMap)
+            {
+                Result = MapViewOfFileEx(MemoryMap, FILE_MAP_READ, 0, 0, 0, BaseAddress);
+                if(!Result && BaseAddress)
+                {
+                    Result = MapViewOfFileEx(MemoryMap, FILE_MAP_READ, 0, 0, 0, 0);
+                }
+                if(Result)
+                {
+                    *Size = (uint64)FileSize.QuadPart;
+                }
+
+                //The view keeps the mapping and the file alive on its own
+                CloseHandle(MemoryMap);
+            }
+        }
+        CloseHandle(FileHandle);
+    }
+
+    return(Result);
+}
+
+//Total page faults for the process so far. The frame loop checks it every frame, it should stay flat.
+internal uint32 Win32GetPageFaultCount(void)
+{
+    uint32 Result = 0;
+
+    PROCESS_MEMORY_COUNTERS Counters = {};
+    Counters.cb = sizeof(Counters);
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+    {
+        Result = Counters.PageFaultCount;
+    }
+
+    return(Result);
+}
+
+//Writes whatever the profiler still has in its window as Chrome trace JSON
+internal void Win32WriteTrace(const char *FileName)
+{
+    memory_index TraceSize = Megabytes(32);
+    char *Trace = (char *)VirtualAlloc(0, TraceSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(Trace)
+    {
+        DWORD BytesToWrite = (DWORD)DebugWriteChromeTrace(Trace, TraceSize);
+        HANDLE File = CreateFileA(FileName, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+        if(File != INVALID_HANDLE_VALUE)
+        {
+            DWORD BytesWritten;
+            WriteFile(File, Trace, BytesToWrite, &BytesWritten, 0);
+            CloseHandle(File);
+        }
+        else
+        {
+            //TODO(Robin): Logging
+        }
+        VirtualFree(Trace, 0, MEM_RELEASE);
+    }
+}
+
+//The platform's half of the work queue: the worker threads and the semaphore they sleep on
+internal PLATFORM_ADD_ENTRY(Win32AddEntry)
+{
+    AddWorkQueueEntry(Queue, Callback, Data);
+    ReleaseSemaphore((HANDLE)Queue->WakeSemaphore, 1, 0);
+}
+
+internal PLATFORM_COMPLETE_ALL_WORK(Win32CompleteAllWork)
+{
+    uint32 ThreadIndex = GetWorkQueueThreadIndex(Queue);
+    while(!IsWorkQueueDone(Queue))
+    {
+        if(!DoNextWorkQueueEntry(Queue, ThreadIndex))
+        {
+            //The last entries are running on other threads. If one of them is waiting for this core, let it have it.
+            SwitchToThread();
+        }
+    }
+}
+
+internal DWORD WINAPI Win32WorkQueueThreadProc(LPVOID Parameter)
+{
+    win32_worker *Worker = (win32_worker *)Parameter;
+    win32_work_queue *WorkQueue = Worker->WorkQueue;
+    platform_work_queue *Queue = WorkQueue->Queue;
+
+    RegisterWorkQueueThread(Queue, Worker->ThreadIndex);
+    DebugNameThread("Worker");
+
+    while(WorkQueue->Running)
+    {
+        if(!DoNextWorkQueueEntry(Queue, Worker->ThreadIndex))
+        {
+            WaitForSingleObjectEx((HANDLE)Queue->WakeSemaphore, INFINITE, FALSE);
+        }
+    }
+
+    return(0);
+}
+
+//The calling thread becomes the queue's owner, and ThreadCount - 1 workers are started
+internal bool32 Win32StartWorkQueue(win32_work_queue *WorkQueue, uint32 ThreadCount)
+{
+    *WorkQueue = {};
+    WorkQueue->Queue = (platform_work_queue *)VirtualAlloc(0, sizeof(platform_work_queue), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    HANDLE WakeSemaphore = CreateSemaphoreEx(0, 0, WORK_QUEUE_MAX_THREADS*WORK_QUEUE_DEQUE_SIZE, 0, 0, SEMAPHORE_ALL_ACCESS);
+    if(!WorkQueue->Queue || !WakeSemaphore)
+    {
+        return(false);
+    }
+
+    InitializeWorkQueue(WorkQueue->Queue, ThreadCount, WakeSemaphore);
+    RegisterWorkQueueThread(WorkQueue->Queue, 0);
+
+    //Only the workers that started count, the queue goes on with fewer (the owner runs entries too) if one didn't
+    WorkQueue->Running = true;
+    WorkQueue->ThreadCount = 1;
+    for(uint32 ThreadIndex = 1; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        win32_worker *Worker = WorkQueue->Workers + ThreadIndex;
+        Worker->WorkQueue = WorkQueue;
+        Worker->ThreadIndex = ThreadIndex;
+        Worker->Thread = CreateThread(0, 0, Win32WorkQueueThreadProc, Worker, 0, 0);
+        if(!Worker->Thread)
+        {
+            //TODO(Robin): Logging
+            WorkQueue->Queue->ThreadCount = ThreadIndex;
+            break;
+        }
+        WorkQueue->ThreadCount = ThreadIndex + 1;
+    }
+
+    return(true);
+}
+
+internal void Win32StopWorkQueue(win32_work_queue *WorkQueue)
+{
+    HANDLE WakeSemaphore = (HANDLE)WorkQueue->Queue->WakeSemaphore;
+    WorkQueue->Running = false;
+    ReleaseSemaphore(WakeSemaphore, WorkQueue->ThreadCount, 0);
+    for(uint32 ThreadIndex = 1; ThreadIndex < WorkQueue->ThreadCount; ++ThreadIndex)
+    {
+        WaitForSingleObject(WorkQueue->Workers[ThreadIndex].Thread, INFINITE);
+        CloseHandle(WorkQueue->Workers[ThreadIndex].Thread);
+    }
+
+    CloseHandle(WakeSemaphore);
+    VirtualFree(WorkQueue->Queue, 0, MEM_RELEASE);
+    WorkQueue->Queue = 0;
+}
+
+//The snapshot file is mapped for the whole run, so starting a recording or a loop is one memory copy, no file I/O
+internal void Win32InitializeReplayBuffer(win32_state *State)
+{
+    win32_replay_buffer *ReplayBuffer = &State->ReplayBuffer;
+    wsprintfA(ReplayBuffer->FileName, "midnight_madness_loop_state.mmi");
+    ReplayBuffer->FileHandle = CreateFileA(ReplayBuffer->FileName, GENERIC_WRITE|GENERIC_READ, 0, 0, CREATE_ALWAYS, 0, 0);
+    if(ReplayBuffer->FileHandle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER MaxSize;
+        MaxSize.QuadPart = State->TotalSize;
+        ReplayBuffer->MemoryMap = CreateFileMappingA(ReplayBuffer->FileHandle, 0, PAGE_READWRITE, MaxSize.HighPart, MaxSize.LowPart, 0);
+        if(ReplayBuffer->MemoryMap)
+        {
+            ReplayBuffer->MemoryBlock = MapViewOfFile(ReplayBuffer->MemoryMap, FILE_MAP_ALL_ACCESS, 0, 0, State->TotalSize);
+        }
+    }
+
+    if(!ReplayBuffer->MemoryBlock)
+    {
+        //TODO(Robin): Logging. Without the snapshot there is nothing to loop back to, so 'L' does nothing.
+    }
+}
+
+//The render thread has rendered every frame submitted so far, and is waiting for the next one
+internal void Win32FinishRendering(win32_render_thread *Thread)
+{
+    if(Thread->Thread)
+    {
+        while(!FramePipelineIsRendered(Thread->Pipeline))
+        {
+            WaitForSingleObject(Thread->FramesRendered, INFINITE);
+        }
+    }
+}
+
+//A frame or a load job that finished after the snapshot was taken, or after it was copied back, would write into the
+//wrong state. Loads are only queued while rendering, so the frames go first.
+internal void Win32FinishGameMemoryWrites(win32_state *State)
+{
+    if(State->RenderThread)
+    {
+        Win32FinishRendering(State->RenderThread);
+    }
+    if(State->LoadQueue)
+    {
+        Win32CompleteAllWork(State->LoadQueue);
+    }
+}
+
+internal void Win32BeginRecordingInput(win32_state *State)
+{
+    if(State->ReplayBuffer.MemoryBlock)
+    {
+        Win32FinishGameMemoryWrites(State);
+        CopyMemory(State->ReplayBuffer.MemoryBlock, State->GameMemoryBlock, State->TotalSize);
+        State->RecordingHandle = CreateFileA("midnight_madness_loop_input.mmi", GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+        State->IsRecording = (State->RecordingHandle != INVALID_HANDLE_VALUE);
+    }
+}
+
+internal void Win32EndRecordingInput(win32_state *State)
+{
+    CloseHandle(State->RecordingHandle);
+    State->IsRecording = false;
+}
+
+internal void Win32BeginInputPlayback(win32_state *State)
+{
+    Win32FinishGameMemoryWrites(State);
+    CopyMemory(State->GameMemoryBlock, State->ReplayBuffer.MemoryBlock, State->TotalSize);
+    State->PlaybackHandle = CreateFileA("midnight_madness_loop_input.mmi", GENERIC_READ, 0, 0, OPEN_EXISTING, 0, 0);
+    State->IsPlayingBack = (State->PlaybackHandle != INVALID_HANDLE_VALUE);
+}
+
+internal void Win32EndInputPlayback(win32_state *State)
+{
+    CloseHandle(State->PlaybackHandle);
+    State->IsPlayingBack = false;
+}
+
+internal void Win32RecordInput(win32_state *State, game_input *NewInput)
+{
+    DWORD BytesWritten;
+    WriteFile(State->RecordingHandle, NewInput, sizeof(*NewInput), &BytesWritten, 0);
+}
+
+internal void Win32PlaybackInput(win32_state *State, game_input *NewInput)
+{
+    DWORD BytesRead = 0;
+    if(ReadFile(State->PlaybackHandle, NewInput, sizeof(*NewInput), &BytesRead, 0))
+    {
+        if(BytesRead == 0)
+        {
+            //We hit the end of the recording, go back to the snapshot and around again
+            Win32EndInputPlayback(State);
+            Win32BeginInputPlayback(State);
+            ReadFile(State->PlaybackHandle, NewInput, sizeof(*NewInput), &BytesRead, 0);
+        }
+    }
+}
+
+internal int64 Win32GetWallClock(void)
+{
+    LARGE_INTEGER Result;
+    QueryPerformanceCounter(&Result);
+    return(Result.QuadPart);
+}
+
+//True if the button went up or down
+internal bool32 Win32ProcessKeyboardMessage(game_button_state *NewState, bool32 IsDown)
+{
+    bool32 Result = (NewState->EndedDown != IsDown);
+    if(Result)
+    {
+        NewState->EndedDown = IsDown;
+        ++NewState->HalfTransitionCount;
+    }
+    return(Result);
+}
+
+//When the message was posted, on the performance counter. Message.time comes from GetTickCount, which only moves once
+//a scheduler tick, so this is only as good as that (up to 15.6ms), but it does count the time the message spent in
+//the queue while we were busy with the last frame.
+internal int64 Win32MessageArrivalTicks(MSG *Message, int64 PerfCountFrequency)
+{
+    int64 Now = Win32GetWallClock();
+    DWORD QueuedMilliseconds = GetTickCount() - Message->time;
+    int64 Result = Now - ((int64)QueuedMilliseconds*PerfCountFrequency) / 1000;
+    return(Result);
+}
+
+//All the messages in the queue, handled here rather than in the window callback so keyboard input goes straight
+//into this frame's controller, and every button it moves into the frame's input events
+internal void Win32ProcessPendingMessages(win32_state *State, game_controller_input *KeyboardController,
+                                          input_event_batch *InputEvents, int64 PerfCountFrequency)
+{
+    TIMED_FUNCTION();
+
+    MSG Message;
+    while(PeekMessageA(&Message, 0, 0, 0, PM_REMOVE))
+    {
+        switch(Message.message)
+        {
+            case WM_QUIT:
+            {
+                GlobalRunning = false;
+            } break;
+
+            case WM_SYSKEYDOWN:
+            case WM_SYSKEYUP:
+            case WM_KEYDOWN:
+            case WM_KEYUP:
+            {
+                uint32 VKCode = (uint32)Message.wParam;
+                bool32 WasDown = ((Message.lParam & (1 << 30)) != 0);
+                bool32 IsDown = ((Message.lParam & (1 << 31)) == 0);
+                if(WasDown != IsDown)
+                {
+                    game_button_state *Button = 0;
+                    if(VKCode == 'W')
+                    {
+                        Button = &KeyboardController->MoveUp;
+                    }
+                    else if(VKCode == 'A')
+                    {
+                        Button = &KeyboardController->MoveLeft;
+                    }
+                    else if(VKCode == 'S')
+                    {
+                        Button = &KeyboardController->MoveDown;
+                    }
+                    else if(VKCode == 'D')
+                    {
+                        Button = &KeyboardController->MoveRight;
+                    }
+                    else if(VKCode == 'Q')
+                    {
+                        Button = &KeyboardController->LeftShoulder;
+                    }
+                    else if(VKCode == 'E')
+                    {
+                        Button = &KeyboardController->RightShoulder;
+                    }
+                    else if(VKCode == VK_UP)
+                    {
+                        Button = &KeyboardController->ActionUp;
+                    }
+                    else if(VKCode == VK_LEFT)
+                    {
+                        Button = &KeyboardController->ActionLeft;
+                    }
+                    else if(VKCode == VK_DOWN)
+                    {
+                        Button = &KeyboardController->ActionDown;
+                    }
+                    else if(VKCode == VK_RIGHT)
+                    {
+                        Button = &KeyboardController->ActionRight;
+                    }
+                    else if(VKCode == VK_ESCAPE)
+                    {
+                        Button = &KeyboardController->Back;
+                    }
+                    else if(VKCode == VK_SPACE)
+                    {
+                        Button = &KeyboardController->Start;
+                    }
+                    else if(VKCode == 'P')
+                    {
+                        //Write out the last few seconds of profile as a Chrome trace
+                        if(IsDown)
+                        {
+                            GlobalWriteTrace = true;
+                        }
+                    }
+                    else if(VKCode == VK_F3)
+                    {
+                        if(IsDown)
+                        {
+                            GlobalShowOverlay = !GlobalShowOverlay;
+                        }
+                    }
+                    else if(VKCode == 'L')
+                    {
+                        //Record, then loop what was recorded, then back to live input
+                        if(IsDown)
+                        {
+                            if(State->IsPlayingBack)
+                            {
+                                Win32EndInputPlayback(State);
+                            }
+                            else if(State->IsRecording)
+                            {
+                                Win32EndRecordingInput(State);
+                                Win32BeginInputPlayback(State);
+                            }
+                            else
+                            {
+                                Win32BeginRecordingInput(State);
+                            }
+                        }
+                    }
+
+                    if(Button && Win32ProcessKeyboardMessage(Button, IsDown))
+                    {
+                        AddInputEvent(InputEvents, Win32MessageArrivalTicks(&Message, PerfCountFrequency),
+                                      (uint32)(Button - KeyboardController->Buttons), IsDown);
+                    }
+                }
+
+                bool32 AltKeyWasDown = (Message.lParam & (1 << 29));
+                if((VKCode == VK_F4) && AltKeyWasDown)
+                {
+                    GlobalRunning = false;
+                }
+            } break;
+
+            default:
+            {
+                //We tell windows to process the message
+                TranslateMessage(&Message);
+                //We tell windows to dispatch the message to MainWindowCallback, windows wants to be the one who dispatches
+                DispatchMessageA(&Message);
+            } break;
+        }
+    }
+}
+
+internal DWORD WINAPI Win32CaptureThreadProc(LPVOID Parameter)
+{
+    win32_capture_thread *Thread = (win32_capture_thread *)Parameter;
+    capture_queue *Queue = Thread->Queue;
+
+    DebugNameThread("Capture");
+
+    //Writing is background work, in CPU and in disk priority, so it mostly gets what the game and audio threads leave
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    for(;;)
+    {
+        WaitForSingleObject(Thread->FramesPublished, INFINITE);
+
+        capture_frame *Frame;
+        while((Frame = BeginCaptureRead(Queue)) != 0)
+        {
+            TIMED_BLOCK("Win32CaptureWrite");
+
+            char Header[64];
+            int HeaderSize;
+            memory_index PixelSize;
+            uint8 *Pixels = PrepareCaptureFrame(Queue, Frame, Header, sizeof(Header), &HeaderSize, &PixelSize);
+            DWORD SampleSize = Frame->SampleCount*2*sizeof(int16);
+
+            DWORD BytesWritten;
+            WriteFile(Thread->FrameFile, Header, HeaderSize, &BytesWritten, 0);
+            WriteFile(Thread->FrameFile, Pixels, (DWORD)PixelSize, &BytesWritten, 0);
+            WriteFile(Thread->WavFile, Frame->Samples, SampleSize, &BytesWritten, 0);
+            Thread->WavDataBytes += SampleSize;
+            ++Thread->FramesWritten;
+
+            EndCaptureRead(Queue);
+        }
+
+        //The game thread publishes everything before it stops us, so once we have drained the queue we are done
+        if(!Thread->Running)
+        {
+            break;
+        }
+    }
+
+    //Now that the sizes are known, the WAV header can be filled in
+    wav_header WavHeader = MakeWavHeader(Thread->SamplesPerSecond, Thread->WavDataBytes);
+    DWORD BytesWritten;
+    SetFilePointer(Thread->WavFile, 0, 0, FILE_BEGIN);
+    WriteFile(Thread->WavFile, &WavHeader, sizeof(WavHeader), &BytesWritten, 0);
+
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+    return(0);
+}
+
+//Sleeps most of the way to the next frame's deadline and spins the rest, see midnight_madness_frame_pacer.h.
+//Sleep only takes whole milliseconds and rounds down, the pacer's margin takes care of the rest.
+internal void Win32WaitForNextFrame(frame_pacer *Pacer)
+{
+    TIMED_FUNCTION();
+
+    int64 Now = Win32GetWallClock();
+    int64 WakeTime = FramePacerWakeTime(Pacer);
+    if(Now < WakeTime)
+    {
+        DWORD SleepMS = (DWORD)((1000*(WakeTime - Now)) / Pacer->TicksPerSecond);
+        if(SleepMS > 0)
+        {
+            int64 SleepTarget = Now + (SleepMS*Pacer->TicksPerSecond) / 1000;
+            Sleep(SleepMS);
+            Now = Win32GetWallClock();
+            FramePacerSlept(Pacer, SleepTarget, Now);
+        }
+    }
+
+    int64 SpinStart = Now;
+    while(Now < Pacer->NextDeadline)
+    {
+        _mm_pause();
+        Now = Win32GetWallClock();
+    }
+    Pacer->SpinTicks += Now - SpinStart;
+
+    AdvanceFramePacer(Pacer, Now);
+}
+
+//Runs the game for one submitted frame: into the swap chain's next buffer (or a capture frame), and its sound
+internal void Win32RenderFrame(win32_render_thread *Thread, frame_pipeline_slot *Slot)
+{
+    //When capturing, the game renders right into a capture frame, and it stays the backbuffer (WM_PAINT included)
+    //until the next frame is presented. If the writer has every frame, this one goes in the swap chain.
+    capture_frame *CaptureFrame = 0;
+    if(Thread->CaptureQueue)
+    {
+        CaptureFrame = BeginCaptureFrame(Thread->CaptureQueue, Slot->FrameIndex);
+    }
+
+    game_offscreen_buffer Buffer = GetDrawBuffer(&GlobalSwapChain);
+    if(CaptureFrame)
+    {
+        Buffer.Memory = CaptureFrame->Pixels;
+    }
+    Slot->Buffer = Buffer;
+    Slot->CaptureFrame = CaptureFrame;
+
+    Slot->RenderStartTicks = Win32GetWallClock();
+    uint64 StartCycleCount = __rdtsc();
+
+    GameUpdateAndRender(Thread->GameMemory, &Slot->Input, &Buffer);
+
+    //Write just enough sound to last until next frame's sound gets here, predicting next frame takes as long as the
+    //main thread expects. The game writes straight into the ring's blocks, and the audio thread does all the talking
+    //to DirectSound.
+    {
+        TIMED_BLOCK("Win32ProduceSound");
+
+        audio_ring *AudioRing = Thread->AudioRing;
+        int SamplesNeeded = ComputeAudioSamplesNeeded(Thread->AudioScheduler, Thread->AudioClock, Slot->ExpectedFrameSeconds);
+        int SamplesProduced = 0;
+        while(SamplesProduced < SamplesNeeded)
+        {
+            game_sound_output_buffer SoundBuffer = {};
+            SoundBuffer.SamplesPerSecond = Thread->SoundOutput->SamplesPerSecond;
+            SoundBuffer.SampleCount = SamplesNeeded - SamplesProduced;
+            if(SoundBuffer.SampleCount > AudioRing->SamplesPerBlock)
+            {
+                SoundBuffer.SampleCount = AudioRing->SamplesPerBlock;
             }
-            else
+            SoundBuffer.Samples = BeginAudioRingWrite(AudioRing);
+            if(!SoundBuffer.Samples)
             {
-                //TODO(Robin) Diagnostic
+                break;
             }
-        
-            //This is the sound
-            DSBUFFERDESC BufferDescription = {};
-            BufferDescription.dwSize = sizeof(BufferDescription);
-            BufferDescription.dwFlags = 0;
-            BufferDescription.dwBufferBytes = BufferSize;
-            BufferDescription.lpwfxFormat = &WaveFormat;
+            GameGetSoundSamples(Thread->GameMemory, &SoundBuffer);
+            if(CaptureFrame)
+            {
+                //The block belongs to the audio thread as soon as it is published, so capture keeps its own copy
+                CopyMemory(CaptureFrame->Samples + 2*CaptureFrame->SampleCount, SoundBuffer.Samples,
+                           SoundBuffer.SampleCount*Thread->SoundOutput->BytesPerSample);
+                CaptureFrame->SampleCount += SoundBuffer.SampleCount;
+            }
+            EndAudioRingWrite(AudioRing, SoundBuffer.SampleCount);
+            SamplesProduced += SoundBuffer.SampleCount;
+        }
+        RecordAudioSamplesProduced(Thread->AudioScheduler, Thread->AudioClock, SamplesProduced);
+    }
 
-            if SUCCEEDED((DirectSound -> CreateSoundBuffer(&BufferDescription, &GlobalSecondaryBuffer, 0)))
-                {
-                    //What should the graph of the sound look like
-                    
-                   if(SUCCEEDED(GlobalSecondaryBuffer->SetFormat(&WaveFormat)))
-                   {
+    Slot->RenderCycles = __rdtsc() - StartCycleCount;
+    Slot->RenderEndTicks = Win32GetWallClock();
 
-                   }
-                   else
-                   {
-                    //TODO(Robin) Diagnostics
-                   }
-            }
-            else
-            {
-                //TODO(Robin) Diagntostic
+    //Until it is presented, WM_PAINT keeps showing the last frame, never one half drawn
+    SwapBackbuffers(&GlobalSwapChain);
+}
 
-            }
+internal DWORD WINAPI Win32RenderThreadProc(LPVOID Parameter)
+{
+    win32_render_thread *Thread = (win32_render_thread *)Parameter;
+
+    DebugNameThread("Render");
+
+    for(;;)
+    {
+        WaitForSingleObject(Thread->FramesSubmitted, INFINITE);
+
+        frame_pipeline_slot *Slot;
+        while((Slot = BeginFrameRender(Thread->Pipeline)) != 0)
+        {
+            Win32RenderFrame(Thread, Slot);
+            EndFrameRender(Thread->Pipeline);
+            ReleaseSemaphore(Thread->FramesRendered, 1, 0);
+        }
+
+        //The main thread has waited for every frame it submitted before it stops us
+        if(!Thread->Running)
+        {
+            break;
         }
     }
+
+    return(0);
 }
 
 internal win32_window_dimension GetWindowDimension(HWND Window)
@@ -205,14 +1102,9 @@ internal win32_window_dimension GetWindowDimension(HWND Window)
 };
 
   
-//Create backbuffer
+//Describe a backbuffer to GDI. The memory was allocated once at startup, resizing never goes back to the OS.
 internal void Win32ResizeDIBSection(win32_offscreen_buffer *Buffer, int Width, int Height)
 {
-    if (Buffer->Memory)
-    {
-        VirtualFree(Buffer->Memory, 0, MEM_RELEASE);
-    }
-
     Buffer->Width = Width;
     Buffer->Height = Height;
     int BytesPerPixel = 4;
@@ -227,36 +1119,70 @@ internal void Win32ResizeDIBSection(win32_offscreen_buffer *Buffer, int Width, i
     Buffer->Info.bmiHeader.biBitCount = 32;
     Buffer->Info.bmiHeader.biCompression = BI_RGB;
 
-    
-    int BitmapMemorySize = (Buffer->Width*Buffer->Height)*BytesPerPixel;
-    //Parameters of VirtualAlloc(1, 2, 3 ,4)
-    //1) The starting address of the region to allocate as virtual memory. Can be anywhere.
-    //2) Rounds up allocated memory to match page size.
-    //3) MEM_COMMIT = Start using the memory right away, MEM_RESERVE = We're going to reserve memory to be used in the future.
-    //4) PAGE_READWRITE = We're both reading from and writing to the memory
-    Buffer->Memory = VirtualAlloc(0, BitmapMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-
     Buffer->Pitch = Width*BytesPerPixel;
-    //TODO(Robin) probably clear this to black
+}
 
+//Resizes every buffer in the swap chain (which clears them to black) and points GlobalBackbuffer at the one shown
+internal void Win32ResizeBackbuffers(int Width, int Height)
+{
+    if(ResizeSwapChain(&GlobalSwapChain, Width, Height, PixelFormat_BGRX8888))
+    {
+        Win32ResizeDIBSection(&GlobalBackbuffer, Width, Height);
+        GlobalBackbuffer.Memory = GetPresentBuffer(&GlobalSwapChain).Memory;
+    }
 }
 
-//Rectangle to rectangle copy, scaling due to differing sizes
+//Our own scaler does the letterboxing and the scaling (see midnight_madness_present.h), so what goes to GDI is always
+//a 1:1 copy. StretchDIBits is only left for when there is no scaler or the window is too big for it.
 internal void Win32DisplayBufferInWindow(win32_offscreen_buffer *Buffer, HDC DeviceContext, int WindowWidth, int WindowHeight)
 {
-    //TODO(Robin) Aspect ratio correction
-    //TODO(Robin) Play with stretch modes
-    StretchDIBits(DeviceContext, 
-                /*
-                X, Y, Width, Height,
-                X, Y, Width, Height,
-                */
-               0, 0, WindowWidth, WindowHeight,
-               0, 0, Buffer->Width, Buffer->Height,
-                Buffer->Memory,
-                &Buffer->Info,
-                DIB_RGB_COLORS,
-                SRCCOPY);
+    win32_offscreen_buffer *Presented = Buffer;
+    if(((WindowWidth != Buffer->Width) || (WindowHeight != Buffer->Height)) && GlobalPresentScaler && GlobalPresentBuffer.Memory &&
+       (WindowWidth > 0) && (WindowHeight > 0) && (WindowWidth <= SWAP_CHAIN_MAX_WIDTH) && (WindowHeight <= SWAP_CHAIN_MAX_HEIGHT))
+    {
+        if((GlobalPresentBuffer.Width != WindowWidth) || (GlobalPresentBuffer.Height != WindowHeight))
+        {
+            Win32ResizeDIBSection(&GlobalPresentBuffer, WindowWidth, WindowHeight);
+        }
+
+        game_offscreen_buffer Source = {};
+        Source.Memory = Buffer->Memory;
+        Source.Width = Buffer->Width;
+        Source.Height = Buffer->Height;
+        Source.Pitch = Buffer->Pitch;
+
+        game_offscreen_buffer Dest = {};
+        Dest.Memory = GlobalPresentBuffer.Memory;
+        Dest.Width = GlobalPresentBuffer.Width;
+        Dest.Height = GlobalPresentBuffer.Height;
+        Dest.Pitch = GlobalPresentBuffer.Pitch;
+
+        if(PresentScaled(GlobalPresentScaler, &Source, &Dest))
+        {
+            Presented = &GlobalPresentBuffer;
+        }
+    }
+
+    if((Presented->Width == WindowWidth) && (Presented->Height == WindowHeight))
+    {
+        //The DIB is top-down, so scan line 0 is the top row and all of them go in one call
+        SetDIBitsToDevice(DeviceContext,
+                          0, 0, WindowWidth, WindowHeight,
+                          0, 0, 0, Presented->Height,
+                          Presented->Memory,
+                          &Presented->Info,
+                          DIB_RGB_COLORS);
+    }
+    else
+    {
+        StretchDIBits(DeviceContext,
+                      0, 0, WindowWidth, WindowHeight,
+                      0, 0, Buffer->Width, Buffer->Height,
+                      Buffer->Memory,
+                      &Buffer->Info,
+                      DIB_RGB_COLORS,
+                      SRCCOPY);
+    }
 }
                                 
                 
@@ -296,72 +1222,7 @@ internal LRESULT Win32MainWindowCallback(HWND Window, UINT Message, WPARAM WPara
         case WM_KEYDOWN:
         case WM_KEYUP:
         {
-            uint32 VKCode = WParam;
-            bool WasDown = ((LParam & (1 << 30)) != 0);
-            bool IsDown = ((LParam & (1 << 31)) == 0);
-            if(WasDown != IsDown)
-            {
-                if(VKCode == 'W')
-                {
-                    if(WasDown)
-                    {
-                        printf("Was down\n");
-                    }
-                    if(IsDown)
-                    {
-                        printf("Is down\n");
-                    }
-                }
-                else if(VKCode == 'A')
-                {
-
-                }
-                else if(VKCode == 'S')
-                {
-                    
-                }
-                else if(VKCode == 'D')
-                {
-                    
-                }
-                else if(VKCode == 'Q')
-                {
-                    
-                }
-                else if(VKCode == 'E')
-                {
-                    
-                }
-                else if(VKCode == VK_UP)
-                {
-                    
-                }
-                else if(VKCode == VK_LEFT)
-                {
-                    
-                }
-                else if(VKCode == VK_DOWN)
-                {
-                    
-                }
-                else if(VKCode == VK_RIGHT)
-                {
-                    
-                }
-                else if(VKCode == VK_ESCAPE)
-                {
-                    
-                }
-                else if(VKCode == VK_SPACE)
-                {
-                }
-            } 
-
-            bool32 AltKeyWasDown = (LParam & (1 << 29));
-            if(VKCode == VK_F4 && AltKeyWasDown)
-            {
-                GlobalRunning = false;
-            }
+            Assert(!"Keyboard input came in through a non-dispatch message!");
         } break;
 
         case WM_PAINT:
@@ -396,7 +1257,39 @@ int WINAPI WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CommandLine,
 
     WNDCLASSA WindowClass = {};
 
-    Win32ResizeDIBSection(&GlobalBackbuffer, 1280, 720);
+    //Pick the widest SIMD path this CPU supports for the game's hot loops
+    GameSelectSIMDLevel(SIMDLevel_Auto);
+
+    //-blend linear blends translucent pixels in linear light, sRGB otherwise. Picked once here, before any thread draws.
+    blend_space BlendSpace = strstr(CommandLine, "-blend linear") ? BlendSpace_Linear : BlendSpace_SRGB;
+    GameSelectBlendSpace(BlendSpace);
+
+    //Ask for 1ms scheduler granularity, so Sleep can be used for frame pacing (and the audio thread's Sleep(1) is 1ms)
+    bool32 SleepIsGranular = (timeBeginPeriod(1) == TIMERR_NOERROR);
+
+    //-pipeline N lets a render thread build frames up to N ahead of the one being shown (0 to 2, default 1), see
+    //midnight_madness_frame_pipeline.h
+    int PipelineDepth = 1;
+    char *PipelineArgument = strstr(CommandLine, "-pipeline ");
+    if(PipelineArgument && (atoi(PipelineArgument + 10) >= 0) && (atoi(PipelineArgument + 10) <= FRAME_PIPELINE_MAX_DEPTH))
+    {
+        PipelineDepth = atoi(PipelineArgument + 10);
+    }
+
+    //One buffer is being shown while the game draws the next (and the render thread's frames in flight have one each),
+    //all from one allocation for the biggest size any could ever be, so a resize never allocates. The present buffer
+    //gets the same treatment.
+    int BackbufferCount = PipelineDepth + 2;
+    void *SwapChainMemory = VirtualAlloc(0, SwapChainMemorySize(SWAP_CHAIN_MAX_WIDTH, SWAP_CHAIN_MAX_HEIGHT, BackbufferCount),
+                                         MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    InitializeSwapChain(&GlobalSwapChain, SwapChainMemory, SWAP_CHAIN_MAX_WIDTH, SWAP_CHAIN_MAX_HEIGHT, BackbufferCount);
+    if(SwapChainMemory)
+    {
+        Win32ResizeBackbuffers(1280, 720);
+    }
+    GlobalPresentBuffer.Memory = VirtualAlloc(0, SwapChainBufferSize(SWAP_CHAIN_MAX_WIDTH, SWAP_CHAIN_MAX_HEIGHT),
+                                              MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    GlobalPresentScaler = (present_scaler *)VirtualAlloc(0, sizeof(present_scaler), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
 
     WindowClass.style = CS_HREDRAW|CS_VREDRAW;
     WindowClass.lpfnWndProc = Win32MainWindowCallback;
@@ -426,102 +1319,360 @@ int WINAPI WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CommandLine,
         {
             HDC DeviceContext = GetDC(Window);
 
-            //Graphics test
-            int XOffset = 0;
-            int YOffset = 0;
+            //Frames are paced to the monitor's refresh rate, unless the command line says otherwise (e.g. -hz 30/60/120)
+            int GameUpdateHz = 60;
+            int MonitorRefreshHz = GetDeviceCaps(DeviceContext, VREFRESH);
+            if(MonitorRefreshHz > 1)
+            {
+                GameUpdateHz = MonitorRefreshHz;
+            }
+            char *HzArgument = strstr(CommandLine, "-hz ");
+            if(HzArgument && (atoi(HzArgument + 4) > 0))
+            {
+                GameUpdateHz = atoi(HzArgument + 4);
+            }
+
+            //-capture saves every frame to midnight_madness_capture.ppm and the sound to midnight_madness_capture.wav,
+            //-captureraw writes raw BGRX pixels to midnight_madness_capture.raw instead of the PPM stream
+            bool32 Capture = (strstr(CommandLine, "-capture") != 0);
+            capture_format CaptureFormat = strstr(CommandLine, "-captureraw") ? CaptureFormat_Raw : CaptureFormat_PPM;
 
             win32_sound_output SoundOutput = {};
             
             SoundOutput.SamplesPerSecond = 48000;
-            SoundOutput.ToneHz = 256;
             SoundOutput.RunningSampleIndex = 0;
-            SoundOutput.WavePeriod = SoundOutput.SamplesPerSecond/SoundOutput.ToneHz;
             SoundOutput.BytesPerSample = sizeof(int16)*2;
             SoundOutput.SecondaryBufferSize = SoundOutput.SamplesPerSecond*SoundOutput.BytesPerSample;
             SoundOutput.ToneVolume = 1000;
             Win32InitDSound(Window, SoundOutput.SamplesPerSecond, SoundOutput.SecondaryBufferSize);
             GlobalSecondaryBuffer->Play(0, 0, DSBPLAY_LOOPING);
 
-            int16 *Samples = (int16 *) VirtualAlloc(0, SoundOutput.SecondaryBufferSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+#if MIDNIGHT_MADNESS_INTERNAL
+            //A fixed base address means pointers into game memory are the same every run, which makes debugging much easier
+            LPVOID BaseAddress = (LPVOID)Terabytes(2);
+#else
+            LPVOID BaseAddress = 0;
+#endif
+
+            game_memory GameMemory = {};
+            GameMemory.PermanentStorageSize = Megabytes(64);
+            GameMemory.TransientStorageSize = Megabytes(128);
+
+            //The game hands sound to the audio thread through a ring of 8 blocks of up to 1/60th of a second each.
+            //How much it actually writes each frame is up to the audio scheduler, which aims for AudioLatencyFrames
+            //frames of sound queued past the write cursor, plus a safety margin the audio thread measures.
+            float32 AudioLatencyFrames = 1.0f;
+            int SamplesPerBlock = SoundOutput.SamplesPerSecond / 60;
+            uint32 AudioRingBlockCount = 8;
+            memory_index AudioRingSize = AudioRingMemorySize(AudioRingBlockCount, SamplesPerBlock);
+
+            //Capture frames are backbuffers, with room for as much sound as the scheduler ever writes in one frame
+            uint32 CaptureFrameCount = 8;
+            int CaptureMaxSampleCount = AudioRingBlockCount*SamplesPerBlock;
+            memory_index CaptureSize = 0;
+            if(Capture)
+            {
+                CaptureSize = CAPTURE_CACHE_LINE + CaptureMemorySize(CaptureFrameCount, GlobalBackbuffer.Width, GlobalBackbuffer.Height,
+                                                                     CaptureMaxSampleCount);
+            }
+
+            //One allocation for everything: the game's permanent and transient storage, a block of silence, the audio ring,
+            //the profiler's tables, then the capture frames if we are capturing
+            uint64 SilenceSize = SamplesPerBlock*SoundOutput.BytesPerSample;
+            uint64 TotalSize = GameMemory.PermanentStorageSize + GameMemory.TransientStorageSize + SilenceSize + AudioRingSize +
+                               DebugStorageSize() + CaptureSize;
+            bool32 UsedLargePages;
+            GameMemory.PermanentStorage = Win32AllocateGameMemory(BaseAddress, TotalSize, &UsedLargePages);
+            GameMemory.TransientStorage = ((uint8 *)GameMemory.PermanentStorage + GameMemory.PermanentStorageSize);
+            int16 *Silence = (int16 *)((uint8 *)GameMemory.TransientStorage + GameMemory.TransientStorageSize);
+            void *AudioRingMemory = (uint8 *)Silence + SilenceSize;
+            void *DebugStorage = (uint8 *)AudioRingMemory + AudioRingSize;
+            void *CaptureMemory = (void *)CaptureAlign((memory_index)DebugStorage + DebugStorageSize());
+
+            if(!GameMemory.PermanentStorage)
+            {
+                //TODO(Robin): Logging
+                return 0;
+            }
+
+            DebugInitialize(DebugStorage);
+            DebugNameThread("Main");
+
+            //One thread per logical processor, this one included, and the game renders a tile at a time on all of them
+            SYSTEM_INFO SystemInfo;
+            GetSystemInfo(&SystemInfo);
+            uint32 ThreadCount = SystemInfo.dwNumberOfProcessors;
+            ThreadCount = (ThreadCount < 1) ? 1 : ((ThreadCount > WORK_QUEUE_MAX_THREADS) ? WORK_QUEUE_MAX_THREADS : ThreadCount);
+            win32_work_queue RenderQueue;
+            if(Win32StartWorkQueue(&RenderQueue, ThreadCount))
+            {
+                GameMemory.RenderQueue = RenderQueue.Queue;
+                GameMemory.PlatformAPI.AddEntry = Win32AddEntry;
+                GameMemory.PlatformAPI.CompleteAllWork = Win32CompleteAllWork;
+            }
+
+            //Asset loads are mostly waiting on the disk, one loader thread is plenty and leaves the cores to the renderer
+            win32_work_queue LoadQueue;
+            if(Win32StartWorkQueue(&LoadQueue, 2))
+            {
+                GameMemory.LowPriorityQueue = LoadQueue.Queue;
+            }
+
+            //The asset file lives next to the exe, wherever we are started from
+            char AssetFileName[MAX_PATH];
+            DWORD EXEFileNameLength = GetModuleFileNameA(0, AssetFileName, sizeof(AssetFileName));
+            char *OnePastLastSlash = AssetFileName;
+            for(char *Scan = AssetFileName; Scan < AssetFileName + EXEFileNameLength; ++Scan)
+            {
+                if(*Scan == '\\')
+                {
+                    OnePastLastSlash = Scan + 1;
+                }
+            }
+            if(EXEFileNameLength && ((OnePastLastSlash - AssetFileName) + sizeof("midnight_madness.mma") <= sizeof(AssetFileName)))
+            {
+                wsprintfA(OnePastLastSlash, "midnight_madness.mma");
+#if MIDNIGHT_MADNESS_INTERNAL
+                //Game memory points into the mapping, so it gets a fixed address too, for looped playback
+                LPVOID AssetBaseAddress = (LPVOID)Terabytes(3);
+#else
+                LPVOID AssetBaseAddress = 0;
+#endif
+                GameMemory.AssetFileMemory = Win32MapFile(AssetFileName, AssetBaseAddress, &GameMemory.AssetFileSize);
+            }
+            if(!GameMemory.AssetFileMemory)
+            {
+                //TODO(Robin): Logging. The game runs without its assets, drawing the stand-ins.
+            }
+
+            //Recording and looping only cover the game's own memory, not the silence, the ring or the profiler tables
+            win32_state Win32State = {};
+            Win32State.TotalSize = GameMemory.PermanentStorageSize + GameMemory.TransientStorageSize;
+            Win32State.GameMemoryBlock = GameMemory.PermanentStorage;
+            Win32State.LoadQueue = GameMemory.LowPriorityQueue;
+            Win32InitializeReplayBuffer(&Win32State);
+
+            game_input Input[2] = {};
+            game_input *NewInput = &Input[0];
+            game_input *OldInput = &Input[1];
+
+            audio_ring AudioRing;
+            InitializeAudioRing(&AudioRing, AudioRingBlockCount, SamplesPerBlock, AudioRingMemory);
+
+            audio_scheduler AudioScheduler;
+            InitializeAudioScheduler(&AudioScheduler, SoundOutput.SamplesPerSecond, AudioRingBlockCount*SamplesPerBlock, AudioLatencyFrames);
+
+            //Until the audio thread is running, the only thing known about the device is how far the write cursor
+            //runs ahead of the play cursor, and that is what the audio thread will start writing at
+            audio_device_clock AudioClock = {};
+            DWORD StartPlayCursor;
+            DWORD StartWriteCursor;
+            if(GlobalSecondaryBuffer && SUCCEEDED(GlobalSecondaryBuffer->GetCurrentPosition(&StartPlayCursor, &StartWriteCursor)))
+            {
+                AudioClock.WriteLeadSamples = ((StartWriteCursor + SoundOutput.SecondaryBufferSize - StartPlayCursor) %
+                                               SoundOutput.SecondaryBufferSize) / SoundOutput.BytesPerSample;
+                AudioClock.WrittenSampleIndex = AudioClock.WriteLeadSamples;
+            }
+
+            win32_audio_thread AudioThread = {};
+            AudioThread.Ring = &AudioRing;
+            AudioThread.Clock = &AudioClock;
+            AudioThread.SoundOutput = &SoundOutput;
+            AudioThread.Silence = Silence;
+            AudioThread.PerfCountFrequency = PerfCountFrequency;
+            AudioThread.Running = true;
+            HANDLE AudioThreadHandle = 0;
+
+            capture_queue CaptureQueue;
+            win32_capture_thread CaptureThread = {};
+            HANDLE CaptureThreadHandle = 0;
+            if(Capture)
+            {
+                InitializeCaptureQueue(&CaptureQueue, CaptureFrameCount, GlobalBackbuffer.Width, GlobalBackbuffer.Height,
+                                       CaptureMaxSampleCount, CaptureFormat, CaptureMemory);
+
+                CaptureThread.Queue = &CaptureQueue;
+                CaptureThread.SamplesPerSecond = SoundOutput.SamplesPerSecond;
+                CaptureThread.FramesPublished = CreateSemaphoreA(0, 0, MAXLONG, 0);
+                CaptureThread.FrameFile = CreateFileA((CaptureFormat == CaptureFormat_Raw) ? "midnight_madness_capture.raw" : "midnight_madness_capture.ppm",
+                                                      GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+                CaptureThread.WavFile = CreateFileA("midnight_madness_capture.wav", GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+                if(CaptureThread.FramesPublished && (CaptureThread.FrameFile != INVALID_HANDLE_VALUE) &&
+                   (CaptureThread.WavFile != INVALID_HANDLE_VALUE))
+                {
+                    //The WAV header gets its sizes when the capture stops, until then the samples go in after an empty one
+                    wav_header WavHeader = MakeWavHeader(SoundOutput.SamplesPerSecond, 0);
+                    DWORD BytesWritten;
+                    WriteFile(CaptureThread.WavFile, &WavHeader, sizeof(WavHeader), &BytesWritten, 0);
+
+                    CaptureThread.Running = true;
+                    CaptureThreadHandle = CreateThread(0, 0, Win32CaptureThreadProc, &CaptureThread, 0, 0);
+                }
+                else
+                {
+                    //TODO(Robin): Logging
+                }
+            }
+
+            //At depth 0 there is no render thread, this one renders every frame right after submitting it
+            frame_pipeline Pipeline;
+            InitializeFramePipeline(&Pipeline, PipelineDepth);
+            InitializeOverlay(&GlobalOverlay);
+            win32_render_thread RenderThread = {};
+            RenderThread.Pipeline = &Pipeline;
+            RenderThread.GameMemory = &GameMemory;
+            RenderThread.CaptureQueue = CaptureThreadHandle ? &CaptureQueue : 0;
+            RenderThread.AudioRing = &AudioRing;
+            RenderThread.AudioScheduler = &AudioScheduler;
+            RenderThread.AudioClock = &AudioClock;
+            RenderThread.SoundOutput = &SoundOutput;
+            if(PipelineDepth)
+            {
+                RenderThread.FramesSubmitted = CreateSemaphoreA(0, 0, MAXLONG, 0);
+                RenderThread.FramesRendered = CreateSemaphoreA(0, 0, MAXLONG, 0);
+                RenderThread.Running = true;
+                if(RenderThread.FramesSubmitted && RenderThread.FramesRendered)
+                {
+                    RenderThread.Thread = CreateThread(0, 0, Win32RenderThreadProc, &RenderThread, 0, 0);
+                }
+                if(!RenderThread.Thread)
+                {
+                    //TODO(Robin): Logging. Without the thread, the frames are rendered here one at a time.
+                    Pipeline.Depth = 0;
+                }
+            }
+            Win32State.RenderThread = &RenderThread;
+            input_latency_stats InputLatency;
+            InitializeInputLatencyStats(&InputLatency, PerfCountFrequency);
 
             GlobalRunning = true;
             LARGE_INTEGER LastCounter;
             QueryPerformanceCounter(&LastCounter);
+            int64 LastStatsCounter = LastCounter.QuadPart;
             int64 LastCycleCount = __rdtsc();
+            uint32 LastPageFaultCount = Win32GetPageFaultCount();
+            frame_pacer Pacer;
+            InitializeFramePacer(&Pacer, PerfCountFrequency, GameUpdateHz, LastCounter.QuadPart);
+            if(!SleepIsGranular)
+            {
+                //Sleep can be off by a whole scheduler tick (15.6ms), start by spinning it all until the pacer knows better
+                Pacer.SleepMargin = Pacer.TicksPerFrame;
+                Pacer.MaxSleepMargin = Pacer.TicksPerFrame;
+            }
+            float32 TargetSecondsPerFrame = FramePacerTargetSeconds(&Pacer);
+            float32 ExpectedFrameSeconds = TargetSecondsPerFrame;
 
             //We enter an infinite loop
             while(GlobalRunning)
             {
-                
-
-                //We process messages as long as there are messages in the queue
-                MSG Message;
-                while(PeekMessageA(&Message, 0, 0, 0, PM_REMOVE))
+                //The frame's latency counts from here, right before the input is read
+                int64 InputCounter = Win32GetWallClock();
+
+                //Keys stay down until a key up message says otherwise, only the transition counts start over
+                game_controller_input *OldKeyboardController = GetController(OldInput, 0);
+                game_controller_input *NewKeyboardController = GetController(NewInput, 0);
+                *NewKeyboardController = {};
+                NewKeyboardController->IsConnected = true;
+                for(int ButtonIndex = 0; ButtonIndex < ArrayCount(NewKeyboardController->Buttons); ++ButtonIndex)
                 {
-                    if(Message.message == WM_QUIT)
-                    {
-                        GlobalRunning = false;
-                    }
-
-                //If we get a new message (no WM_QUIT or error, for example)..
-                
-                    //We tell windows to process the message
-                    TranslateMessage(&Message);
-                    //We tell windows to dispatch the message to MainWindowCallback, windows wants to be the one who dispatches
-                    DispatchMessage(&Message);
+                    NewKeyboardController->Buttons[ButtonIndex].EndedDown = OldKeyboardController->Buttons[ButtonIndex].EndedDown;
                 }
 
-                
-
-                DWORD ByteToLock;
-                DWORD BytesToWrite;
-                DWORD PlayCursor;
-                DWORD WriteCursor;
-                bool32 SoundIsValid = false;
+                input_event_batch InputEvents = {};
+                Win32ProcessPendingMessages(&Win32State, NewKeyboardController, &InputEvents, PerfCountFrequency);
 
+                if(Win32State.IsRecording)
+                {
+                    Win32RecordInput(&Win32State, NewInput);
+                }
+                if(Win32State.IsPlayingBack)
+                {
+                    Win32PlaybackInput(&Win32State, NewInput);
+                }
 
-                if(SUCCEEDED(GlobalSecondaryBuffer->GetCurrentPosition(&PlayCursor, &WriteCursor)))
+                frame_pipeline_slot *Slot = BeginFrameSubmit(&Pipeline);
+                Slot->Input = *NewInput;
+                Slot->FrameIndex = Pipeline.SubmittedCount;
+                Slot->PlatformFlags = 0;
+                Slot->InputTicks = InputCounter;
+                Slot->ExpectedFrameSeconds = ExpectedFrameSeconds;
+                Slot->InputEvents = InputEvents;
+                EndFrameSubmit(&Pipeline);
+                if(Pipeline.Depth)
+                {
+                    ReleaseSemaphore(RenderThread.FramesSubmitted, 1, 0);
+                }
+                else
                 {
-                    ByteToLock = (SoundOutput.RunningSampleIndex*SoundOutput.BytesPerSample) % SoundOutput.SecondaryBufferSize;
+                    Win32RenderFrame(&RenderThread, BeginFrameRender(&Pipeline));
+                    EndFrameRender(&Pipeline);
+                }
 
-                    if(ByteToLock > PlayCursor)
+                //Once there are more frames in flight than the pipeline is deep, the oldest one goes out while the
+                //render thread gets on with the next
+                if(FramePipelineMustPresent(&Pipeline))
+                {
+                    frame_pipeline_slot *Presented;
+                    while((Presented = BeginFramePresent(&Pipeline)) == 0)
                     {
-                        BytesToWrite = SoundOutput.SecondaryBufferSize-ByteToLock;
-                        BytesToWrite += PlayCursor;
+                        WaitForSingleObject(RenderThread.FramesRendered, INFINITE);
                     }
-                    else
+
+                    //The audio thread starts once the first frame has filled the ring, so it doesn't begin with an underrun
+                    if(!AudioThreadHandle && GlobalSecondaryBuffer)
                     {
-                        BytesToWrite = PlayCursor - ByteToLock;
+                        AudioThreadHandle = CreateThread(0, 0, Win32AudioThreadProc, &AudioThread, 0, 0);
                     }
 
-                    SoundIsValid = true;
+                    //Drawn into the frame before it goes out, so a capture has it too while it is shown
+                    if(GlobalShowOverlay)
+                    {
+                        frame_time_histogram *FrameTimes = &Pacer.FrameTimes;
+                        BeginOverlayText(&GlobalOverlay);
+                        OverlayPrint(&GlobalOverlay, "Frame time at %d Hz: mean %.2f ms  p99 %.2f ms  missed %u", GameUpdateHz,
+                                     FrameTimeMean(FrameTimes)*1000.0f, FrameTimePercentile(FrameTimes, 99.0f)*1000.0f,
+                                     Pacer.MissedFrameCount);
+                        OverlayPrint(&GlobalOverlay, "Render %.2f ms  %.2f Mcycles  blending in %s",
+                                     (float32)(Presented->RenderEndTicks - Presented->RenderStartTicks)*1000.0f / (float32)PerfCountFrequency,
+                                     (float32)Presented->RenderCycles / 1.0e6f, (BlendSpace == BlendSpace_Linear) ? "linear" : "sRGB");
+                        OverlayPrint(&GlobalOverlay, "Input to present %.2f ms (mean)  pipeline depth %d",
+                                     Pipeline.LatencyCount ? (float32)Pipeline.LatencyTicksSum*1000.0f / (float32)(Pipeline.LatencyCount*PerfCountFrequency) : 0.0f,
+                                     Pipeline.Depth);
+                        OverlayPrint(&GlobalOverlay, "Audio latency %.1f ms  max %.1f ms  underruns %u",
+                                     AudioScheduler.LastLatencySeconds*1000.0f, AudioScheduler.MaxLatencySeconds*1000.0f,
+                                     AudioRing.UnderrunCount);
+                        OverlayPrint(&GlobalOverlay, "Overlay %.3f Mcycles (last frame)  F3 hides", (float32)GlobalOverlay.LastCycles / 1.0e6f);
+                        OverlayPrintProfile(&GlobalOverlay, 8);
+                        DrawOverlay(&GlobalOverlay, &Presented->Buffer);
+                    }
 
-                }
+                    //Wait out the rest of the frame, then show it, so frames go out as evenly as we can make them
+                    Win32WaitForNextFrame(&Pacer);
 
-                game_sound_output_buffer SoundBuffer = {};
-                SoundBuffer.SamplesPerSecond = SoundOutput.SamplesPerSecond;
-                SoundBuffer.SamplesPerSecond = SoundOutput.SamplesPerSecond;
-                SoundBuffer.SampleCount = BytesToWrite / SoundOutput.BytesPerSample;
-                SoundBuffer.Samples = Samples;
+                    {
+                        TIMED_BLOCK("Win32DisplayBuffer");
+                        GlobalBackbuffer.Memory = Presented->Buffer.Memory;
+                        win32_window_dimension Dimension = GetWindowDimension(Window);
+                        Win32DisplayBufferInWindow(&GlobalBackbuffer, DeviceContext, Dimension.Width, Dimension.Height);
+                    }
 
-                game_offscreen_buffer Buffer = {};
-                Buffer.Memory = GlobalBackbuffer.Memory;
-                Buffer.Width = GlobalBackbuffer.Width;
-                Buffer.Height = GlobalBackbuffer.Height;
-                Buffer.Pitch = GlobalBackbuffer.Pitch;
-                GameUpdateAndRender(&Buffer, XOffset, YOffset, &SoundBuffer, SoundOutput.ToneHz);
+                    //The frame is out, the writer can have it
+                    if(Presented->CaptureFrame)
+                    {
+                        EndCaptureFrame(&CaptureQueue);
+                        ReleaseSemaphore(CaptureThread.FramesPublished, 1, 0);
+                    }
 
-                if(SoundIsValid)
-                {
-                    Win32FillSoundBuffer(&SoundOutput, ByteToLock, BytesToWrite, &SoundBuffer);
+                    //Every key press and release this frame took in has now reached the screen
+                    int64 PresentCounter = Win32GetWallClock();
+                    RecordInputLatencies(&InputLatency, &Presented->InputEvents, Presented->InputTicks,
+                                         Presented->RenderEndTicks, PresentCounter);
+                    EndFramePresent(&Pipeline, Presented, PresentCounter);
                 }
 
-
-
-                win32_window_dimension Dimension = GetWindowDimension(Window);
-                Win32DisplayBufferInWindow(&GlobalBackbuffer, DeviceContext, Dimension.Width, Dimension.Height);
-
-                ++XOffset;
+                game_input *Temp = NewInput;
+                NewInput = OldInput;
+                OldInput = Temp;
 
                 LARGE_INTEGER EndCounter;
                 QueryPerformanceCounter(&EndCounter);
@@ -533,13 +1684,158 @@ int WINAPI WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CommandLine,
                 int32 microsecPerFrame = (1000'000*CounterElapsed) / PerfCountFrequency;
                 uint16 FramesPerSecond = 1000'000/microsecPerFrame;
                 int32 MegaCyclesPerFrame = CyclesElapsed/1000'000;
+                uint32 PageFaultCount = Win32GetPageFaultCount();
+                uint32 PageFaultsThisFrame = PageFaultCount - LastPageFaultCount;
+
+                //Next frame should take exactly a target frame, unless we are missing them
+                float32 SecondsElapsed = (float32)CounterElapsed / (float32)PerfCountFrequency;
+                ExpectedFrameSeconds = (SecondsElapsed > TargetSecondsPerFrame) ? SecondsElapsed : TargetSecondsPerFrame;
+                DebugEndFrame(SecondsElapsed);
+
+                //OutputDebugStringA is slow, so the stats and the profile only go out once a second
+                if(EndCounter.QuadPart - LastStatsCounter >= PerfCountFrequency)
+                {
+                    //wsprintfA can't do floats, so the audio latency goes out in tenths of a millisecond
+                    char StringBuffer[512];
+                    wsprintfA(StringBuffer, "FPS: %d   |   Megacycles per frame: %d   |   Page faults: %u   |   Audio underruns: %u, overruns: %u"
+                              "   |   Audio latency: %d (max %d) x0.1ms, samples: %d (%d-%d), cursor granularity: %u, write lead: %u\n ",
+                              FramesPerSecond, MegaCyclesPerFrame, PageFaultsThisFrame, AudioRing.UnderrunCount, AudioRing.OverrunCount,
+                              (int)(AudioScheduler.LastLatencySeconds*10000.0f), (int)(AudioScheduler.MaxLatencySeconds*10000.0f),
+                              AudioScheduler.LastSampleCount, AudioScheduler.MinSampleCount, AudioScheduler.MaxSampleCount,
+                              AudioClock.GranularitySamples, AudioClock.WriteLeadSamples);
+                    OutputDebugStringA(StringBuffer);
+
+                    //Frame times over the last FRAME_TIME_HISTORY frames, in hundredths of a millisecond
+                    frame_time_histogram *FrameTimes = &Pacer.FrameTimes;
+                    wsprintfA(StringBuffer, "Frame time at %d Hz: mean %d, std dev %d, p99 %d x0.01ms   |   Missed frames: %u of %u   |   Spin: %d us per frame\n ",
+                              GameUpdateHz, (int)(FrameTimeMean(FrameTimes)*100000.0f), (int)(FrameTimeStandardDeviation(FrameTimes)*100000.0f),
+                              (int)(FrameTimePercentile(FrameTimes, 99.0f)*100000.0f), Pacer.MissedFrameCount, Pacer.FrameCount,
+                              Pacer.FrameCount ? (int)((1000000*Pacer.SpinTicks) / (PerfCountFrequency*Pacer.FrameCount)) : 0);
+                    OutputDebugStringA(StringBuffer);
+
+                    //Input to present over the last second, which is what the pipeline depth buys its throughput with
+                    int64 TicksPer100Microseconds = PerfCountFrequency / 10000;
+                    wsprintfA(StringBuffer, "Pipeline: depth %d   |   Input to present: mean %d, max %d x0.1ms\n ",
+                              Pipeline.Depth,
+                              Pipeline.LatencyCount ? (int)(Pipeline.LatencyTicksSum / Pipeline.LatencyCount / TicksPer100Microseconds) : 0,
+                              (int)(Pipeline.MaxLatencyTicks / TicksPer100Microseconds));
+                    OutputDebugStringA(StringBuffer);
+                    ResetFramePipelineStats(&Pipeline);
+
+                    //Every key press and release, from when it was posted to when the frame it went into was presented
+                    if(InputLatency.EventCount)
+                    {
+                        wsprintfA(StringBuffer, "Input events: %u (%u untimed)   |   Event to present: mean %d, p50 %d, p90 %d, p99 %d, max %d x0.1ms"
+                                  "   |   Queued %d, rendering %d, presenting %d x0.1ms (mean)\n ",
+                                  InputLatency.EventCount, InputLatency.DroppedCount,
+                                  (int)(InputLatencyMean(&InputLatency, InputLatency.Sum)*10000.0f),
+                                  (int)(InputLatencyPercentile(&InputLatency, 50.0f)*10000.0f),
+                                  (int)(InputLatencyPercentile(&InputLatency, 90.0f)*10000.0f),
+                                  (int)(InputLatencyPercentile(&InputLatency, 99.0f)*10000.0f),
+                                  (int)(InputLatency.MaxSeconds*10000.0f),
+                                  (int)(InputLatencyMean(&InputLatency, InputLatency.QueuedSum)*10000.0f),
+                                  (int)(InputLatencyMean(&InputLatency, InputLatency.RenderingSum)*10000.0f),
+                                  (int)(InputLatencyMean(&InputLatency, InputLatency.PresentingSum)*10000.0f));
+                        OutputDebugStringA(StringBuffer);
+                        ResetInputLatencyStats(&InputLatency);
+                    }
+
+                    //Resize cost in microseconds, at the rate cycles went by this frame
+                    int64 CyclesPerMicrosecond = microsecPerFrame ? (CyclesElapsed / microsecPerFrame) : 1;
+                    CyclesPerMicrosecond = CyclesPerMicrosecond ? CyclesPerMicrosecond : 1;
+                    wsprintfA(StringBuffer, "Swap chain: %d x %dx%d   |   Swaps: %u   |   Resizes: %u, mean %d us, max %d us\n ",
+                              GlobalSwapChain.BufferCount, GlobalSwapChain.Width, GlobalSwapChain.Height, (uint32)GlobalSwapChain.SwapCount,
+                              (uint32)GlobalSwapChain.ResizeCount,
+                              GlobalSwapChain.ResizeCount ? (int)(GlobalSwapChain.ResizeCycles / GlobalSwapChain.ResizeCount / CyclesPerMicrosecond) : 0,
+                              (int)(GlobalSwapChain.MaxResizeCycles / CyclesPerMicrosecond));
+                    OutputDebugStringA(StringBuffer);
+
+                    if(CaptureThreadHandle)
+                    {
+                        wsprintfA(StringBuffer, "Capture: %u frames written, %u dropped\n ",
+                                  CaptureThread.FramesWritten, CaptureQueue.DroppedFrameCount);
+                        OutputDebugStringA(StringBuffer);
+                    }
+
+                    char ProfileBuffer[8192];
+                    if(DebugWriteSummary(ProfileBuffer, sizeof(ProfileBuffer)))
+                    {
+                        OutputDebugStringA(ProfileBuffer);
+                    }
+
+                    LastStatsCounter = EndCounter.QuadPart;
+                }
+
+                if(GlobalWriteTrace)
+                {
+                    Win32WriteTrace("midnight_madness_trace.json");
+                    GlobalWriteTrace = false;
+                }
 
-                char StringBuffer[256];
-                wsprintfA(StringBuffer, "FPS: %d   |   Megacycles per frame: %d\n ", FramesPerSecond, MegaCyclesPerFrame);
-                OutputDebugStringA(StringBuffer);
-                
                 LastCounter = EndCounter;
                 LastCycleCount = EndCycleCount;
+                LastPageFaultCount = PageFaultCount;
+            }
+
+            //The frames still in flight are rendered, and the captured ones handed to the writer, before the render
+            //thread stops
+            Win32FinishRendering(&RenderThread);
+            while(!FramePipelineIsEmpty(&Pipeline))
+            {
+                frame_pipeline_slot *Presented = BeginFramePresent(&Pipeline);
+                if(Presented->CaptureFrame)
+                {
+                    EndCaptureFrame(&CaptureQueue);
+                    ReleaseSemaphore(CaptureThread.FramesPublished, 1, 0);
+                }
+                EndFramePresent(&Pipeline, Presented, Win32GetWallClock());
+            }
+            if(RenderThread.Thread)
+            {
+                RenderThread.Running = false;
+                ReleaseSemaphore(RenderThread.FramesSubmitted, 1, 0);
+                WaitForSingleObject(RenderThread.Thread, INFINITE);
+                CloseHandle(RenderThread.Thread);
+            }
+            if(RenderThread.FramesSubmitted)
+            {
+                CloseHandle(RenderThread.FramesSubmitted);
+            }
+            if(RenderThread.FramesRendered)
+            {
+                CloseHandle(RenderThread.FramesRendered);
+            }
+
+            if(AudioThreadHandle)
+            {
+                AudioThread.Running = false;
+                WaitForSingleObject(AudioThreadHandle, INFINITE);
+                CloseHandle(AudioThreadHandle);
+            }
+
+            if(CaptureThreadHandle)
+            {
+                CaptureThread.Running = false;
+                ReleaseSemaphore(CaptureThread.FramesPublished, 1, 0);
+                WaitForSingleObject(CaptureThreadHandle, INFINITE);
+                CloseHandle(CaptureThreadHandle);
+                CloseHandle(CaptureThread.FrameFile);
+                CloseHandle(CaptureThread.WavFile);
+                CloseHandle(CaptureThread.FramesPublished);
+            }
+
+            if(GameMemory.RenderQueue)
+            {
+                Win32StopWorkQueue(&RenderQueue);
+            }
+            if(GameMemory.LowPriorityQueue)
+            {
+                Win32StopWorkQueue(&LoadQueue);
+            }
+
+            if(SleepIsGranular)
+            {
+                timeEndPeriod(1);
             }
                 ReleaseDC(Window, DeviceContext);
         }